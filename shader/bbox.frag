@@ -0,0 +1,10 @@
+#version 330 core
+
+// Only used for occlusion queries, color writes are turned off while it runs
+out vec4 FragColor;
+
+
+void main()
+{
+	FragColor = vec4(1.0);
+}
@@ -0,0 +1,16 @@
+#version 330 core
+
+// Corner of the unit cube, in [0, 1]
+layout (location = 0) in vec3 aPos;
+
+// Imports the camera matrix from the main function
+uniform mat4 camMatrix;
+// World space bounding box the cube is stretched over
+uniform vec3 boxMin;
+uniform vec3 boxMax;
+
+
+void main()
+{
+	gl_Position = camMatrix * vec4(mix(boxMin, boxMax, aPos), 1.0);
+}
@@ -0,0 +1,136 @@
+#version 460 core
+#extension GL_ARB_bindless_texture : require
+
+// Outputs colors in RGBA
+out vec4 FragColor;
+
+// Imports the current position from the Vertex Shader
+in vec3 crntPos;
+// Imports the normal from the Vertex Shader
+in vec3 Normal;
+// Imports the color from the Vertex Shader
+in vec3 color;
+// Imports the texture coordinates from the Vertex Shader
+in vec2 texCoord;
+// Imports the entry of the material table from the Vertex Shader
+flat in int material;
+
+
+
+// Texture handles and factors of every material, filled by BindlessMaterials. The index only
+// changes between the draws of a multi-draw, never inside one
+struct Material
+{
+	uvec2 diffuse;
+	uvec2 specular;
+	vec4 baseColorFactor;
+	vec4 emissiveFactor;
+	// Fragments with less base color alpha are discarded, 0 unless the glTF alphaMode is MASK
+	float alphaCutoff;
+};
+layout (std430, binding = 3) readonly buffer Materials
+{
+	Material materials[];
+};
+// Gets the color of the light from the main function
+uniform vec4 lightColor;
+// Gets the position of the light from the main function
+uniform vec3 lightPos;
+// Gets the position of the camera from the main function
+uniform vec3 camPos;
+
+
+// Base color texture scaled by the factor of the material
+vec4 baseColor()
+{
+	return texture(sampler2D(materials[material].diffuse), texCoord) * materials[material].baseColorFactor;
+}
+
+vec4 pointLight()
+{	
+	// used in two variables so I calculate it here to not have to do it twice
+	vec3 lightVec = lightPos - crntPos;
+
+	// intensity of light with respect to distance
+	float dist = length(lightVec);
+	float a = 3.0;
+	float b = 0.7;
+	float inten = 1.0f / (a * dist * dist + b * dist + 1.0f);
+
+	// ambient lighting
+	float ambient = 0.20f;
+
+	// diffuse lighting
+	vec3 normal = normalize(Normal);
+	vec3 lightDirection = normalize(lightVec);
+	float diffuse = max(dot(normal, lightDirection), 0.0f);
+
+	// specular lighting
+	float specularLight = 0.50f;
+	vec3 viewDirection = normalize(camPos - crntPos);
+	vec3 reflectionDirection = reflect(-lightDirection, normal);
+	float specAmount = pow(max(dot(viewDirection, reflectionDirection), 0.0f), 16);
+	float specular = specAmount * specularLight;
+
+	return (baseColor() * (diffuse * inten + ambient) + texture(sampler2D(materials[material].specular), texCoord).r * specular * inten) * lightColor;
+}
+
+vec4 direcLight()
+{
+	// ambient lighting
+	float ambient = 0.20f;
+
+	// diffuse lighting
+	vec3 normal = normalize(Normal);
+	vec3 lightDirection = normalize(vec3(1.0f, 1.0f, 0.0f));
+	float diffuse = max(dot(normal, lightDirection), 0.0f);
+
+	// specular lighting
+	float specularLight = 0.50f;
+	vec3 viewDirection = normalize(camPos - crntPos);
+	vec3 reflectionDirection = reflect(-lightDirection, normal);
+	float specAmount = pow(max(dot(viewDirection, reflectionDirection), 0.0f), 16);
+	float specular = specAmount * specularLight;
+
+	return (baseColor() * (diffuse + ambient) + texture(sampler2D(materials[material].specular), texCoord).r * specular) * lightColor;
+}
+
+vec4 spotLight()
+{
+	// controls how big the area that is lit up is
+	float outerCone = 0.90f;
+	float innerCone = 0.95f;
+
+	// ambient lighting
+	float ambient = 0.20f;
+
+	// diffuse lighting
+	vec3 normal = normalize(Normal);
+	vec3 lightDirection = normalize(lightPos - crntPos);
+	float diffuse = max(dot(normal, lightDirection), 0.0f);
+
+	// specular lighting
+	float specularLight = 0.50f;
+	vec3 viewDirection = normalize(camPos - crntPos);
+	vec3 reflectionDirection = reflect(-lightDirection, normal);
+	float specAmount = pow(max(dot(viewDirection, reflectionDirection), 0.0f), 16);
+	float specular = specAmount * specularLight;
+
+	// calculates the intensity of the crntPos based on its angle to the center of the light cone
+	float angle = dot(vec3(0.0f, -1.0f, 0.0f), -lightDirection);
+	float inten = clamp((angle - outerCone) / (innerCone - outerCone), 0.0f, 1.0f);
+
+	return (baseColor() * (diffuse * inten + ambient) + texture(sampler2D(materials[material].specular), texCoord).r * specular * inten) * lightColor;
+}
+
+
+void main()
+{
+	// Cuts out the transparent parts of masked materials
+	if (baseColor().a < materials[material].alphaCutoff)
+	{
+		discard;
+	}
+	// outputs final color
+	FragColor = direcLight() + vec4(materials[material].emissiveFactor.rgb, 0.0f);
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#version 330 core
+
+// Outputs the id of the virtual texture page this pixel needs, 0 is left where nothing was drawn
+layout (location = 0) out uint PageID;
+
+// Imports the texture coordinates from the Vertex Shader
+in vec2 texCoord;
+
+
+// Size of the virtual texture in texels and of one page
+uniform vec2 virtualSize;
+uniform float pageSize;
+// Number of page levels, the last one is a single page
+uniform float pageLevels;
+// Moves the level back to what the full resolution frame will sample
+uniform float feedbackBias;
+
+
+void main()
+{
+	// The level comes from the unwrapped coordinates, so the wrap doesn't cause a seam of coarse pages
+	vec2 dx = dFdx(texCoord * virtualSize);
+	vec2 dy = dFdy(texCoord * virtualSize);
+	float level = clamp(floor(0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + feedbackBias), 0.0, pageLevels - 1.0);
+
+	vec2 uv = fract(texCoord);
+	vec2 levelSize = max(floor(virtualSize / exp2(level)), vec2(1.0));
+	uvec2 page = uvec2(min(floor(uv * levelSize / pageSize), ceil(levelSize / pageSize) - 1.0));
+	// Same layout as PageId: valid bit, level, y, x
+	PageID = 0x80000000u | (uint(level) << 24) | (page.y << 12) | page.x;
+}
@@ -0,0 +1,69 @@
+#version 460 core
+
+// Positions/Coordinates
+layout (location = 0) in vec3 aPos;
+// Normals (not necessarily normalized)
+layout (location = 1) in vec3 aNormal;
+// Colors
+layout (location = 2) in vec3 aColor;
+// Texture Coordinates
+layout (location = 3) in vec2 aTex;
+
+
+// Outputs the current position for the Fragment Shader
+out vec3 crntPos;
+// Outputs the normal for the Fragment Shader
+out vec3 Normal;
+// Outputs the color for the Fragment Shader
+out vec3 color;
+// Outputs the texture coordinates to the Fragment Shader
+out vec2 texCoord;
+// Outputs the entry of the bindless material table to the Fragment Shader
+flat out int material;
+
+
+// Per-draw data, one entry for every command of the frame
+struct DrawData
+{
+	mat4 model;
+	// Vertex location and layout, only used by pulling.vert
+	int vertexOffset;
+	int stride;
+	int normalOffset;
+	int colorOffset;
+	int texUVOffset;
+	// Entry of the bindless material table, only used by bindless.frag
+	int material;
+};
+layout (std430, binding = 0) readonly buffer Draws
+{
+	DrawData draws[];
+};
+
+// Per-frame camera data streamed by Camera::Upload
+layout (std140, binding = 1) uniform Frame
+{
+	mat4 camMatrix;
+	vec4 camPos;
+};
+// Index of the first command of the current glMultiDrawElementsIndirect call
+uniform int drawOffset;
+
+
+
+void main()
+{
+	mat4 model = draws[drawOffset + gl_DrawID].model;
+	material = draws[drawOffset + gl_DrawID].material;
+	// calculates current position, negated like the -rotation of part13.vert
+	crntPos = -vec3(model * vec4(aPos, 1.0f));
+	// Assigns the normal from the Vertex Data to "Normal"
+	Normal = aNormal;
+	// Assigns the colors from the Vertex Data to "color"
+	color = aColor;
+	// Assigns the texture coordinates from the Vertex Data to "texCoord"
+	texCoord = mat2(0.0, -1.0, 1.0, 0.0) * aTex;
+	
+	// Outputs the positions/coordinates of all vertices
+	gl_Position = camMatrix * vec4(crntPos, 1.0);
+}
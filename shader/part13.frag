@@ -17,6 +17,17 @@ in vec2 texCoord;
 // Gets the Texture Units from the main function
 uniform sampler2D diffuse0;
 uniform sampler2D specular0;
+// Factors of the bound material, filled by Material::Upload
+layout (std140) uniform Material
+{
+	vec4 baseColorFactor;
+	vec4 emissiveFactor;
+	// Layer of the base color and metallic roughness textures inside their array textures
+	ivec4 layers;
+	float metallicFactor;
+	float roughnessFactor;
+	float alphaCutoff;
+};
 // Gets the color of the light from the main function
 uniform vec4 lightColor;
 // Gets the position of the light from the main function
@@ -25,6 +36,12 @@ uniform vec3 lightPos;
 uniform vec3 camPos;
 
 
+// Base color texture scaled by the factor of the material
+vec4 baseColor()
+{
+	return texture(diffuse0, texCoord) * baseColorFactor;
+}
+
 vec4 pointLight()
 {	
 	// used in two variables so I calculate it here to not have to do it twice
@@ -51,7 +68,7 @@ vec4 pointLight()
 	float specAmount = pow(max(dot(viewDirection, reflectionDirection), 0.0f), 16);
 	float specular = specAmount * specularLight;
 
-	return (texture(diffuse0, texCoord) * (diffuse * inten + ambient) + texture(specular0, texCoord).r * specular * inten) * lightColor;
+	return (baseColor() * (diffuse * inten + ambient) + texture(specular0, texCoord).r * specular * inten) * lightColor;
 }
 
 vec4 direcLight()
@@ -71,7 +88,7 @@ vec4 direcLight()
 	float specAmount = pow(max(dot(viewDirection, reflectionDirection), 0.0f), 16);
 	float specular = specAmount * specularLight;
 
-	return (texture(diffuse0, texCoord) * (diffuse + ambient) + texture(specular0, texCoord).r * specular) * lightColor;
+	return (baseColor() * (diffuse + ambient) + texture(specular0, texCoord).r * specular) * lightColor;
 }
 
 vec4 spotLight()
@@ -99,12 +116,17 @@ vec4 spotLight()
 	float angle = dot(vec3(0.0f, -1.0f, 0.0f), -lightDirection);
 	float inten = clamp((angle - outerCone) / (innerCone - outerCone), 0.0f, 1.0f);
 
-	return (texture(diffuse0, texCoord) * (diffuse * inten + ambient) + texture(specular0, texCoord).r * specular * inten) * lightColor;
+	return (baseColor() * (diffuse * inten + ambient) + texture(specular0, texCoord).r * specular * inten) * lightColor;
 }
 
 
 void main()
 {
+	// Cuts out the transparent parts of masked materials
+	if (baseColor().a < alphaCutoff)
+	{
+		discard;
+	}
 	// outputs final color
-	FragColor = direcLight();
+	FragColor = direcLight() + vec4(emissiveFactor.rgb, 0.0f);
 }
\ No newline at end of file
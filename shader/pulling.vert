@@ -0,0 +1,82 @@
+#version 460 core
+
+// No vertex attributes, every vertex is read from the Vertices buffer below
+
+
+// Outputs the current position for the Fragment Shader
+out vec3 crntPos;
+// Outputs the normal for the Fragment Shader
+out vec3 Normal;
+// Outputs the color for the Fragment Shader
+out vec3 color;
+// Outputs the texture coordinates to the Fragment Shader
+out vec2 texCoord;
+// Outputs the entry of the bindless material table to the Fragment Shader
+flat out int material;
+
+
+// Per-draw data, one entry for every command of the frame
+struct DrawData
+{
+	mat4 model;
+	// Where the vertices of the draw start, in floats
+	int vertexOffset;
+	// Floats per vertex and where each attribute sits inside a vertex, -1 when it's missing
+	int stride;
+	int normalOffset;
+	int colorOffset;
+	int texUVOffset;
+	// Entry of the bindless material table, only used by bindless.frag
+	int material;
+};
+layout (std430, binding = 0) readonly buffer Draws
+{
+	DrawData draws[];
+};
+
+// The whole vertex buffer of the geometry arena
+layout (std430, binding = 2) readonly buffer Vertices
+{
+	float vertices[];
+};
+
+// Per-frame camera data streamed by Camera::Upload
+layout (std140, binding = 1) uniform Frame
+{
+	mat4 camMatrix;
+	vec4 camPos;
+};
+// Index of the first command of the current glMultiDrawElementsIndirect call
+uniform int drawOffset;
+
+
+vec3 fetchVec3(int index)
+{
+	return vec3(vertices[index], vertices[index + 1], vertices[index + 2]);
+}
+
+
+void main()
+{
+	DrawData draw = draws[drawOffset + gl_DrawID];
+	// The draw commands use a base vertex of 0, so gl_VertexID is the index of the mesh
+	int vertex = draw.vertexOffset + gl_VertexID * draw.stride;
+
+	vec3 aPos = fetchVec3(vertex);
+	vec3 aNormal = draw.normalOffset >= 0 ? fetchVec3(vertex + draw.normalOffset) : vec3(0.0f, 1.0f, 0.0f);
+	vec3 aColor = draw.colorOffset >= 0 ? fetchVec3(vertex + draw.colorOffset) : vec3(1.0f, 1.0f, 1.0f);
+	vec2 aTex = draw.texUVOffset >= 0 ? vec2(vertices[vertex + draw.texUVOffset], vertices[vertex + draw.texUVOffset + 1]) : vec2(0.0f);
+
+	// calculates current position, negated like the -rotation of part13.vert
+	crntPos = -vec3(draw.model * vec4(aPos, 1.0f));
+	// Assigns the normal from the Vertex Data to "Normal"
+	Normal = aNormal;
+	// Assigns the colors from the Vertex Data to "color"
+	color = aColor;
+	// Assigns the texture coordinates from the Vertex Data to "texCoord"
+	texCoord = mat2(0.0, -1.0, 1.0, 0.0) * aTex;
+	material = draw.material;
+	
+	// Outputs the positions/coordinates of all vertices
+	gl_Position = camMatrix * vec4(crntPos, 1.0);
+}
@@ -0,0 +1,73 @@
+#version 330 core
+
+// Outputs colors in RGBA
+out vec4 FragColor;
+
+// Imports the current position from the Vertex Shader
+in vec3 crntPos;
+// Imports the normal from the Vertex Shader
+in vec3 Normal;
+// Imports the color from the Vertex Shader
+in vec3 color;
+// Imports the texture coordinates from the Vertex Shader
+in vec2 texCoord;
+
+
+// Physical pages and the page table that points into them
+uniform sampler2D pageAtlas;
+uniform sampler2D pageTable;
+// Size of the virtual texture in texels and of one page
+uniform vec2 virtualSize;
+uniform float pageSize;
+// Number of page levels, the last one is a single page
+uniform float pageLevels;
+// Number of page slots in the atlas on each side
+uniform vec2 atlasSlots;
+// Gets the position of the camera from the main function
+uniform vec3 camPos;
+// Gets the color of the light from the main function
+uniform vec4 lightColor;
+
+
+// Samples the virtual texture through the page table. Pages that aren't resident yet
+// fall back to the finest coarser page the table points to
+vec4 virtualTexture(vec2 coord)
+{
+	vec2 dx = dFdx(coord * virtualSize);
+	vec2 dy = dFdy(coord * virtualSize);
+	float level = clamp(floor(0.5 * log2(max(dot(dx, dx), dot(dy, dy)))), 0.0, pageLevels - 1.0);
+
+	vec2 uv = fract(coord);
+	// Slot x, slot y and level of the page that is actually there
+	vec3 entry = floor(textureLod(pageTable, uv, level).rgb * 255.0 + 0.5);
+	vec2 levelSize = max(floor(virtualSize / exp2(entry.b)), vec2(1.0));
+	vec2 inPage = fract(uv * levelSize / pageSize);
+	return textureLod(pageAtlas, (entry.rg + inPage) / atlasSlots, 0.0);
+}
+
+vec4 direcLight()
+{
+	// ambient lighting
+	float ambient = 0.20f;
+
+	// diffuse lighting
+	vec3 normal = normalize(Normal);
+	vec3 lightDirection = normalize(vec3(1.0f, 1.0f, 0.0f));
+	float diffuse = max(dot(normal, lightDirection), 0.0f);
+
+	// specular lighting
+	float specularLight = 0.50f;
+	vec3 viewDirection = normalize(camPos - crntPos);
+	vec3 reflectionDirection = reflect(-lightDirection, normal);
+	float specAmount = pow(max(dot(viewDirection, reflectionDirection), 0.0f), 16);
+	float specular = specAmount * specularLight;
+
+	return (virtualTexture(texCoord) * (diffuse + ambient) + specular) * lightColor;
+}
+
+
+void main()
+{
+	// outputs final color
+	FragColor = direcLight();
+}
@@ -0,0 +1,420 @@
+#include"BVH.h"
+
+#include<algorithm>
+
+#include"JobSystem.h"
+
+// Number of buckets the centroids are sorted into when evaluating split positions
+static const int binCount = 16;
+// Leaves never hold more than this, the SAH decides for anything smaller
+static const unsigned int maxLeafSize = 4;
+// Subtrees smaller than this are not worth a job
+static const unsigned int parallelThreshold = 16 * 1024;
+
+static float surfaceArea(const AABB& box)
+{
+	glm::vec3 size = box.max - box.min;
+	if (size.x < 0.0f || size.y < 0.0f || size.z < 0.0f)
+	{
+		return 0.0f;
+	}
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+static AABB merge(const AABB& a, const AABB& b)
+{
+	AABB result = { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+	return result;
+}
+
+
+// Builds the tree from scratch, the top levels are built on the job system for large inputs
+void BVH::Build(const std::vector<AABB>& boxes)
+{
+	nodes.clear();
+	parents.clear();
+	primitives.resize(boxes.size());
+	leaves.resize(boxes.size());
+	if (boxes.empty())
+	{
+		return;
+	}
+
+	BuildContext context;
+	context.boxes = &boxes;
+	context.centroids.resize(boxes.size());
+	for (unsigned int i = 0; i < boxes.size(); i++)
+	{
+		primitives[i] = i;
+		context.centroids[i] = boxes[i].Center();
+	}
+	// Every split above this depth hands one side to the job system
+	unsigned int threads = JobSystem::Shared().ThreadCount();
+	context.parallelDepth = 0;
+	while ((1u << context.parallelDepth) < threads)
+	{
+		context.parallelDepth++;
+	}
+
+	// A binary tree with N leaves never has more than 2N - 1 nodes
+	nodes.resize(2 * boxes.size());
+	context.nodeCount = 1;
+	buildNode(context, 0, 0, boxes.size(), 0);
+	nodes.resize(context.nodeCount);
+
+	// The links a partial refit climbs up, cheaper to fill in here than from every build job
+	parents.resize(nodes.size());
+	parents[0] = 0;
+	for (unsigned int n = 0; n < nodes.size(); n++)
+	{
+		const BVHNode& node = nodes[n];
+		if (node.count > 0)
+		{
+			for (unsigned int i = node.first; i < node.first + node.count; i++)
+			{
+				leaves[primitives[i]] = n;
+			}
+		}
+		else
+		{
+			parents[node.first] = n;
+			parents[node.first + 1] = n;
+		}
+	}
+}
+
+void BVH::buildNode(BuildContext& context, unsigned int nodeIndex, unsigned int first, unsigned int count, int depth)
+{
+	const std::vector<AABB>& boxes = *context.boxes;
+
+	AABB bounds = AABB::Empty();
+	AABB centroidBounds = AABB::Empty();
+	for (unsigned int i = first; i < first + count; i++)
+	{
+		bounds = merge(bounds, boxes[primitives[i]]);
+		centroidBounds.Expand(context.centroids[primitives[i]]);
+	}
+
+	BVHNode& node = nodes[nodeIndex];
+	node.bounds = bounds;
+	node.first = first;
+	node.count = count;
+	if (count <= 1)
+	{
+		return;
+	}
+
+	// Split along the axis where the centroids are spread the most
+	glm::vec3 spread = centroidBounds.max - centroidBounds.min;
+	int axis = 0;
+	if (spread.y > spread[axis]) axis = 1;
+	if (spread.z > spread[axis]) axis = 2;
+
+	unsigned int mid = first;
+	if (spread[axis] > 0.0f)
+	{
+		// Sort the centroids into bins and sweep the split planes between them
+		unsigned int binCounts[binCount] = {};
+		AABB binBounds[binCount];
+		for (int b = 0; b < binCount; b++)
+		{
+			binBounds[b] = AABB::Empty();
+		}
+		float scale = binCount / spread[axis];
+		for (unsigned int i = first; i < first + count; i++)
+		{
+			int b = std::min(binCount - 1, (int)((context.centroids[primitives[i]][axis] - centroidBounds.min[axis]) * scale));
+			binCounts[b]++;
+			binBounds[b] = merge(binBounds[b], boxes[primitives[i]]);
+		}
+
+		float rightCosts[binCount];
+		AABB right = AABB::Empty();
+		unsigned int rightCount = 0;
+		for (int b = binCount - 1; b > 0; b--)
+		{
+			right = merge(right, binBounds[b]);
+			rightCount += binCounts[b];
+			rightCosts[b] = rightCount * surfaceArea(right);
+		}
+		float bestCost = -1.0f;
+		int bestSplit = 0;
+		AABB left = AABB::Empty();
+		unsigned int leftCount = 0;
+		for (int b = 1; b < binCount; b++)
+		{
+			left = merge(left, binBounds[b - 1]);
+			leftCount += binCounts[b - 1];
+			if (leftCount == 0 || leftCount == count)
+			{
+				continue;
+			}
+			float cost = leftCount * surfaceArea(left) + rightCosts[b];
+			if (bestCost < 0.0f || cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = b;
+			}
+		}
+
+		// Small nodes stay leaves when splitting them doesn't pay off
+		float leafCost = count * surfaceArea(bounds);
+		if (count <= maxLeafSize && (bestCost < 0.0f || bestCost >= leafCost))
+		{
+			return;
+		}
+		if (bestCost >= 0.0f)
+		{
+			unsigned int* begin = &primitives[0] + first;
+			unsigned int* split = std::partition(begin, begin + count, [&](unsigned int primitive)
+			{
+				int b = std::min(binCount - 1, (int)((context.centroids[primitive][axis] - centroidBounds.min[axis]) * scale));
+				return b < bestSplit;
+			});
+			mid = split - &primitives[0];
+		}
+	}
+	else if (count <= maxLeafSize)
+	{
+		return;
+	}
+
+	// All centroids in one spot or one bin, fall back to halving the range
+	if (mid == first || mid == first + count)
+	{
+		mid = first + count / 2;
+		unsigned int* begin = &primitives[0] + first;
+		std::nth_element(begin, &primitives[0] + mid, begin + count, [&](unsigned int a, unsigned int b)
+		{
+			return context.centroids[a][axis] < context.centroids[b][axis];
+		});
+	}
+
+	unsigned int children = context.nodeCount.fetch_add(2);
+	node.first = children;
+	node.count = 0;
+
+	unsigned int leftCount = mid - first;
+	unsigned int rightCount = count - leftCount;
+	if (depth < context.parallelDepth && count >= parallelThreshold)
+	{
+		JobCounter left;
+		JobSystem::Shared().Run([this, &context, children, first, leftCount, depth]()
+		{
+			buildNode(context, children, first, leftCount, depth + 1);
+		}, &left);
+		buildNode(context, children + 1, mid, rightCount, depth + 1);
+		JobSystem::Shared().Wait(left);
+	}
+	else
+	{
+		buildNode(context, children, first, leftCount, depth + 1);
+		buildNode(context, children + 1, mid, rightCount, depth + 1);
+	}
+}
+
+// Updates the node bounds after boxes moved, keeps the tree structure
+void BVH::Refit(const std::vector<AABB>& boxes)
+{
+	// Children are always created after their parent, so walking backwards visits them first
+	for (unsigned int n = nodes.size(); n-- > 0;)
+	{
+		refitNode(n, boxes);
+	}
+}
+
+// Same as Refit when only the boxes of changed moved, only their leaves and the nodes above them are updated
+void BVH::Refit(const std::vector<AABB>& boxes, const std::vector<unsigned int>& changed)
+{
+	// Most of the tree lies above some changed leaf anyway, the plain walk has no marking to pay for
+	if (changed.size() * 4 >= primitives.size())
+	{
+		Refit(boxes);
+		return;
+	}
+
+	// Climb from every changed leaf until a node that is already marked, its ancestors are then marked too
+	refitNodes.clear();
+	refitMarks.assign(nodes.size(), false);
+	for (unsigned int c = 0; c < changed.size(); c++)
+	{
+		unsigned int n = leaves[changed[c]];
+		while (!refitMarks[n])
+		{
+			refitMarks[n] = true;
+			refitNodes.push_back(n);
+			if (n == 0)
+			{
+				break;
+			}
+			n = parents[n];
+		}
+	}
+
+	// Children have higher indices than their parent, so the highest go first like in the full walk
+	std::sort(refitNodes.begin(), refitNodes.end(), std::greater<unsigned int>());
+	for (unsigned int r = 0; r < refitNodes.size(); r++)
+	{
+		refitNode(refitNodes[r], boxes);
+	}
+}
+
+// Recomputes the bounds of one node from its primitives or its children
+void BVH::refitNode(unsigned int nodeIndex, const std::vector<AABB>& boxes)
+{
+	BVHNode& node = nodes[nodeIndex];
+	if (node.count > 0)
+	{
+		node.bounds = AABB::Empty();
+		for (unsigned int i = node.first; i < node.first + node.count; i++)
+		{
+			node.bounds = merge(node.bounds, boxes[primitives[i]]);
+		}
+	}
+	else
+	{
+		node.bounds = merge(nodes[node.first].bounds, nodes[node.first + 1].bounds);
+	}
+}
+
+// Writes the indices of the boxes that touch the frustum to visible, whole subtrees inside it are accepted untested
+void BVH::Cull(const Frustum& frustum, const std::vector<AABB>& boxes, std::vector<unsigned int>& visible) const
+{
+	if (nodes.empty())
+	{
+		return;
+	}
+	std::vector<unsigned int> stack;
+	stack.push_back(0);
+	while (!stack.empty())
+	{
+		unsigned int n = stack.back();
+		stack.pop_back();
+		const BVHNode& node = nodes[n];
+		FrustumResult result = frustum.Classify(node.bounds);
+		if (result == FRUSTUM_OUTSIDE)
+		{
+			continue;
+		}
+		if (result == FRUSTUM_INSIDE)
+		{
+			collect(n, visible);
+		}
+		else if (node.count > 0)
+		{
+			for (unsigned int i = node.first; i < node.first + node.count; i++)
+			{
+				if (frustum.Intersects(boxes[primitives[i]]))
+				{
+					visible.push_back(primitives[i]);
+				}
+			}
+		}
+		else
+		{
+			stack.push_back(node.first + 1);
+			stack.push_back(node.first);
+		}
+	}
+}
+
+// Adds every primitive below a node to visible
+void BVH::collect(unsigned int nodeIndex, std::vector<unsigned int>& visible) const
+{
+	const BVHNode& node = nodes[nodeIndex];
+	if (node.count > 0)
+	{
+		visible.insert(visible.end(), primitives.begin() + node.first, primitives.begin() + node.first + node.count);
+		return;
+	}
+	collect(node.first, visible);
+	collect(node.first + 1, visible);
+}
+
+// Finds the closest primitive hit by a ray within maxDistance, boxes are visited front to back
+bool BVH::Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const RayTest& test, unsigned int& hitPrimitive, float& hitDistance) const
+{
+	if (nodes.empty())
+	{
+		return false;
+	}
+	glm::vec3 invDirection = 1.0f / direction;
+	float best = maxDistance;
+	bool hit = false;
+
+	std::vector<unsigned int> stack;
+	if (rayBoxEntry(nodes[0].bounds, origin, invDirection, best) >= 0.0f)
+	{
+		stack.push_back(0);
+	}
+	while (!stack.empty())
+	{
+		const BVHNode& node = nodes[stack.back()];
+		stack.pop_back();
+		// A closer hit may have been found since this node was pushed
+		if (rayBoxEntry(node.bounds, origin, invDirection, best) < 0.0f)
+		{
+			continue;
+		}
+		if (node.count > 0)
+		{
+			for (unsigned int i = node.first; i < node.first + node.count; i++)
+			{
+				float distance = test(primitives[i]);
+				if (distance >= 0.0f && distance <= best)
+				{
+					best = distance;
+					hitPrimitive = primitives[i];
+					hit = true;
+				}
+			}
+			continue;
+		}
+		// Push the farther child first so the nearer one is popped next
+		float leftEntry = rayBoxEntry(nodes[node.first].bounds, origin, invDirection, best);
+		float rightEntry = rayBoxEntry(nodes[node.first + 1].bounds, origin, invDirection, best);
+		unsigned int nearChild = node.first;
+		unsigned int farChild = node.first + 1;
+		if (rightEntry >= 0.0f && (leftEntry < 0.0f || rightEntry < leftEntry))
+		{
+			std::swap(nearChild, farChild);
+			std::swap(leftEntry, rightEntry);
+		}
+		if (rightEntry >= 0.0f)
+		{
+			stack.push_back(farChild);
+		}
+		if (leftEntry >= 0.0f)
+		{
+			stack.push_back(nearChild);
+		}
+	}
+	if (hit)
+	{
+		hitDistance = best;
+	}
+	return hit;
+}
+
+// Same as Raycast for the segment from start to end
+bool BVH::Segment(const glm::vec3& start, const glm::vec3& end, const RayTest& test, unsigned int& hitPrimitive, float& hitDistance) const
+{
+	float length = glm::length(end - start);
+	if (length <= 0.0f)
+	{
+		return false;
+	}
+	return Raycast(start, (end - start) / length, length, test, hitPrimitive, hitDistance);
+}
+
+// Distance at which a ray enters a box, negative if it misses. invDirection is 1 / direction
+float rayBoxEntry(const AABB& box, const glm::vec3& origin, const glm::vec3& invDirection, float maxDistance)
+{
+	glm::vec3 t0 = (box.min - origin) * invDirection;
+	glm::vec3 t1 = (box.max - origin) * invDirection;
+	glm::vec3 tNear = glm::min(t0, t1);
+	glm::vec3 tFar = glm::max(t0, t1);
+	float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+	float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+	return entry <= exit ? entry : -1.0f;
+}
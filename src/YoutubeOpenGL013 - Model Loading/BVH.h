@@ -0,0 +1,75 @@
+#ifndef BVH_CLASS_H
+#define BVH_CLASS_H
+
+#include<atomic>
+#include<functional>
+#include<vector>
+
+#include"Frustum.h"
+
+
+struct BVHNode
+{
+	AABB bounds;
+	// Leaves: first entry in BVH::primitives. Inner nodes: index of the left child, the right child follows it
+	unsigned int first;
+	// Number of primitives in a leaf, 0 for inner nodes
+	unsigned int count;
+};
+
+
+// Bounding volume hierarchy over the boxes of many objects (for example every mesh instance
+// of a scene). Built with the surface area heuristic, can be refitted when objects move
+class BVH
+{
+public:
+	// Tests one primitive exactly and returns the distance along the ray, or a negative value on a miss
+	typedef std::function<float(unsigned int primitive)> RayTest;
+
+	std::vector<BVHNode> nodes;
+	// Primitive indices, every leaf owns a contiguous range of them
+	std::vector<unsigned int> primitives;
+	// Parent of every node, the root points at itself
+	std::vector<unsigned int> parents;
+	// Leaf node of every primitive, indexed by the primitive itself
+	std::vector<unsigned int> leaves;
+
+	// Builds the tree from scratch, the top levels are built on the job system for large inputs
+	void Build(const std::vector<AABB>& boxes);
+	// Updates the node bounds after boxes moved, keeps the tree structure
+	void Refit(const std::vector<AABB>& boxes);
+	// Same as Refit when only the boxes of changed moved, only their leaves and the nodes above them are updated
+	void Refit(const std::vector<AABB>& boxes, const std::vector<unsigned int>& changed);
+
+	// Writes the indices of the boxes that touch the frustum to visible, whole subtrees inside it are accepted untested
+	void Cull(const Frustum& frustum, const std::vector<AABB>& boxes, std::vector<unsigned int>& visible) const;
+	// Finds the closest primitive hit by a ray within maxDistance, boxes are visited front to back
+	bool Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const RayTest& test, unsigned int& hitPrimitive, float& hitDistance) const;
+	// Same as Raycast for the segment from start to end
+	bool Segment(const glm::vec3& start, const glm::vec3& end, const RayTest& test, unsigned int& hitPrimitive, float& hitDistance) const;
+
+private:
+	// Shared by all threads of one Build
+	struct BuildContext
+	{
+		const std::vector<AABB>* boxes;
+		std::vector<glm::vec3> centroids;
+		std::atomic<unsigned int> nodeCount;
+		int parallelDepth;
+	};
+
+	// Nodes touched by the last partial Refit, kept here so the storage is reused
+	std::vector<unsigned int> refitNodes;
+	std::vector<bool> refitMarks;
+
+	void buildNode(BuildContext& context, unsigned int nodeIndex, unsigned int first, unsigned int count, int depth);
+	// Recomputes the bounds of one node from its primitives or its children
+	void refitNode(unsigned int nodeIndex, const std::vector<AABB>& boxes);
+	// Adds every primitive below a node to visible
+	void collect(unsigned int nodeIndex, std::vector<unsigned int>& visible) const;
+};
+
+// Distance at which a ray enters a box, negative if it misses. invDirection is 1 / direction
+float rayBoxEntry(const AABB& box, const glm::vec3& origin, const glm::vec3& invDirection, float maxDistance);
+
+#endif
@@ -0,0 +1,111 @@
+#include"BindlessMaterials.h"
+
+#include<algorithm>
+#include<cstring>
+
+
+BindlessMaterials::BindlessMaterials()
+	: buffer(0), capacity(0), uploaded(0)
+{
+	// The same textures Material::Bind puts on empty roles, so both paths draw a material alike
+	Material::CreateFallbackTextures();
+}
+
+
+// Index of the entry for the textures and factors of a material, added the first time they are seen
+GLuint BindlessMaterials::Index(const Material& material)
+{
+	GLuint diffuse = material.textures[Material::BASE_COLOR];
+	GLuint specular = material.textures[Material::METALLIC_ROUGHNESS];
+	Entry entry;
+	// The fallbacks are a single texel, their own nearest filtering is all they need
+	entry.diffuse = diffuse != 0 ? handleOf(diffuse, material.samplerObjects[Material::BASE_COLOR])
+		: handleOf(Material::FallbackTexture(Material::BASE_COLOR), 0);
+	entry.specular = specular != 0 ? handleOf(specular, material.samplerObjects[Material::METALLIC_ROUGHNESS])
+		: handleOf(Material::FallbackTexture(Material::METALLIC_ROUGHNESS), 0);
+	entry.baseColorFactor = material.block.baseColorFactor;
+	entry.emissiveFactor = material.block.emissiveFactor;
+	entry.alphaCutoff = material.block.alphaCutoff;
+	entry.padding[0] = entry.padding[1] = entry.padding[2] = 0.0f;
+
+	std::map<Entry, GLuint, EntryLess>::iterator found = indices.find(entry);
+	if (found != indices.end())
+	{
+		return found->second;
+	}
+	GLuint index = (GLuint)entries.size();
+	entries.push_back(entry);
+	indices[entry] = index;
+	return index;
+}
+
+
+// Writes new entries to the storage buffer and binds it to an indexed binding point
+void BindlessMaterials::Bind(GLuint binding)
+{
+	if (entries.size() > capacity)
+	{
+		// Grows by doubling and writes everything again, materials are only added while textures arrive
+		capacity = std::max<size_t>(64, capacity * 2);
+		while (capacity < entries.size())
+		{
+			capacity *= 2;
+		}
+		if (buffer == 0)
+		{
+			glGenBuffers(1, &buffer);
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * sizeof(Entry), NULL, GL_DYNAMIC_DRAW);
+		uploaded = 0;
+	}
+	if (uploaded < entries.size())
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, uploaded * sizeof(Entry), (entries.size() - uploaded) * sizeof(Entry), entries.data() + uploaded);
+		uploaded = entries.size();
+	}
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+}
+
+
+// Makes the handles non resident and deletes the buffer, the fallback textures belong to Material
+void BindlessMaterials::Delete()
+{
+	for (std::unordered_map<uint64_t, GLuint64>::iterator it = handles.begin(); it != handles.end(); ++it)
+	{
+		glMakeTextureHandleNonResidentARB(it->second);
+	}
+	handles.clear();
+	indices.clear();
+	entries.clear();
+	glDeleteBuffers(1, &buffer);
+	buffer = 0;
+	capacity = 0;
+	uploaded = 0;
+}
+
+
+bool BindlessMaterials::EntryLess::operator()(const Entry& a, const Entry& b) const
+{
+	return std::memcmp(&a, &b, sizeof(Entry)) < 0;
+}
+
+
+// Handle of a texture sampled with the state of a sampler object, or with its own state for sampler 0
+GLuint64 BindlessMaterials::handleOf(GLuint texture, GLuint sampler)
+{
+	uint64_t key = ((uint64_t)texture << 32) | sampler;
+	std::unordered_map<uint64_t, GLuint64>::iterator found = handles.find(key);
+	if (found != handles.end())
+	{
+		return found->second;
+	}
+	// Freezes the state of the texture and of the sampler, the handle stays valid until either is deleted.
+	// The sampler carries the glTF wrap and filter modes, the same ones Material::Bind binds next to the texture
+	GLuint64 handle = sampler != 0 ? glGetTextureSamplerHandleARB(texture, sampler) : glGetTextureHandleARB(texture);
+	glMakeTextureHandleResidentARB(handle);
+	handles[key] = handle;
+	return handle;
+}
+
@@ -0,0 +1,65 @@
+#ifndef BINDLESS_MATERIALS_CLASS_H
+#define BINDLESS_MATERIALS_CLASS_H
+
+#include<map>
+#include<unordered_map>
+#include<vector>
+
+#include"GLExtensions.h"
+#include"Material.h"
+
+
+// Material table for GL_ARB_bindless_texture. Every texture gets one resident handle per sampler
+// it is used with and every combination of handles and factors one entry in a storage buffer, so draws only carry a
+// material index and meshes with different materials fit into the same multi-draw.
+// Needs GLCaps.bindlessTexture. A texture's parameters and storage can't change once it has a
+// handle, so textures whose mip levels are still managed by TextureResidency don't belong here
+class BindlessMaterials
+{
+public:
+	BindlessMaterials();
+
+	// Index of the entry for the textures and factors of a material, added the first time they are seen.
+	// Textures of 0 (missing or still uploading) sample as white diffuse and no specular
+	GLuint Index(const Material& material);
+	// Writes new entries to the storage buffer and binds it to an indexed binding point
+	void Bind(GLuint binding);
+	// Number of entries in the table
+	unsigned int Count() const { return (unsigned int)entries.size(); }
+	// Makes the handles non resident and deletes the buffer, the fallback textures belong to Material
+	void Delete();
+
+private:
+	// One entry of the storage buffer, handles are read as uvec2 by shader/bindless.frag (std430 layout)
+	struct Entry
+	{
+		GLuint64 diffuse;
+		GLuint64 specular;
+		// The factors part13.frag reads from the Material block
+		glm::vec4 baseColorFactor;
+		glm::vec4 emissiveFactor;
+		float alphaCutoff;
+		float padding[3];
+	};
+	// Orders entries by their bytes, every field is written so there is no garbage in between
+	struct EntryLess
+	{
+		bool operator()(const Entry& a, const Entry& b) const;
+	};
+
+	std::vector<Entry> entries;
+	// Index of every entry, materials with the same textures and factors share one
+	std::map<Entry, GLuint, EntryLess> indices;
+	// Resident handle of every texture and sampler pair, keyed by both IDs
+	std::unordered_map<uint64_t, GLuint64> handles;
+
+	GLuint buffer;
+	// Entries the buffer has room for and entries already written to it
+	size_t capacity;
+	size_t uploaded;
+
+	// Handle of a texture sampled with the state of a sampler object, or with its own state for sampler 0
+	GLuint64 handleOf(GLuint texture, GLuint sampler);
+};
+
+#endif
@@ -0,0 +1,59 @@
+#include"Bounds.h"
+
+#include<algorithm>
+#include<cfloat>
+
+// Grows the box so it contains a point
+void AABB::Expand(const glm::vec3& point)
+{
+	min = glm::min(min, point);
+	max = glm::max(max, point);
+}
+
+// Returns the box around the transformed corners of this box
+AABB AABB::Transform(const glm::mat4& matrix) const
+{
+	// Arvo's method, every axis of the matrix adds its smallest and largest contribution
+	glm::vec3 translation = glm::vec3(matrix[3]);
+	AABB result = { translation, translation };
+	for (int column = 0; column < 3; column++)
+	{
+		for (int row = 0; row < 3; row++)
+		{
+			float a = matrix[column][row] * min[column];
+			float b = matrix[column][row] * max[column];
+			result.min[row] += std::min(a, b);
+			result.max[row] += std::max(a, b);
+		}
+	}
+	return result;
+}
+
+// Box that contains nothing, Expand makes it valid
+AABB AABB::Empty()
+{
+	AABB box = { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+	return box;
+}
+
+// Box around a list of points
+AABB AABB::FromPoints(const std::vector<glm::vec3>& points)
+{
+	AABB box = Empty();
+	for (unsigned int i = 0; i < points.size(); i++)
+	{
+		box.Expand(points[i]);
+	}
+	return box;
+}
+
+// Sphere around a local box after it has been transformed by a matrix
+BoundingSphere BoundingSphere::FromAABB(const AABB& box, const glm::mat4& matrix)
+{
+	// The largest axis scale keeps the sphere conservative for non-uniform scaling
+	float scale = std::max(glm::length(glm::vec3(matrix[0])), std::max(glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2]))));
+	BoundingSphere sphere;
+	sphere.center = glm::vec3(matrix * glm::vec4(box.Center(), 1.0f));
+	sphere.radius = glm::length(box.Extents()) * scale;
+	return sphere;
+}
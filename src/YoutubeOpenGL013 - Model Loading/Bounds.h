@@ -0,0 +1,38 @@
+#ifndef BOUNDS_CLASS_H
+#define BOUNDS_CLASS_H
+
+#include<vector>
+#include<glm/glm.hpp>
+
+
+// Axis aligned bounding box
+struct AABB
+{
+	glm::vec3 min;
+	glm::vec3 max;
+
+	glm::vec3 Center() const { return (min + max) * 0.5f; }
+	glm::vec3 Extents() const { return (max - min) * 0.5f; }
+
+	// Grows the box so it contains a point
+	void Expand(const glm::vec3& point);
+	// Returns the box around the transformed corners of this box
+	AABB Transform(const glm::mat4& matrix) const;
+
+	// Box that contains nothing, Expand makes it valid
+	static AABB Empty();
+	// Box around a list of points
+	static AABB FromPoints(const std::vector<glm::vec3>& points);
+};
+
+
+struct BoundingSphere
+{
+	glm::vec3 center;
+	float radius;
+
+	// Sphere around a local box after it has been transformed by a matrix
+	static BoundingSphere FromAABB(const AABB& box, const glm::mat4& matrix);
+};
+
+#endif
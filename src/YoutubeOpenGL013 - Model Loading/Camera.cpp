@@ -23,12 +23,36 @@ void Camera::updateMatrix(float FOVdeg, float nearPlane, float farPlane)
 	// Sets new camera matrix
 	// cameraMatrix = view;
 	cameraMatrix = projection * view;
+	Camera::FOVdeg = FOVdeg;
+	Camera::nearPlane = nearPlane;
+	Camera::farPlane = farPlane;
 }
 
-void Camera::Matrix(Shader& shader, const char* uniform)
+void Camera::Matrix(CommandBuffer& commands, Shader& shader, const char* uniform)
 {
 	// Exports camera matrix
-	glUniformMatrix4fv(glGetUniformLocation(shader.ID, uniform), 1, GL_FALSE, glm::value_ptr(cameraMatrix));
+	commands.UniformMatrix4f(shader.Uniform(uniform), cameraMatrix);
+}
+
+void Camera::Upload(StreamBuffer& stream, GLuint binding)
+{
+	FrameUniforms frame = { cameraMatrix, glm::vec4(Position, 1.0f) };
+	GLintptr offset = stream.Upload(&frame, sizeof(FrameUniforms), GLCaps.uniformBufferAlignment);
+	glBindBufferRange(GL_UNIFORM_BUFFER, binding, stream.ID, offset, sizeof(FrameUniforms));
+}
+
+void Camera::CursorRay(double x, double y, glm::vec3& origin, glm::vec3& direction) const
+{
+	// Window pixels to normalized device coordinates, y points up there
+	float ndcX = (float)(2.0 * x / width - 1.0);
+	float ndcY = (float)(1.0 - 2.0 * y / height);
+
+	// Unprojects the point on the near and on the far plane
+	glm::mat4 inverse = glm::inverse(cameraMatrix);
+	glm::vec4 nearPoint = inverse * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverse * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+	origin = glm::vec3(nearPoint) / nearPoint.w;
+	direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
 }
 
 void Camera::Inputs(GLFWwindow* window)
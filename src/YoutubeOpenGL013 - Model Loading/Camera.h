@@ -11,6 +11,16 @@
 #include<glm/gtx/vector_angle.hpp>
 
 #include"shader.h"
+#include"StreamBuffer.h"
+#include"CommandBuffer.h"
+
+
+// Per-frame data of the camera as laid out in the std140 Frame block of the shaders
+struct FrameUniforms
+{
+	glm::mat4 camMatrix;
+	glm::vec4 camPos;
+};
 
 
 class Camera
@@ -21,6 +31,10 @@ public:
 	glm::vec3 Orientation = glm::vec3(0.0f, 0.0f, -1.0f);
 	glm::vec3 Up = glm::vec3(0.0f, 1.0f, 0.0f);
 	glm::mat4 cameraMatrix = glm::mat4(1.0f);
+	// Projection settings of the last updateMatrix
+	float FOVdeg = 45.0f;
+	float nearPlane = 0.1f;
+	float farPlane = 100.0f;
 
 	// Prevents the camera from jumping around when first clicking left click
 	bool firstClick = true;
@@ -38,8 +52,12 @@ public:
 
 	// Updates the camera matrix to the Vertex Shader
 	void updateMatrix(float FOVdeg, float nearPlane, float farPlane);
-	// Exports the camera matrix to a shader
-	void Matrix(Shader& shader, const char* uniform);
+	// Records exporting the camera matrix to a shader, the shader has to be in use at that point
+	void Matrix(CommandBuffer& commands, Shader& shader, const char* uniform);
+	// Writes the camera matrix and position to the stream buffer and binds them as a uniform block
+	void Upload(StreamBuffer& stream, GLuint binding);
+	// Ray from the near plane through a point of the window given in pixels from the top left, for picking
+	void CursorRay(double x, double y, glm::vec3& origin, glm::vec3& direction) const;
 	// Handles camera inputs
 	void Inputs(GLFWwindow* window);
 };
@@ -0,0 +1,207 @@
+#include"CommandBuffer.h"
+
+CommandBuffer::CommandBuffer(size_t blockSize)
+	: memory(blockSize)
+{
+	first = NULL;
+	last = NULL;
+	count = 0;
+}
+
+void CommandBuffer::UseProgram(uint32_t program)
+{
+	push<UseProgramCommand>()->program = program;
+}
+
+void CommandBuffer::BindVertexArray(uint32_t vertexArray)
+{
+	push<BindVertexArrayCommand>()->vertexArray = vertexArray;
+}
+
+void CommandBuffer::BindTexture(uint32_t unit, uint32_t texture, uint32_t target)
+{
+	BindTextureCommand* command = push<BindTextureCommand>();
+	command->unit = unit;
+	command->texture = texture;
+	command->target = target;
+}
+
+void CommandBuffer::BindSampler(uint32_t unit, uint32_t sampler)
+{
+	BindSamplerCommand* command = push<BindSamplerCommand>();
+	command->unit = unit;
+	command->sampler = sampler;
+}
+
+void CommandBuffer::BindUniformBuffer(uint32_t binding, uint32_t buffer)
+{
+	BindUniformBufferCommand* command = push<BindUniformBufferCommand>();
+	command->binding = binding;
+	command->buffer = buffer;
+}
+
+// Locations below 0 are dropped while recording, the same as the API would ignore them
+void CommandBuffer::Uniform1i(int32_t location, int32_t value)
+{
+	if (location < 0)
+	{
+		return;
+	}
+	Uniform1iCommand* command = push<Uniform1iCommand>();
+	command->location = location;
+	command->value = value;
+}
+
+void CommandBuffer::Uniform3f(int32_t location, glm::vec3 value)
+{
+	if (location < 0)
+	{
+		return;
+	}
+	Uniform3fCommand* command = push<Uniform3fCommand>();
+	command->location = location;
+	command->value = value;
+}
+
+void CommandBuffer::Uniform4f(int32_t location, glm::vec4 value)
+{
+	if (location < 0)
+	{
+		return;
+	}
+	Uniform4fCommand* command = push<Uniform4fCommand>();
+	command->location = location;
+	command->value = value;
+}
+
+void CommandBuffer::UniformMatrix4f(int32_t location, const glm::mat4& value)
+{
+	if (location < 0)
+	{
+		return;
+	}
+	UniformMatrix4fCommand* command = push<UniformMatrix4fCommand>();
+	command->location = location;
+	command->value = value;
+}
+
+void CommandBuffer::DrawIndexed(uint32_t indexCount, uint32_t firstIndex, int32_t baseVertex)
+{
+	DrawIndexedCommand* command = push<DrawIndexedCommand>();
+	command->indexCount = indexCount;
+	command->firstIndex = firstIndex;
+	command->baseVertex = baseVertex;
+}
+
+void CommandBuffer::BeginConditionalRender(uint32_t query, bool noWait)
+{
+	BeginConditionalRenderCommand* command = push<BeginConditionalRenderCommand>();
+	command->query = query;
+	command->noWait = noWait;
+}
+
+void CommandBuffer::EndConditionalRender()
+{
+	push<EndConditionalRenderCommand>();
+}
+
+// Throws away all commands and keeps the memory for the next recording
+void CommandBuffer::Reset()
+{
+	memory.Reset();
+	first = NULL;
+	last = NULL;
+	count = 0;
+}
+
+// Writes one line of text per command
+void CommandBuffer::Print(std::ostream& out) const
+{
+	for (const Command* command = first; command != NULL; command = command->next)
+	{
+		switch (command->type)
+		{
+		case COMMAND_USE_PROGRAM:
+			out << "UseProgram " << ((const UseProgramCommand*)command)->program << "\n";
+			break;
+		case COMMAND_BIND_VERTEX_ARRAY:
+			out << "BindVertexArray " << ((const BindVertexArrayCommand*)command)->vertexArray << "\n";
+			break;
+		case COMMAND_BIND_TEXTURE:
+		{
+			const BindTextureCommand* bind = (const BindTextureCommand*)command;
+			out << "BindTexture " << bind->unit << " " << bind->texture << " " << bind->target << "\n";
+			break;
+		}
+		case COMMAND_BIND_SAMPLER:
+		{
+			const BindSamplerCommand* bind = (const BindSamplerCommand*)command;
+			out << "BindSampler " << bind->unit << " " << bind->sampler << "\n";
+			break;
+		}
+		case COMMAND_BIND_UNIFORM_BUFFER:
+		{
+			const BindUniformBufferCommand* bind = (const BindUniformBufferCommand*)command;
+			out << "BindUniformBuffer " << bind->binding << " " << bind->buffer << "\n";
+			break;
+		}
+		case COMMAND_UNIFORM_1I:
+		{
+			const Uniform1iCommand* uniform = (const Uniform1iCommand*)command;
+			out << "Uniform1i " << uniform->location << " " << uniform->value << "\n";
+			break;
+		}
+		case COMMAND_UNIFORM_3F:
+		{
+			const Uniform3fCommand* uniform = (const Uniform3fCommand*)command;
+			out << "Uniform3f " << uniform->location;
+			for (int i = 0; i < 3; i++)
+			{
+				out << " " << uniform->value[i];
+			}
+			out << "\n";
+			break;
+		}
+		case COMMAND_UNIFORM_4F:
+		{
+			const Uniform4fCommand* uniform = (const Uniform4fCommand*)command;
+			out << "Uniform4f " << uniform->location;
+			for (int i = 0; i < 4; i++)
+			{
+				out << " " << uniform->value[i];
+			}
+			out << "\n";
+			break;
+		}
+		case COMMAND_UNIFORM_MATRIX_4F:
+		{
+			const UniformMatrix4fCommand* uniform = (const UniformMatrix4fCommand*)command;
+			out << "UniformMatrix4f " << uniform->location;
+			for (int c = 0; c < 4; c++)
+			{
+				for (int r = 0; r < 4; r++)
+				{
+					out << " " << uniform->value[c][r];
+				}
+			}
+			out << "\n";
+			break;
+		}
+		case COMMAND_DRAW_INDEXED:
+		{
+			const DrawIndexedCommand* draw = (const DrawIndexedCommand*)command;
+			out << "DrawIndexed " << draw->indexCount << " " << draw->firstIndex << " " << draw->baseVertex << "\n";
+			break;
+		}
+		case COMMAND_BEGIN_CONDITIONAL_RENDER:
+		{
+			const BeginConditionalRenderCommand* begin = (const BeginConditionalRenderCommand*)command;
+			out << "BeginConditionalRender " << begin->query << (begin->noWait ? " nowait" : " wait") << "\n";
+			break;
+		}
+		case COMMAND_END_CONDITIONAL_RENDER:
+			out << "EndConditionalRender\n";
+			break;
+		}
+	}
+}
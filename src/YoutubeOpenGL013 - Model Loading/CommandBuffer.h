@@ -0,0 +1,191 @@
+#ifndef COMMAND_BUFFER_CLASS_H
+#define COMMAND_BUFFER_CLASS_H
+
+#include<cstdint>
+#include<new>
+#include<ostream>
+#include<glm/glm.hpp>
+
+#include"LinearAllocator.h"
+
+
+// Every kind of command a CommandBuffer can hold
+enum CommandType : uint8_t
+{
+	COMMAND_USE_PROGRAM,
+	COMMAND_BIND_VERTEX_ARRAY,
+	COMMAND_BIND_TEXTURE,
+	COMMAND_BIND_SAMPLER,
+	COMMAND_BIND_UNIFORM_BUFFER,
+	COMMAND_UNIFORM_1I,
+	COMMAND_UNIFORM_3F,
+	COMMAND_UNIFORM_4F,
+	COMMAND_UNIFORM_MATRIX_4F,
+	COMMAND_DRAW_INDEXED,
+	COMMAND_BEGIN_CONDITIONAL_RENDER,
+	COMMAND_END_CONDITIONAL_RENDER
+};
+
+
+// Start of every command, the payload follows in the derived struct. All commands are plain
+// data that only name objects by their IDs, so they can be recorded without a context
+struct Command
+{
+	CommandType type;
+	// Next command in recording order, NULL for the last one
+	Command* next;
+};
+
+struct UseProgramCommand : Command
+{
+	static const CommandType Type = COMMAND_USE_PROGRAM;
+	uint32_t program;
+};
+
+struct BindVertexArrayCommand : Command
+{
+	static const CommandType Type = COMMAND_BIND_VERTEX_ARRAY;
+	uint32_t vertexArray;
+};
+
+// Binds a texture to a texture unit
+struct BindTextureCommand : Command
+{
+	static const CommandType Type = COMMAND_BIND_TEXTURE;
+	uint32_t unit;
+	uint32_t texture;
+	// Texture target such as GL_TEXTURE_2D
+	uint32_t target;
+};
+
+// Binds a sampler object to a texture unit, 0 samples with the state of the texture itself
+struct BindSamplerCommand : Command
+{
+	static const CommandType Type = COMMAND_BIND_SAMPLER;
+	uint32_t unit;
+	uint32_t sampler;
+};
+
+// Binds a whole buffer to an indexed uniform block binding point
+struct BindUniformBufferCommand : Command
+{
+	static const CommandType Type = COMMAND_BIND_UNIFORM_BUFFER;
+	uint32_t binding;
+	uint32_t buffer;
+};
+
+// Uniforms always go to the program of the last UseProgramCommand
+struct Uniform1iCommand : Command
+{
+	static const CommandType Type = COMMAND_UNIFORM_1I;
+	int32_t location;
+	int32_t value;
+};
+
+struct Uniform3fCommand : Command
+{
+	static const CommandType Type = COMMAND_UNIFORM_3F;
+	int32_t location;
+	glm::vec3 value;
+};
+
+struct Uniform4fCommand : Command
+{
+	static const CommandType Type = COMMAND_UNIFORM_4F;
+	int32_t location;
+	glm::vec4 value;
+};
+
+struct UniformMatrix4fCommand : Command
+{
+	static const CommandType Type = COMMAND_UNIFORM_MATRIX_4F;
+	int32_t location;
+	glm::mat4 value;
+};
+
+// Indexed triangles with 32 bit indices from the bound vertex array
+struct DrawIndexedCommand : Command
+{
+	static const CommandType Type = COMMAND_DRAW_INDEXED;
+	uint32_t indexCount;
+	uint32_t firstIndex;
+	int32_t baseVertex;
+};
+
+// Skips the draws up to the next EndConditionalRender when the query saw no samples
+struct BeginConditionalRenderCommand : Command
+{
+	static const CommandType Type = COMMAND_BEGIN_CONDITIONAL_RENDER;
+	uint32_t query;
+	// Draw anyway instead of waiting when the result isn't there yet
+	bool noWait;
+};
+
+struct EndConditionalRenderCommand : Command
+{
+	static const CommandType Type = COMMAND_END_CONDITIONAL_RENDER;
+};
+
+
+// Stream of rendering commands in a linear allocator. Recording knows nothing about the graphics
+// API, so any thread can fill a buffer of its own while the context thread replays finished ones
+// in order with ExecuteCommands. Recorded streams can be printed and compared without a GPU
+class CommandBuffer
+{
+public:
+	CommandBuffer(size_t blockSize = 64 * 1024);
+
+	void UseProgram(uint32_t program);
+	void BindVertexArray(uint32_t vertexArray);
+	// Target defaults to GL_TEXTURE_2D
+	void BindTexture(uint32_t unit, uint32_t texture, uint32_t target = 0x0DE1);
+	void BindSampler(uint32_t unit, uint32_t sampler);
+	void BindUniformBuffer(uint32_t binding, uint32_t buffer);
+	// Locations below 0 are dropped while recording, the same as the API would ignore them
+	void Uniform1i(int32_t location, int32_t value);
+	void Uniform3f(int32_t location, glm::vec3 value);
+	void Uniform4f(int32_t location, glm::vec4 value);
+	void UniformMatrix4f(int32_t location, const glm::mat4& value);
+	void DrawIndexed(uint32_t indexCount, uint32_t firstIndex, int32_t baseVertex);
+	void BeginConditionalRender(uint32_t query, bool noWait);
+	void EndConditionalRender();
+
+	// Throws away all commands and keeps the memory for the next recording
+	void Reset();
+
+	// First command in recording order, follow next for the rest
+	const Command* First() const { return first; }
+	size_t CommandCount() const { return count; }
+	size_t UsedBytes() const { return memory.UsedBytes(); }
+
+	// Writes one line of text per command
+	void Print(std::ostream& out) const;
+
+private:
+	LinearAllocator memory;
+	Command* first;
+	Command* last;
+	size_t count;
+
+	// Allocates a command of type T and links it behind the last one
+	template<typename T>
+	T* push()
+	{
+		T* command = new (memory.Allocate(sizeof(T), alignof(T))) T();
+		command->type = T::Type;
+		command->next = NULL;
+		if (last == NULL)
+		{
+			first = command;
+		}
+		else
+		{
+			last->next = command;
+		}
+		last = command;
+		count++;
+		return command;
+	}
+};
+
+#endif
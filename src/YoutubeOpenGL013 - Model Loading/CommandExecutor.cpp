@@ -0,0 +1,86 @@
+#include"CommandExecutor.h"
+
+#include<glm/gtc/type_ptr.hpp>
+
+// Replays a recorded CommandBuffer through OpenGL in recording order.
+// Has to run on the thread that owns the context
+void ExecuteCommands(const CommandBuffer& commands)
+{
+	for (const Command* command = commands.First(); command != NULL; command = command->next)
+	{
+		switch (command->type)
+		{
+		case COMMAND_USE_PROGRAM:
+			glUseProgram(((const UseProgramCommand*)command)->program);
+			break;
+		case COMMAND_BIND_VERTEX_ARRAY:
+			glBindVertexArray(((const BindVertexArrayCommand*)command)->vertexArray);
+			break;
+		case COMMAND_BIND_TEXTURE:
+		{
+			const BindTextureCommand* bind = (const BindTextureCommand*)command;
+			if (GLCaps.directStateAccess)
+			{
+				glBindTextureUnit(bind->unit, bind->texture);
+			}
+			else
+			{
+				glActiveTexture(GL_TEXTURE0 + bind->unit);
+				glBindTexture(bind->target, bind->texture);
+			}
+			break;
+		}
+		case COMMAND_BIND_SAMPLER:
+		{
+			const BindSamplerCommand* bind = (const BindSamplerCommand*)command;
+			glBindSampler(bind->unit, bind->sampler);
+			break;
+		}
+		case COMMAND_BIND_UNIFORM_BUFFER:
+		{
+			const BindUniformBufferCommand* bind = (const BindUniformBufferCommand*)command;
+			glBindBufferBase(GL_UNIFORM_BUFFER, bind->binding, bind->buffer);
+			break;
+		}
+		case COMMAND_UNIFORM_1I:
+		{
+			const Uniform1iCommand* uniform = (const Uniform1iCommand*)command;
+			glUniform1i(uniform->location, uniform->value);
+			break;
+		}
+		case COMMAND_UNIFORM_3F:
+		{
+			const Uniform3fCommand* uniform = (const Uniform3fCommand*)command;
+			glUniform3fv(uniform->location, 1, glm::value_ptr(uniform->value));
+			break;
+		}
+		case COMMAND_UNIFORM_4F:
+		{
+			const Uniform4fCommand* uniform = (const Uniform4fCommand*)command;
+			glUniform4fv(uniform->location, 1, glm::value_ptr(uniform->value));
+			break;
+		}
+		case COMMAND_UNIFORM_MATRIX_4F:
+		{
+			const UniformMatrix4fCommand* uniform = (const UniformMatrix4fCommand*)command;
+			glUniformMatrix4fv(uniform->location, 1, GL_FALSE, glm::value_ptr(uniform->value));
+			break;
+		}
+		case COMMAND_DRAW_INDEXED:
+		{
+			const DrawIndexedCommand* draw = (const DrawIndexedCommand*)command;
+			glDrawElementsBaseVertex(GL_TRIANGLES, draw->indexCount, GL_UNSIGNED_INT, (void*)(draw->firstIndex * sizeof(GLuint)), draw->baseVertex);
+			break;
+		}
+		case COMMAND_BEGIN_CONDITIONAL_RENDER:
+		{
+			const BeginConditionalRenderCommand* begin = (const BeginConditionalRenderCommand*)command;
+			glBeginConditionalRender(begin->query, begin->noWait ? GL_QUERY_NO_WAIT : GL_QUERY_WAIT);
+			break;
+		}
+		case COMMAND_END_CONDITIONAL_RENDER:
+			glEndConditionalRender();
+			break;
+		}
+	}
+}
@@ -0,0 +1,12 @@
+#ifndef COMMAND_EXECUTOR_CLASS_H
+#define COMMAND_EXECUTOR_CLASS_H
+
+#include"GLExtensions.h"
+#include"CommandBuffer.h"
+
+
+// Replays a recorded CommandBuffer through OpenGL in recording order.
+// Has to run on the thread that owns the context
+void ExecuteCommands(const CommandBuffer& commands);
+
+#endif
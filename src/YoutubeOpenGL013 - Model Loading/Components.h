@@ -0,0 +1,50 @@
+#ifndef COMPONENTS_CLASS_H
+#define COMPONENTS_CLASS_H
+
+#include<cstdint>
+#include<glad/glad.h>
+#include<glm/glm.hpp>
+
+#include"Bounds.h"
+
+class Mesh;
+
+
+// Components of renderable objects, kept in a Registry. Plain data only, so the pools stay
+// tightly packed and can be read by several threads at once
+
+// Matrix handed to the shader as "model"
+struct TransformComponent
+{
+	glm::mat4 model;
+};
+
+// Which geometry the object draws, the mesh has to outlive the entity
+struct MeshComponent
+{
+	Mesh* mesh;
+};
+
+// Material of the object, the same for objects whose materials bind the same textures, samplers and buffer
+struct MaterialComponent
+{
+	// Material::BindingKey of the material of the mesh
+	uint64_t bindings;
+};
+
+// World space bounds used by culling
+struct BoundsComponent
+{
+	AABB box;
+	BoundingSphere sphere;
+};
+
+// Result of the culling stages for the current frame
+struct VisibilityComponent
+{
+	bool visible;
+	// Level of detail picked for the object, 0 is full detail
+	unsigned int lod;
+};
+
+#endif
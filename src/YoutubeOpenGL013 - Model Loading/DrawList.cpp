@@ -0,0 +1,140 @@
+#include"DrawList.h"
+
+#include<algorithm>
+#include<cmath>
+
+#include"Frustum.h"
+#include"JobSystem.h"
+#include"CommandExecutor.h"
+
+
+// Fills packets for the camera, can run while nothing else changes the registry
+void DrawList::Build(Registry& registry, Camera& camera)
+{
+	Frustum frustum(camera.cameraMatrix);
+	glm::vec3 eye = camera.Position;
+	glm::vec3 forward = glm::normalize(camera.Orientation);
+	// Pixels covered by one unit at distance one
+	float pixelsPerUnit = camera.height * 0.5f / std::tan(glm::radians(camera.FOVdeg) * 0.5f);
+	float range = std::max(camera.farPlane - camera.nearPlane, 1e-6f);
+
+	// Makes sure every pool exists before the jobs look them up
+	ComponentPool<TransformComponent>& transforms = registry.Pool<TransformComponent>();
+	registry.Pool<MeshComponent>();
+	registry.Pool<MaterialComponent>();
+	registry.Pool<BoundsComponent>();
+	registry.Pool<VisibilityComponent>();
+
+	size_t count = transforms.Size();
+	size_t chunks = (count + chunkSize - 1) / chunkSize;
+	chunkPackets.resize(chunks);
+
+	ParallelFor(count, chunkSize, [&](size_t chunk, size_t begin, size_t end)
+	{
+		std::vector<DrawPacket>& output = chunkPackets[chunk];
+		output.clear();
+		registry.EachInRange<TransformComponent, MeshComponent, MaterialComponent, BoundsComponent, VisibilityComponent>(begin, end,
+			[&](Entity entity, TransformComponent& transform, MeshComponent& mesh, MaterialComponent& material, BoundsComponent& bounds, VisibilityComponent& visibility)
+		{
+			visibility.visible = false;
+			if (!frustum.Intersects(bounds.box))
+			{
+				return;
+			}
+
+			// LOD from the size on screen, objects below the last level are too small to matter
+			float distance = std::max(glm::dot(bounds.sphere.center - eye, forward), camera.nearPlane);
+			float pixelRadius = bounds.sphere.radius / distance * pixelsPerUnit;
+			if (pixelRadius < minPixelRadius)
+			{
+				return;
+			}
+			unsigned int lod = 0;
+			for (float threshold = lodPixelRadius; pixelRadius < threshold && lod < maxLod; threshold *= 0.5f)
+			{
+				lod++;
+			}
+			visibility.visible = true;
+			visibility.lod = lod;
+
+			// 32 bits depth, 32 bits dense index. The index makes every key unique
+			uint64_t depth = (uint64_t)(glm::clamp((distance - camera.nearPlane) / range, 0.0f, 1.0f) * 4294967295.0);
+			uint64_t index = transforms.IndexOf(entity);
+			uint64_t key = (depth << 32) | (index & 0xFFFFFFFF);
+			output.push_back(DrawPacket{ material.bindings, key, mesh.mesh, transform.model, lod });
+		});
+	});
+
+	// Chunks are appended in order, so the result doesn't depend on which thread ran which chunk
+	packets.clear();
+	for (size_t c = 0; c < chunks; c++)
+	{
+		packets.insert(packets.end(), chunkPackets[c].begin(), chunkPackets[c].end());
+	}
+	std::sort(packets.begin(), packets.end(), [](const DrawPacket& a, const DrawPacket& b)
+	{
+		return a.material != b.material ? a.material < b.material : a.sortKey < b.sortKey;
+	});
+	visibleCount = packets.size();
+	culledCount = count - visibleCount;
+}
+
+
+// Records the draws of packets in parallel, one command buffer per chunk of packets
+void DrawList::Record(Shader& shader, Camera& camera)
+{
+	GeometryArena& arena = GeometryArena::Shared();
+
+	// Everything that is the same for all packets is set once
+	setupCommands.Reset();
+	setupCommands.UseProgram(shader.ID);
+	setupCommands.BindVertexArray(arena.vertexArray.ID);
+	setupCommands.Uniform3f(shader.Uniform("camPos"), camera.Position);
+	camera.Matrix(setupCommands, shader, "camMatrix");
+	glm::mat4 identity = glm::mat4(1.0f);
+	setupCommands.UniformMatrix4f(shader.Uniform("translation"), identity);
+	setupCommands.UniformMatrix4f(shader.Uniform("rotation"), identity);
+	setupCommands.UniformMatrix4f(shader.Uniform("scale"), identity);
+	GLint modelLocation = shader.Uniform("model");
+
+	recordedChunks = (packets.size() + chunkSize - 1) / chunkSize;
+	while (chunkCommands.size() < recordedChunks)
+	{
+		chunkCommands.emplace_back(new CommandBuffer());
+	}
+
+	ParallelFor(packets.size(), chunkSize, [&](size_t chunk, size_t begin, size_t end)
+	{
+		CommandBuffer& commands = *chunkCommands[chunk];
+		commands.Reset();
+		// Packets are sorted by material, so the bindings only change between runs of the same material.
+		// Every chunk binds its first material itself since it can't know what the chunk before ends with
+		for (size_t p = begin; p < end; p++)
+		{
+			const DrawPacket& packet = packets[p];
+			if (p == begin || !packets[p - 1].mesh->material.SameBindings(packet.mesh->material))
+			{
+				packet.mesh->material.Bind(commands);
+			}
+			commands.UniformMatrix4f(modelLocation, packet.model);
+			const GeometryRange& range = arena.Get(packet.mesh->geometry);
+			commands.DrawIndexed(range.indexCount, range.firstIndex, range.baseVertex);
+		}
+	});
+}
+
+
+// Records the draws and replays them, has to run on the thread that owns the OpenGL context
+void DrawList::Submit(Shader& shader, Camera& camera)
+{
+	if (packets.empty())
+	{
+		return;
+	}
+	Record(shader, camera);
+	ExecuteCommands(setupCommands);
+	for (size_t c = 0; c < recordedChunks; c++)
+	{
+		ExecuteCommands(*chunkCommands[c]);
+	}
+}
@@ -0,0 +1,68 @@
+#ifndef DRAW_LIST_CLASS_H
+#define DRAW_LIST_CLASS_H
+
+#include<cstdint>
+#include<memory>
+
+#include"Mesh.h"
+#include"Registry.h"
+#include"Components.h"
+#include"CommandBuffer.h"
+
+
+// Everything the context thread needs to issue one draw
+struct DrawPacket
+{
+	// Sorted ascending by the bindings of the material, then by sortKey: depth front to back, then the place in the registry
+	uint64_t material;
+	uint64_t sortKey;
+	Mesh* mesh;
+	glm::mat4 model;
+	// 0 is full detail, higher levels cover fewer pixels
+	unsigned int lod;
+};
+
+
+// Builds the list of draws of a frame from a Registry. Culling, LOD selection, sort keys and the
+// packets themselves are computed in parallel over chunks of entities. The chunks are merged in
+// order and the keys are unique, so the list comes out the same no matter how many cores ran it
+class DrawList
+{
+public:
+	std::vector<DrawPacket> packets;
+
+	// Number of entities that were drawn and skipped in the last Build
+	unsigned int visibleCount = 0;
+	unsigned int culledCount = 0;
+
+	// Objects smaller than this many pixels on screen (bounding sphere radius) are skipped
+	float minPixelRadius = 1.0f;
+	// Every LOD level halves the pixel radius the level before it started at
+	float lodPixelRadius = 200.0f;
+	unsigned int maxLod = 3;
+
+	// Entities handed to one job
+	size_t chunkSize = 1024;
+
+	// Fills packets for the camera, can run while nothing else changes the registry
+	void Build(Registry& registry, Camera& camera);
+	// Records the draws of packets in parallel, one command buffer per chunk of packets
+	void Record(Shader& shader, Camera& camera);
+	// Records the draws and replays them, has to run on the thread that owns the OpenGL context
+	void Submit(Shader& shader, Camera& camera);
+
+	// State shared by all packets followed by the commands of every chunk, valid after Record
+	const CommandBuffer& SetupCommands() const { return setupCommands; }
+	size_t CommandChunkCount() const { return recordedChunks; }
+	const CommandBuffer& ChunkCommands(size_t chunk) const { return *chunkCommands[chunk]; }
+
+private:
+	// Output of every chunk, kept between frames so the storage is reused
+	std::vector<std::vector<DrawPacket>> chunkPackets;
+	// Command buffers are kept between frames as well, so recording doesn't allocate once they are big enough
+	CommandBuffer setupCommands;
+	std::vector<std::unique_ptr<CommandBuffer>> chunkCommands;
+	size_t recordedChunks = 0;
+};
+
+#endif
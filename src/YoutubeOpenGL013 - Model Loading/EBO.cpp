@@ -1,13 +1,35 @@
+#include<cstddef>
 #include "EBO.h"
 
 // Constructor that generates a Elements Buffer Object and links it to indices
 EBO::EBO(std::vector<GLuint>& indices)
 {
+	// With DSA the buffer gets immutable storage without touching the bound VAO
+	if (GLCaps.directStateAccess)
+	{
+		glCreateBuffers(1, &ID);
+		glNamedBufferStorage(ID, indices.size() * sizeof(GLuint), indices.data(), 0);
+		return;
+	}
 	glGenBuffers(1, &ID);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
 }
 
+// Constructor that generates an empty Elements Buffer Object of a size in bytes
+EBO::EBO(GLsizeiptr size)
+{
+	if (GLCaps.directStateAccess)
+	{
+		glCreateBuffers(1, &ID);
+		glNamedBufferStorage(ID, size, NULL, GL_DYNAMIC_STORAGE_BIT);
+		return;
+	}
+	glGenBuffers(1, &ID);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, NULL, GL_STATIC_DRAW);
+}
+
 // Binds the EBO
 void EBO::Bind()
 {
@@ -1,9 +1,10 @@
 #ifndef EBO_CLASS_H
 #define EBO_CLASS_H
 
-#include<glad/glad.h>
 #include<vector>
 
+#include"GLExtensions.h"
+
 class EBO
 {
 public:
@@ -11,6 +12,8 @@ public:
 	GLuint ID;
 	// Constructor that generates a Elements Buffer Object and links it to indices
 	EBO(std::vector<GLuint>& indices);
+	// Constructor that generates an empty Elements Buffer Object of a size in bytes
+	EBO(GLsizeiptr size);
 
 	// Binds the EBO
 	void Bind();
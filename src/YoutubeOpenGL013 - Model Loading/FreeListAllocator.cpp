@@ -0,0 +1,134 @@
+#include"FreeListAllocator.h"
+
+// Constructor that starts with one free range covering the whole capacity
+FreeListAllocator::FreeListAllocator(size_t capacity)
+{
+	FreeListAllocator::capacity = capacity;
+	freeBytes = 0;
+	insertFree(0, capacity);
+}
+
+// Finds the smallest free range that fits size bytes starting at a multiple of alignment
+size_t FreeListAllocator::Allocate(size_t size, size_t alignment)
+{
+	if (size == 0 || alignment == 0)
+	{
+		return InvalidOffset;
+	}
+
+	// Best fit keeps the large ranges intact for large meshes
+	std::map<size_t, size_t>::iterator best = freeBlocks.end();
+	size_t bestWaste = (size_t)-1;
+	for (std::map<size_t, size_t>::iterator it = freeBlocks.begin(); it != freeBlocks.end(); ++it)
+	{
+		size_t aligned = (it->first + alignment - 1) / alignment * alignment;
+		size_t padding = aligned - it->first;
+		if (it->second < padding + size)
+		{
+			continue;
+		}
+		size_t waste = it->second - size;
+		if (waste < bestWaste)
+		{
+			best = it;
+			bestWaste = waste;
+			if (waste == padding)
+			{
+				break;
+			}
+		}
+	}
+	if (best == freeBlocks.end())
+	{
+		return InvalidOffset;
+	}
+
+	size_t blockOffset = best->first;
+	size_t blockSize = best->second;
+	size_t aligned = (blockOffset + alignment - 1) / alignment * alignment;
+	freeBlocks.erase(best);
+	freeBytes -= blockSize;
+
+	// Whatever is left in front of or behind the allocation stays free
+	if (aligned > blockOffset)
+	{
+		insertFree(blockOffset, aligned - blockOffset);
+	}
+	if (blockOffset + blockSize > aligned + size)
+	{
+		insertFree(aligned + size, blockOffset + blockSize - aligned - size);
+	}
+	return aligned;
+}
+
+// Gives back a range returned by Allocate
+void FreeListAllocator::Free(size_t offset, size_t size)
+{
+	if (size == 0)
+	{
+		return;
+	}
+	insertFree(offset, size);
+}
+
+// Extends the address space, the new bytes are free
+void FreeListAllocator::Grow(size_t newCapacity)
+{
+	if (newCapacity <= capacity)
+	{
+		return;
+	}
+	size_t oldCapacity = capacity;
+	capacity = newCapacity;
+	insertFree(oldCapacity, newCapacity - oldCapacity);
+}
+
+// Marks [0, used) as allocated and everything after it as free, used after compacting
+void FreeListAllocator::Reset(size_t used)
+{
+	freeBlocks.clear();
+	freeBytes = 0;
+	if (used < capacity)
+	{
+		insertFree(used, capacity - used);
+	}
+}
+
+size_t FreeListAllocator::LargestFreeBlock() const
+{
+	size_t largest = 0;
+	for (std::map<size_t, size_t>::const_iterator it = freeBlocks.begin(); it != freeBlocks.end(); ++it)
+	{
+		if (it->second > largest)
+		{
+			largest = it->second;
+		}
+	}
+	return largest;
+}
+
+// Adds a free range and merges it with its neighbours
+void FreeListAllocator::insertFree(size_t offset, size_t size)
+{
+	freeBytes += size;
+
+	std::map<size_t, size_t>::iterator next = freeBlocks.lower_bound(offset);
+	// Merge with the range right behind this one
+	if (next != freeBlocks.end() && offset + size == next->first)
+	{
+		size += next->second;
+		next = freeBlocks.erase(next);
+	}
+	// Merge with the range right in front of this one
+	if (next != freeBlocks.begin())
+	{
+		std::map<size_t, size_t>::iterator prev = next;
+		--prev;
+		if (prev->first + prev->second == offset)
+		{
+			prev->second += size;
+			return;
+		}
+	}
+	freeBlocks.insert(next, std::make_pair(offset, size));
+}
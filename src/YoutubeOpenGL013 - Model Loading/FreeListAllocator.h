@@ -0,0 +1,44 @@
+#ifndef FREE_LIST_ALLOCATOR_CLASS_H
+#define FREE_LIST_ALLOCATOR_CLASS_H
+
+#include<cstddef>
+#include<map>
+
+
+// Hands out ranges of a fixed address space (for example a big GL buffer)
+// and coalesces neighbouring free ranges when they are given back.
+// It never touches the memory itself, so it works without an OpenGL context
+class FreeListAllocator
+{
+public:
+	// Returned by Allocate when no free range is large enough
+	static const size_t InvalidOffset = (size_t)-1;
+
+	// Constructor that starts with one free range covering the whole capacity
+	FreeListAllocator(size_t capacity);
+
+	// Finds the smallest free range that fits size bytes starting at a multiple of alignment
+	size_t Allocate(size_t size, size_t alignment = 1);
+	// Gives back a range returned by Allocate
+	void Free(size_t offset, size_t size);
+	// Extends the address space, the new bytes are free
+	void Grow(size_t newCapacity);
+	// Marks [0, used) as allocated and everything after it as free, used after compacting
+	void Reset(size_t used);
+
+	size_t Capacity() const { return capacity; }
+	size_t FreeBytes() const { return freeBytes; }
+	size_t FreeBlockCount() const { return freeBlocks.size(); }
+	size_t LargestFreeBlock() const;
+
+private:
+	size_t capacity;
+	size_t freeBytes;
+	// Free ranges sorted by offset, maps offset to size
+	std::map<size_t, size_t> freeBlocks;
+
+	// Adds a free range and merges it with its neighbours
+	void insertFree(size_t offset, size_t size);
+};
+
+#endif
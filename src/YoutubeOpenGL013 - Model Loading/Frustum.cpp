@@ -0,0 +1,92 @@
+#include"Frustum.h"
+
+// Extracts the planes from a projection * view matrix such as Camera::cameraMatrix
+Frustum::Frustum(const glm::mat4& cameraMatrix)
+{
+	// glm is column major, so the rows of the matrix are gathered first
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++)
+	{
+		rows[i] = glm::vec4(cameraMatrix[0][i], cameraMatrix[1][i], cameraMatrix[2][i], cameraMatrix[3][i]);
+	}
+
+	// Gribb/Hartmann extraction for OpenGL clip space where -w <= x, y, z <= w
+	planes[0] = rows[3] + rows[0];
+	planes[1] = rows[3] - rows[0];
+	planes[2] = rows[3] + rows[1];
+	planes[3] = rows[3] - rows[1];
+	planes[4] = rows[3] + rows[2];
+	planes[5] = rows[3] - rows[2];
+
+	// Normalizes the planes so the distances are in world units
+	for (int i = 0; i < 6; i++)
+	{
+		planes[i] /= glm::length(glm::vec3(planes[i]));
+	}
+}
+
+// Checks if any part of a sphere could be visible
+bool Frustum::Intersects(const BoundingSphere& sphere) const
+{
+	for (int i = 0; i < 6; i++)
+	{
+		if (glm::dot(glm::vec3(planes[i]), sphere.center) + planes[i].w < -sphere.radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Checks if any part of a box could be visible
+bool Frustum::Intersects(const AABB& box) const
+{
+	for (int i = 0; i < 6; i++)
+	{
+		// The corner furthest along the plane normal is the last one to leave the frustum
+		glm::vec3 normal = glm::vec3(planes[i]);
+		glm::vec3 corner = glm::vec3
+		(
+			normal.x >= 0.0f ? box.max.x : box.min.x,
+			normal.y >= 0.0f ? box.max.y : box.min.y,
+			normal.z >= 0.0f ? box.max.z : box.min.z
+		);
+		if (glm::dot(normal, corner) + planes[i].w < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Tells apart boxes that are completely inside, so hierarchies can skip testing their children
+FrustumResult Frustum::Classify(const AABB& box) const
+{
+	FrustumResult result = FRUSTUM_INSIDE;
+	for (int i = 0; i < 6; i++)
+	{
+		// Furthest corner along the normal decides outside, the nearest one decides inside
+		glm::vec3 normal = glm::vec3(planes[i]);
+		glm::vec3 furthest = glm::vec3
+		(
+			normal.x >= 0.0f ? box.max.x : box.min.x,
+			normal.y >= 0.0f ? box.max.y : box.min.y,
+			normal.z >= 0.0f ? box.max.z : box.min.z
+		);
+		glm::vec3 nearest = glm::vec3
+		(
+			normal.x >= 0.0f ? box.min.x : box.max.x,
+			normal.y >= 0.0f ? box.min.y : box.max.y,
+			normal.z >= 0.0f ? box.min.z : box.max.z
+		);
+		if (glm::dot(normal, furthest) + planes[i].w < 0.0f)
+		{
+			return FRUSTUM_OUTSIDE;
+		}
+		if (glm::dot(normal, nearest) + planes[i].w < 0.0f)
+		{
+			result = FRUSTUM_INTERSECTS;
+		}
+	}
+	return result;
+}
@@ -0,0 +1,36 @@
+#ifndef FRUSTUM_CLASS_H
+#define FRUSTUM_CLASS_H
+
+#include<glm/glm.hpp>
+
+#include"Bounds.h"
+
+
+// Result of testing a volume against all six planes
+enum FrustumResult
+{
+	FRUSTUM_OUTSIDE,
+	FRUSTUM_INTERSECTS,
+	FRUSTUM_INSIDE
+};
+
+
+// The six planes of a camera's view volume, normals point inwards
+class Frustum
+{
+public:
+	// Planes stored as (normal, distance), in the order left, right, bottom, top, near, far
+	glm::vec4 planes[6];
+
+	// Extracts the planes from a projection * view matrix such as Camera::cameraMatrix
+	Frustum(const glm::mat4& cameraMatrix);
+
+	// Checks if any part of a sphere could be visible
+	bool Intersects(const BoundingSphere& sphere) const;
+	// Checks if any part of a box could be visible
+	bool Intersects(const AABB& box) const;
+	// Tells apart boxes that are completely inside, so hierarchies can skip testing their children
+	FrustumResult Classify(const AABB& box) const;
+};
+
+#endif
@@ -0,0 +1,333 @@
+#include"FrustumCulling.h"
+
+#include<algorithm>
+#include<atomic>
+#include<cmath>
+
+// The SSE2 path is always there on x86-64. The AVX2 path is compiled for AVX2 on its own through
+// the target attribute, the rest of the file stays SSE2, and it only runs when CPUID reports AVX2
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include<immintrin.h>
+#define CULLING_HAS_SSE2
+#if defined(__GNUC__)
+#define CULLING_HAS_AVX2
+#define CULLING_AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(_MSC_VER)
+#include<intrin.h>
+#define CULLING_HAS_AVX2
+#define CULLING_AVX2_TARGET
+#endif
+#endif
+
+
+// Best path the CPU supports, checked once with CPUID
+CullingPath SupportedCullingPath()
+{
+#if defined(CULLING_HAS_AVX2) && defined(__GNUC__)
+	static const CullingPath supported = __builtin_cpu_supports("avx2") ? CULLING_AVX2 : CULLING_SSE2;
+	return supported;
+#elif defined(CULLING_HAS_AVX2)
+	static const CullingPath supported = []()
+	{
+		// AVX2 needs the CPU to have it and the OS to save the YMM registers
+		int info[4];
+		__cpuid(info, 1);
+		bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+		__cpuidex(info, 7, 0);
+		return osSavesYmm && (info[1] & (1 << 5)) != 0 ? CULLING_AVX2 : CULLING_SSE2;
+	}();
+	return supported;
+#elif defined(CULLING_HAS_SSE2)
+	return CULLING_SSE2;
+#else
+	return CULLING_SCALAR;
+#endif
+}
+
+// Path picked with SetCullingPath, -1 until then
+static std::atomic<int> chosenPath(-1);
+
+// Path used by CullSpheres and CullBoxes, starts at SupportedCullingPath
+CullingPath CurrentCullingPath()
+{
+	int chosen = chosenPath.load(std::memory_order_relaxed);
+	return chosen < 0 ? SupportedCullingPath() : (CullingPath)chosen;
+}
+
+// Paths the CPU doesn't support are lowered to the best one it does
+void SetCullingPath(CullingPath path)
+{
+	chosenPath.store(std::min(path, SupportedCullingPath()), std::memory_order_relaxed);
+}
+
+
+// Appends the bounds of one object, its index is the previous Size()
+void BoundsSoA::Push(const AABB& box, const BoundingSphere& sphere)
+{
+	glm::vec3 center = box.Center();
+	glm::vec3 extents = box.Extents();
+	centerX.push_back(center.x);
+	centerY.push_back(center.y);
+	centerZ.push_back(center.z);
+	extentX.push_back(extents.x);
+	extentY.push_back(extents.y);
+	extentZ.push_back(extents.z);
+	sphereX.push_back(sphere.center.x);
+	sphereY.push_back(sphere.center.y);
+	sphereZ.push_back(sphere.center.z);
+	radius.push_back(sphere.radius);
+}
+
+// Replaces the bounds of an object that moved
+void BoundsSoA::Set(unsigned int index, const AABB& box, const BoundingSphere& sphere)
+{
+	glm::vec3 center = box.Center();
+	glm::vec3 extents = box.Extents();
+	centerX[index] = center.x;
+	centerY[index] = center.y;
+	centerZ[index] = center.z;
+	extentX[index] = extents.x;
+	extentY[index] = extents.y;
+	extentZ[index] = extents.z;
+	sphereX[index] = sphere.center.x;
+	sphereY[index] = sphere.center.y;
+	sphereZ[index] = sphere.center.z;
+	radius[index] = sphere.radius;
+}
+
+void BoundsSoA::Clear()
+{
+	centerX.clear(); centerY.clear(); centerZ.clear();
+	extentX.clear(); extentY.clear(); extentZ.clear();
+	sphereX.clear(); sphereY.clear(); sphereZ.clear();
+	radius.clear();
+}
+
+
+// Scalar test of one object, used for the tail of a batch and when there is no SIMD.
+// A box with center c and half size e is outside a plane when dot(n, c) + dot(|n|, e) + w < 0
+static bool boxVisible(const Frustum& frustum, const BoundsSoA& bounds, size_t i)
+{
+	for (int p = 0; p < 6; p++)
+	{
+		const glm::vec4& plane = frustum.planes[p];
+		float distance = plane.x * bounds.centerX[i] + plane.y * bounds.centerY[i] + plane.z * bounds.centerZ[i] + plane.w;
+		float reach = std::fabs(plane.x) * bounds.extentX[i] + std::fabs(plane.y) * bounds.extentY[i] + std::fabs(plane.z) * bounds.extentZ[i];
+		if (distance + reach < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool sphereVisible(const Frustum& frustum, const BoundsSoA& bounds, size_t i)
+{
+	for (int p = 0; p < 6; p++)
+	{
+		const glm::vec4& plane = frustum.planes[p];
+		float distance = plane.x * bounds.sphereX[i] + plane.y * bounds.sphereY[i] + plane.z * bounds.sphereZ[i] + plane.w;
+		if (distance < -bounds.radius[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+#if defined(CULLING_HAS_AVX2)
+// 8 spheres per step, returns where it stopped
+CULLING_AVX2_TARGET static size_t cullSpheresAVX2(const Frustum& frustum, const BoundsSoA& bounds, size_t i, size_t end, std::vector<unsigned int>& visible)
+{
+	__m256 zero = _mm256_setzero_ps();
+	for (; i + 8 <= end; i += 8)
+	{
+		__m256 x = _mm256_loadu_ps(&bounds.sphereX[i]);
+		__m256 y = _mm256_loadu_ps(&bounds.sphereY[i]);
+		__m256 z = _mm256_loadu_ps(&bounds.sphereZ[i]);
+		__m256 r = _mm256_loadu_ps(&bounds.radius[i]);
+		__m256 outside = zero;
+		for (int p = 0; p < 6; p++)
+		{
+			const glm::vec4& plane = frustum.planes[p];
+			__m256 distance = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.x), x), _mm256_mul_ps(_mm256_set1_ps(plane.y), y)),
+				_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.z), z), _mm256_set1_ps(plane.w)));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, r), zero, _CMP_LT_OQ));
+		}
+		int mask = ~_mm256_movemask_ps(outside) & 0xFF;
+		for (int lane = 0; lane < 8; lane++)
+		{
+			if (mask & (1 << lane))
+			{
+				visible.push_back(i + lane);
+			}
+		}
+	}
+	return i;
+}
+#endif
+
+#if defined(CULLING_HAS_SSE2)
+// 4 spheres per step, returns where it stopped
+static size_t cullSpheresSSE2(const Frustum& frustum, const BoundsSoA& bounds, size_t i, size_t end, std::vector<unsigned int>& visible)
+{
+	__m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= end; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(&bounds.sphereX[i]);
+		__m128 y = _mm_loadu_ps(&bounds.sphereY[i]);
+		__m128 z = _mm_loadu_ps(&bounds.sphereZ[i]);
+		__m128 r = _mm_loadu_ps(&bounds.radius[i]);
+		__m128 outside = zero;
+		for (int p = 0; p < 6; p++)
+		{
+			const glm::vec4& plane = frustum.planes[p];
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), x), _mm_mul_ps(_mm_set1_ps(plane.y), y)),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), z), _mm_set1_ps(plane.w)));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, r), zero));
+		}
+		int mask = ~_mm_movemask_ps(outside) & 0xF;
+		for (int lane = 0; lane < 4; lane++)
+		{
+			if (mask & (1 << lane))
+			{
+				visible.push_back(i + lane);
+			}
+		}
+	}
+	return i;
+}
+#endif
+
+// Writes the indices of the spheres in [begin, end) that touch the frustum to visible, in increasing order
+void CullSpheres(const Frustum& frustum, const BoundsSoA& bounds, size_t begin, size_t end, std::vector<unsigned int>& visible)
+{
+	size_t i = begin;
+	CullingPath path = CurrentCullingPath();
+#if defined(CULLING_HAS_AVX2)
+	if (path == CULLING_AVX2)
+	{
+		i = cullSpheresAVX2(frustum, bounds, i, end, visible);
+	}
+#endif
+#if defined(CULLING_HAS_SSE2)
+	// Also takes the last few the AVX2 loop left
+	if (path >= CULLING_SSE2)
+	{
+		i = cullSpheresSSE2(frustum, bounds, i, end, visible);
+	}
+#endif
+	for (; i < end; i++)
+	{
+		if (sphereVisible(frustum, bounds, i))
+		{
+			visible.push_back(i);
+		}
+	}
+}
+
+#if defined(CULLING_HAS_AVX2)
+// 8 boxes per step, returns where it stopped
+CULLING_AVX2_TARGET static size_t cullBoxesAVX2(const Frustum& frustum, const BoundsSoA& bounds, size_t i, size_t end, std::vector<unsigned int>& visible)
+{
+	__m256 zero = _mm256_setzero_ps();
+	for (; i + 8 <= end; i += 8)
+	{
+		__m256 cx = _mm256_loadu_ps(&bounds.centerX[i]);
+		__m256 cy = _mm256_loadu_ps(&bounds.centerY[i]);
+		__m256 cz = _mm256_loadu_ps(&bounds.centerZ[i]);
+		__m256 ex = _mm256_loadu_ps(&bounds.extentX[i]);
+		__m256 ey = _mm256_loadu_ps(&bounds.extentY[i]);
+		__m256 ez = _mm256_loadu_ps(&bounds.extentZ[i]);
+		__m256 outside = zero;
+		for (int p = 0; p < 6; p++)
+		{
+			const glm::vec4& plane = frustum.planes[p];
+			__m256 distance = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.x), cx), _mm256_mul_ps(_mm256_set1_ps(plane.y), cy)),
+				_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.z), cz), _mm256_set1_ps(plane.w)));
+			__m256 reach = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.x)), ex), _mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.y)), ey)),
+				_mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.z)), ez));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), zero, _CMP_LT_OQ));
+		}
+		int mask = ~_mm256_movemask_ps(outside) & 0xFF;
+		for (int lane = 0; lane < 8; lane++)
+		{
+			if (mask & (1 << lane))
+			{
+				visible.push_back(i + lane);
+			}
+		}
+	}
+	return i;
+}
+#endif
+
+#if defined(CULLING_HAS_SSE2)
+// 4 boxes per step, returns where it stopped
+static size_t cullBoxesSSE2(const Frustum& frustum, const BoundsSoA& bounds, size_t i, size_t end, std::vector<unsigned int>& visible)
+{
+	__m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= end; i += 4)
+	{
+		__m128 cx = _mm_loadu_ps(&bounds.centerX[i]);
+		__m128 cy = _mm_loadu_ps(&bounds.centerY[i]);
+		__m128 cz = _mm_loadu_ps(&bounds.centerZ[i]);
+		__m128 ex = _mm_loadu_ps(&bounds.extentX[i]);
+		__m128 ey = _mm_loadu_ps(&bounds.extentY[i]);
+		__m128 ez = _mm_loadu_ps(&bounds.extentZ[i]);
+		__m128 outside = zero;
+		for (int p = 0; p < 6; p++)
+		{
+			const glm::vec4& plane = frustum.planes[p];
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), cx), _mm_mul_ps(_mm_set1_ps(plane.y), cy)),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), cz), _mm_set1_ps(plane.w)));
+			__m128 reach = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::fabs(plane.x)), ex), _mm_mul_ps(_mm_set1_ps(std::fabs(plane.y)), ey)),
+				_mm_mul_ps(_mm_set1_ps(std::fabs(plane.z)), ez));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), zero));
+		}
+		int mask = ~_mm_movemask_ps(outside) & 0xF;
+		for (int lane = 0; lane < 4; lane++)
+		{
+			if (mask & (1 << lane))
+			{
+				visible.push_back(i + lane);
+			}
+		}
+	}
+	return i;
+}
+#endif
+
+// Writes the indices of the boxes in [begin, end) that touch the frustum to visible, in increasing order
+void CullBoxes(const Frustum& frustum, const BoundsSoA& bounds, size_t begin, size_t end, std::vector<unsigned int>& visible)
+{
+	size_t i = begin;
+	CullingPath path = CurrentCullingPath();
+#if defined(CULLING_HAS_AVX2)
+	if (path == CULLING_AVX2)
+	{
+		i = cullBoxesAVX2(frustum, bounds, i, end, visible);
+	}
+#endif
+#if defined(CULLING_HAS_SSE2)
+	// Also takes the last few the AVX2 loop left
+	if (path >= CULLING_SSE2)
+	{
+		i = cullBoxesSSE2(frustum, bounds, i, end, visible);
+	}
+#endif
+	for (; i < end; i++)
+	{
+		if (boxVisible(frustum, bounds, i))
+		{
+			visible.push_back(i);
+		}
+	}
+}
@@ -0,0 +1,48 @@
+#ifndef FRUSTUM_CULLING_CLASS_H
+#define FRUSTUM_CULLING_CLASS_H
+
+#include<vector>
+
+#include"Frustum.h"
+
+
+// Bounds of many objects stored as separate arrays (structure of arrays), so the
+// culling loops can load 4 or 8 objects per instruction instead of one glm::vec3 at a time
+class BoundsSoA
+{
+public:
+	// Box centers and half sizes
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> extentX, extentY, extentZ;
+	// Sphere around the same object
+	std::vector<float> sphereX, sphereY, sphereZ, radius;
+
+	// Appends the bounds of one object, its index is the previous Size()
+	void Push(const AABB& box, const BoundingSphere& sphere);
+	// Replaces the bounds of an object that moved
+	void Set(unsigned int index, const AABB& box, const BoundingSphere& sphere);
+	void Clear();
+	size_t Size() const { return centerX.size(); }
+};
+
+// Widest instruction set the culling loops use, 8 objects per step with AVX2 and 4 with SSE2
+enum CullingPath
+{
+	CULLING_SCALAR,
+	CULLING_SSE2,
+	CULLING_AVX2
+};
+
+// Best path the CPU supports, checked once with CPUID
+CullingPath SupportedCullingPath();
+// Path used by CullSpheres and CullBoxes, starts at SupportedCullingPath
+CullingPath CurrentCullingPath();
+// Lowers the path to compare the paths against each other, paths the CPU doesn't support are never picked
+void SetCullingPath(CullingPath path);
+
+// Writes the indices of the spheres in [begin, end) that touch the frustum to visible, in increasing order
+void CullSpheres(const Frustum& frustum, const BoundsSoA& bounds, size_t begin, size_t end, std::vector<unsigned int>& visible);
+// Writes the indices of the boxes in [begin, end) that touch the frustum to visible, in increasing order
+void CullBoxes(const Frustum& frustum, const BoundsSoA& bounds, size_t begin, size_t end, std::vector<unsigned int>& visible);
+
+#endif
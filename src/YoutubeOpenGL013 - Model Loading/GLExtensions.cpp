@@ -0,0 +1,121 @@
+#include"GLExtensions.h"
+
+#include<cstring>
+
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glext_glMultiDrawElementsIndirect = NULL;
+PFNGLBUFFERSTORAGEPROC glext_glBufferStorage = NULL;
+PFNGLCREATEBUFFERSPROC glext_glCreateBuffers = NULL;
+PFNGLNAMEDBUFFERSTORAGEPROC glext_glNamedBufferStorage = NULL;
+PFNGLNAMEDBUFFERSUBDATAPROC glext_glNamedBufferSubData = NULL;
+PFNGLCOPYNAMEDBUFFERSUBDATAPROC glext_glCopyNamedBufferSubData = NULL;
+PFNGLMAPNAMEDBUFFERRANGEPROC glext_glMapNamedBufferRange = NULL;
+PFNGLUNMAPNAMEDBUFFERPROC glext_glUnmapNamedBuffer = NULL;
+PFNGLCREATEVERTEXARRAYSPROC glext_glCreateVertexArrays = NULL;
+PFNGLVERTEXARRAYVERTEXBUFFERPROC glext_glVertexArrayVertexBuffer = NULL;
+PFNGLVERTEXARRAYELEMENTBUFFERPROC glext_glVertexArrayElementBuffer = NULL;
+PFNGLVERTEXARRAYATTRIBFORMATPROC glext_glVertexArrayAttribFormat = NULL;
+PFNGLVERTEXARRAYATTRIBBINDINGPROC glext_glVertexArrayAttribBinding = NULL;
+PFNGLENABLEVERTEXARRAYATTRIBPROC glext_glEnableVertexArrayAttrib = NULL;
+PFNGLCREATETEXTURESPROC glext_glCreateTextures = NULL;
+PFNGLTEXTURESTORAGE2DPROC glext_glTextureStorage2D = NULL;
+PFNGLTEXTURESUBIMAGE2DPROC glext_glTextureSubImage2D = NULL;
+PFNGLTEXTUREPARAMETERIPROC glext_glTextureParameteri = NULL;
+PFNGLGENERATETEXTUREMIPMAPPROC glext_glGenerateTextureMipmap = NULL;
+PFNGLBINDTEXTUREUNITPROC glext_glBindTextureUnit = NULL;
+PFNGLGETTEXTUREHANDLEARBPROC glext_glGetTextureHandleARB = NULL;
+PFNGLGETTEXTURESAMPLERHANDLEARBPROC glext_glGetTextureSamplerHandleARB = NULL;
+PFNGLMAKETEXTUREHANDLERESIDENTARBPROC glext_glMakeTextureHandleResidentARB = NULL;
+PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC glext_glMakeTextureHandleNonResidentARB = NULL;
+
+GLCapabilities GLCaps;
+
+// Checks if the current context advertises an extension
+bool hasGLExtension(const char* name)
+{
+	GLint numExtensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+	for (GLint i = 0; i < numExtensions; i++)
+	{
+		const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+		if (extension != NULL && std::strcmp(extension, name) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Loads the entry points and fills GLCaps, call once right after gladLoadGL()
+void loadGLExtensions()
+{
+	GLCaps.major = GLVersion.major;
+	GLCaps.minor = GLVersion.minor;
+	int version = GLCaps.major * 10 + GLCaps.minor;
+
+	glext_glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)glfwGetProcAddress("glMultiDrawElementsIndirect");
+	glext_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)glfwGetProcAddress("glBufferStorage");
+	glext_glCreateBuffers = (PFNGLCREATEBUFFERSPROC)glfwGetProcAddress("glCreateBuffers");
+	glext_glNamedBufferStorage = (PFNGLNAMEDBUFFERSTORAGEPROC)glfwGetProcAddress("glNamedBufferStorage");
+	glext_glNamedBufferSubData = (PFNGLNAMEDBUFFERSUBDATAPROC)glfwGetProcAddress("glNamedBufferSubData");
+	glext_glCopyNamedBufferSubData = (PFNGLCOPYNAMEDBUFFERSUBDATAPROC)glfwGetProcAddress("glCopyNamedBufferSubData");
+	glext_glMapNamedBufferRange = (PFNGLMAPNAMEDBUFFERRANGEPROC)glfwGetProcAddress("glMapNamedBufferRange");
+	glext_glUnmapNamedBuffer = (PFNGLUNMAPNAMEDBUFFERPROC)glfwGetProcAddress("glUnmapNamedBuffer");
+	glext_glCreateVertexArrays = (PFNGLCREATEVERTEXARRAYSPROC)glfwGetProcAddress("glCreateVertexArrays");
+	glext_glVertexArrayVertexBuffer = (PFNGLVERTEXARRAYVERTEXBUFFERPROC)glfwGetProcAddress("glVertexArrayVertexBuffer");
+	glext_glVertexArrayElementBuffer = (PFNGLVERTEXARRAYELEMENTBUFFERPROC)glfwGetProcAddress("glVertexArrayElementBuffer");
+	glext_glVertexArrayAttribFormat = (PFNGLVERTEXARRAYATTRIBFORMATPROC)glfwGetProcAddress("glVertexArrayAttribFormat");
+	glext_glVertexArrayAttribBinding = (PFNGLVERTEXARRAYATTRIBBINDINGPROC)glfwGetProcAddress("glVertexArrayAttribBinding");
+	glext_glEnableVertexArrayAttrib = (PFNGLENABLEVERTEXARRAYATTRIBPROC)glfwGetProcAddress("glEnableVertexArrayAttrib");
+	glext_glCreateTextures = (PFNGLCREATETEXTURESPROC)glfwGetProcAddress("glCreateTextures");
+	glext_glTextureStorage2D = (PFNGLTEXTURESTORAGE2DPROC)glfwGetProcAddress("glTextureStorage2D");
+	glext_glTextureSubImage2D = (PFNGLTEXTURESUBIMAGE2DPROC)glfwGetProcAddress("glTextureSubImage2D");
+	glext_glTextureParameteri = (PFNGLTEXTUREPARAMETERIPROC)glfwGetProcAddress("glTextureParameteri");
+	glext_glGenerateTextureMipmap = (PFNGLGENERATETEXTUREMIPMAPPROC)glfwGetProcAddress("glGenerateTextureMipmap");
+	glext_glBindTextureUnit = (PFNGLBINDTEXTUREUNITPROC)glfwGetProcAddress("glBindTextureUnit");
+	glext_glGetTextureHandleARB = (PFNGLGETTEXTUREHANDLEARBPROC)glfwGetProcAddress("glGetTextureHandleARB");
+	glext_glGetTextureSamplerHandleARB = (PFNGLGETTEXTURESAMPLERHANDLEARBPROC)glfwGetProcAddress("glGetTextureSamplerHandleARB");
+	glext_glMakeTextureHandleResidentARB = (PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)glfwGetProcAddress("glMakeTextureHandleResidentARB");
+	glext_glMakeTextureHandleNonResidentARB = (PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)glfwGetProcAddress("glMakeTextureHandleNonResidentARB");
+
+	// gl_DrawID is only core from GLSL 4.60 on
+	GLCaps.multiDrawIndirect = version >= 46 && glext_glMultiDrawElementsIndirect != NULL;
+	GLCaps.bufferStorage = (version >= 44 || hasGLExtension("GL_ARB_buffer_storage")) && glext_glBufferStorage != NULL;
+	GLCaps.directStateAccess = (version >= 45 || hasGLExtension("GL_ARB_direct_state_access"))
+		&& GLCaps.bufferStorage
+		&& glext_glCreateBuffers != NULL
+		&& glext_glNamedBufferStorage != NULL
+		&& glext_glNamedBufferSubData != NULL
+		&& glext_glCopyNamedBufferSubData != NULL
+		&& glext_glMapNamedBufferRange != NULL
+		&& glext_glUnmapNamedBuffer != NULL
+		&& glext_glCreateVertexArrays != NULL
+		&& glext_glVertexArrayVertexBuffer != NULL
+		&& glext_glVertexArrayElementBuffer != NULL
+		&& glext_glVertexArrayAttribFormat != NULL
+		&& glext_glVertexArrayAttribBinding != NULL
+		&& glext_glEnableVertexArrayAttrib != NULL
+		&& glext_glCreateTextures != NULL
+		&& glext_glTextureStorage2D != NULL
+		&& glext_glTextureSubImage2D != NULL
+		&& glext_glTextureParameteri != NULL
+		&& glext_glGenerateTextureMipmap != NULL
+		&& glext_glBindTextureUnit != NULL;
+
+	GLCaps.conservativeOcclusion = version >= 43 || hasGLExtension("GL_ARB_ES3_compatibility");
+	GLCaps.bindlessTexture = GLCaps.multiDrawIndirect && hasGLExtension("GL_ARB_bindless_texture")
+		&& glext_glGetTextureHandleARB != NULL
+		&& glext_glGetTextureSamplerHandleARB != NULL
+		&& glext_glMakeTextureHandleResidentARB != NULL
+		&& glext_glMakeTextureHandleNonResidentARB != NULL;
+
+	if (version >= 46 || hasGLExtension("GL_ARB_texture_filter_anisotropic") || hasGLExtension("GL_EXT_texture_filter_anisotropic"))
+	{
+		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &GLCaps.maxAnisotropy);
+	}
+
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &GLCaps.uniformBufferAlignment);
+	if (version >= 43)
+	{
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &GLCaps.storageBufferAlignment);
+	}
+}
@@ -0,0 +1,147 @@
+#ifndef GL_EXTENSIONS_CLASS_H
+#define GL_EXTENSIONS_CLASS_H
+
+#include<glad/glad.h>
+#include<glfw3.h>
+
+// The glad loader in include/ is generated for OpenGL 3.3 only, so every newer
+// entry point that the faster render paths need is declared and loaded here.
+// Each path checks GLCaps before using them and falls back to the 3.3 code.
+
+#ifndef GL_VERSION_4_3
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+#define GL_ANY_SAMPLES_PASSED_CONSERVATIVE 0x8D6A
+
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+#endif
+
+#ifndef GL_VERSION_4_4
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+#endif
+
+#ifndef GL_VERSION_4_5
+typedef void (APIENTRYP PFNGLCREATEBUFFERSPROC)(GLsizei n, GLuint* buffers);
+typedef void (APIENTRYP PFNGLNAMEDBUFFERSTORAGEPROC)(GLuint buffer, GLsizeiptr size, const void* data, GLbitfield flags);
+typedef void (APIENTRYP PFNGLNAMEDBUFFERSUBDATAPROC)(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data);
+typedef void (APIENTRYP PFNGLCOPYNAMEDBUFFERSUBDATAPROC)(GLuint readBuffer, GLuint writeBuffer, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size);
+typedef void* (APIENTRYP PFNGLMAPNAMEDBUFFERRANGEPROC)(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef GLboolean (APIENTRYP PFNGLUNMAPNAMEDBUFFERPROC)(GLuint buffer);
+typedef void (APIENTRYP PFNGLCREATEVERTEXARRAYSPROC)(GLsizei n, GLuint* arrays);
+typedef void (APIENTRYP PFNGLVERTEXARRAYVERTEXBUFFERPROC)(GLuint vaobj, GLuint bindingindex, GLuint buffer, GLintptr offset, GLsizei stride);
+typedef void (APIENTRYP PFNGLVERTEXARRAYELEMENTBUFFERPROC)(GLuint vaobj, GLuint buffer);
+typedef void (APIENTRYP PFNGLVERTEXARRAYATTRIBFORMATPROC)(GLuint vaobj, GLuint attribindex, GLint size, GLenum type, GLboolean normalized, GLuint relativeoffset);
+typedef void (APIENTRYP PFNGLVERTEXARRAYATTRIBBINDINGPROC)(GLuint vaobj, GLuint attribindex, GLuint bindingindex);
+typedef void (APIENTRYP PFNGLENABLEVERTEXARRAYATTRIBPROC)(GLuint vaobj, GLuint index);
+typedef void (APIENTRYP PFNGLCREATETEXTURESPROC)(GLenum target, GLsizei n, GLuint* textures);
+typedef void (APIENTRYP PFNGLTEXTURESTORAGE2DPROC)(GLuint texture, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+typedef void (APIENTRYP PFNGLTEXTURESUBIMAGE2DPROC)(GLuint texture, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels);
+typedef void (APIENTRYP PFNGLTEXTUREPARAMETERIPROC)(GLuint texture, GLenum pname, GLint param);
+typedef void (APIENTRYP PFNGLGENERATETEXTUREMIPMAPPROC)(GLuint texture);
+typedef void (APIENTRYP PFNGLBINDTEXTUREUNITPROC)(GLuint unit, GLuint texture);
+#endif
+
+#ifndef GL_VERSION_4_6
+#define GL_TEXTURE_MAX_ANISOTROPY 0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY 0x84FF
+#endif
+
+// Never core, only available as an extension
+#ifndef GL_ARB_bindless_texture
+typedef GLuint64 (APIENTRYP PFNGLGETTEXTUREHANDLEARBPROC)(GLuint texture);
+typedef GLuint64 (APIENTRYP PFNGLGETTEXTURESAMPLERHANDLEARBPROC)(GLuint texture, GLuint sampler);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)(GLuint64 handle);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)(GLuint64 handle);
+#endif
+
+// Entry points loaded through glfwGetProcAddress
+extern PFNGLMULTIDRAWELEMENTSINDIRECTPROC glext_glMultiDrawElementsIndirect;
+#define glMultiDrawElementsIndirect glext_glMultiDrawElementsIndirect
+extern PFNGLBUFFERSTORAGEPROC glext_glBufferStorage;
+#define glBufferStorage glext_glBufferStorage
+extern PFNGLCREATEBUFFERSPROC glext_glCreateBuffers;
+#define glCreateBuffers glext_glCreateBuffers
+extern PFNGLNAMEDBUFFERSTORAGEPROC glext_glNamedBufferStorage;
+#define glNamedBufferStorage glext_glNamedBufferStorage
+extern PFNGLNAMEDBUFFERSUBDATAPROC glext_glNamedBufferSubData;
+#define glNamedBufferSubData glext_glNamedBufferSubData
+extern PFNGLCOPYNAMEDBUFFERSUBDATAPROC glext_glCopyNamedBufferSubData;
+#define glCopyNamedBufferSubData glext_glCopyNamedBufferSubData
+extern PFNGLMAPNAMEDBUFFERRANGEPROC glext_glMapNamedBufferRange;
+#define glMapNamedBufferRange glext_glMapNamedBufferRange
+extern PFNGLUNMAPNAMEDBUFFERPROC glext_glUnmapNamedBuffer;
+#define glUnmapNamedBuffer glext_glUnmapNamedBuffer
+extern PFNGLCREATEVERTEXARRAYSPROC glext_glCreateVertexArrays;
+#define glCreateVertexArrays glext_glCreateVertexArrays
+extern PFNGLVERTEXARRAYVERTEXBUFFERPROC glext_glVertexArrayVertexBuffer;
+#define glVertexArrayVertexBuffer glext_glVertexArrayVertexBuffer
+extern PFNGLVERTEXARRAYELEMENTBUFFERPROC glext_glVertexArrayElementBuffer;
+#define glVertexArrayElementBuffer glext_glVertexArrayElementBuffer
+extern PFNGLVERTEXARRAYATTRIBFORMATPROC glext_glVertexArrayAttribFormat;
+#define glVertexArrayAttribFormat glext_glVertexArrayAttribFormat
+extern PFNGLVERTEXARRAYATTRIBBINDINGPROC glext_glVertexArrayAttribBinding;
+#define glVertexArrayAttribBinding glext_glVertexArrayAttribBinding
+extern PFNGLENABLEVERTEXARRAYATTRIBPROC glext_glEnableVertexArrayAttrib;
+#define glEnableVertexArrayAttrib glext_glEnableVertexArrayAttrib
+extern PFNGLCREATETEXTURESPROC glext_glCreateTextures;
+#define glCreateTextures glext_glCreateTextures
+extern PFNGLTEXTURESTORAGE2DPROC glext_glTextureStorage2D;
+#define glTextureStorage2D glext_glTextureStorage2D
+extern PFNGLTEXTURESUBIMAGE2DPROC glext_glTextureSubImage2D;
+#define glTextureSubImage2D glext_glTextureSubImage2D
+extern PFNGLTEXTUREPARAMETERIPROC glext_glTextureParameteri;
+#define glTextureParameteri glext_glTextureParameteri
+extern PFNGLGENERATETEXTUREMIPMAPPROC glext_glGenerateTextureMipmap;
+#define glGenerateTextureMipmap glext_glGenerateTextureMipmap
+extern PFNGLBINDTEXTUREUNITPROC glext_glBindTextureUnit;
+#define glBindTextureUnit glext_glBindTextureUnit
+extern PFNGLGETTEXTUREHANDLEARBPROC glext_glGetTextureHandleARB;
+#define glGetTextureHandleARB glext_glGetTextureHandleARB
+extern PFNGLGETTEXTURESAMPLERHANDLEARBPROC glext_glGetTextureSamplerHandleARB;
+#define glGetTextureSamplerHandleARB glext_glGetTextureSamplerHandleARB
+extern PFNGLMAKETEXTUREHANDLERESIDENTARBPROC glext_glMakeTextureHandleResidentARB;
+#define glMakeTextureHandleResidentARB glext_glMakeTextureHandleResidentARB
+extern PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC glext_glMakeTextureHandleNonResidentARB;
+#define glMakeTextureHandleNonResidentARB glext_glMakeTextureHandleNonResidentARB
+
+
+// Stores which optional features the current context supports
+struct GLCapabilities
+{
+	// Version of the context that was actually created
+	int major = 0;
+	int minor = 0;
+
+	// glMultiDrawElementsIndirect together with gl_DrawID and shader storage buffers
+	bool multiDrawIndirect = false;
+	// Immutable buffer storage that can stay mapped while the GPU reads it
+	bool bufferStorage = false;
+	// Direct State Access, objects are created and edited without binding them
+	bool directStateAccess = false;
+	// GL_ANY_SAMPLES_PASSED_CONSERVATIVE occlusion queries
+	bool conservativeOcclusion = false;
+	// GL_ARB_bindless_texture on top of multiDrawIndirect, shaders sample through handles read from buffers
+	bool bindlessTexture = false;
+
+	// Largest GL_TEXTURE_MAX_ANISOTROPY of a sampler, 1 without anisotropic filtering
+	float maxAnisotropy = 1.0f;
+
+	// Offsets passed to glBindBufferRange have to be multiples of these
+	GLint uniformBufferAlignment = 256;
+	GLint storageBufferAlignment = 256;
+};
+
+extern GLCapabilities GLCaps;
+
+// Loads the entry points above and fills GLCaps, call once right after gladLoadGL()
+void loadGLExtensions();
+// Checks if the current context advertises an extension
+bool hasGLExtension(const char* name);
+
+#endif
@@ -0,0 +1,269 @@
+#include"GeometryArena.h"
+
+// Start with room for about a million vertices and three million indices, the buffers grow when needed
+static const GLsizeiptr sharedVertexBytes = 1024 * 1024 * sizeof(Vertex);
+static const GLsizeiptr sharedIndexBytes = 3 * 1024 * 1024 * sizeof(GLuint);
+
+// Compact before growing once the free space is split into this many pieces
+static const size_t maxFreeBlocks = 64;
+
+// Constructor that reserves the buffers with initial sizes in bytes
+GeometryArena::GeometryArena(GLsizeiptr vertexBytes, GLsizeiptr indexBytes)
+	: vertexBuffer(vertexBytes), indexBuffer(indexBytes), vertexAllocator(vertexBytes), indexAllocator(indexBytes)
+{
+	linkAttributes();
+}
+
+// Arena used by all meshes, created on first use so a context has to be current
+GeometryArena& GeometryArena::Shared()
+{
+	static GeometryArena arena(sharedVertexBytes, sharedIndexBytes);
+	return arena;
+}
+
+// Copies the geometry into the arena and returns a handle to it
+GeometryArena::Handle GeometryArena::Allocate(std::vector<Vertex>& vertices, std::vector<GLuint>& indices)
+{
+	return Allocate(vertices.data(), vertices.size(), standardVertexFormat, indices.data(), indices.size());
+}
+
+GeometryArena::Handle GeometryArena::Allocate(const void* vertexData, GLsizei vertexCount, VertexFormat format, const GLuint* indexData, GLsizei indexCount)
+{
+	GLsizei vertexStride = format.stride * sizeof(float);
+
+	GeometryRange range = {};
+	range.vertexBytes = (GLsizeiptr)vertexCount * vertexStride;
+	range.vertexStride = vertexStride;
+	range.format = format;
+	range.indexCount = indexCount;
+	range.live = true;
+
+	// Empty ranges take no space, the allocator has no offset to give for them
+	if (range.vertexBytes > 0)
+	{
+		// Vertices are aligned to their stride so baseVertex is a whole number
+		size_t offset = vertexAllocator.Allocate(range.vertexBytes, vertexStride);
+		if (offset == FreeListAllocator::InvalidOffset)
+		{
+			makeRoom(vertexAllocator, range.vertexBytes, vertexStride, true);
+			offset = vertexAllocator.Allocate(range.vertexBytes, vertexStride);
+		}
+		range.vertexOffset = offset;
+		range.baseVertex = offset / vertexStride;
+		uploadBuffer(vertexBuffer.ID, range.vertexOffset, range.vertexBytes, vertexData);
+	}
+
+	if (indexCount > 0)
+	{
+		size_t offset = indexAllocator.Allocate(indexCount * sizeof(GLuint), sizeof(GLuint));
+		if (offset == FreeListAllocator::InvalidOffset)
+		{
+			makeRoom(indexAllocator, indexCount * sizeof(GLuint), sizeof(GLuint), false);
+			offset = indexAllocator.Allocate(indexCount * sizeof(GLuint), sizeof(GLuint));
+		}
+		range.firstIndex = offset / sizeof(GLuint);
+		uploadBuffer(indexBuffer.ID, range.firstIndex * sizeof(GLuint), indexCount * sizeof(GLuint), indexData);
+	}
+
+	Handle handle;
+	if (!freeHandles.empty())
+	{
+		handle = freeHandles.back();
+		freeHandles.pop_back();
+		ranges[handle] = range;
+	}
+	else
+	{
+		handle = ranges.size();
+		ranges.push_back(range);
+	}
+	return handle;
+}
+
+// Releases the geometry of a handle
+void GeometryArena::Free(Handle handle)
+{
+	GeometryRange& range = ranges[handle];
+	if (!range.live)
+	{
+		return;
+	}
+	if (range.vertexBytes > 0)
+	{
+		vertexAllocator.Free(range.vertexOffset, range.vertexBytes);
+	}
+	if (range.indexCount > 0)
+	{
+		indexAllocator.Free(range.firstIndex * sizeof(GLuint), range.indexCount * sizeof(GLuint));
+	}
+	range.live = false;
+	freeHandles.push_back(handle);
+
+	// Unloading many meshes leaves holes that small meshes can't fill anymore
+	if (vertexAllocator.FreeBlockCount() > maxFreeBlocks || indexAllocator.FreeBlockCount() > maxFreeBlocks)
+	{
+		Defragment();
+	}
+}
+
+// Moves all live geometry to the front of the buffers so the free space is in one piece
+void GeometryArena::Defragment()
+{
+	// Source and destination ranges of glCopyBufferSubData may not overlap inside one buffer,
+	// so the live data is copied into fresh buffers of the same size
+	GLuint newVertices = createBuffer(vertexAllocator.Capacity());
+	GLuint newIndices = createBuffer(indexAllocator.Capacity());
+
+	size_t vertexEnd = 0;
+	size_t indexEnd = 0;
+	for (unsigned int i = 0; i < ranges.size(); i++)
+	{
+		GeometryRange& range = ranges[i];
+		if (!range.live)
+		{
+			continue;
+		}
+		// Empty ranges stay at offset 0
+		if (range.vertexBytes > 0)
+		{
+			vertexEnd = (vertexEnd + range.vertexStride - 1) / range.vertexStride * range.vertexStride;
+			copyBuffer(vertexBuffer.ID, newVertices, range.vertexOffset, vertexEnd, range.vertexBytes);
+			range.vertexOffset = vertexEnd;
+			range.baseVertex = vertexEnd / range.vertexStride;
+			vertexEnd += range.vertexBytes;
+		}
+		if (range.indexCount > 0)
+		{
+			copyBuffer(indexBuffer.ID, newIndices, range.firstIndex * sizeof(GLuint), indexEnd, range.indexCount * sizeof(GLuint));
+			range.firstIndex = indexEnd / sizeof(GLuint);
+			indexEnd += range.indexCount * sizeof(GLuint);
+		}
+	}
+
+	vertexBuffer.Delete();
+	indexBuffer.Delete();
+	vertexBuffer.ID = newVertices;
+	indexBuffer.ID = newIndices;
+	vertexAllocator.Reset(vertexEnd);
+	indexAllocator.Reset(indexEnd);
+	linkAttributes();
+}
+
+// Binds the VAO of the arena
+void GeometryArena::Bind()
+{
+	vertexArray.Bind();
+}
+
+// Binds the index-only VAO and exposes the vertex buffer as a shader storage buffer
+void GeometryArena::BindPulling(GLuint binding)
+{
+	pullingArray.Bind();
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, vertexBuffer.ID);
+}
+
+// Unbinds the VAO of the arena
+void GeometryArena::Unbind()
+{
+	vertexArray.Unbind();
+}
+
+// Deletes the VAO and the buffers
+void GeometryArena::Delete()
+{
+	vertexArray.Delete();
+	pullingArray.Delete();
+	vertexBuffer.Delete();
+	indexBuffer.Delete();
+}
+
+// Makes room for an allocation by compacting first and growing if that isn't enough
+void GeometryArena::makeRoom(FreeListAllocator& allocator, size_t size, size_t alignment, bool vertices)
+{
+	if (allocator.FreeBytes() >= size + alignment)
+	{
+		Defragment();
+		if (allocator.LargestFreeBlock() >= size + alignment)
+		{
+			return;
+		}
+	}
+
+	// Double the buffer so the number of copies stays logarithmic in the scene size
+	size_t newCapacity = allocator.Capacity() * 2;
+	while (newCapacity < allocator.Capacity() + size + alignment)
+	{
+		newCapacity *= 2;
+	}
+	growBuffer(vertices ? vertexBuffer.ID : indexBuffer.ID, allocator.Capacity(), newCapacity);
+	allocator.Grow(newCapacity);
+	linkAttributes();
+}
+
+// Replaces a buffer with a bigger one and copies the old content over
+void GeometryArena::growBuffer(GLuint& ID, GLsizeiptr oldSize, GLsizeiptr newSize)
+{
+	GLuint newID = createBuffer(newSize);
+	copyBuffer(ID, newID, 0, 0, oldSize);
+
+	glDeleteBuffers(1, &ID);
+	ID = newID;
+}
+
+// Points the VAO to the current buffers
+void GeometryArena::linkAttributes()
+{
+	vertexArray.Bind();
+	vertexArray.LinkAttrib(vertexBuffer, 0, 3, GL_FLOAT, sizeof(Vertex), (void*)0);
+	vertexArray.LinkAttrib(vertexBuffer, 1, 3, GL_FLOAT, sizeof(Vertex), (void*)(3 * sizeof(float)));
+	vertexArray.LinkAttrib(vertexBuffer, 2, 3, GL_FLOAT, sizeof(Vertex), (void*)(6 * sizeof(float)));
+	vertexArray.LinkAttrib(vertexBuffer, 3, 2, GL_FLOAT, sizeof(Vertex), (void*)(9 * sizeof(float)));
+	vertexArray.Unbind();
+	vertexArray.LinkEBO(indexBuffer);
+	pullingArray.LinkEBO(indexBuffer);
+}
+
+// Creates an empty buffer that can be updated with uploadBuffer
+GLuint GeometryArena::createBuffer(GLsizeiptr size)
+{
+	GLuint ID;
+	if (GLCaps.directStateAccess)
+	{
+		glCreateBuffers(1, &ID);
+		glNamedBufferStorage(ID, size, NULL, GL_DYNAMIC_STORAGE_BIT);
+		return ID;
+	}
+	glGenBuffers(1, &ID);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, ID);
+	glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	return ID;
+}
+
+// Writes data into a buffer, without DSA through the copy target so the element binding of the bound VAO stays untouched
+void GeometryArena::uploadBuffer(GLuint ID, GLintptr offset, GLsizeiptr size, const void* data)
+{
+	if (GLCaps.directStateAccess)
+	{
+		glNamedBufferSubData(ID, offset, size, data);
+		return;
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, ID);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+// Copies a range from one buffer to another on the GPU
+void GeometryArena::copyBuffer(GLuint readID, GLuint writeID, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size)
+{
+	if (GLCaps.directStateAccess)
+	{
+		glCopyNamedBufferSubData(readID, writeID, readOffset, writeOffset, size);
+		return;
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, readID);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, writeID);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, readOffset, writeOffset, size);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
@@ -0,0 +1,89 @@
+#ifndef GEOMETRY_ARENA_CLASS_H
+#define GEOMETRY_ARENA_CLASS_H
+
+#include<vector>
+
+#include"VAO.h"
+#include"EBO.h"
+#include"FreeListAllocator.h"
+
+
+// Where the geometry of one mesh currently lives inside the arena
+struct GeometryRange
+{
+	// Byte offset and size of the vertices inside the vertex buffer
+	GLintptr vertexOffset;
+	GLsizeiptr vertexBytes;
+	GLsizei vertexStride;
+	VertexFormat format;
+	// Value for the baseVertex parameter of the glDraw*BaseVertex calls
+	GLint baseVertex;
+	// Position and number of indices inside the index buffer
+	GLuint firstIndex;
+	GLuint indexCount;
+	bool live;
+};
+
+
+// One big vertex buffer and one big index buffer shared by every mesh.
+// Meshes only keep a handle, so the arena can move their data around when it
+// grows or compacts itself and all meshes can be drawn from the same VAO
+class GeometryArena
+{
+public:
+	typedef unsigned int Handle;
+
+	// The VAO every mesh is drawn with
+	VAO vertexArray;
+	// VAO with only the index buffer, for shaders that fetch the vertices themselves
+	VAO pullingArray;
+
+	// Constructor that reserves the buffers with initial sizes in bytes
+	GeometryArena(GLsizeiptr vertexBytes, GLsizeiptr indexBytes);
+	// Arena used by all meshes, created on first use so a context has to be current
+	static GeometryArena& Shared();
+
+	// Copies the geometry into the arena and returns a handle to it
+	Handle Allocate(std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
+	Handle Allocate(const void* vertexData, GLsizei vertexCount, VertexFormat format, const GLuint* indexData, GLsizei indexCount);
+	// Releases the geometry of a handle
+	void Free(Handle handle);
+	// Returns where the geometry of a handle currently lives
+	const GeometryRange& Get(Handle handle) const { return ranges[handle]; }
+	// Moves all live geometry to the front of the buffers so the free space is in one piece
+	void Defragment();
+
+	GLuint VertexBufferID() const { return vertexBuffer.ID; }
+	GLuint IndexBufferID() const { return indexBuffer.ID; }
+
+	// Binds the VAO of the arena
+	void Bind();
+	// Binds the index-only VAO and exposes the vertex buffer as a shader storage buffer
+	void BindPulling(GLuint binding);
+	// Unbinds the VAO of the arena
+	void Unbind();
+	// Deletes the VAO and the buffers
+	void Delete();
+
+private:
+	VBO vertexBuffer;
+	EBO indexBuffer;
+	FreeListAllocator vertexAllocator;
+	FreeListAllocator indexAllocator;
+
+	std::vector<GeometryRange> ranges;
+	std::vector<Handle> freeHandles;
+
+	// Makes room for an allocation by compacting first and growing if that isn't enough
+	void makeRoom(FreeListAllocator& allocator, size_t size, size_t alignment, bool vertices);
+	// Replaces a buffer with a bigger one and copies the old content over
+	void growBuffer(GLuint& ID, GLsizeiptr oldSize, GLsizeiptr newSize);
+	// Points the VAO to the current buffers
+	void linkAttributes();
+	// Buffer helpers that use DSA when it's available
+	GLuint createBuffer(GLsizeiptr size);
+	void uploadBuffer(GLuint ID, GLintptr offset, GLsizeiptr size, const void* data);
+	void copyBuffer(GLuint readID, GLuint writeID, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size);
+};
+
+#endif
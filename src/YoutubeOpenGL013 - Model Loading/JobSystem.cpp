@@ -0,0 +1,341 @@
+#include"JobSystem.h"
+
+#include<algorithm>
+#include<chrono>
+
+// Index of the worker running on this thread in the pool that started it, -1 for other threads
+static thread_local int workerIndex = -1;
+static thread_local const JobSystem* workerPool = NULL;
+
+
+WorkStealingDeque::WorkStealingDeque(size_t capacity)
+	: top(0), bottom(0), buffer(capacity), mask(capacity - 1)
+{
+}
+
+
+bool WorkStealingDeque::Push(Job* job)
+{
+	int64_t b = bottom.load(std::memory_order_relaxed);
+	int64_t t = top.load(std::memory_order_acquire);
+	if (b - t > mask)
+	{
+		return false;
+	}
+	buffer[b & mask].store(job, std::memory_order_relaxed);
+	// The job has to be visible before a thief can see the new bottom
+	std::atomic_thread_fence(std::memory_order_release);
+	bottom.store(b + 1, std::memory_order_relaxed);
+	return true;
+}
+
+
+Job* WorkStealingDeque::Pop()
+{
+	int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+	bottom.store(b, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t t = top.load(std::memory_order_relaxed);
+	if (t > b)
+	{
+		// Empty
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return NULL;
+	}
+	Job* job = buffer[b & mask].load(std::memory_order_relaxed);
+	if (t == b)
+	{
+		// Last job, a thief may be taking it at the same time
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			job = NULL;
+		}
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+
+Job* WorkStealingDeque::Steal()
+{
+	int64_t t = top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t b = bottom.load(std::memory_order_acquire);
+	if (t >= b)
+	{
+		return NULL;
+	}
+	Job* job = buffer[t & mask].load(std::memory_order_relaxed);
+	if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+	{
+		return NULL;
+	}
+	return job;
+}
+
+
+// Pool with one worker per core, created on first use. Call it from the main thread first
+JobSystem& JobSystem::Shared()
+{
+	static JobSystem pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+	return pool;
+}
+
+
+// Starts workerThreads threads next to the calling thread
+JobSystem::JobSystem(unsigned int workerThreads)
+	: running(true), queuedJobs(0)
+{
+	mainThread = std::this_thread::get_id();
+	workerIndex = 0;
+	workerPool = this;
+	for (unsigned int i = 0; i <= workerThreads; i++)
+	{
+		deques.push_back(new WorkStealingDeque());
+	}
+	for (unsigned int i = 1; i <= workerThreads; i++)
+	{
+		workers.emplace_back(&JobSystem::workerLoop, this, (int)i);
+	}
+}
+
+
+JobSystem::~JobSystem()
+{
+	running = false;
+	sleepCondition.notify_all();
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+	for (size_t i = 0; i < deques.size(); i++)
+	{
+		delete deques[i];
+	}
+	if (workerPool == this)
+	{
+		workerIndex = -1;
+		workerPool = NULL;
+	}
+}
+
+
+// Schedules a job on any thread
+void JobSystem::Run(std::function<void()> function, JobCounter* counter)
+{
+	if (counter != NULL)
+	{
+		counter->value.fetch_add(1, std::memory_order_relaxed);
+	}
+	schedule(new Job{ std::move(function), counter });
+}
+
+
+// Schedules a job once dependency reached zero
+void JobSystem::RunAfter(JobCounter& dependency, std::function<void()> function, JobCounter* counter)
+{
+	if (counter != NULL)
+	{
+		counter->value.fetch_add(1, std::memory_order_relaxed);
+	}
+	Job* job = new Job{ std::move(function), counter };
+	{
+		// execute takes the same lock after the counter dropped to zero, so the job can't be missed
+		std::lock_guard<std::mutex> lock(dependency.continuationMutex);
+		if (!dependency.IsDone())
+		{
+			dependency.continuations.push_back(job);
+			return;
+		}
+	}
+	schedule(job);
+}
+
+
+// Schedules a job that only the main thread runs, inside Wait or RunMainThreadJobs
+void JobSystem::RunOnMainThread(std::function<void()> function, JobCounter* counter)
+{
+	if (counter != NULL)
+	{
+		counter->value.fetch_add(1, std::memory_order_relaxed);
+	}
+	std::lock_guard<std::mutex> lock(mainMutex);
+	mainJobs.push_back(new Job{ std::move(function), counter });
+}
+
+
+// Runs other jobs until the counter reaches zero, so waiting inside a job can't deadlock the pool
+void JobSystem::Wait(JobCounter& counter)
+{
+	int worker = currentWorker();
+	while (!counter.IsDone())
+	{
+		if (worker == 0)
+		{
+			RunMainThreadJobs();
+		}
+		Job* job = findJob(worker);
+		if (job != NULL)
+		{
+			execute(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+	// The last job drops the counter to zero while it holds continuationMutex. Taking the lock once
+	// makes sure that job is done with the counter before the caller may destroy it
+	std::lock_guard<std::mutex> lock(counter.continuationMutex);
+}
+
+
+// Runs the jobs queued for the main thread, call from the main thread once a frame
+void JobSystem::RunMainThreadJobs()
+{
+	while (true)
+	{
+		Job* job;
+		{
+			std::lock_guard<std::mutex> lock(mainMutex);
+			if (mainJobs.empty())
+			{
+				return;
+			}
+			job = mainJobs.front();
+			mainJobs.pop_front();
+		}
+		execute(job);
+	}
+}
+
+
+// Splits [0, count) into chunks of chunkSize and runs body(chunk, begin, end) for every chunk, returns when all are done
+void JobSystem::ParallelFor(size_t count, size_t chunkSize, const std::function<void(size_t chunk, size_t begin, size_t end)>& body)
+{
+	chunkSize = std::max<size_t>(1, chunkSize);
+	size_t chunks = (count + chunkSize - 1) / chunkSize;
+	if (chunks <= 1)
+	{
+		if (count > 0)
+		{
+			body(0, 0, count);
+		}
+		return;
+	}
+	JobCounter counter;
+	for (size_t chunk = 0; chunk < chunks; chunk++)
+	{
+		Run([&body, chunk, chunkSize, count]()
+		{
+			body(chunk, chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize));
+		}, &counter);
+	}
+	Wait(counter);
+}
+
+
+void JobSystem::schedule(Job* job)
+{
+	int worker = currentWorker();
+	if (worker < 0 || !deques[worker]->Push(job))
+	{
+		std::lock_guard<std::mutex> lock(injectMutex);
+		injected.push_back(job);
+	}
+	queuedJobs.fetch_add(1, std::memory_order_release);
+	sleepCondition.notify_one();
+}
+
+
+// Finds one job for the calling thread, or returns NULL
+Job* JobSystem::findJob(int worker)
+{
+	Job* job = NULL;
+	if (worker >= 0)
+	{
+		job = deques[worker]->Pop();
+	}
+	if (job == NULL)
+	{
+		std::lock_guard<std::mutex> lock(injectMutex);
+		if (!injected.empty())
+		{
+			job = injected.front();
+			injected.pop_front();
+		}
+	}
+	// Steal from the others, starting next to this worker so thieves spread out
+	for (size_t i = 1; job == NULL && i <= deques.size(); i++)
+	{
+		size_t victim = (std::max(worker, 0) + i) % deques.size();
+		if ((int)victim != worker)
+		{
+			job = deques[victim]->Steal();
+		}
+	}
+	if (job != NULL)
+	{
+		queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+
+void JobSystem::execute(Job* job)
+{
+	job->function();
+	JobCounter* counter = job->counter;
+	delete job;
+	if (counter == NULL)
+	{
+		return;
+	}
+
+	std::vector<Job*> ready;
+	{
+		std::lock_guard<std::mutex> lock(counter->continuationMutex);
+		if (counter->value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			ready.swap(counter->continuations);
+		}
+	}
+	for (size_t i = 0; i < ready.size(); i++)
+	{
+		schedule(ready[i]);
+	}
+}
+
+
+void JobSystem::workerLoop(int worker)
+{
+	workerIndex = worker;
+	workerPool = this;
+	while (running)
+	{
+		Job* job = findJob(worker);
+		if (job != NULL)
+		{
+			execute(job);
+			continue;
+		}
+		// A short timeout covers the rare wakeup that slips in between findJob and the wait
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepCondition.wait_for(lock, std::chrono::milliseconds(1), [this]()
+		{
+			return !running || queuedJobs.load(std::memory_order_acquire) > 0;
+		});
+	}
+}
+
+
+int JobSystem::currentWorker() const
+{
+	return workerPool == this ? workerIndex : -1;
+}
+
+
+void ParallelFor(size_t count, size_t chunkSize, const std::function<void(size_t chunk, size_t begin, size_t end)>& body)
+{
+	JobSystem::Shared().ParallelFor(count, chunkSize, body);
+}
@@ -0,0 +1,126 @@
+#ifndef JOB_SYSTEM_CLASS_H
+#define JOB_SYSTEM_CLASS_H
+
+#include<atomic>
+#include<condition_variable>
+#include<cstdint>
+#include<deque>
+#include<functional>
+#include<mutex>
+#include<thread>
+#include<vector>
+
+
+// Work to run on some thread of the JobSystem
+struct Job
+{
+	std::function<void()> function;
+	// Decremented once the function returned, may be NULL
+	class JobCounter* counter;
+};
+
+
+// Counts unfinished jobs. Jobs started with a counter increment it and decrement it when
+// they finish, JobSystem::Wait returns when it reaches zero. Jobs started with RunAfter
+// wait for a counter to reach zero before they are scheduled at all. Only destroy a counter
+// after JobSystem::Wait returned, IsDone can turn true while the last job still uses it
+class JobCounter
+{
+public:
+	JobCounter() : value(0) {}
+
+	bool IsDone() const { return value.load(std::memory_order_acquire) == 0; }
+	int Value() const { return value.load(std::memory_order_acquire); }
+
+private:
+	friend class JobSystem;
+	std::atomic<int> value;
+	// Jobs waiting for the counter to reach zero
+	std::mutex continuationMutex;
+	std::vector<Job*> continuations;
+};
+
+
+// Chase-Lev work stealing deque. The owning thread pushes and pops at the bottom without
+// locking, every other thread steals from the top. Fixed capacity, Push fails when full
+class WorkStealingDeque
+{
+public:
+	// Capacity has to be a power of two
+	WorkStealingDeque(size_t capacity = 4096);
+
+	// Only the owning thread may call Push and Pop
+	bool Push(Job* job);
+	Job* Pop();
+	// Any thread may steal, returns NULL when empty or when it lost a race
+	Job* Steal();
+
+private:
+	std::atomic<int64_t> top;
+	std::atomic<int64_t> bottom;
+	std::vector<std::atomic<Job*>> buffer;
+	int64_t mask;
+};
+
+
+// Pool of worker threads shared by every subsystem. Each worker owns a deque, idle workers
+// steal from the others. The thread that created the pool counts as worker 0 and is the only
+// one that runs jobs started with RunOnMainThread, which is where OpenGL work has to go
+class JobSystem
+{
+public:
+	// Pool with one worker per core, created on first use. Call it from the main thread first
+	static JobSystem& Shared();
+
+	// Starts workerThreads threads next to the calling thread
+	JobSystem(unsigned int workerThreads);
+	~JobSystem();
+
+	// Schedules a job on any thread
+	void Run(std::function<void()> function, JobCounter* counter = NULL);
+	// Schedules a job once dependency reached zero
+	void RunAfter(JobCounter& dependency, std::function<void()> function, JobCounter* counter = NULL);
+	// Schedules a job that only the main thread runs, inside Wait or RunMainThreadJobs
+	void RunOnMainThread(std::function<void()> function, JobCounter* counter = NULL);
+	// Runs other jobs until the counter reaches zero, so waiting inside a job can't deadlock the pool
+	void Wait(JobCounter& counter);
+	// Runs the jobs queued for the main thread, call from the main thread once a frame
+	void RunMainThreadJobs();
+
+	// Splits [0, count) into chunks of chunkSize and runs body(chunk, begin, end) for every chunk, returns when all are done
+	void ParallelFor(size_t count, size_t chunkSize, const std::function<void(size_t chunk, size_t begin, size_t end)>& body);
+
+	// Threads that run jobs, the main thread included
+	unsigned int ThreadCount() const { return workers.size() + 1; }
+	bool IsMainThread() const { return std::this_thread::get_id() == mainThread; }
+
+private:
+	// deques[0] belongs to the main thread, deques[i] to workers[i - 1]
+	std::vector<WorkStealingDeque*> deques;
+	std::vector<std::thread> workers;
+	std::thread::id mainThread;
+	std::atomic<bool> running;
+
+	// Jobs started from threads that aren't part of the pool, or that didn't fit into a deque
+	std::mutex injectMutex;
+	std::deque<Job*> injected;
+	std::mutex mainMutex;
+	std::deque<Job*> mainJobs;
+
+	// Idle workers sleep here until new jobs arrive
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+	std::atomic<int> queuedJobs;
+
+	void schedule(Job* job);
+	// Finds one job for the calling thread, or returns NULL
+	Job* findJob(int worker);
+	void execute(Job* job);
+	void workerLoop(int worker);
+	int currentWorker() const;
+};
+
+// Same as JobSystem::Shared().ParallelFor
+void ParallelFor(size_t count, size_t chunkSize, const std::function<void(size_t chunk, size_t begin, size_t end)>& body);
+
+#endif
@@ -0,0 +1,68 @@
+#include"LinearAllocator.h"
+
+#include<algorithm>
+#include<cstdint>
+
+// Constructor that allocates blocks of blockSize bytes as they are needed
+LinearAllocator::LinearAllocator(size_t blockSize)
+{
+	LinearAllocator::blockSize = blockSize;
+	current = 0;
+	offset = 0;
+	used = 0;
+}
+
+LinearAllocator::~LinearAllocator()
+{
+	for (size_t i = 0; i < blocks.size(); i++)
+	{
+		::operator delete(blocks[i].data);
+	}
+}
+
+// Takes size bytes starting at a multiple of alignment, alignment has to be a power of two
+void* LinearAllocator::Allocate(size_t size, size_t alignment)
+{
+	// Walks over the kept blocks first, a new one is only made when none of them fits
+	while (true)
+	{
+		if (current < blocks.size())
+		{
+			Block& block = blocks[current];
+			uintptr_t start = (uintptr_t)(block.data + offset);
+			size_t padding = ((start + alignment - 1) & ~(uintptr_t)(alignment - 1)) - start;
+			if (offset + padding + size <= block.size)
+			{
+				void* result = block.data + offset + padding;
+				offset += padding + size;
+				used += padding + size;
+				return result;
+			}
+			// Doesn't fit, the rest of the block stays unused until the next Reset
+			current++;
+			offset = 0;
+			continue;
+		}
+		// Allocations bigger than a block get a block of their own
+		size_t bytes = std::max(blockSize, size + alignment);
+		blocks.push_back(Block{ (unsigned char*)::operator new(bytes), bytes });
+	}
+}
+
+// Frees every allocation at once
+void LinearAllocator::Reset()
+{
+	current = 0;
+	offset = 0;
+	used = 0;
+}
+
+size_t LinearAllocator::Capacity() const
+{
+	size_t total = 0;
+	for (size_t i = 0; i < blocks.size(); i++)
+	{
+		total += blocks[i].size;
+	}
+	return total;
+}
@@ -0,0 +1,45 @@
+#ifndef LINEAR_ALLOCATOR_CLASS_H
+#define LINEAR_ALLOCATOR_CLASS_H
+
+#include<cstddef>
+#include<vector>
+
+
+// Bump allocator over a list of memory blocks. Allocations are never freed one by one,
+// Reset makes all of them free again and keeps the blocks for the next round, so once it
+// has grown to the size a frame needs it no longer touches the heap. Not thread safe
+class LinearAllocator
+{
+public:
+	// Constructor that allocates blocks of blockSize bytes as they are needed
+	LinearAllocator(size_t blockSize = 64 * 1024);
+	~LinearAllocator();
+
+	LinearAllocator(const LinearAllocator&) = delete;
+	LinearAllocator& operator=(const LinearAllocator&) = delete;
+
+	// Takes size bytes starting at a multiple of alignment, alignment has to be a power of two
+	void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+	// Frees every allocation at once
+	void Reset();
+
+	size_t UsedBytes() const { return used; }
+	size_t Capacity() const;
+
+private:
+	struct Block
+	{
+		unsigned char* data;
+		size_t size;
+	};
+
+	size_t blockSize;
+	std::vector<Block> blocks;
+	// Block the next allocation comes from and the first free byte inside it
+	size_t current;
+	size_t offset;
+	// Bytes handed out since the last Reset, including padding
+	size_t used;
+};
+
+#endif
@@ -0,0 +1,264 @@
+#include"Material.h"
+#include"SamplerCache.h"
+
+#include<algorithm>
+#include<string>
+
+// Textures of the roles that have none, see FallbackTexture
+static GLuint fallbackTextures[Material::ROLE_COUNT] = {};
+
+
+// The glTF default material, white and fully rough without textures
+Material::Material()
+{
+	block.baseColorFactor = glm::vec4(1.0f);
+	block.emissiveFactor = glm::vec4(0.0f);
+	block.layers = glm::ivec4(0);
+	block.metallicFactor = 1.0f;
+	block.roughnessFactor = 1.0f;
+	block.alphaCutoff = 0.0f;
+	block.padding = 0.0f;
+	for (int r = 0; r < ROLE_COUNT; r++)
+	{
+		textures[r] = 0;
+		targets[r] = GL_TEXTURE_2D;
+		images[r] = -1;
+		samplers[r] = -1;
+		samplerObjects[r] = 0;
+	}
+	uniformBuffer = 0;
+}
+
+
+// Reads the factors and texture references of entry index of the materials array of a glTF file
+Material::Material(const nlohmann::json& JSON, unsigned int index)
+	: Material()
+{
+	const nlohmann::json& material = JSON["materials"][index];
+	const nlohmann::json& textureList = JSON["textures"];
+	// A texture reference names an entry of textures, which names the image and the sampler
+	auto readTexture = [&](const nlohmann::json& owner, const char* name, Role role)
+	{
+		if (owner.find(name) == owner.end())
+		{
+			return;
+		}
+		unsigned int texture = owner[name]["index"];
+		images[role] = textureList[texture].value("source", -1);
+		samplers[role] = textureList[texture].value("sampler", -1);
+	};
+
+	if (material.find("pbrMetallicRoughness") != material.end())
+	{
+		const nlohmann::json& pbr = material["pbrMetallicRoughness"];
+		if (pbr.find("baseColorFactor") != pbr.end())
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				block.baseColorFactor[i] = pbr["baseColorFactor"][i].get<float>();
+			}
+		}
+		block.metallicFactor = pbr.value("metallicFactor", 1.0f);
+		block.roughnessFactor = pbr.value("roughnessFactor", 1.0f);
+		readTexture(pbr, "baseColorTexture", BASE_COLOR);
+		readTexture(pbr, "metallicRoughnessTexture", METALLIC_ROUGHNESS);
+	}
+	if (material.find("emissiveFactor") != material.end())
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			block.emissiveFactor[i] = material["emissiveFactor"][i].get<float>();
+		}
+	}
+	if (material.value("alphaMode", std::string("OPAQUE")) == "MASK")
+	{
+		block.alphaCutoff = material.value("alphaCutoff", 0.5f);
+	}
+}
+
+
+// Type string of a role, the same as Texture::type of a texture used for it
+const char* Material::RoleType(Role role)
+{
+	static const char* const types[ROLE_COUNT] = { "diffuse", "specular" };
+	return types[role];
+}
+
+
+// Sampler uniform of a role in the shaders
+const char* Material::SamplerName(Role role)
+{
+	static const char* const names[ROLE_COUNT] = { "diffuse0", "specular0" };
+	return names[role];
+}
+
+
+// Points the sampler uniforms and the Material block of a shader to where Bind puts them, once after linking
+void Material::SetupShader(Shader& shader)
+{
+	shader.Activate();
+	for (int r = 0; r < ROLE_COUNT; r++)
+	{
+		glUniform1i(shader.Uniform(SamplerName((Role)r)), r);
+	}
+	GLuint index = glGetUniformBlockIndex(shader.ID, "Material");
+	if (index != GL_INVALID_INDEX)
+	{
+		glUniformBlockBinding(shader.ID, index, blockBinding);
+	}
+}
+
+
+// 1x1 texture a role without a texture samples, 0 until created
+GLuint Material::FallbackTexture(Role role)
+{
+	return fallbackTextures[role];
+}
+
+
+// Creates the fallback textures on the context thread, before the first Bind is recorded
+void Material::CreateFallbackTextures()
+{
+	static const unsigned char colors[ROLE_COUNT][4] = { { 255, 255, 255, 255 }, { 0, 0, 0, 255 } };
+	for (int r = 0; r < ROLE_COUNT; r++)
+	{
+		if (fallbackTextures[r] != 0)
+		{
+			continue;
+		}
+		glGenTextures(1, &fallbackTextures[r]);
+		glBindTexture(GL_TEXTURE_2D, fallbackTextures[r]);
+		// A single texel, Bind pairs it with sampler 0 so this filtering is the one used
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, colors[r]);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+}
+
+
+void Material::DeleteFallbackTextures()
+{
+	glDeleteTextures(ROLE_COUNT, fallbackTextures);
+	for (int r = 0; r < ROLE_COUNT; r++)
+	{
+		fallbackTextures[r] = 0;
+	}
+}
+
+
+// Uses the first diffuse and specular texture as base color and metallic roughness
+void Material::SetTextures(const std::vector<Texture>& textureList)
+{
+	bool found[ROLE_COUNT] = {};
+	for (unsigned int i = 0; i < textureList.size(); i++)
+	{
+		for (int r = 0; r < ROLE_COUNT; r++)
+		{
+			if (!found[r] && std::string(textureList[i].type) == RoleType((Role)r))
+			{
+				found[r] = true;
+				textures[r] = textureList[i].ID;
+				targets[r] = textureList[i].target;
+				block.layers[r] = std::max(textureList[i].layer, 0);
+				// Textures that came without a glTF sampler, the floor and packed ones, share the default sampler
+				if (samplerObjects[r] == 0)
+				{
+					samplerObjects[r] = SamplerCache::Shared().Default();
+				}
+				break;
+			}
+		}
+	}
+}
+
+
+// Copies block into the uniform buffer, creating it the first time
+void Material::Upload()
+{
+	if (uniformBuffer == 0)
+	{
+		glGenBuffers(1, &uniformBuffer);
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, uniformBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(MaterialBlock), &block, GL_STATIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+
+// Records binding the textures with their samplers and the uniform buffer. Roles without a texture get
+// their fallback texture, roles keep what is bound only while the fallbacks don't exist yet
+void Material::Bind(CommandBuffer& commands) const
+{
+	for (int r = 0; r < ROLE_COUNT; r++)
+	{
+		GLuint texture = textures[r] != 0 ? textures[r] : fallbackTextures[r];
+		if (texture != 0)
+		{
+			commands.BindTexture(r, texture, textures[r] != 0 ? targets[r] : GL_TEXTURE_2D);
+			// Also with 0, so the sampler of the material drawn before doesn't stay on the unit
+			commands.BindSampler(r, textures[r] != 0 ? samplerObjects[r] : 0);
+		}
+	}
+	if (uniformBuffer != 0)
+	{
+		commands.BindUniformBuffer(blockBinding, uniformBuffer);
+	}
+}
+
+
+// Checks if binding other after this one would change nothing, counting the fallback textures both would bind
+bool Material::SameBindings(const Material& other) const
+{
+	if (other.uniformBuffer != 0 && other.uniformBuffer != uniformBuffer)
+	{
+		return false;
+	}
+	for (int r = 0; r < ROLE_COUNT; r++)
+	{
+		GLuint texture = textures[r] != 0 ? textures[r] : fallbackTextures[r];
+		GLuint otherTexture = other.textures[r] != 0 ? other.textures[r] : fallbackTextures[r];
+		if (otherTexture == 0)
+		{
+			continue;
+		}
+		GLenum target = textures[r] != 0 ? targets[r] : GL_TEXTURE_2D;
+		GLenum otherTarget = other.textures[r] != 0 ? other.targets[r] : GL_TEXTURE_2D;
+		GLuint sampler = textures[r] != 0 ? samplerObjects[r] : 0;
+		GLuint otherSampler = other.textures[r] != 0 ? other.samplerObjects[r] : 0;
+		if (otherTexture != texture || otherTarget != target || otherSampler != sampler)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+// Hash of everything Bind records, equal for materials that bind the same
+uint64_t Material::BindingKey() const
+{
+	GLuint bindings[1 + 3 * ROLE_COUNT];
+	bindings[0] = uniformBuffer;
+	for (int r = 0; r < ROLE_COUNT; r++)
+	{
+		bindings[1 + 3 * r] = textures[r] != 0 ? textures[r] : fallbackTextures[r];
+		bindings[2 + 3 * r] = textures[r] != 0 ? targets[r] : GL_TEXTURE_2D;
+		bindings[3 + 3 * r] = textures[r] != 0 ? samplerObjects[r] : 0;
+	}
+	// FNV-1a, 64 bits leave collisions to chance that only cost a bind
+	uint64_t key = 14695981039346656037ull;
+	for (GLuint binding : bindings)
+	{
+		key = (key ^ binding) * 1099511628211ull;
+	}
+	return key;
+}
+
+
+// Deletes the uniform buffer, the textures belong to whoever created them
+void Material::Delete()
+{
+	glDeleteBuffers(1, &uniformBuffer);
+	uniformBuffer = 0;
+}
@@ -0,0 +1,91 @@
+#ifndef MATERIAL_CLASS_H
+#define MATERIAL_CLASS_H
+
+#include<cstdint>
+#include<json/json.h>
+#include<glm/glm.hpp>
+#include<vector>
+
+#include"Texture.h"
+
+
+// Factors of a material as laid out in the std140 Material block of the shaders
+struct MaterialBlock
+{
+	glm::vec4 baseColorFactor;
+	// rgb emissive color, w unused
+	glm::vec4 emissiveFactor;
+	// Layer of every texture role inside its array texture, 0 for plain 2D textures
+	glm::ivec4 layers;
+	float metallicFactor;
+	float roughnessFactor;
+	// Fragments with less base color alpha are discarded, 0 unless the glTF alphaMode is MASK
+	float alphaCutoff;
+	float padding;
+};
+
+
+// Everything a draw needs from a glTF material, read once at load time. Every texture role
+// always goes to the same texture unit and the factors sit in a uniform buffer of their own, so
+// binding a material records a few binds and no uniform lookups, strings or allocations
+class Material
+{
+public:
+	// Texture roles, each one is bound to the texture unit of the same number
+	enum Role
+	{
+		BASE_COLOR,
+		METALLIC_ROUGHNESS,
+		ROLE_COUNT
+	};
+	// Uniform block binding point the buffer of the bound material goes to
+	static const GLuint blockBinding = 2;
+
+	MaterialBlock block;
+	// Texture of every role, 0 where the material has none or it is still loading
+	GLuint textures[ROLE_COUNT];
+	GLenum targets[ROLE_COUNT];
+	// glTF image and sampler of every role, -1 where there is none
+	int images[ROLE_COUNT];
+	int samplers[ROLE_COUNT];
+	// Sampler object of every role from the SamplerCache, SetTextures gives roles still at 0 the default one
+	GLuint samplerObjects[ROLE_COUNT];
+	// Holds block after Upload, 0 before
+	GLuint uniformBuffer;
+
+	// The glTF default material, white and fully rough without textures
+	Material();
+	// Reads the factors and texture references of entry index of the materials array of a glTF file
+	Material(const nlohmann::json& JSON, unsigned int index);
+
+	// Type string of a role, the same as Texture::type of a texture used for it
+	static const char* RoleType(Role role);
+	// Sampler uniform of a role in the shaders
+	static const char* SamplerName(Role role);
+	// Points the sampler uniforms and the Material block of a shader to where Bind puts them, once after linking
+	static void SetupShader(Shader& shader);
+	// 1x1 texture a role without a texture samples: white base color, so only the factor counts as glTF
+	// says, and black metallic roughness, which the shaders read as no specular. 0 until created
+	static GLuint FallbackTexture(Role role);
+	// Creates the fallback textures on the context thread, before the first Bind is recorded
+	static void CreateFallbackTextures();
+	static void DeleteFallbackTextures();
+
+	// Uses the first diffuse and specular texture as base color and metallic roughness, call Upload
+	// afterwards if any of them sits in an array texture
+	void SetTextures(const std::vector<Texture>& textures);
+	// Copies block into the uniform buffer, creating it the first time
+	void Upload();
+	// Records binding the textures with their samplers and the uniform buffer. Roles without a texture get
+	// their fallback texture, roles keep what is bound only while the fallbacks don't exist yet
+	void Bind(CommandBuffer& commands) const;
+	// Checks if binding other after this one would change nothing, counting the fallback textures both would bind
+	bool SameBindings(const Material& other) const;
+	// Hash of everything Bind records, equal for materials that bind the same. Draws sorted by it keep
+	// the materials SameBindings finds equal next to each other
+	uint64_t BindingKey() const;
+	// Deletes the uniform buffer, the textures belong to whoever created them
+	void Delete();
+};
+
+#endif
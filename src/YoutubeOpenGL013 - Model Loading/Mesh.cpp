@@ -1,7 +1,24 @@
 #include <fstream>
 #include "Mesh.h"
+#include "CommandExecutor.h"
 
 Mesh::Mesh(std::vector <Vertex>& vertices, std::vector <GLuint>& indices, std::vector <Texture>& textures)
+	: Mesh(vertices, indices, textures, AABB::Empty())
+{
+	for (unsigned int i = 0; i < vertices.size(); i++)
+	{
+		bounds.Expand(vertices[i].position);
+	}
+}
+
+
+Mesh::Mesh(std::vector <Vertex>& vertices, std::vector <GLuint>& indices, std::vector <Texture>& textures, AABB bounds)
+	: Mesh(vertices, indices, textures, bounds, Material())
+{
+}
+
+
+Mesh::Mesh(std::vector <Vertex>& vertices, std::vector <GLuint>& indices, std::vector <Texture>& textures, AABB bounds, const Material& material)
 {
 	std::cout << "Vertices count:" << vertices.size() << std::endl;
 	std::cout << "Indices count:" << indices.size() << std::endl;
@@ -10,27 +27,81 @@ Mesh::Mesh(std::vector <Vertex>& vertices, std::vector <GLuint>& indices, std::v
 	Mesh::vertices = vertices;
 	Mesh::indices = indices;
 	Mesh::textures = textures;
+	Mesh::bounds = bounds;
+	Mesh::material = material;
+	Mesh::material.SetTextures(textures);
   
-	VAO.Bind();
-	// Generates Vertex Buffer Object and links it to vertices
-	VBO VBO(vertices);
-	// Generates Element Buffer Object and links it to indices
-	EBO EBO(indices);
-	// Links VBO attributes such as coordinates and colors to VAO
-	VAO.LinkAttrib(VBO, 0, 3, GL_FLOAT, sizeof(Vertex), (void*)0);
-	VAO.LinkAttrib(VBO, 1, 3, GL_FLOAT, sizeof(Vertex), (void*)(3 * sizeof(float)));
-	VAO.LinkAttrib(VBO, 2, 3, GL_FLOAT, sizeof(Vertex), (void*)(6 * sizeof(float)));
-	VAO.LinkAttrib(VBO, 3, 2, GL_FLOAT, sizeof(Vertex), (void*)(9 * sizeof(float)));
-	// Unbind all to prevent accidentally modifying them
-	VAO.Unbind();
-	VBO.Unbind();
-	EBO.Unbind();
+	// Copies the vertices and indices into the buffers shared by all meshes
+	geometry = GeometryArena::Shared().Allocate(vertices, indices);
 }
 
 
-void Mesh::Draw
+void Mesh::Delete()
+{
+	GeometryArena::Shared().Free(geometry);
+	if (occlusionQuery != 0)
+	{
+		glDeleteQueries(1, &occlusionQuery);
+		occlusionQuery = 0;
+	}
+}
+
+
+void Mesh::EnableOcclusionQuery()
+{
+	if (occlusionQuery == 0)
+	{
+		glGenQueries(1, &occlusionQuery);
+	}
+}
+
+
+void Mesh::QueryOcclusion(OcclusionQueryPass& pass, const AABB& worldBox)
+{
+	// Starting a new query on the same object would throw the pending result away
+	if (occlusionQuery == 0 || queryPending)
+	{
+		return;
+	}
+	glBeginQuery(pass.target, occlusionQuery);
+	pass.DrawBox(worldBox);
+	glEndQuery(pass.target);
+	queryPending = true;
+	queryIssued = true;
+}
+
+
+bool Mesh::PollOcclusion()
+{
+	if (queryPending)
+	{
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(occlusionQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available)
+		{
+			GLuint samplesPassed = GL_FALSE;
+			glGetQueryObjectuiv(occlusionQuery, GL_QUERY_RESULT, &samplesPassed);
+			occluded = samplesPassed == GL_FALSE;
+			queryPending = false;
+		}
+	}
+	return occluded;
+}
+
+
+void Mesh::ResetOcclusion()
+{
+	// The next query may reuse the object even if the old result never got read, GL replaces it
+	occluded = false;
+	queryPending = false;
+	queryIssued = false;
+}
+
+
+void Mesh::Record
 (
-		Shader& shader, 
+		CommandBuffer& commands,
+		Shader& shader,
 		Camera& camera,
 		glm::mat4 matrix,
 		glm::vec3 translation,
@@ -39,31 +110,15 @@ void Mesh::Draw
 )
 {
 	// Bind shader to be able to access uniforms
-	shader.Activate();
-	VAO.Bind();
-
-	// Keep track of how many of each type of textures we have
-	unsigned int numDiffuse = 0;
-	unsigned int numSpecular = 0;
+	commands.UseProgram(shader.ID);
+	GeometryArena& arena = GeometryArena::Shared();
+	commands.BindVertexArray(arena.vertexArray.ID);
 
-	for (unsigned int i = 0; i < textures.size(); i++)
-	{
-		std::string num;
-		std::string type = textures[i].type;
-		if (type == "diffuse")
-		{
-			num = std::to_string(numDiffuse++);
-		}
-		else if (type == "specular")
-		{
-			num = std::to_string(numSpecular++);
-		}
-		textures[i].texUnit(shader, (type + num).c_str(), i);
-		textures[i].Bind();
-	}
+	// Sampler uniforms point at fixed units since Material::SetupShader, so only the objects change
+	material.Bind(commands);
 	// Take care of the camera Matrix
-	glUniform3f(glGetUniformLocation(shader.ID, "camPos"), camera.Position.x, camera.Position.y, camera.Position.z);
-	camera.Matrix(shader, "camMatrix");
+	commands.Uniform3f(shader.Uniform("camPos"), camera.Position);
+	camera.Matrix(commands, shader, "camMatrix");
 
 	glm::mat4 trans = glm::mat4(1.0f);
 	glm::mat4 rot = glm::mat4(1.0f);
@@ -73,11 +128,39 @@ void Mesh::Draw
 	rot = glm::mat4_cast(rotation);
 	sca = glm::scale(sca, scale);
 	
-	glUniformMatrix4fv(glGetUniformLocation(shader.ID, "translation"), 1, GL_FALSE, glm::value_ptr(trans));
-	glUniformMatrix4fv(glGetUniformLocation(shader.ID, "rotation"), 1, GL_FALSE, glm::value_ptr(rot));
-	glUniformMatrix4fv(glGetUniformLocation(shader.ID, "scale"), 1, GL_FALSE, glm::value_ptr(sca));
-	glUniformMatrix4fv(glGetUniformLocation(shader.ID, "model"), 1, GL_FALSE, glm::value_ptr(matrix));
-
-	// Draw the actual mesh
-	glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-}
\ No newline at end of file
+	commands.UniformMatrix4f(shader.Uniform("translation"), trans);
+	commands.UniformMatrix4f(shader.Uniform("rotation"), rot);
+	commands.UniformMatrix4f(shader.Uniform("scale"), sca);
+	commands.UniformMatrix4f(shader.Uniform("model"), matrix);
+
+	// Draw the actual mesh from its place inside the arena
+	const GeometryRange& range = arena.Get(geometry);
+	// The GPU skips the draw by itself when the last box query saw no samples,
+	// with QUERY_NO_WAIT it draws anyway instead of stalling when the result isn't there yet
+	if (queryIssued)
+	{
+		commands.BeginConditionalRender(occlusionQuery, true);
+	}
+	commands.DrawIndexed(range.indexCount, range.firstIndex, range.baseVertex);
+	if (queryIssued)
+	{
+		commands.EndConditionalRender();
+	}
+}
+
+
+void Mesh::Draw
+(
+		CommandBuffer& commands,
+		Shader& shader,
+		Camera& camera,
+		glm::mat4 matrix,
+		glm::vec3 translation,
+		glm::quat rotation,
+		glm::vec3 scale
+)
+{
+	commands.Reset();
+	Record(commands, shader, camera, matrix, translation, rotation, scale);
+	ExecuteCommands(commands);
+}
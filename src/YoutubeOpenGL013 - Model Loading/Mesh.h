@@ -3,10 +3,12 @@
 
 #include<string>
 
-#include"VAO.h"
-#include"EBO.h"
+#include"GeometryArena.h"
 #include"Camera.h"
 #include"Texture.h"
+#include"Material.h"
+#include"Bounds.h"
+#include"OcclusionQueryPass.h"
 
 class Mesh
 {
@@ -14,15 +16,54 @@ public:
 	std::vector <Vertex> vertices;
 	std::vector <GLuint> indices;
 	std::vector <Texture> textures;
-	// Store VAO in public so it can be used in the Draw function
-	VAO VAO;
+	// Factors and texture bindings, bound with one call before every draw. The mesh doesn't own its uniform buffer
+	Material material;
+	// Handle to the vertices and indices inside the shared geometry arena
+	GeometryArena::Handle geometry;
+	// Bounding box of the vertices in the space of the mesh
+	AABB bounds;
+	// Occlusion query around the bounding box, 0 unless EnableOcclusionQuery was called
+	GLuint occlusionQuery = 0;
+	// Set while a query was issued and its result hasn't been read yet
+	bool queryPending = false;
+	// Set once the query has run at least once, conditional rendering needs a finished query
+	bool queryIssued = false;
+	// Result of the last query that finished
+	bool occluded = false;
 
-	// Initializes the mesh
+	// Initializes the mesh, the bounds are computed from the vertices
 	Mesh(std::vector <Vertex>& vertices, std::vector <GLuint>& indices, std::vector <Texture>& textures);
+	// Initializes the mesh with bounds that are already known, such as the min/max of a glTF accessor
+	Mesh(std::vector <Vertex>& vertices, std::vector <GLuint>& indices, std::vector <Texture>& textures, AABB bounds);
+	// Initializes the mesh with the factors of a material, its textures are taken from textures
+	Mesh(std::vector <Vertex>& vertices, std::vector <GLuint>& indices, std::vector <Texture>& textures, AABB bounds, const Material& material);
 
-	// Draws the mesh
+	// Releases the geometry of the mesh inside the arena
+	void Delete();
+	// Creates the occlusion query, worth it for meshes with many vertices
+	void EnableOcclusionQuery();
+	// Issues a query around a world space box unless the last one is still pending, call between pass.Begin and pass.End
+	void QueryOcclusion(OcclusionQueryPass& pass, const AABB& worldBox);
+	// Reads the result of the pending query if the GPU has it already and returns if the mesh was hidden. Never waits
+	bool PollOcclusion();
+	// Forgets the last result, for a mesh that wasn't queried for a while so its result describes an old view
+	void ResetOcclusion();
+	// Records everything Draw does, needs no context so it can run on any thread
+	void Record
+	(
+		CommandBuffer& commands,
+		Shader& shader, 
+		Camera& camera,
+		glm::mat4 matrix = glm::mat4(1.0f),
+		glm::vec3 translation = glm::vec3(0.0f, 0.0f, 0.0f),
+		glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+		glm::vec3 scale = glm::vec3(1.0f, 1.0f, 1.0f)
+	);
+	// Records the mesh into commands, which is reset first, and runs them right away. Only on the context
+	// thread, the caller keeps the buffer so its memory is reused from one draw to the next
 	void Draw
 	(
+		CommandBuffer& commands,
 		Shader& shader, 
 		Camera& camera,
 		glm::mat4 matrix = glm::mat4(1.0f),
@@ -1,22 +1,413 @@
 #include "Model.h"
 
+#include <algorithm>
+#include <cmath>
 
-Model::Model(const char* file)
+#include "JobSystem.h"
+#include "CommandExecutor.h"
+#include "SamplerCache.h"
+
+// part13.vert multiplies by -rotation, which mirrors every mesh through the origin
+static const glm::mat4 mirror = glm::scale(glm::mat4(1.0f), glm::vec3(-1.0f, -1.0f, -1.0f));
+// Below this many meshes a flat SIMD loop is faster than walking the hierarchy
+static const unsigned int bvhCullThreshold = 256;
+// Anisotropic filtering of the textures of a file, for samplers with mip levels. Clamped to what the context supports
+static const float textureAnisotropy = 8.0f;
+
+
+Model::Model(const char* file, TextureUploader* uploader)
 {
+  Model::uploader = uploader;
   std::string text = get_file_contents(file);
   JSON = nlohmann::json::parse(text);
   
   Model::file = file;
   data = getData();
+  loadMaterials();
+  loadTextures();
   
   traverseNode(0);
+  computeBounds();
 }
 
 void Model::Draw(Shader& shader, Camera& camera)
 {
+  Cull(camera);
+  // All meshes go into one stream that is replayed at the end
+  drawCommands.Reset();
+  for (unsigned int v = 0; v < visibleMeshes.size(); v++)
+  {
+    unsigned int i = visibleMeshes[v];
+    meshes[i].Record(drawCommands, shader, camera, matricesMeshes[i]);
+  }
+  ExecuteCommands(drawCommands);
+}
+
+
+void Model::RequestTextureLevels(TextureResidency& residency, Camera& camera)
+{
+  // Pixels one unit at distance one covers on screen
+  float pixelsPerUnit = camera.height * 0.5f / std::tan(glm::radians(camera.FOVdeg) * 0.5f);
+  for (unsigned int i = 0; i < meshes.size(); i++)
+  {
+    if (meshes[i].textures.empty() || uvDensities[i] <= 0.0f)
+    {
+      continue;
+    }
+    // The nearest point of the bounding sphere needs the most detail
+    const BoundingSphere& sphere = spheresMeshes[i];
+    float distance = std::max(glm::length(sphere.center - camera.Position) - sphere.radius, camera.nearPlane);
+    // World units per mesh unit, the largest axis scale of the transform
+    const glm::mat4& world = worldMatrices[i];
+    float scale = std::max(glm::length(glm::vec3(world[0])), std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+    float uvPerWorldUnit = uvDensities[i] / std::max(scale, 1e-6f);
+    float uvPerPixel = uvPerWorldUnit * distance / pixelsPerUnit;
+    for (unsigned int t = 0; t < meshes[i].textures.size(); t++)
+    {
+      residency.Request(meshes[i].textures[t].ID, uvPerPixel);
+    }
+  }
+}
+
+
+void Model::AddToRegistry(Registry& registry)
+{
+  Model::registry = &registry;
+  meshEntities.clear();
   for (unsigned int i = 0; i < meshes.size(); i++)
   {
-    meshes[i].Mesh::Draw(shader, camera, matricesMeshes[i]);
+    Entity entity = registry.Create();
+    registry.Add(entity, TransformComponent{ matricesMeshes[i] });
+    registry.Add(entity, MeshComponent{ &meshes[i] });
+    registry.Add(entity, materialOf(i));
+    registry.Add(entity, BoundsComponent{ boundsMeshes[i], spheresMeshes[i] });
+    registry.Add(entity, VisibilityComponent{ true, 0 });
+    meshEntities.push_back(entity);
+  }
+  // Everything the culling and submission loops read sits at the same index in every pool
+  registry.Align<TransformComponent, MeshComponent>();
+  registry.Align<TransformComponent, MaterialComponent>();
+  registry.Align<TransformComponent, BoundsComponent>();
+  registry.Align<TransformComponent, VisibilityComponent>();
+}
+
+
+void Model::Update()
+{
+  if (!scene.IsDirty())
+  {
+    return;
+  }
+  changedNodes.clear();
+  changedMeshes.clear();
+  scene.Update(changedNodes);
+  for (unsigned int n = 0; n < changedNodes.size(); n++)
+  {
+    int mesh = scene.meshIndices[changedNodes[n]];
+    if (mesh >= 0)
+    {
+      matricesMeshes[mesh] = scene.worlds[changedNodes[n]];
+      updateMeshBounds(mesh);
+      changedMeshes.push_back(mesh);
+      if (registry != NULL)
+      {
+        registry->Get<TransformComponent>(meshEntities[mesh]).model = matricesMeshes[mesh];
+        registry->Get<BoundsComponent>(meshEntities[mesh]) = BoundsComponent{ boundsMeshes[mesh], spheresMeshes[mesh] };
+      }
+    }
+  }
+  // The tree structure stays, only the boxes above the moved meshes grow or shrink
+  meshBVH.Refit(boundsMeshes, changedMeshes);
+  for (unsigned int o = 0; o < occluders.size(); o++)
+  {
+    occluders[o].world = worldMatrices[occluderMeshes[o]];
+  }
+}
+
+
+void Model::Cull(Camera& camera)
+{
+  Frustum frustum(camera.cameraMatrix);
+  
+  visibleMeshes.clear();
+  if (meshes.size() >= bvhCullThreshold)
+  {
+    // Rejects whole groups of meshes at once, sorted afterwards so batching sees the meshes in order
+    meshBVH.Cull(frustum, boundsMeshes, visibleMeshes);
+    std::sort(visibleMeshes.begin(), visibleMeshes.end());
+  }
+  else
+  {
+    CullBoxes(frustum, cullingBounds, 0, cullingBounds.Size(), visibleMeshes);
+  }
+  
+  occludedCount = 0;
+  if (occlusionCulling && !occluders.empty())
+  {
+    // Nothing here waits on the GPU, so this overlaps with the GPU drawing the last frame
+    size_t inFrustum = visibleMeshes.size();
+    occlusion.Render(camera.cameraMatrix, occluders);
+    occlusion.Filter(boundsMeshes, visibleMeshes);
+    occludedCount = inFrustum - visibleMeshes.size();
+  }
+  
+  // Meshes whose box query came back empty are skipped, they keep being queried so they can come back
+  previousQueriedMeshes.swap(queriedMeshes);
+  queriedMeshes.clear();
+  size_t kept = 0;
+  for (size_t v = 0; v < visibleMeshes.size(); v++)
+  {
+    unsigned int i = visibleMeshes[v];
+    if (meshes[i].occlusionQuery != 0)
+    {
+      queriedMeshes.push_back(i);
+      if (meshes[i].PollOcclusion())
+      {
+        occludedCount++;
+        continue;
+      }
+    }
+    visibleMeshes[kept++] = i;
+  }
+  visibleMeshes.resize(kept);
+  
+  // A mesh that was culled before the queries got to it keeps the result from when it was last seen.
+  // It would be skipped, or conditionally rendered, on that stale result when it comes back, so the
+  // meshes queried last time but not now start over. Both lists are sorted
+  size_t q = 0;
+  for (size_t p = 0; p < previousQueriedMeshes.size(); p++)
+  {
+    unsigned int i = previousQueriedMeshes[p];
+    while (q < queriedMeshes.size() && queriedMeshes[q] < i)
+    {
+      q++;
+    }
+    if (q == queriedMeshes.size() || queriedMeshes[q] != i)
+    {
+      meshes[i].ResetOcclusion();
+    }
+  }
+  visibleCount = visibleMeshes.size();
+  culledCount = meshes.size() - visibleCount;
+}
+
+
+void Model::ChooseOccluders(float minRadiusFraction)
+{
+  float largest = 0.0f;
+  for (unsigned int i = 0; i < spheresMeshes.size(); i++)
+  {
+    largest = std::max(largest, spheresMeshes[i].radius);
+  }
+  
+  occluders.clear();
+  occluderMeshes.clear();
+  occluderPositions.clear();
+  occluderPositions.reserve(meshes.size());
+  for (unsigned int i = 0; i < meshes.size(); i++)
+  {
+    if (spheresMeshes[i].radius < largest * minRadiusFraction)
+    {
+      continue;
+    }
+    // The rasterizer only needs the positions, not the whole vertex
+    occluderPositions.push_back(std::vector<glm::vec3>());
+    std::vector<glm::vec3>& positions = occluderPositions.back();
+    for (unsigned int v = 0; v < meshes[i].vertices.size(); v++)
+    {
+      positions.push_back(meshes[i].vertices[v].position);
+    }
+    occluders.push_back(OcclusionCuller::Occluder{ &positions, &meshes[i].indices, worldMatrices[i] });
+    occluderMeshes.push_back(i);
+  }
+}
+
+
+void Model::EnableOcclusionQueries(GLsizei minIndices)
+{
+  for (unsigned int i = 0; i < meshes.size(); i++)
+  {
+    if (meshes[i].indices.size() >= (size_t)minIndices)
+    {
+      meshes[i].EnableOcclusionQuery();
+    }
+  }
+}
+
+
+void Model::QueryOcclusion(OcclusionQueryPass& pass, Camera& camera)
+{
+  if (queriedMeshes.empty())
+  {
+    return;
+  }
+  pass.Begin(camera.cameraMatrix);
+  for (unsigned int q = 0; q < queriedMeshes.size(); q++)
+  {
+    unsigned int i = queriedMeshes[q];
+    // From inside a box the near plane cuts its sides away, so the query can't be trusted
+    AABB reach = boundsMeshes[i];
+    reach.min -= glm::vec3(camera.nearPlane);
+    reach.max += glm::vec3(camera.nearPlane);
+    if (glm::all(glm::greaterThanEqual(camera.Position, reach.min)) && glm::all(glm::lessThanEqual(camera.Position, reach.max)))
+    {
+      meshes[i].occluded = false;
+      continue;
+    }
+    meshes[i].QueryOcclusion(pass, boundsMeshes[i]);
+  }
+  pass.End();
+}
+
+
+bool Model::Raycast(glm::vec3 origin, glm::vec3 direction, float maxDistance, unsigned int& hitMesh, float& hitDistance)
+{
+  direction = glm::normalize(direction);
+  BVH::RayTest test = [&](unsigned int i)
+  {
+    // Intersect in the space of the mesh and measure the distance back in world space
+    glm::mat4 inverse = glm::inverse(worldMatrices[i]);
+    glm::vec3 localOrigin = glm::vec3(inverse * glm::vec4(origin, 1.0f));
+    glm::vec3 localDirection = glm::vec3(inverse * glm::vec4(direction, 0.0f));
+    
+    float closest = -1.0f;
+    std::vector<Vertex>& vertices = meshes[i].vertices;
+    std::vector<GLuint>& indices = meshes[i].indices;
+    for (unsigned int t = 0; t + 2 < indices.size(); t += 3)
+    {
+      // Moller-Trumbore ray/triangle intersection
+      glm::vec3 a = vertices[indices[t]].position;
+      glm::vec3 edge1 = vertices[indices[t + 1]].position - a;
+      glm::vec3 edge2 = vertices[indices[t + 2]].position - a;
+      glm::vec3 p = glm::cross(localDirection, edge2);
+      float det = glm::dot(edge1, p);
+      if (std::fabs(det) < 1e-8f) continue;
+      glm::vec3 s = localOrigin - a;
+      float u = glm::dot(s, p) / det;
+      if (u < 0.0f || u > 1.0f) continue;
+      glm::vec3 q = glm::cross(s, edge1);
+      float v = glm::dot(localDirection, q) / det;
+      if (v < 0.0f || u + v > 1.0f) continue;
+      float tLocal = glm::dot(edge2, q) / det;
+      if (tLocal < 0.0f) continue;
+      
+      glm::vec3 worldHit = glm::vec3(worldMatrices[i] * glm::vec4(localOrigin + tLocal * localDirection, 1.0f));
+      float distance = glm::length(worldHit - origin);
+      if (closest < 0.0f || distance < closest)
+      {
+        closest = distance;
+      }
+    }
+    return closest;
+  };
+  return meshBVH.Raycast(origin, direction, maxDistance, test, hitMesh, hitDistance);
+}
+
+
+void Model::DrawIndirect(Shader& shader, Camera& camera, StreamBuffer& stream, bool pullVertices, BindlessMaterials* materials)
+{
+  Cull(camera);
+  
+  shader.Activate();
+  GeometryArena& arena = GeometryArena::Shared();
+  if (pullVertices)
+  {
+    // Any vertex format can be drawn through the same VAO, only the indices come from it
+    arena.BindPulling(2);
+  }
+  else
+  {
+    arena.Bind();
+  }
+  
+  glUniform3f(shader.Uniform("camPos"), camera.Position.x, camera.Position.y, camera.Position.z);
+  
+  // Build the command list of this frame, meshes that need a different material start a new multi-draw.
+  // Roles a material has no texture for bind the white or black fallback, so they split batches like any other texture.
+  // Bindless draws pick their textures from the material table, so they all share one batch
+  bool bindless = materials != NULL && GLCaps.bindlessTexture;
+  commands.clear();
+  draws.clear();
+  batchStarts.clear();
+  batchMaterials.clear();
+  for (unsigned int v = 0; v < visibleMeshes.size(); v++)
+  {
+    unsigned int i = visibleMeshes[v];
+    bool newBatch = batchStarts.empty();
+    if (!newBatch && !bindless)
+    {
+      newBatch = !meshes[batchMaterials.back()].material.SameBindings(meshes[i].material);
+    }
+    if (newBatch)
+    {
+      batchStarts.push_back(commands.size());
+      batchMaterials.push_back(i);
+    }
+    
+    const GeometryRange& range = arena.Get(meshes[i].geometry);
+    // Pulled vertices are addressed by the shader, so gl_VertexID has to stay the raw index
+    GLint baseVertex = pullVertices ? 0 : range.baseVertex;
+    DrawElementsIndirectCommand command = { range.indexCount, 1, range.firstIndex, baseVertex, 0 };
+    commands.push_back(command);
+    DrawData draw = { matricesMeshes[i], (GLint)(range.vertexOffset / sizeof(float)), range.format, 0, { 0, 0 } };
+    if (bindless)
+    {
+      // Every mesh needs its own factors, meshes without textures get the white and black fallbacks
+      draw.material = (GLint)materials->Index(meshes[i].material);
+    }
+    draws.push_back(draw);
+  }
+  batchStarts.push_back(commands.size());
+  
+  if (commands.empty())
+  {
+    return;
+  }
+  
+  // Both lists go straight into mapped memory, nothing waits for the GPU
+  GLintptr commandOffset = stream.Upload(commands.data(), commands.size() * sizeof(DrawElementsIndirectCommand));
+  GLintptr drawOffset = stream.Upload(draws.data(), draws.size() * sizeof(DrawData), GLCaps.storageBufferAlignment);
+  stream.Flush();
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, stream.ID);
+  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, stream.ID, drawOffset, draws.size() * sizeof(DrawData));
+  if (bindless)
+  {
+    materials->Bind(3);
+  }
+  
+  for (unsigned int b = 0; b < batchMaterials.size(); b++)
+  {
+    if (!bindless)
+    {
+      textureCommands.Reset();
+      meshes[batchMaterials[b]].material.Bind(textureCommands);
+      ExecuteCommands(textureCommands);
+    }
+    // gl_DrawID restarts at 0 for every call, so tell the shader where this batch begins
+    glUniform1i(shader.Uniform("drawOffset"), batchStarts[b]);
+    glMultiDrawElementsIndirect
+    (
+      GL_TRIANGLES,
+      GL_UNSIGNED_INT,
+      (void*)(commandOffset + batchStarts[b] * sizeof(DrawElementsIndirectCommand)),
+      batchStarts[b + 1] - batchStarts[b],
+      0
+    );
+  }
+  
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+
+void Model::Delete()
+{
+  for (unsigned int i = 0; i < meshes.size(); i++)
+  {
+    meshes[i].Delete();
+  }
+  for (unsigned int i = 0; i < materials.size(); i++)
+  {
+    materials[i].Delete();
   }
 }
 
@@ -37,7 +428,32 @@ void Model::loadMesh(unsigned int indMesh)
   
   std::vector<Vertex> vertices = assembleVertices(positions, normals, texUVs);
   std::vector<GLuint> indices = getIndices(JSON["accessors"][indAccId]);
-  std::vector<Texture> textures = getTextures();
+  // The textures of the material, the primitive's own copies so textureReady can patch them
+  int indMaterial = JSON["meshes"][indMesh]["primitives"][0].value("material", -1);
+  const Material& material = indMaterial >= 0 ? materials[indMaterial] : materials.back();
+  std::vector<Texture> textures;
+  for (int r = 0; r < Material::ROLE_COUNT; r++)
+  {
+    if (material.images[r] >= 0 && imageTextures[material.images[r]] >= 0)
+    {
+      Texture texture = loadedTex[imageTextures[material.images[r]]];
+      texture.type = Material::RoleType((Material::Role)r);
+      textures.push_back(texture);
+    }
+  }
+  
+  // glTF requires min/max on position accessors, but computing them keeps broken files working
+  AABB bounds;
+  nlohmann::json posAccessor = JSON["accessors"][posAccId];
+  if (posAccessor.find("min") != posAccessor.end() && posAccessor.find("max") != posAccessor.end())
+  {
+    bounds.min = glm::vec3(posAccessor["min"][0].get<float>(), posAccessor["min"][1].get<float>(), posAccessor["min"][2].get<float>());
+    bounds.max = glm::vec3(posAccessor["max"][0].get<float>(), posAccessor["max"][1].get<float>(), posAccessor["max"][2].get<float>());
+  }
+  else
+  {
+    bounds = AABB::FromPoints(positions);
+  }
   
   // for (auto item: vertices)
   // {
@@ -46,11 +462,51 @@ void Model::loadMesh(unsigned int indMesh)
   //   std::cout << "Index: " << item.position.z << std::endl;
   //   break;
   // }
-  meshes.push_back(Mesh(vertices, indices, textures));
+  // How much of the texture one unit of surface covers, for picking mip levels to stream
+  float surfaceArea = 0.0f;
+  float uvArea = 0.0f;
+  for (unsigned int i = 0; i + 2 < indices.size(); i += 3)
+  {
+    const Vertex& a = vertices[indices[i]];
+    const Vertex& b = vertices[indices[i + 1]];
+    const Vertex& c = vertices[indices[i + 2]];
+    surfaceArea += 0.5f * glm::length(glm::cross(b.position - a.position, c.position - a.position));
+    glm::vec2 ab = b.texUV - a.texUV;
+    glm::vec2 ac = c.texUV - a.texUV;
+    uvArea += 0.5f * std::abs(ab.x * ac.y - ab.y * ac.x);
+  }
+  uvDensities.push_back(surfaceArea > 0.0f ? std::sqrt(uvArea / surfaceArea) : 0.0f);
+  
+  meshes.push_back(Mesh(vertices, indices, textures, bounds, material));
+}
+
+
+void Model::computeBounds()
+{
+  boundsMeshes.resize(meshes.size());
+  spheresMeshes.resize(meshes.size());
+  worldMatrices.resize(meshes.size());
+  cullingBounds.Clear();
+  for (unsigned int i = 0; i < meshes.size(); i++)
+  {
+    cullingBounds.Push(AABB::Empty(), BoundingSphere());
+    updateMeshBounds(i);
+  }
+  meshBVH.Build(boundsMeshes);
+}
+
+
+void Model::updateMeshBounds(unsigned int indMesh)
+{
+  glm::mat4 world = mirror * matricesMeshes[indMesh];
+  worldMatrices[indMesh] = world;
+  boundsMeshes[indMesh] = meshes[indMesh].bounds.Transform(world);
+  spheresMeshes[indMesh] = BoundingSphere::FromAABB(meshes[indMesh].bounds, world);
+  cullingBounds.Set(indMesh, boundsMeshes[indMesh], spheresMeshes[indMesh]);
 }
 
 
-void Model::traverseNode(unsigned int nextNode, glm::mat4 matrix)
+void Model::traverseNode(unsigned int nextNode, int parent)
 {
   nlohmann::json node = JSON["nodes"][nextNode];
   
@@ -100,22 +556,15 @@ void Model::traverseNode(unsigned int nextNode, glm::mat4 matrix)
     matNode = glm::make_mat4(matValues);
   }
   
-  glm::mat4 trans = glm::mat4(1.0f);
-  glm::mat4 rot = glm::mat4(1.0f);
-  glm::mat4 sca = glm::mat4(1.0f);
-  
-  trans = glm::translate(trans, translation);
-  rot = glm::mat4_cast(rotation);
-  sca = glm::scale(sca, scale);
+  // The scene graph keeps the local transform and computes the world matrix from the parent
+  bool hasMesh = node.find("mesh") != node.end();
+  int meshIndex = hasMesh ? (int)meshes.size() : -1;
+  unsigned int sceneNode = scene.AddNode(parent, meshIndex, matNode, translation, rotation, scale);
   
-  glm::mat4 matNextNode = matrix * matNode * trans * rot * sca;
-  
-  if (node.find("mesh") != node.end())
+  if (hasMesh)
   {
-    translationsMeshes.push_back(translation);
-    rotationsMeshes.push_back(rotation);
-    scalesMeshes.push_back(scale);
-    matricesMeshes.push_back(matNextNode);
+    matricesMeshes.push_back(scene.worlds[sceneNode]);
+    meshNodes.push_back(sceneNode);
     
     loadMesh(node["mesh"]);
   }
@@ -124,7 +573,7 @@ void Model::traverseNode(unsigned int nextNode, glm::mat4 matrix)
   {
     for (unsigned int i = 0; i < node["children"].size(); i++)
     {
-      traverseNode(node["children"][i], matNextNode);
+      traverseNode(node["children"][i], sceneNode);
     }
   }
 }
@@ -226,46 +675,136 @@ std::vector<GLuint> Model::getIndices(nlohmann::json accessor)
 }
 
 
-std::vector<Texture> Model::getTextures()
+void Model::loadMaterials()
 {
-  std::vector<Texture> textures;
+  nlohmann::json materialList = JSON["materials"];
+  for (unsigned int i = 0; i < materialList.size(); i++)
+  {
+    materials.push_back(Material(JSON, i));
+  }
+  materials.push_back(Material());
   
+  // Texture references without a sampler get the default SamplerState, the one glTF leaves to the renderer
+  nlohmann::json samplerList = JSON["samplers"];
+  for (unsigned int i = 0; i < materials.size(); i++)
+  {
+    for (int r = 0; r < Material::ROLE_COUNT; r++)
+    {
+      if (materials[i].images[r] < 0)
+      {
+        continue;
+      }
+      int sampler = materials[i].samplers[r];
+      SamplerState state = SamplerState::FromGLTF(sampler >= 0 ? samplerList[sampler] : nlohmann::json::object());
+      if (state.UsesMipmaps())
+      {
+        state.anisotropy = textureAnisotropy;
+      }
+      materials[i].samplerObjects[r] = SamplerCache::Shared().Get(state);
+    }
+    materials[i].Upload();
+  }
+}
+
+
+void Model::loadTextures()
+{
   std::string fileStr = std::string(file);
   std::string fileDirectory = fileStr.substr(0, fileStr.find_last_of('/') + 1);
   
-  for (unsigned int i = 0; i < JSON["images"].size(); i++)
+  // The role of an image comes from the first material that uses it
+  nlohmann::json imageList = JSON["images"];
+  std::vector<const char*> imageTypes(imageList.size(), (const char*)NULL);
+  for (unsigned int m = 0; m < materials.size(); m++)
   {
-    std::string texPath = JSON["images"][i]["uri"];
-    
-    bool skip = false;
-    for (unsigned int j = 0; j < loadedTexName.size(); j++)
+    for (int r = 0; r < Material::ROLE_COUNT; r++)
     {
-      if (loadedTexName[j] == texPath)
+      int image = materials[m].images[r];
+      if (image >= 0 && image < (int)imageTypes.size() && imageTypes[image] == NULL)
       {
-        skip = true;
-        break;
+        imageTypes[image] = Material::RoleType((Material::Role)r);
       }
     }
-    
-    if (skip) continue;
-    
-    if (texPath.find("baseColor") != std::string::npos)
+  }
+  std::vector<unsigned int> texImages;
+  std::vector<std::string> texPaths;
+  for (unsigned int i = 0; i < imageList.size(); i++)
+  {
+    if (imageTypes[i] != NULL)
     {
-      Texture diffuse = Texture((fileDirectory + texPath).c_str(), "diffuse", loadedTex.size());
-      textures.push_back(diffuse);
-      loadedTex.push_back(diffuse);
-      loadedTexName.push_back(texPath);
+      texImages.push_back(i);
+      texPaths.push_back(imageList[i]["uri"]);
     }
-    else if (texPath.find("metallicRoughness") != std::string::npos)
+  }
+  
+  // Decoding is the slow part and needs no OpenGL, so every image is decoded as its own job
+  std::vector<TextureImage> images(texPaths.size());
+  ParallelFor(texPaths.size(), 1, [&](size_t, size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; i++)
     {
-      Texture specular = Texture((fileDirectory + texPath).c_str(), "specular", loadedTex.size());
-      textures.push_back(specular);
-      loadedTex.push_back(specular);
-      loadedTexName.push_back(texPath);
+      images[i] = TextureImage::Load((fileDirectory + texPaths[i]).c_str());
     }
-  }
+  });
   
-  return textures;
+  imageTextures.assign(imageList.size(), -1);
+  for (unsigned int i = 0; i < texPaths.size(); i++)
+  {
+    GLuint slot = loadedTex.size();
+    const char* texType = imageTypes[texImages[i]];
+    imageTextures[texImages[i]] = slot;
+    if (uploader != NULL)
+    {
+      // The uploader creates the texture, until then the meshes keep a placeholder with ID 0
+      loadedTex.push_back(Texture((GLuint)0, texType, slot));
+      uploader->UploadTexture(images[i], texType, slot, [this, slot](GLuint ID)
+      {
+        textureReady(slot, ID);
+      });
+    }
+    else
+    {
+      // Without an uploader the textures are created here, on the thread that owns the context
+      loadedTex.push_back(Texture(images[i], texType, slot));
+    }
+  }
+}
+
+
+MaterialComponent Model::materialOf(unsigned int indMesh)
+{
+  const Material& material = meshes[indMesh].material;
+  return MaterialComponent{ material.BindingKey() };
+}
+
+
+// Puts a texture that finished uploading in place of its placeholder
+void Model::textureReady(GLuint slot, GLuint ID)
+{
+  // Slots are the index in loadedTex, so they tell the textures of this model apart
+  loadedTex[slot].ID = ID;
+  for (unsigned int i = 0; i < meshes.size(); i++)
+  {
+    bool changed = false;
+    for (unsigned int t = 0; t < meshes[i].textures.size(); t++)
+    {
+      Texture& texture = meshes[i].textures[t];
+      if (texture.unit == slot && texture.ID == 0)
+      {
+        texture.ID = ID;
+        changed = true;
+      }
+    }
+    if (!changed)
+    {
+      continue;
+    }
+    meshes[i].material.SetTextures(meshes[i].textures);
+    if (registry != NULL)
+    {
+      registry->Get<MaterialComponent>(meshEntities[i]) = materialOf(i);
+    }
+  }
 }
 
 
@@ -3,35 +3,158 @@
 
 #include <json/json.h>
 #include "Mesh.h"
+#include "StreamBuffer.h"
+#include "FrustumCulling.h"
+#include "BVH.h"
+#include "OcclusionCuller.h"
+#include "SceneGraph.h"
+#include "Registry.h"
+#include "Components.h"
+#include "TextureUploader.h"
+#include "TextureResidency.h"
+#include "BindlessMaterials.h"
+
+
+// Layout of one record read by glMultiDrawElementsIndirect, written to the stream buffer every frame
+struct DrawElementsIndirectCommand
+{
+  GLuint count;
+  GLuint instanceCount;
+  GLuint firstIndex;
+  GLint baseVertex;
+  GLuint baseInstance;
+};
+
+// Per-draw data read by shader/indirect.vert and shader/pulling.vert through gl_DrawID (std430 layout)
+struct DrawData
+{
+  glm::mat4 model;
+  // Where the vertices of the draw start inside the arena and how they are laid out, in floats.
+  // Only used when the shader pulls the vertices itself
+  GLint vertexOffset;
+  VertexFormat format;
+  // Entry of the bindless material table the draw samples its textures from
+  GLint material;
+  GLint padding[2];
+};
 
 class Model
 {
   public:
-    Model(const char* file);
+    // With an uploader the textures are created later, by the upload thread or the pixel buffer
+    // streamer, and meshes draw without them until they arrive. Otherwise they are created right here
+    Model(const char* file, TextureUploader* uploader = NULL);
+    
+    // Node hierarchy of the file, change transforms through it and call Update
+    SceneGraph scene;
+    
+    // Number of meshes the last Cull kept and skipped. Skipped meshes failed the frustum test,
+    // the CPU occlusion test or their last occlusion query
+    unsigned int visibleCount = 0;
+    unsigned int culledCount = 0;
+    // How many of the skipped meshes were inside the frustum, hidden by the CPU occlusion test or their query
+    unsigned int occludedCount = 0;
+    // Tests the meshes that pass the frustum test against the occluders on the CPU as well
+    bool occlusionCulling = false;
+    
+    // Picks the meshes whose bounding sphere is at least minRadiusFraction of the largest one as occluders
+    void ChooseOccluders(float minRadiusFraction = 0.25f);
+    // Gives every mesh with at least minIndices indices a GPU occlusion query on its bounding box
+    void EnableOcclusionQueries(GLsizei minIndices = 30000);
+    // Issues the box queries of this frame, call after everything was drawn. Their results hide meshes in later frames
+    void QueryOcclusion(OcclusionQueryPass& pass, Camera& camera);
+    // Creates one entity per mesh with transform, mesh, material, bounds and visibility components.
+    // Update keeps their transforms and bounds in sync, the registry has to outlive the model
+    void AddToRegistry(Registry& registry);
+    // Brings the mesh matrices and bounds up to date with the nodes that changed in the scene graph
+    void Update();
+    // Tests every mesh against the view frustum of the camera, Draw and DrawIndirect call it themselves
+    void Cull(Camera& camera);
+    // Asks the residency manager for the mip level each textured mesh needs, from its size on screen and UV density
+    void RequestTextureLevels(TextureResidency& residency, Camera& camera);
+    // Finds the closest mesh triangle hit by a world space ray, for picking
+    bool Raycast(glm::vec3 origin, glm::vec3 direction, float maxDistance, unsigned int& hitMesh, float& hitDistance);
     void Draw(Shader& shader, Camera& camera);
+    // Draws every mesh through glMultiDrawElementsIndirect, needs GLCaps.multiDrawIndirect.
+    // Commands and per-draw data are written to the stream buffer, the Frame block has to be bound already.
+    // With pullVertices the shader reads the vertices from the arena itself (shader/pulling.vert).
+    // With a bindless material table every visible mesh goes into a single multi-draw and the shader
+    // samples its textures through the table (shader/bindless.frag), otherwise textures are bound per batch
+    void DrawIndirect(Shader& shader, Camera& camera, StreamBuffer& stream, bool pullVertices = false, BindlessMaterials* materials = NULL);
+    // Releases the geometry of all meshes and the uniform buffers of the materials
+    void Delete();
     
   private:
     const char* file;
+    TextureUploader* uploader;
     std::vector<unsigned char> data;
     nlohmann::json JSON;
     
     std::vector<Mesh> meshes;
-    std::vector<glm::vec3> translationsMeshes;
-    std::vector<glm::quat> rotationsMeshes;
-    std::vector<glm::vec3> scalesMeshes;
     std::vector<glm::mat4> matricesMeshes;
+    // Texture coordinate units per unit of mesh space of every mesh, the square root of UV area over surface area
+    std::vector<float> uvDensities;
+    // Scene graph node of every mesh
+    std::vector<unsigned int> meshNodes;
+    // Reused by Update
+    std::vector<unsigned int> changedNodes;
+    std::vector<unsigned int> changedMeshes;
+    // Entity of every mesh after AddToRegistry
+    Registry* registry = NULL;
+    std::vector<Entity> meshEntities;
+    // World space bounds of every mesh, computed once after loading
+    std::vector<AABB> boundsMeshes;
+    std::vector<BoundingSphere> spheresMeshes;
+    // The same bounds laid out for the SIMD culling loops
+    BoundsSoA cullingBounds;
+    // Hierarchy over boundsMeshes for large scenes and ray queries
+    BVH meshBVH;
+    std::vector<glm::mat4> worldMatrices;
+    // Depth buffer the occluders are rasterized into
+    OcclusionCuller occlusion;
+    std::vector<OcclusionCuller::Occluder> occluders;
+    std::vector<unsigned int> occluderMeshes;
+    std::vector<std::vector<glm::vec3>> occluderPositions;
+    // Meshes with a query that were inside the frustum in the last Cull, visible or not
+    std::vector<unsigned int> queriedMeshes;
+    // The same for the Cull before, to find the meshes that have left since
+    std::vector<unsigned int> previousQueriedMeshes;
+    // Meshes that survived the last Cull
+    std::vector<unsigned int> visibleMeshes;
+    
+    // Rebuilt every frame, kept here so the storage is reused
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<DrawData> draws;
+    std::vector<GLuint> batchStarts;
+    std::vector<unsigned int> batchMaterials;
+    // Recorded draws of Draw and the texture bindings of DrawIndirect
+    CommandBuffer drawCommands;
+    CommandBuffer textureCommands;
     
-    std::vector<std::string> loadedTexName;
+    // Entries of the materials array, followed by the glTF default material for primitives without one
+    std::vector<Material> materials;
     std::vector<Texture> loadedTex;
+    // Index in loadedTex of every glTF image, -1 for images no material uses
+    std::vector<int> imageTextures;
     
     void loadMesh(unsigned int indMesh);
+    void computeBounds();
+    void updateMeshBounds(unsigned int indMesh);
+    
+    void traverseNode(unsigned int nextNode, int parent = -1);
     
-    void traverseNode(unsigned int nextNode, glm::mat4 matrix = glm::mat4(1.0f));
+    // Bindings of the material of a mesh for its MaterialComponent
+    MaterialComponent materialOf(unsigned int indMesh);
+    // Puts a texture that finished uploading in place of its placeholder
+    void textureReady(GLuint slot, GLuint ID);
     
     std::vector<unsigned char> getData();
     std::vector<float> getFloats(nlohmann::json accessor);
     std::vector<GLuint> getIndices(nlohmann::json accessor);
-    std::vector<Texture> getTextures();
+    // Reads the materials and uploads their factors, once before the meshes are loaded
+    void loadMaterials();
+    // Loads every image a material uses, with the role the material gives it
+    void loadTextures();
     
     std::vector<Vertex> assembleVertices
     (
@@ -0,0 +1,329 @@
+#include"OcclusionCuller.h"
+
+#include<algorithm>
+#include<cmath>
+
+#include"JobSystem.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include<emmintrin.h>
+#define RASTER_SSE2
+#endif
+
+// Rows and boxes handed to one job
+static const unsigned int rowsPerJob = 16;
+static const unsigned int boxesPerJob = 256;
+
+// Limits a screen coordinate to [0, size] while it is still a float, casting a float outside the
+// range of int is undefined. NaN ends up at 0
+static float clampToScreen(float value, int size)
+{
+	return std::min((float)size, std::max(0.0f, value));
+}
+
+
+OcclusionCuller::OcclusionCuller(int width, int height)
+{
+	OcclusionCuller::width = (std::max(width, 4) + 3) & ~3;
+	OcclusionCuller::height = std::max(height, 1);
+
+	// Every level halves the previous one until a single texel is left
+	int levelWidth = OcclusionCuller::width;
+	int levelHeight = OcclusionCuller::height;
+	while (true)
+	{
+		levelWidths.push_back(levelWidth);
+		levelHeights.push_back(levelHeight);
+		levels.push_back(std::vector<float>(levelWidth * levelHeight, 1.0f));
+		if (levelWidth == 1 && levelHeight == 1)
+		{
+			break;
+		}
+		levelWidth = std::max(1, (levelWidth + 1) / 2);
+		levelHeight = std::max(1, (levelHeight + 1) / 2);
+	}
+}
+
+
+// Clears the depth buffer, rasterizes the occluders and builds the pyramid
+void OcclusionCuller::Render(const glm::mat4& viewProjection, const std::vector<Occluder>& occluders)
+{
+	OcclusionCuller::viewProjection = viewProjection;
+	std::fill(levels[0].begin(), levels[0].end(), 1.0f);
+
+	triangles.resize(occluders.size());
+	ParallelFor(occluders.size(), 1, [&](size_t, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			setupTriangles(occluders[i], triangles[i]);
+		}
+	});
+	// Every job owns a band of rows, so no two threads ever write the same pixel
+	ParallelFor(height, rowsPerJob, [&](size_t, size_t begin, size_t end)
+	{
+		rasterizeRows(begin, end);
+	});
+	buildHierarchy();
+}
+
+
+void OcclusionCuller::setupTriangles(const Occluder& occluder, std::vector<ScreenTriangle>& output) const
+{
+	output.clear();
+	const std::vector<glm::vec3>& positions = *occluder.positions;
+	const std::vector<GLuint>& indices = *occluder.indices;
+	glm::mat4 matrix = viewProjection * occluder.world;
+
+	for (size_t t = 0; t + 2 < indices.size(); t += 3)
+	{
+		ScreenTriangle triangle;
+		bool clipped = false;
+		for (int v = 0; v < 3; v++)
+		{
+			glm::vec4 clip = matrix * glm::vec4(positions[indices[t + v]], 1.0f);
+			// Triangles crossing the near plane are skipped instead of clipped,
+			// drawing less of an occluder can only ever keep more meshes visible
+			if (clip.w <= 1e-6f || clip.z < -clip.w)
+			{
+				clipped = true;
+				break;
+			}
+			float invW = 1.0f / clip.w;
+			triangle.x[v] = (clip.x * invW * 0.5f + 0.5f) * width;
+			triangle.y[v] = (clip.y * invW * 0.5f + 0.5f) * height;
+			triangle.z[v] = clip.z * invW * 0.5f + 0.5f;
+		}
+		if (!clipped)
+		{
+			output.push_back(triangle);
+		}
+	}
+}
+
+
+// Rasterizes every triangle into the rows [rowBegin, rowEnd) of level 0
+void OcclusionCuller::rasterizeRows(int rowBegin, int rowEnd)
+{
+	float* depth = levels[0].data();
+	for (size_t o = 0; o < triangles.size(); o++)
+	{
+		for (size_t t = 0; t < triangles[o].size(); t++)
+		{
+			ScreenTriangle tri = triangles[o][t];
+			float area = (tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0]) - (tri.y[1] - tri.y[0]) * (tri.x[2] - tri.x[0]);
+			if (std::fabs(area) < 1e-8f)
+			{
+				continue;
+			}
+			// Depth only, so both windings are drawn, turned around to always have a positive area
+			if (area < 0.0f)
+			{
+				std::swap(tri.x[1], tri.x[2]);
+				std::swap(tri.y[1], tri.y[2]);
+				std::swap(tri.z[1], tri.z[2]);
+				area = -area;
+			}
+
+			float left = std::min(tri.x[0], std::min(tri.x[1], tri.x[2]));
+			float right = std::max(tri.x[0], std::max(tri.x[1], tri.x[2]));
+			float bottom = std::min(tri.y[0], std::min(tri.y[1], tri.y[2]));
+			float top = std::max(tri.y[0], std::max(tri.y[1], tri.y[2]));
+			if (right < 0.0f || left >= width || top < rowBegin || bottom >= rowEnd)
+			{
+				continue;
+			}
+			int minX = (int)std::floor(clampToScreen(left, width));
+			int maxX = std::min(width - 1, (int)std::ceil(clampToScreen(right, width)));
+			int minY = std::max(rowBegin, (int)std::floor(clampToScreen(bottom, height)));
+			int maxY = std::min(rowEnd - 1, (int)std::ceil(clampToScreen(top, height)));
+			if (minX > maxX || minY > maxY)
+			{
+				continue;
+			}
+
+			// Edge functions e = a * x + b * y + c, positive inside. Edge i is opposite to vertex i
+			float a[3], b[3], c[3];
+			for (int e = 0; e < 3; e++)
+			{
+				int from = (e + 1) % 3;
+				int to = (e + 2) % 3;
+				a[e] = tri.y[from] - tri.y[to];
+				b[e] = tri.x[to] - tri.x[from];
+				c[e] = -(a[e] * tri.x[from] + b[e] * tri.y[from]);
+			}
+			// The edge functions divided by the area are the barycentric weights, so depth is linear in x and y too
+			float invArea = 1.0f / area;
+			float za = (a[0] * tri.z[0] + a[1] * tri.z[1] + a[2] * tri.z[2]) * invArea;
+			float zb = (b[0] * tri.z[0] + b[1] * tri.z[1] + b[2] * tri.z[2]) * invArea;
+			float zc = (c[0] * tri.z[0] + c[1] * tri.z[1] + c[2] * tri.z[2]) * invArea;
+
+#if defined(RASTER_SSE2)
+			// Width is a multiple of 4, so starting on a multiple of 4 never runs past the row
+			int startX = minX & ~3;
+			__m128 zero = _mm_setzero_ps();
+			__m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+			__m128 px = _mm_add_ps(_mm_set1_ps((float)startX), offsets);
+			__m128 step[3], rowStart[3];
+			for (int e = 0; e < 3; e++)
+			{
+				step[e] = _mm_set1_ps(a[e] * 4.0f);
+				rowStart[e] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[e]), px), _mm_set1_ps(c[e]));
+			}
+			__m128 zStep = _mm_set1_ps(za * 4.0f);
+			__m128 zRowStart = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(za), px), _mm_set1_ps(zc));
+
+			for (int y = minY; y <= maxY; y++)
+			{
+				float py = y + 0.5f;
+				__m128 e0 = _mm_add_ps(rowStart[0], _mm_set1_ps(b[0] * py));
+				__m128 e1 = _mm_add_ps(rowStart[1], _mm_set1_ps(b[1] * py));
+				__m128 e2 = _mm_add_ps(rowStart[2], _mm_set1_ps(b[2] * py));
+				__m128 z = _mm_add_ps(zRowStart, _mm_set1_ps(zb * py));
+				float* row = depth + y * width;
+				for (int x = startX; x <= maxX; x += 4)
+				{
+					__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+					if (_mm_movemask_ps(inside) != 0)
+					{
+						__m128 old = _mm_loadu_ps(row + x);
+						__m128 closer = _mm_min_ps(old, z);
+						_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, closer), _mm_andnot_ps(inside, old)));
+					}
+					e0 = _mm_add_ps(e0, step[0]);
+					e1 = _mm_add_ps(e1, step[1]);
+					e2 = _mm_add_ps(e2, step[2]);
+					z = _mm_add_ps(z, zStep);
+				}
+			}
+#else
+			for (int y = minY; y <= maxY; y++)
+			{
+				float py = y + 0.5f;
+				float* row = depth + y * width;
+				for (int x = minX; x <= maxX; x++)
+				{
+					float px = x + 0.5f;
+					if (a[0] * px + b[0] * py + c[0] >= 0.0f && a[1] * px + b[1] * py + c[1] >= 0.0f && a[2] * px + b[2] * py + c[2] >= 0.0f)
+					{
+						row[x] = std::min(row[x], za * px + zb * py + zc);
+					}
+				}
+			}
+#endif
+		}
+	}
+}
+
+
+// Every texel of a level keeps the furthest depth of the 2x2 texels below it
+void OcclusionCuller::buildHierarchy()
+{
+	for (size_t l = 1; l < levels.size(); l++)
+	{
+		const std::vector<float>& below = levels[l - 1];
+		int belowWidth = levelWidths[l - 1];
+		int belowHeight = levelHeights[l - 1];
+		for (int y = 0; y < levelHeights[l]; y++)
+		{
+			int y0 = std::min(y * 2, belowHeight - 1);
+			int y1 = std::min(y * 2 + 1, belowHeight - 1);
+			for (int x = 0; x < levelWidths[l]; x++)
+			{
+				int x0 = std::min(x * 2, belowWidth - 1);
+				int x1 = std::min(x * 2 + 1, belowWidth - 1);
+				levels[l][y * levelWidths[l] + x] = std::max(
+					std::max(below[y0 * belowWidth + x0], below[y0 * belowWidth + x1]),
+					std::max(below[y1 * belowWidth + x0], below[y1 * belowWidth + x1]));
+			}
+		}
+	}
+}
+
+
+// Checks if any part of a world space box could be in front of the occluders
+bool OcclusionCuller::IsVisible(const AABB& box) const
+{
+	float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f;
+	float nearest = 1.0f;
+	for (int corner = 0; corner < 8; corner++)
+	{
+		glm::vec3 point
+		(
+			(corner & 1) ? box.max.x : box.min.x,
+			(corner & 2) ? box.max.y : box.min.y,
+			(corner & 4) ? box.max.z : box.min.z
+		);
+		glm::vec4 clip = viewProjection * glm::vec4(point, 1.0f);
+		// Boxes reaching past the near plane are too close to judge
+		if (clip.w <= 1e-6f || clip.z < -clip.w)
+		{
+			return true;
+		}
+		float invW = 1.0f / clip.w;
+		float x = (clip.x * invW * 0.5f + 0.5f) * width;
+		float y = (clip.y * invW * 0.5f + 0.5f) * height;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		nearest = std::min(nearest, clip.z * invW * 0.5f + 0.5f);
+	}
+
+	if (maxX < 0.0f || minX >= width || maxY < 0.0f || minY >= height)
+	{
+		// Off screen, the frustum test decides about those
+		return true;
+	}
+	int x0 = (int)std::floor(clampToScreen(minX, width));
+	int x1 = std::min(width - 1, (int)std::floor(clampToScreen(maxX, width)));
+	int y0 = (int)std::floor(clampToScreen(minY, height));
+	int y1 = std::min(height - 1, (int)std::floor(clampToScreen(maxY, height)));
+	// Only NaN corners get past the test above with an empty rectangle
+	x0 = std::min(x0, x1);
+	y0 = std::min(y0, y1);
+
+	// Go up the pyramid until the rectangle covers at most 2x2 texels
+	int level = 0;
+	while (level + 1 < (int)levels.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1))
+	{
+		level++;
+	}
+	const std::vector<float>& depth = levels[level];
+	int levelWidth = levelWidths[level];
+	for (int y = y0 >> level; y <= (y1 >> level); y++)
+	{
+		for (int x = x0 >> level; x <= (x1 >> level); x++)
+		{
+			if (nearest <= depth[y * levelWidth + x])
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+
+// Removes the indices of hidden boxes from indices, keeps the order of the rest
+void OcclusionCuller::Filter(const std::vector<AABB>& boxes, std::vector<unsigned int>& indices) const
+{
+	std::vector<char> visible(indices.size());
+	ParallelFor(indices.size(), boxesPerJob, [&](size_t, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			visible[i] = IsVisible(boxes[indices[i]]);
+		}
+	});
+
+	size_t kept = 0;
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		if (visible[i])
+		{
+			indices[kept++] = indices[i];
+		}
+	}
+	indices.resize(kept);
+}
@@ -0,0 +1,65 @@
+#ifndef OCCLUSION_CULLER_CLASS_H
+#define OCCLUSION_CULLER_CLASS_H
+
+#include<glad/glad.h>
+#include<vector>
+
+#include"Bounds.h"
+
+
+// Software occlusion culling. A few large occluder meshes are rasterized into a small depth
+// buffer on the CPU, a hierarchical-Z pyramid (furthest depth of every 2x2 block) is built
+// from it and the bounding boxes of the other meshes are tested against that pyramid.
+// Needs no OpenGL at all, so it can run on the job system while the GPU draws the last frame
+class OcclusionCuller
+{
+public:
+	// Triangles of one occluder, the positions are in the space of the mesh
+	struct Occluder
+	{
+		const std::vector<glm::vec3>* positions;
+		const std::vector<GLuint>* indices;
+		glm::mat4 world;
+	};
+
+	// Width is rounded up to a multiple of 4 so the rasterizer can fill 4 pixels per instruction
+	OcclusionCuller(int width = 256, int height = 128);
+
+	// Clears the depth buffer, rasterizes the occluders and builds the pyramid
+	void Render(const glm::mat4& viewProjection, const std::vector<Occluder>& occluders);
+	// Checks if any part of a world space box could be in front of the occluders
+	bool IsVisible(const AABB& box) const;
+	// Removes the indices of hidden boxes from indices, keeps the order of the rest
+	void Filter(const std::vector<AABB>& boxes, std::vector<unsigned int>& indices) const;
+
+	int Width() const { return width; }
+	int Height() const { return height; }
+	int LevelCount() const { return (int)levels.size(); }
+	// Depth values in [0, 1] of one pyramid level, level 0 is the full buffer
+	const std::vector<float>& Level(int level) const { return levels[level]; }
+
+private:
+	// A triangle after projection, in pixels and depth
+	struct ScreenTriangle
+	{
+		float x[3];
+		float y[3];
+		float z[3];
+	};
+
+	int width;
+	int height;
+	glm::mat4 viewProjection;
+	std::vector<std::vector<float>> levels;
+	std::vector<int> levelWidths;
+	std::vector<int> levelHeights;
+	// Projected triangles of every occluder, reused between frames
+	std::vector<std::vector<ScreenTriangle>> triangles;
+
+	void setupTriangles(const Occluder& occluder, std::vector<ScreenTriangle>& output) const;
+	// Rasterizes every triangle into the rows [rowBegin, rowEnd) of level 0
+	void rasterizeRows(int rowBegin, int rowEnd);
+	void buildHierarchy();
+};
+
+#endif
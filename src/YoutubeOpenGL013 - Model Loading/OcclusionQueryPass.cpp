@@ -0,0 +1,89 @@
+#include"OcclusionQueryPass.h"
+
+#include<glm/gtc/type_ptr.hpp>
+
+
+// A vertex with only a position, the box shader reads nothing else
+static Vertex corner(float x, float y, float z)
+{
+	return Vertex{ glm::vec3(x, y, z), glm::vec3(0.0f), glm::vec3(0.0f), glm::vec2(0.0f) };
+}
+
+// Corners of the unit cube, the shader stretches it over a box
+static std::vector<Vertex> cubeCorners =
+{
+	corner(0.0f, 0.0f, 0.0f), corner(1.0f, 0.0f, 0.0f),
+	corner(0.0f, 1.0f, 0.0f), corner(1.0f, 1.0f, 0.0f),
+	corner(0.0f, 0.0f, 1.0f), corner(1.0f, 0.0f, 1.0f),
+	corner(0.0f, 1.0f, 1.0f), corner(1.0f, 1.0f, 1.0f)
+};
+
+// Two triangles for each side, the winding doesn't matter because both sides are drawn
+static std::vector<GLuint> cubeSides =
+{
+	0, 1, 3,  0, 3, 2, // -z
+	4, 5, 7,  4, 7, 6, // +z
+	0, 1, 5,  0, 5, 4, // -y
+	2, 3, 7,  2, 7, 6, // +y
+	0, 2, 6,  0, 6, 4, // -x
+	1, 3, 7,  1, 7, 5  // +x
+};
+
+
+OcclusionQueryPass::OcclusionQueryPass()
+	: shader("shader/bbox.vert", "shader/bbox.frag"), cubeVertices(cubeCorners), cubeIndices(cubeSides)
+{
+	// The conservative query may report a few extra pixels but never hides a visible box
+	target = GLCaps.conservativeOcclusion ? GL_ANY_SAMPLES_PASSED_CONSERVATIVE : GL_ANY_SAMPLES_PASSED;
+
+	cube.Bind();
+	cube.LinkAttrib(cubeVertices, 0, 3, GL_FLOAT, sizeof(Vertex), (void*)0);
+	cube.LinkEBO(cubeIndices);
+	cube.Unbind();
+
+	boxMinLocation = shader.Uniform("boxMin");
+	boxMaxLocation = shader.Uniform("boxMax");
+}
+
+
+// Turns off color and depth writes and binds the box shader, call after everything else was drawn
+void OcclusionQueryPass::Begin(glm::mat4 camMatrix)
+{
+	shader.Activate();
+	glUniformMatrix4fv(shader.Uniform("camMatrix"), 1, GL_FALSE, glm::value_ptr(camMatrix));
+	cube.Bind();
+
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+	// Pulls the box a little towards the camera so a mesh that touches its own box can't hide it
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(-1.0f, -1.0f);
+}
+
+
+// Draws one world space box, has to be inside glBeginQuery/glEndQuery
+void OcclusionQueryPass::DrawBox(const AABB& box)
+{
+	glUniform3f(boxMinLocation, box.min.x, box.min.y, box.min.z);
+	glUniform3f(boxMaxLocation, box.max.x, box.max.y, box.max.z);
+	glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+}
+
+
+// Restores the state Begin changed
+void OcclusionQueryPass::End()
+{
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glDepthMask(GL_TRUE);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	cube.Unbind();
+}
+
+
+void OcclusionQueryPass::Delete()
+{
+	cube.Delete();
+	cubeVertices.Delete();
+	cubeIndices.Delete();
+	shader.Delete();
+}
@@ -0,0 +1,38 @@
+#ifndef OCCLUSION_QUERY_PASS_CLASS_H
+#define OCCLUSION_QUERY_PASS_CLASS_H
+
+#include"VAO.h"
+#include"shader.h"
+#include"Bounds.h"
+
+
+// Draws bounding boxes into the depth buffer without changing it, so that occlusion queries
+// around them tell if any pixel of the box would be visible. Used by Mesh::QueryOcclusion
+class OcclusionQueryPass
+{
+public:
+	// Query target, GL_ANY_SAMPLES_PASSED_CONSERVATIVE when the context has it
+	GLenum target;
+
+	// Loads shader/bbox.vert and shader/bbox.frag and creates the unit cube
+	OcclusionQueryPass();
+
+	// Turns off color and depth writes and binds the box shader, call after everything else was drawn
+	void Begin(glm::mat4 camMatrix);
+	// Draws one world space box, has to be inside glBeginQuery/glEndQuery
+	void DrawBox(const AABB& box);
+	// Restores the state Begin changed
+	void End();
+	// Deletes the shader and the cube
+	void Delete();
+
+private:
+	Shader shader;
+	VBO cubeVertices;
+	EBO cubeIndices;
+	VAO cube;
+	GLint boxMinLocation;
+	GLint boxMaxLocation;
+};
+
+#endif
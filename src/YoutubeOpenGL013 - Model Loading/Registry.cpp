@@ -0,0 +1,58 @@
+#include"Registry.h"
+
+#include<atomic>
+
+
+Entity Registry::Create()
+{
+	uint32_t slot;
+	if (!freeSlots.empty())
+	{
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else
+	{
+		if (versions.size() >= 0xFFFFFF)
+		{
+			throw std::invalid_argument("Registry is out of entity slots");
+		}
+		slot = versions.size();
+		versions.push_back(0);
+	}
+	return ((Entity)versions[slot] << 24) | slot;
+}
+
+
+// Removes the entity and all of its components
+void Registry::Destroy(Entity entity)
+{
+	if (!IsAlive(entity))
+	{
+		return;
+	}
+	for (size_t p = 0; p < pools.size(); p++)
+	{
+		if (pools[p])
+		{
+			pools[p]->Remove(entity);
+		}
+	}
+	uint32_t slot = entity & 0xFFFFFF;
+	versions[slot]++;
+	freeSlots.push_back(slot);
+}
+
+
+bool Registry::IsAlive(Entity entity) const
+{
+	uint32_t slot = entity & 0xFFFFFF;
+	return slot < versions.size() && versions[slot] == (entity >> 24);
+}
+
+
+size_t Registry::nextTypeIndex()
+{
+	static std::atomic<size_t> counter(0);
+	return counter++;
+}
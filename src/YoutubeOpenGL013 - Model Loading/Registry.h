@@ -0,0 +1,211 @@
+#ifndef REGISTRY_CLASS_H
+#define REGISTRY_CLASS_H
+
+#include<algorithm>
+#include<cstdint>
+#include<memory>
+#include<stdexcept>
+#include<tuple>
+#include<utility>
+#include<vector>
+
+
+// An entity is only an id: the low 24 bits index the entity slot, the high 8 bits count
+// how often that slot was reused, so handles to destroyed entities stop matching
+typedef uint32_t Entity;
+const Entity NullEntity = 0xFFFFFFFF;
+// Marks entity slots without a component in the sparse arrays
+const uint32_t InvalidComponentIndex = 0xFFFFFFFF;
+
+
+// Lets the Registry remove an entity from pools of any component type
+class ComponentPoolBase
+{
+public:
+	virtual ~ComponentPoolBase() {}
+	virtual bool Has(Entity entity) const = 0;
+	virtual void Remove(Entity entity) = 0;
+};
+
+
+// Sparse set of one component type. The components are packed at the front of a dense array
+// in any order, the sparse array maps entity slots to their place in it. Adding and removing
+// are O(1) and iterating touches nothing but the dense arrays
+template<typename T>
+class ComponentPool : public ComponentPoolBase
+{
+public:
+	// Dense arrays, entities[i] owns components[i]
+	std::vector<Entity> entities;
+	std::vector<T> components;
+
+	T& Add(Entity entity, const T& component)
+	{
+		uint32_t slot = entity & 0xFFFFFF;
+		if (slot >= sparse.size())
+		{
+			sparse.resize(slot + 1, InvalidComponentIndex);
+		}
+		if (sparse[slot] != InvalidComponentIndex)
+		{
+			// Adding again replaces the component
+			components[sparse[slot]] = component;
+			return components[sparse[slot]];
+		}
+		sparse[slot] = entities.size();
+		entities.push_back(entity);
+		components.push_back(component);
+		return components.back();
+	}
+
+	bool Has(Entity entity) const
+	{
+		uint32_t slot = entity & 0xFFFFFF;
+		return slot < sparse.size() && sparse[slot] != InvalidComponentIndex && entities[sparse[slot]] == entity;
+	}
+
+	T& Get(Entity entity) { return components[sparse[entity & 0xFFFFFF]]; }
+	const T& Get(Entity entity) const { return components[sparse[entity & 0xFFFFFF]]; }
+	// Place of an entity in the dense arrays
+	size_t IndexOf(Entity entity) const { return sparse[entity & 0xFFFFFF]; }
+
+	// Moves the last component into the hole, so the dense arrays stay packed
+	void Remove(Entity entity)
+	{
+		if (!Has(entity))
+		{
+			return;
+		}
+		uint32_t index = sparse[entity & 0xFFFFFF];
+		uint32_t last = entities.size() - 1;
+		if (index != last)
+		{
+			entities[index] = entities[last];
+			components[index] = std::move(components[last]);
+			sparse[entities[index] & 0xFFFFFF] = index;
+		}
+		entities.pop_back();
+		components.pop_back();
+		sparse[entity & 0xFFFFFF] = InvalidComponentIndex;
+	}
+
+	// Exchanges the places of two components in the dense arrays
+	void Swap(size_t a, size_t b)
+	{
+		std::swap(entities[a], entities[b]);
+		std::swap(components[a], components[b]);
+		sparse[entities[a] & 0xFFFFFF] = a;
+		sparse[entities[b] & 0xFFFFFF] = b;
+	}
+
+	size_t Size() const { return entities.size(); }
+
+private:
+	std::vector<uint32_t> sparse;
+};
+
+
+// Owns all entities and one pool per component type
+class Registry
+{
+public:
+	Entity Create();
+	// Removes the entity and all of its components
+	void Destroy(Entity entity);
+	bool IsAlive(Entity entity) const;
+	size_t EntityCount() const { return versions.size() - freeSlots.size(); }
+
+	template<typename T>
+	T& Add(Entity entity, const T& component) { return Pool<T>().Add(entity, component); }
+	template<typename T>
+	bool Has(Entity entity) { return Pool<T>().Has(entity); }
+	template<typename T>
+	T& Get(Entity entity) { return Pool<T>().Get(entity); }
+	template<typename T>
+	void Remove(Entity entity) { Pool<T>().Remove(entity); }
+
+	template<typename T>
+	ComponentPool<T>& Pool()
+	{
+		size_t type = typeIndex<T>();
+		if (type >= pools.size())
+		{
+			pools.resize(type + 1);
+		}
+		if (!pools[type])
+		{
+			pools[type].reset(new ComponentPool<T>());
+		}
+		return *static_cast<ComponentPool<T>*>(pools[type].get());
+	}
+
+	// Reorders the pool of Follower so every entity that also has a Lead component sits at the
+	// same dense index as in the pool of Lead. Afterwards index i of both pools is the same entity
+	// for all i below the size of Lead, so both can be walked side by side without lookups
+	template<typename Lead, typename Follower>
+	void Align()
+	{
+		ComponentPool<Lead>& lead = Pool<Lead>();
+		ComponentPool<Follower>& follower = Pool<Follower>();
+		size_t next = 0;
+		for (size_t i = 0; i < lead.Size(); i++)
+		{
+			Entity entity = lead.entities[i];
+			if (follower.Has(entity))
+			{
+				follower.Swap(follower.IndexOf(entity), next++);
+			}
+		}
+	}
+
+	// Calls function(entity, T&, Others&...) for the entities at dense indices [begin, end) of the
+	// pool of T that have all the other components too. Ranges that don't overlap can run on
+	// different threads as long as no components are added or removed meanwhile and every
+	// pool was created before (Pool creates missing pools, which isn't thread safe)
+	template<typename T, typename... Others, typename Function>
+	void EachInRange(size_t begin, size_t end, Function function)
+	{
+		ComponentPool<T>& pool = Pool<T>();
+		// Looked up once, the pools of the other types don't move while iterating
+		std::tuple<ComponentPool<Others>*...> others(&Pool<Others>()...);
+		end = std::min(end, pool.Size());
+		for (size_t i = begin; i < end; i++)
+		{
+			Entity entity = pool.entities[i];
+			bool hasAll = true;
+			bool has[] = { true, std::get<ComponentPool<Others>*>(others)->Has(entity)... };
+			for (size_t h = 0; h < sizeof(has) / sizeof(has[0]); h++)
+			{
+				hasAll = hasAll && has[h];
+			}
+			if (hasAll)
+			{
+				function(entity, pool.components[i], std::get<ComponentPool<Others>*>(others)->Get(entity)...);
+			}
+		}
+	}
+
+	// Same as EachInRange over the whole pool of T
+	template<typename T, typename... Others, typename Function>
+	void Each(Function function)
+	{
+		EachInRange<T, Others...>(0, Pool<T>().Size(), function);
+	}
+
+private:
+	// Reuse count of every entity slot
+	std::vector<uint8_t> versions;
+	std::vector<uint32_t> freeSlots;
+	std::vector<std::unique_ptr<ComponentPoolBase>> pools;
+
+	// Gives every component type a small number the first time it is used
+	static size_t nextTypeIndex();
+	template<typename T>
+	static size_t typeIndex()
+	{
+		static const size_t index = nextTypeIndex();
+		return index;
+	}
+};
+
+#endif
@@ -0,0 +1,56 @@
+#include"RingAllocator.h"
+
+// Constructor that creates an empty ring of a size in bytes
+RingAllocator::RingAllocator(size_t capacity)
+{
+	RingAllocator::capacity = capacity;
+	head = 0;
+	used = 0;
+	frameUsed = 0;
+}
+
+// Takes size bytes starting at a multiple of alignment, never splitting a range over the end of the ring
+size_t RingAllocator::Allocate(size_t size, size_t alignment)
+{
+	if (size == 0 || alignment == 0 || size > capacity)
+	{
+		return InvalidOffset;
+	}
+
+	size_t aligned = (head + alignment - 1) / alignment * alignment;
+	size_t needed = aligned - head + size;
+	// Ranges don't wrap, the bytes left at the end are skipped and count as used
+	if (aligned + size > capacity)
+	{
+		aligned = 0;
+		needed = capacity - head + size;
+	}
+	// The free bytes always start at head, so comparing the amounts is enough
+	if (needed > capacity - used)
+	{
+		return InvalidOffset;
+	}
+
+	head = aligned + size;
+	used += needed;
+	frameUsed += needed;
+	return aligned;
+}
+
+// Closes the current frame, its bytes stay in use until RetireFrame
+void RingAllocator::EndFrame()
+{
+	frameSizes.push_back(frameUsed);
+	frameUsed = 0;
+}
+
+// Frees all bytes of the oldest closed frame
+void RingAllocator::RetireFrame()
+{
+	if (frameSizes.empty())
+	{
+		return;
+	}
+	used -= frameSizes.front();
+	frameSizes.pop_front();
+}
@@ -0,0 +1,43 @@
+#ifndef RING_ALLOCATOR_CLASS_H
+#define RING_ALLOCATOR_CLASS_H
+
+#include<cstddef>
+#include<deque>
+
+
+// Hands out ranges of a circular address space in the order they are used by frames.
+// The bytes of a frame only become free again once that frame is retired, which is
+// when the GPU has finished reading them. Knows nothing about OpenGL
+class RingAllocator
+{
+public:
+	// Returned by Allocate when the ring is full
+	static const size_t InvalidOffset = (size_t)-1;
+
+	// Constructor that creates an empty ring of a size in bytes
+	RingAllocator(size_t capacity);
+
+	// Takes size bytes starting at a multiple of alignment, never splitting a range over the end of the ring
+	size_t Allocate(size_t size, size_t alignment = 1);
+	// Closes the current frame, its bytes stay in use until RetireFrame
+	void EndFrame();
+	// Frees all bytes of the oldest closed frame
+	void RetireFrame();
+
+	size_t Capacity() const { return capacity; }
+	size_t UsedBytes() const { return used; }
+	size_t FramesInFlight() const { return frameSizes.size(); }
+
+private:
+	size_t capacity;
+	// Offset where the next allocation starts
+	size_t head;
+	// Bytes in use by closed frames and the current frame, including padding
+	size_t used;
+	// Bytes taken by the current frame so far
+	size_t frameUsed;
+	// Bytes taken by every closed frame that hasn't been retired, oldest first
+	std::deque<size_t> frameSizes;
+};
+
+#endif
@@ -0,0 +1,95 @@
+#include"SamplerCache.h"
+
+#include<algorithm>
+
+
+// Reads an entry of the glTF samplers array, missing values keep the defaults
+SamplerState SamplerState::FromGLTF(const nlohmann::json& sampler)
+{
+	SamplerState state;
+	state.minFilter = sampler.value("minFilter", state.minFilter);
+	state.magFilter = sampler.value("magFilter", state.magFilter);
+	state.wrapS = sampler.value("wrapS", state.wrapS);
+	state.wrapT = sampler.value("wrapT", state.wrapT);
+	return state;
+}
+
+
+// Checks if the state filters with mip levels
+bool SamplerState::UsesMipmaps() const
+{
+	return minFilter != GL_NEAREST && minFilter != GL_LINEAR;
+}
+
+
+// Sets the state as the own parameters of a texture, for sampling without a sampler object
+void SamplerState::ApplyToTexture(GLuint texture, GLenum target) const
+{
+	if (GLCaps.directStateAccess)
+	{
+		glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, minFilter);
+		glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, magFilter);
+		glTextureParameteri(texture, GL_TEXTURE_WRAP_S, wrapS);
+		glTextureParameteri(texture, GL_TEXTURE_WRAP_T, wrapT);
+		return;
+	}
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, minFilter);
+	glTexParameteri(target, GL_TEXTURE_MAG_FILTER, magFilter);
+	glTexParameteri(target, GL_TEXTURE_WRAP_S, wrapS);
+	glTexParameteri(target, GL_TEXTURE_WRAP_T, wrapT);
+}
+
+
+bool SamplerState::operator==(const SamplerState& other) const
+{
+	return minFilter == other.minFilter && magFilter == other.magFilter
+		&& wrapS == other.wrapS && wrapT == other.wrapT && anisotropy == other.anisotropy;
+}
+
+
+// Cache of the context, created on first use
+SamplerCache& SamplerCache::Shared()
+{
+	static SamplerCache cache;
+	return cache;
+}
+
+
+// Sampler object with the given state, created the first time it is asked for
+GLuint SamplerCache::Get(SamplerState state)
+{
+	state.anisotropy = std::max(1.0f, std::min(state.anisotropy, GLCaps.maxAnisotropy));
+	for (unsigned int i = 0; i < states.size(); i++)
+	{
+		if (states[i] == state)
+		{
+			return samplers[i];
+		}
+	}
+
+	GLuint sampler;
+	glGenSamplers(1, &sampler);
+	glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, state.minFilter);
+	glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, state.magFilter);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, state.wrapS);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, state.wrapT);
+	if (state.anisotropy > 1.0f)
+	{
+		glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY, state.anisotropy);
+	}
+	states.push_back(state);
+	samplers.push_back(sampler);
+	return sampler;
+}
+
+
+// Deletes every sampler object
+void SamplerCache::Delete()
+{
+	if (!samplers.empty())
+	{
+		glDeleteSamplers((GLsizei)samplers.size(), samplers.data());
+	}
+	samplers.clear();
+	states.clear();
+}
@@ -0,0 +1,58 @@
+#ifndef SAMPLER_CACHE_CLASS_H
+#define SAMPLER_CACHE_CLASS_H
+
+#include<json/json.h>
+#include<vector>
+
+#include"GLExtensions.h"
+
+
+// Filtering and wrapping of a sampler object. The defaults are the sampling of every texture that
+// names no glTF sampler, and the only place the engine spells them out
+struct SamplerState
+{
+	GLenum minFilter = GL_LINEAR_MIPMAP_LINEAR;
+	GLenum magFilter = GL_LINEAR;
+	GLenum wrapS = GL_REPEAT;
+	GLenum wrapT = GL_REPEAT;
+	// 1 turns anisotropic filtering off
+	float anisotropy = 1.0f;
+
+	// Reads an entry of the glTF samplers array, missing values keep the defaults
+	static SamplerState FromGLTF(const nlohmann::json& sampler);
+	// Checks if the state filters with mip levels
+	bool UsesMipmaps() const;
+	// Sets the state as the own parameters of a texture, for sampling without a sampler object.
+	// Without direct state access the texture has to be bound to target
+	void ApplyToTexture(GLuint texture, GLenum target) const;
+
+	bool operator==(const SamplerState& other) const;
+};
+
+
+// Sampler objects shared by every material. Sampling state lives apart from the texture objects,
+// so one texture can be sampled differently by several materials without a second copy of its pixels.
+// Create and bind samplers only on the thread that owns the context
+class SamplerCache
+{
+public:
+	// Cache of the context, created on first use
+	static SamplerCache& Shared();
+
+	// Sampler object with the given state, created the first time it is asked for.
+	// Anisotropy is clamped to what the context supports before looking for a match
+	GLuint Get(SamplerState state);
+	// Sampler object with the default state, for textures that come without a glTF sampler
+	GLuint Default() { return Get(SamplerState()); }
+	// Number of distinct sampler objects
+	unsigned int Count() const { return (unsigned int)samplers.size(); }
+	// Deletes every sampler object
+	void Delete();
+
+private:
+	// A scene only has a handful of distinct states, so a linear search beats hashing
+	std::vector<SamplerState> states;
+	std::vector<GLuint> samplers;
+};
+
+#endif
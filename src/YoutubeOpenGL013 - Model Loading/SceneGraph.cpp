@@ -0,0 +1,235 @@
+#include"SceneGraph.h"
+
+#include<algorithm>
+#include<stdexcept>
+#include<glm/gtc/matrix_transform.hpp>
+
+#include"JobSystem.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include<xmmintrin.h>
+#define TRANSFORM_SSE2
+#endif
+
+// Updating fewer nodes than this is faster on the calling thread alone
+static const unsigned int minNodesPerThread = 4096;
+
+
+// out = a * b for column major 4x4 matrices, out may not alias a or b
+static inline void multiplyMatrices(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+{
+#if defined(TRANSFORM_SSE2)
+	const float* left = &a[0][0];
+	const float* right = &b[0][0];
+	float* result = &out[0][0];
+	__m128 column0 = _mm_loadu_ps(left);
+	__m128 column1 = _mm_loadu_ps(left + 4);
+	__m128 column2 = _mm_loadu_ps(left + 8);
+	__m128 column3 = _mm_loadu_ps(left + 12);
+	// Every column of the result is a mix of the columns of a, weighted by one column of b
+	for (int c = 0; c < 4; c++)
+	{
+		const float* weights = right + c * 4;
+		__m128 mixed = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(weights[0])), _mm_mul_ps(column1, _mm_set1_ps(weights[1]))),
+			_mm_add_ps(_mm_mul_ps(column2, _mm_set1_ps(weights[2])), _mm_mul_ps(column3, _mm_set1_ps(weights[3]))));
+		_mm_storeu_ps(result + c * 4, mixed);
+	}
+#else
+	out = a * b;
+#endif
+}
+
+
+// Adds a node below parent (-1 for a root) and returns its index
+unsigned int SceneGraph::AddNode(int parent, int mesh, glm::mat4 matrix, glm::vec3 translation, glm::quat rotation, glm::vec3 scale)
+{
+	unsigned int index = parents.size();
+	// Appending keeps the subtree of the parent contiguous only if it currently ends at the back
+	if (parent >= 0 && ((unsigned int)parent >= index || parent + subtreeSizes[parent] != index))
+	{
+		throw std::invalid_argument("SceneGraph nodes have to be added in depth-first order");
+	}
+
+	parents.push_back(parent);
+	subtreeSizes.push_back(1);
+	matrices.push_back(matrix);
+	translations.push_back(translation);
+	rotations.push_back(rotation);
+	scales.push_back(scale);
+	locals.push_back(glm::mat4(1.0f));
+	worlds.push_back(glm::mat4(1.0f));
+	meshIndices.push_back(mesh);
+	dirty.push_back(false);
+
+	for (int ancestor = parent; ancestor >= 0; ancestor = parents[ancestor])
+	{
+		subtreeSizes[ancestor]++;
+	}
+
+	// The parent is already up to date, so the world matrix can be computed right away
+	updateLocal(index);
+	updateRange(index, index + 1);
+	return index;
+}
+
+
+void SceneGraph::SetTranslation(unsigned int node, glm::vec3 translation)
+{
+	translations[node] = translation;
+	markDirty(node);
+}
+
+void SceneGraph::SetRotation(unsigned int node, glm::quat rotation)
+{
+	rotations[node] = rotation;
+	markDirty(node);
+}
+
+void SceneGraph::SetScale(unsigned int node, glm::vec3 scale)
+{
+	scales[node] = scale;
+	markDirty(node);
+}
+
+
+// Recomputes the world matrices below every dirty node and appends the indices of all nodes that changed
+void SceneGraph::Update(std::vector<unsigned int>& changed)
+{
+	for (size_t d = 0; d < dirtyNodes.size(); d++)
+	{
+		updateLocal(dirtyNodes[d]);
+		dirty[dirtyNodes[d]] = false;
+	}
+
+	// In depth-first order a dirty node inside the range of an earlier one is already covered by it
+	std::sort(dirtyNodes.begin(), dirtyNodes.end());
+	ranges.clear();
+	unsigned int covered = 0;
+	unsigned int total = 0;
+	for (size_t d = 0; d < dirtyNodes.size(); d++)
+	{
+		unsigned int node = dirtyNodes[d];
+		if (node < covered)
+		{
+			continue;
+		}
+		covered = node + subtreeSizes[node];
+		ranges.push_back(Range{ node, covered });
+		total += subtreeSizes[node];
+	}
+	dirtyNodes.clear();
+
+	unsigned int threads = JobSystem::Shared().ThreadCount();
+	threads = std::max(1u, std::min(threads, total / minNodesPerThread));
+	if (threads > 1)
+	{
+		// Split big ranges into their root and the subtrees of its children, which don't depend on each other
+		std::vector<Range> split;
+		for (size_t r = 0; r < ranges.size(); r++)
+		{
+			Range range = ranges[r];
+			if (range.end - range.first < total / threads)
+			{
+				split.push_back(range);
+				continue;
+			}
+			updateRange(range.first, range.first + 1);
+			for (unsigned int child = range.first + 1; child < range.end; child += subtreeSizes[child])
+			{
+				split.push_back(Range{ child, child + subtreeSizes[child] });
+			}
+		}
+
+		// A few jobs per thread, stealing evens out subtrees of different sizes
+		size_t rangesPerJob = std::max<size_t>(1, split.size() / (threads * 4));
+		ParallelFor(split.size(), rangesPerJob, [this, &split](size_t, size_t begin, size_t end)
+		{
+			for (size_t r = begin; r < end; r++)
+			{
+				updateRange(split[r].first, split[r].end);
+			}
+		});
+	}
+	else
+	{
+		for (size_t r = 0; r < ranges.size(); r++)
+		{
+			updateRange(ranges[r].first, ranges[r].end);
+		}
+	}
+
+	for (size_t r = 0; r < ranges.size(); r++)
+	{
+		for (unsigned int node = ranges[r].first; node < ranges[r].end; node++)
+		{
+			changed.push_back(node);
+		}
+	}
+}
+
+
+// Same result as Update the straightforward way, recomputes all world matrices with glm
+void SceneGraph::UpdateRecursive(std::vector<unsigned int>& changed)
+{
+	for (size_t d = 0; d < dirtyNodes.size(); d++)
+	{
+		updateLocal(dirtyNodes[d]);
+		dirty[dirtyNodes[d]] = false;
+	}
+	dirtyNodes.clear();
+
+	for (unsigned int root = 0; root < parents.size(); root += subtreeSizes[root])
+	{
+		updateRecursive(root, glm::mat4(1.0f), changed);
+	}
+}
+
+
+void SceneGraph::markDirty(unsigned int node)
+{
+	if (!dirty[node])
+	{
+		dirty[node] = true;
+		dirtyNodes.push_back(node);
+	}
+}
+
+
+void SceneGraph::updateLocal(unsigned int node)
+{
+	glm::mat4 trans = glm::translate(glm::mat4(1.0f), translations[node]);
+	glm::mat4 rot = glm::mat4_cast(rotations[node]);
+	glm::mat4 sca = glm::scale(glm::mat4(1.0f), scales[node]);
+	locals[node] = matrices[node] * trans * rot * sca;
+}
+
+
+// Recomputes the world matrices of [first, end), every parent outside the range has to be up to date
+void SceneGraph::updateRange(unsigned int first, unsigned int end)
+{
+	for (unsigned int node = first; node < end; node++)
+	{
+		int parent = parents[node];
+		if (parent < 0)
+		{
+			worlds[node] = locals[node];
+		}
+		else
+		{
+			multiplyMatrices(worlds[parent], locals[node], worlds[node]);
+		}
+	}
+}
+
+
+void SceneGraph::updateRecursive(unsigned int node, const glm::mat4& parentWorld, std::vector<unsigned int>& changed)
+{
+	worlds[node] = parentWorld * locals[node];
+	changed.push_back(node);
+	// The children follow their parent, each one after the subtree of the one before
+	for (unsigned int child = node + 1; child < node + subtreeSizes[node]; child += subtreeSizes[child])
+	{
+		updateRecursive(child, worlds[node], changed);
+	}
+}
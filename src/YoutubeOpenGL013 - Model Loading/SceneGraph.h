@@ -0,0 +1,79 @@
+#ifndef SCENE_GRAPH_CLASS_H
+#define SCENE_GRAPH_CLASS_H
+
+#include<vector>
+#include<glm/glm.hpp>
+#include<glm/gtc/quaternion.hpp>
+
+
+// Hierarchy of nodes with local transforms, stored as flat arrays (structure of arrays).
+// Nodes are kept in depth-first order, so every parent comes before its children and the
+// subtree of node i is the range [i, i + subtreeSizes[i]). Changing a node only marks it
+// dirty, Update then walks the ranges of the dirty subtrees in one linear pass each
+class SceneGraph
+{
+public:
+	// -1 for roots
+	std::vector<int> parents;
+	// Number of nodes in the subtree of every node, the node itself included
+	std::vector<unsigned int> subtreeSizes;
+	// Local transform relative to the parent, matrices come from the glTF "matrix" property and are applied first
+	std::vector<glm::mat4> matrices;
+	std::vector<glm::vec3> translations;
+	std::vector<glm::quat> rotations;
+	std::vector<glm::vec3> scales;
+	// The four above as one matrix
+	std::vector<glm::mat4> locals;
+	// Transform from the node to the root of the graph
+	std::vector<glm::mat4> worlds;
+	// Index of the mesh the node draws, -1 if it has none
+	std::vector<int> meshIndices;
+
+	// Adds a node below parent (-1 for a root) and returns its index. Nodes have to be added
+	// in depth-first order, parent has to be the last added node or one of its ancestors
+	unsigned int AddNode
+	(
+		int parent,
+		int mesh = -1,
+		glm::mat4 matrix = glm::mat4(1.0f),
+		glm::vec3 translation = glm::vec3(0.0f, 0.0f, 0.0f),
+		glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+		glm::vec3 scale = glm::vec3(1.0f, 1.0f, 1.0f)
+	);
+
+	// Change the local transform of a node
+	void SetTranslation(unsigned int node, glm::vec3 translation);
+	void SetRotation(unsigned int node, glm::quat rotation);
+	void SetScale(unsigned int node, glm::vec3 scale);
+
+	// Recomputes the world matrices below every dirty node and appends the indices of all nodes that changed.
+	// Independent subtrees are updated on the job system when there are enough nodes to update
+	void Update(std::vector<unsigned int>& changed);
+	// Same result as Update the straightforward way: recurses from every root and recomputes all world
+	// matrices with glm, dirty or not. Kept as the reference Update is tested and measured against
+	void UpdateRecursive(std::vector<unsigned int>& changed);
+	// Checks if any node was changed since the last Update
+	bool IsDirty() const { return !dirtyNodes.empty(); }
+	size_t Size() const { return parents.size(); }
+
+private:
+	std::vector<char> dirty;
+	// Nodes marked dirty since the last Update, a node is in here at most once
+	std::vector<unsigned int> dirtyNodes;
+
+	// Ranges of nodes that can be updated independently of each other, reused by Update
+	struct Range
+	{
+		unsigned int first;
+		unsigned int end;
+	};
+	std::vector<Range> ranges;
+
+	void markDirty(unsigned int node);
+	void updateLocal(unsigned int node);
+	// Recomputes the world matrices of [first, end), every parent outside the range has to be up to date
+	void updateRange(unsigned int first, unsigned int end);
+	void updateRecursive(unsigned int node, const glm::mat4& parentWorld, std::vector<unsigned int>& changed);
+};
+
+#endif
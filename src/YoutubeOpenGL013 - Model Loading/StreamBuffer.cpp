@@ -0,0 +1,149 @@
+#include"StreamBuffer.h"
+
+#include<cstring>
+#include<stdexcept>
+
+// Constructor that creates the buffer with a size in bytes for a number of frames in flight
+StreamBuffer::StreamBuffer(GLsizeiptr size, unsigned int framesInFlight)
+	: ring(size)
+{
+	StreamBuffer::framesInFlight = framesInFlight;
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	if (GLCaps.directStateAccess)
+	{
+		glCreateBuffers(1, &ID);
+		glNamedBufferStorage(ID, size, NULL, flags);
+		mapped = (unsigned char*)glMapNamedBufferRange(ID, 0, size, flags);
+		return;
+	}
+
+	glGenBuffers(1, &ID);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, ID);
+	if (GLCaps.bufferStorage)
+	{
+		// Coherent mapping means writes become visible without flushing or unmapping
+		glBufferStorage(GL_COPY_WRITE_BUFFER, size, NULL, flags);
+		mapped = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags);
+	}
+	else
+	{
+		glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_STREAM_DRAW);
+		shadow.resize(size);
+		mapped = shadow.data();
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+// Reserves memory for this frame, waits for the GPU only if the ring is full
+StreamAllocation StreamBuffer::Allocate(GLsizeiptr size, GLsizeiptr alignment)
+{
+	size_t offset = ring.Allocate(size, alignment);
+	while (offset == RingAllocator::InvalidOffset)
+	{
+		if (fences.empty())
+		{
+			throw std::invalid_argument("Stream buffer allocation is larger than the whole buffer");
+		}
+		retireOldest();
+		offset = ring.Allocate(size, alignment);
+	}
+
+	StreamAllocation allocation = { (GLintptr)offset, mapped + offset };
+	if (!GLCaps.bufferStorage)
+	{
+		pending.push_back(allocation);
+		pendingSizes.push_back(size);
+	}
+	return allocation;
+}
+
+// Copies data into a new allocation and returns its offset
+GLintptr StreamBuffer::Upload(const void* data, GLsizeiptr size, GLsizeiptr alignment)
+{
+	StreamAllocation allocation = Allocate(size, alignment);
+	std::memcpy(allocation.data, data, size);
+	return allocation.offset;
+}
+
+// Makes the written data visible to the GPU, only does work without persistent mapping
+void StreamBuffer::Flush()
+{
+	if (pending.empty())
+	{
+		return;
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, ID);
+	for (unsigned int i = 0; i < pending.size(); i++)
+	{
+		glBufferSubData(GL_COPY_WRITE_BUFFER, pending[i].offset, pendingSizes[i], pending[i].data);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	pending.clear();
+	pendingSizes.clear();
+}
+
+// Retires frames that the GPU has finished, call at the start of a frame
+void StreamBuffer::BeginFrame()
+{
+	while (!fences.empty())
+	{
+		GLenum result = glClientWaitSync(fences.front(), 0, 0);
+		if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+		{
+			break;
+		}
+		glDeleteSync(fences.front());
+		fences.pop_front();
+		ring.RetireFrame();
+	}
+	// Never let the CPU run more than framesInFlight frames ahead
+	while (fences.size() >= framesInFlight)
+	{
+		retireOldest();
+	}
+}
+
+// Puts a fence behind the commands of this frame, call after the last draw
+void StreamBuffer::EndFrame()
+{
+	Flush();
+	fences.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+	ring.EndFrame();
+}
+
+// Deletes the buffer and its fences
+void StreamBuffer::Delete()
+{
+	while (!fences.empty())
+	{
+		glDeleteSync(fences.front());
+		fences.pop_front();
+	}
+	if (GLCaps.directStateAccess)
+	{
+		glUnmapNamedBuffer(ID);
+	}
+	else if (GLCaps.bufferStorage)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, ID);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+	glDeleteBuffers(1, &ID);
+}
+
+// Blocks until the oldest frame is done on the GPU and frees its memory
+void StreamBuffer::retireOldest()
+{
+	GLsync fence = fences.front();
+	// The first wait flushes the commands so the fence is guaranteed to signal
+	GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+	while (result == GL_TIMEOUT_EXPIRED)
+	{
+		result = glClientWaitSync(fence, 0, 1000000);
+	}
+	glDeleteSync(fence);
+	fences.pop_front();
+	ring.RetireFrame();
+}
@@ -0,0 +1,62 @@
+#ifndef STREAM_BUFFER_CLASS_H
+#define STREAM_BUFFER_CLASS_H
+
+#include<deque>
+#include<vector>
+
+#include"GLExtensions.h"
+#include"RingAllocator.h"
+
+
+// Memory handed out by a StreamBuffer for one frame
+struct StreamAllocation
+{
+	// Offset inside the buffer, used when binding the range or as the draw/attribute offset
+	GLintptr offset;
+	// Where the CPU writes the data
+	void* data;
+};
+
+
+// One buffer that carries all data which changes every frame (per-frame uniforms,
+// draw commands, instance transforms, dynamic vertices). It stays mapped for its whole
+// life and fences keep the CPU from overwriting what the GPU still reads.
+// Without buffer storage the data is written to a CPU copy and uploaded in Flush
+class StreamBuffer
+{
+public:
+	// ID reference of the buffer, bind it to whatever target the data is used with
+	GLuint ID;
+
+	// Constructor that creates the buffer with a size in bytes for a number of frames in flight
+	StreamBuffer(GLsizeiptr size, unsigned int framesInFlight = 3);
+
+	// Reserves memory for this frame, waits for the GPU only if the ring is full
+	StreamAllocation Allocate(GLsizeiptr size, GLsizeiptr alignment = 4);
+	// Copies data into a new allocation and returns its offset
+	GLintptr Upload(const void* data, GLsizeiptr size, GLsizeiptr alignment = 4);
+	// Makes the written data visible to the GPU, only does work without persistent mapping
+	void Flush();
+	// Retires frames that the GPU has finished, call at the start of a frame
+	void BeginFrame();
+	// Puts a fence behind the commands of this frame, call after the last draw
+	void EndFrame();
+	// Deletes the buffer and its fences
+	void Delete();
+
+private:
+	RingAllocator ring;
+	unsigned int framesInFlight;
+	std::deque<GLsync> fences;
+	// Pointer to the mapped buffer, or to the CPU copy when persistent mapping isn't available
+	unsigned char* mapped;
+	std::vector<unsigned char> shadow;
+	// Ranges written since the last Flush, only used without persistent mapping
+	std::vector<StreamAllocation> pending;
+	std::vector<GLsizeiptr> pendingSizes;
+
+	// Blocks until the oldest frame is done on the GPU and frees its memory
+	void retireOldest();
+};
+
+#endif
@@ -1,83 +1,247 @@
 #include"Texture.h"
 
+#include<algorithm>
+#include<stdexcept>
+
+#include"JobSystem.h"
+#include"SamplerCache.h"
+
+// Flips every image so it appears right side up. Set once before main, so decoding on several threads never writes it
+static const bool flipOnLoad = (stbi_set_flip_vertically_on_load(true), true);
+
+// Reads and decodes an image file, bytes is NULL if that failed
+TextureImage TextureImage::Load(const char* image)
+{
+	TextureImage result = { NULL, 0, 0, 0 };
+	// Reads the image from a file and stores it in bytes
+	result.bytes = stbi_load(image, &result.width, &result.height, &result.channels, 0);
+	return result;
+}
+
+
 Texture::Texture(const char* image, const char* texType, GLuint slot)
 {
-	// Assigns the type of the texture ot the texture object
-	type = texType;
+	TextureImage pixels = TextureImage::Load(image);
+	create(pixels, texType, slot);
+}
 
-	// Stores the width, height, and the number of color channels of the image
-	int widthImg, heightImg, numColCh;
-	// Flips the image so it appears right side up
-	stbi_set_flip_vertically_on_load(true);
-	// Reads the image from a file and stores it in bytes
-	unsigned char* bytes = stbi_load(image, &widthImg, &heightImg, &numColCh, 0);
 
-	// Generates an OpenGL texture object
-	glGenTextures(1, &ID);
-	// Assigns the texture to a Texture Unit
-	glActiveTexture(GL_TEXTURE0 + slot);
+// Creates the texture from pixels decoded earlier and frees them
+Texture::Texture(TextureImage& image, const char* texType, GLuint slot)
+{
+	create(image, texType, slot);
+}
+
+
+// Wraps a texture object that exists already, or 0 for one that is still being uploaded
+Texture::Texture(GLuint ID, const char* texType, GLuint slot)
+{
+	Texture::ID = ID;
+	type = texType;
 	unit = slot;
-	// Almost 90% Texture is 2D
-	glBindTexture(GL_TEXTURE_2D, ID);
+}
 
-	// Configures the type of algorithm that is used to make the image smaller or bigger
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-	// Configures the way the texture repeats (if it does at all)
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+// Creates a texture with room for every mip level of a width x height image, filled later through Upload
+Texture::Texture(int width, int height, const char* texType, GLuint slot)
+{
+	type = texType;
+	unit = slot;
+	allocate(width, height);
+}
 
-	// Extra lines in case you choose to use GL_CLAMP_TO_BORDER
-	// float flatColor[] = {1.0f, 1.0f, 1.0f, 1.0f};
-	// glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, flatColor);
 
-	if (numColCh == 4)
+// Picks the layout of decoded pixels from their number of channels
+GLenum Texture::PixelFormat(int channels)
+{
+	if (channels == 4)
+	{
+		return GL_RGBA;
+	}
+	else if (channels == 3)
 	{
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, widthImg, heightImg, 0, GL_RGBA, GL_UNSIGNED_BYTE, bytes);
+		return GL_RGB;
 	}
-	else if (numColCh == 3)
+	else if (channels == 1)
 	{
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, widthImg, heightImg, 0, GL_RGB, GL_UNSIGNED_BYTE, bytes);
+		return GL_RED;
 	}
-	else if (numColCh == 1)
+	throw std::invalid_argument("Automatic Texture type recognition failed");
+}
+
+
+// Every mip level of the image down to 1x1 on the CPU, each texel averages 2x2 texels of the level before
+std::vector<std::vector<unsigned char>> Texture::BuildMipChain(const TextureImage& image, std::vector<int>& widths, std::vector<int>& heights)
+{
+	int channels = image.channels;
+	std::vector<std::vector<unsigned char>> levels;
+	widths.assign(1, image.width);
+	heights.assign(1, image.height);
+	levels.push_back(std::vector<unsigned char>(image.bytes, image.bytes + (size_t)image.width * image.height * channels));
+	while (widths.back() > 1 || heights.back() > 1)
 	{
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, widthImg, heightImg, 0, GL_RED, GL_UNSIGNED_BYTE, bytes);
+		int srcWidth = widths.back();
+		int srcHeight = heights.back();
+		int width = std::max(1, srcWidth / 2);
+		int height = std::max(1, srcHeight / 2);
+		std::vector<unsigned char> level((size_t)width * height * channels);
+		const std::vector<unsigned char>& src = levels.back();
+		ParallelFor(height, 64, [&](size_t, size_t begin, size_t end)
+		{
+			for (size_t y = begin; y < end; y++)
+			{
+				// Odd sizes repeat their last row or column
+				size_t y0 = std::min<size_t>(y * 2, srcHeight - 1);
+				size_t y1 = std::min<size_t>(y * 2 + 1, srcHeight - 1);
+				for (int x = 0; x < width; x++)
+				{
+					size_t x0 = std::min(x * 2, srcWidth - 1);
+					size_t x1 = std::min(x * 2 + 1, srcWidth - 1);
+					for (int c = 0; c < channels; c++)
+					{
+						unsigned int sum = src[(y0 * srcWidth + x0) * channels + c] + src[(y0 * srcWidth + x1) * channels + c]
+							+ src[(y1 * srcWidth + x0) * channels + c] + src[(y1 * srcWidth + x1) * channels + c];
+						level[(y * width + x) * channels + c] = (unsigned char)((sum + 2) / 4);
+					}
+				}
+			}
+		});
+		widths.push_back(width);
+		heights.push_back(height);
+		levels.push_back(std::move(level));
 	}
-	else 
+	return levels;
+}
+
+
+// Copies rows [y, y + rows) of level 0 from pixels, which is an offset into the bound pixel unpack buffer if there is one
+void Texture::Upload(int y, int width, int rows, GLenum format, const void* pixels)
+{
+	if (GLCaps.directStateAccess)
 	{
-		throw std::invalid_argument("Automatic Texture type recognition failed");
+		glTextureSubImage2D(ID, 0, 0, y, width, rows, format, GL_UNSIGNED_BYTE, pixels);
+		return;
 	}
-		
-	// Generates MipMaps
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D, ID);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, width, rows, format, GL_UNSIGNED_BYTE, pixels);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+
+// Fills the smaller mip levels from level 0, call once level 0 is complete
+void Texture::GenerateMipmaps()
+{
+	if (GLCaps.directStateAccess)
+	{
+		glGenerateTextureMipmap(ID);
+		return;
+	}
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D, ID);
 	glGenerateMipmap(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+
+void Texture::create(TextureImage& image, const char* texType, GLuint slot)
+{
+	// Assigns the type of the texture ot the texture object
+	type = texType;
+	unit = slot;
+
+	// Stores the width, height, and the number of color channels of the image
+	int widthImg = image.width;
+	int heightImg = image.height;
+	unsigned char* bytes = image.bytes;
+	image.bytes = NULL;
+
+	GLenum format;
+	try
+	{
+		format = PixelFormat(image.channels);
+	}
+	catch (...)
+	{
+		stbi_image_free(bytes);
+		throw;
+	}
+
+	allocate(widthImg, heightImg);
+	Upload(0, widthImg, heightImg, format, bytes);
+	GenerateMipmaps();
 
 	// Deletes the image data as it is already in the OpenGL Texture object
 	stbi_image_free(bytes);
+}
+
+
+void Texture::allocate(int width, int height)
+{
+	if (GLCaps.directStateAccess)
+	{
+		// With DSA the texture is set up without binding it, so no texture unit gets disturbed
+		glCreateTextures(GL_TEXTURE_2D, 1, &ID);
+		SamplerState().ApplyToTexture(ID, GL_TEXTURE_2D);
+
+		// Immutable storage for the whole mip chain
+		GLsizei levels = 1;
+		while ((std::max(width, height) >> levels) > 0)
+		{
+			levels++;
+		}
+		glTextureStorage2D(ID, levels, GL_RGBA8, width, height);
+		return;
+	}
+
+	// Generates an OpenGL texture object
+	glGenTextures(1, &ID);
+	// Assigns the texture to a Texture Unit
+	glActiveTexture(GL_TEXTURE0 + unit);
+	// Almost 90% Texture is 2D
+	glBindTexture(GL_TEXTURE_2D, ID);
+
+	// Configures how the image gets smaller or bigger and how it repeats, for sampling without a sampler object
+	SamplerState().ApplyToTexture(ID, GL_TEXTURE_2D);
+
+	// Extra lines in case you choose to use GL_CLAMP_TO_BORDER
+	// float flatColor[] = {1.0f, 1.0f, 1.0f, 1.0f};
+	// glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, flatColor);
+
+	// Level 0 without data, GenerateMipmaps creates the other levels
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 
 	// Unbinds the OpenGL Texture object so that it can't accidentally be modified
 	glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void Texture::texUnit(Shader& shader, const char* uniform, GLuint unit)
+void Texture::texUnit(CommandBuffer& commands, Shader& shader, const char* uniform, GLuint unit)
 {
-	// Gets the location of the uniform
-	GLuint texUni = glGetUniformLocation(shader.ID, uniform);
 	// Shader needs to be activated before changing the value of a uniform
-	shader.Activate();
+	commands.UseProgram(shader.ID);
 	// Sets the value of the uniform
-	glUniform1i(texUni, unit);
+	commands.Uniform1i(shader.Uniform(uniform), unit);
 }
 
 void Texture::Bind()
 {
+	if (GLCaps.directStateAccess)
+	{
+		glBindTextureUnit(unit, ID);
+		return;
+	}
 	glActiveTexture(GL_TEXTURE0 + unit);
-	glBindTexture(GL_TEXTURE_2D, ID);
+	glBindTexture(target, ID);
+}
+
+void Texture::Bind(CommandBuffer& commands)
+{
+	commands.BindTexture(unit, ID, target);
 }
 
 void Texture::Unbind()
 {
-	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindTexture(target, 0);
 }
 
 void Texture::Delete()
@@ -1,10 +1,24 @@
 #ifndef TEXTURE_CLASS_H
 #define TEXTURE_CLASS_H
 
-#include<glad/glad.h>
 #include<stb/stb_image.h>
+#include<vector>
 
+#include"GLExtensions.h"
 #include"shader.h"
+#include"CommandBuffer.h"
+
+// Pixels of an image file decoded by stb_image. Decoding needs no OpenGL, so it can run on any thread
+struct TextureImage
+{
+	unsigned char* bytes;
+	int width;
+	int height;
+	int channels;
+
+	// Reads and decodes an image file, bytes is NULL if that failed
+	static TextureImage Load(const char* image);
+};
 
 class Texture
 {
@@ -12,16 +26,41 @@ public:
 	GLuint ID;
 	const char* type;
 	GLuint unit;
+	// GL_TEXTURE_2D_ARRAY for images packed into an array texture, layer is then the image inside it
+	GLenum target = GL_TEXTURE_2D;
+	GLint layer = -1;
 	
 	Texture(const char* image, const char* texType, GLuint slot);
+	// Creates the texture from pixels decoded earlier and frees them
+	Texture(TextureImage& image, const char* texType, GLuint slot);
+	// Wraps a texture object that exists already, or 0 for one that is still being uploaded
+	Texture(GLuint ID, const char* texType, GLuint slot);
+	// Creates a texture with room for every mip level of a width x height image, filled later through Upload
+	Texture(int width, int height, const char* texType, GLuint slot);
+
+	// Picks the layout of decoded pixels from their number of channels
+	static GLenum PixelFormat(int channels);
+	// Every mip level of the image down to 1x1 on the CPU, each texel averages 2x2 texels of the level before.
+	// Keeps the channels of the image, the pixels themselves aren't freed
+	static std::vector<std::vector<unsigned char>> BuildMipChain(const TextureImage& image, std::vector<int>& widths, std::vector<int>& heights);
+	// Copies rows [y, y + rows) of level 0 from pixels, which is an offset into the bound pixel unpack buffer if there is one
+	void Upload(int y, int width, int rows, GLenum format, const void* pixels);
+	// Fills the smaller mip levels from level 0, call once level 0 is complete
+	void GenerateMipmaps();
 
-	// Assigns a texture unit to a texture
-	void texUnit(Shader& shader, const char* uniform, GLuint unit);
+	// Records assigning a texture unit to a texture
+	void texUnit(CommandBuffer& commands, Shader& shader, const char* uniform, GLuint unit);
 	// Binds a texture
 	void Bind();
+	// Records binding the texture to its unit
+	void Bind(CommandBuffer& commands);
 	// Unbinds a texture
 	void Unbind();
 	// Deletes a texture
 	void Delete();
+
+private:
+	void create(TextureImage& image, const char* texType, GLuint slot);
+	void allocate(int width, int height);
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include"TextureArrayPacker.h"
+#include"SamplerCache.h"
+
+#include<algorithm>
+
+
+// Queues an image and takes over its pixels, index then names it in Get
+bool TextureArrayPacker::Add(TextureImage& image, unsigned int& index)
+{
+	if (image.bytes == NULL || image.width > maxSize || image.height > maxSize)
+	{
+		return false;
+	}
+	// Fails here rather than in Build for images OpenGL can't take
+	Texture::PixelFormat(image.channels);
+
+	unsigned int group = 0;
+	while (group < groups.size() && (groups[group].width != image.width || groups[group].height != image.height
+		|| groups[group].channels != image.channels))
+	{
+		group++;
+	}
+	if (group == groups.size())
+	{
+		groups.push_back(Group{ image.width, image.height, image.channels, {}, 0 });
+	}
+
+	index = (unsigned int)images.size();
+	groupOf.push_back(group);
+	layerOf.push_back((GLint)groups[group].images.size());
+	groups[group].images.push_back(index);
+	images.push_back(image);
+	image.bytes = NULL;
+	return true;
+}
+
+
+// Creates one array texture for every group of images with the same size and channels and frees the pixels
+void TextureArrayPacker::Build()
+{
+	for (unsigned int i = 0; i < groups.size(); i++)
+	{
+		if (groups[i].ID == 0)
+		{
+			create(groups[i]);
+		}
+	}
+}
+
+
+// The layer of a packed image, to be used like any other texture by Mesh
+Texture TextureArrayPacker::Get(unsigned int index, const char* texType, GLuint slot) const
+{
+	Texture texture(groups[groupOf[index]].ID, texType, slot);
+	texture.target = GL_TEXTURE_2D_ARRAY;
+	texture.layer = layerOf[index];
+	return texture;
+}
+
+
+void TextureArrayPacker::Delete()
+{
+	for (unsigned int i = 0; i < groups.size(); i++)
+	{
+		glDeleteTextures(1, &groups[i].ID);
+		groups[i].ID = 0;
+	}
+}
+
+
+void TextureArrayPacker::create(Group& group)
+{
+	GLsizei layers = (GLsizei)group.images.size();
+	GLenum format = Texture::PixelFormat(group.channels);
+
+	glGenTextures(1, &group.ID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, group.ID);
+	// Same filtering and wrapping as a single Texture, every layer repeats on its own
+	SamplerState().ApplyToTexture(group.ID, GL_TEXTURE_2D_ARRAY);
+
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, group.width, group.height, layers, 0, format, GL_UNSIGNED_BYTE, NULL);
+	// Rows of RGB and single channel images aren't padded to 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (GLsizei layer = 0; layer < layers; layer++)
+	{
+		TextureImage& image = images[group.images[layer]];
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, group.width, group.height, 1, format, GL_UNSIGNED_BYTE, image.bytes);
+		stbi_image_free(image.bytes);
+		image.bytes = NULL;
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	// Mip levels are filtered per layer, so neighbouring images never bleed into each other
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
@@ -0,0 +1,52 @@
+#ifndef TEXTURE_ARRAY_PACKER_CLASS_H
+#define TEXTURE_ARRAY_PACKER_CLASS_H
+
+#include<vector>
+
+#include"Texture.h"
+
+
+// Packs small images into GL_TEXTURE_2D_ARRAY textures, one array for every size and number of
+// channels, so meshes using different small textures bind the same texture object and only a
+// layer uniform changes between them. The images keep their own texture coordinates, unlike in an
+// atlas wrapping with GL_REPEAT and the mip levels still work without padding around the images
+class TextureArrayPacker
+{
+public:
+	// Images larger than this on either side are better off in a texture of their own
+	int maxSize = 256;
+
+	// Queues an image and takes over its pixels, index then names it in Get.
+	// Returns false and leaves the image alone if it is too large or didn't decode
+	bool Add(TextureImage& image, unsigned int& index);
+	// Creates one array texture for every group of images with the same size and channels and frees the pixels
+	void Build();
+
+	// The layer of a packed image, to be used like any other texture by Mesh. Call after Build
+	Texture Get(unsigned int index, const char* texType, GLuint slot) const;
+	// Number of array textures Build created
+	unsigned int ArrayCount() const { return (unsigned int)groups.size(); }
+	// Deletes the array textures
+	void Delete();
+
+private:
+	// Images that end up in the same array texture
+	struct Group
+	{
+		int width;
+		int height;
+		int channels;
+		std::vector<unsigned int> images;
+		GLuint ID;
+	};
+
+	std::vector<TextureImage> images;
+	// Group and layer of every image, by index
+	std::vector<unsigned int> groupOf;
+	std::vector<GLint> layerOf;
+	std::vector<Group> groups;
+
+	void create(Group& group);
+};
+
+#endif
@@ -0,0 +1,283 @@
+#include"TextureResidency.h"
+#include"SamplerCache.h"
+
+#include<algorithm>
+#include<cmath>
+
+
+TextureResidency::TextureResidency(size_t budgetBytes, size_t uploadBytesPerFrame, int residentSize)
+{
+	TextureResidency::budgetBytes = budgetBytes;
+	TextureResidency::uploadBytesPerFrame = uploadBytesPerFrame;
+	TextureResidency::residentSize = residentSize;
+	residentBytes = 0;
+}
+
+
+// Builds the mip chain of the pixels, creates the texture with only the small levels and hands its ID to ready right away.
+// The type stays with the placeholder Texture of the model, the levels are the same for every type
+void TextureResidency::UploadTexture(TextureImage image, const char*, GLuint slot, std::function<void(GLuint)> ready)
+{
+	Entry entry;
+	try
+	{
+		entry.format = Texture::PixelFormat(image.channels);
+	}
+	catch (...)
+	{
+		stbi_image_free(image.bytes);
+		throw;
+	}
+	entry.unit = slot;
+	entry.channels = image.channels;
+	entry.requested = 0.0f;
+
+	// Level 0 is the decoded image, every further level averages 2x2 texels of the one before
+	entry.levels = Texture::BuildMipChain(image, entry.widths, entry.heights);
+	stbi_image_free(image.bytes);
+
+	int lastLevel = (int)entry.levels.size() - 1;
+	entry.minimumResident = lastLevel;
+	for (int l = 0; l <= lastLevel; l++)
+	{
+		if (std::max(entry.widths[l], entry.heights[l]) <= residentSize)
+		{
+			entry.minimumResident = l;
+			break;
+		}
+	}
+	entry.resident = entry.minimumResident;
+	entry.pendingRows = 0;
+
+	// Mutable storage, so single levels can be given memory and take it back later
+	glGenTextures(1, &entry.ID);
+	bind(entry);
+	SamplerState().ApplyToTexture(entry.ID, GL_TEXTURE_2D);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (int l = entry.resident; l <= lastLevel; l++)
+	{
+		glTexImage2D(GL_TEXTURE_2D, l, GL_RGBA8, entry.widths[l], entry.heights[l], 0, entry.format, GL_UNSIGNED_BYTE, entry.levels[l].data());
+		residentBytes += levelBytes(entry, l);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	// Sampling only ever sees the resident levels
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, entry.resident);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, lastLevel);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	GLuint ID = entry.ID;
+	entryOfTexture[ID] = entries.size();
+	entries.push_back(std::move(entry));
+	if (ready)
+	{
+		ready(ID);
+	}
+}
+
+
+// Asks for enough detail that one screen pixel covers uvPerPixel texture coordinate units. The finest request of a frame wins
+void TextureResidency::Request(GLuint ID, float uvPerPixel)
+{
+	std::unordered_map<GLuint, unsigned int>::iterator found = entryOfTexture.find(ID);
+	if (found == entryOfTexture.end() || uvPerPixel <= 0.0f)
+	{
+		return;
+	}
+	Entry& entry = entries[found->second];
+	if (entry.requested == 0.0f || uvPerPixel < entry.requested)
+	{
+		entry.requested = uvPerPixel;
+	}
+}
+
+
+// Evicts and streams levels towards the requests of this frame, call once a frame on the thread that owns the context
+void TextureResidency::Update()
+{
+	std::vector<int> wanted(entries.size());
+	for (unsigned int i = 0; i < entries.size(); i++)
+	{
+		wanted[i] = wantedLevel(entries[i]);
+		// A level that is partly up but no longer needed gives its memory back
+		if (entries[i].pendingRows > 0 && wanted[i] >= entries[i].resident)
+		{
+			dropPending(entries[i]);
+		}
+	}
+
+	size_t uploaded = 0;
+	while (uploaded < uploadBytesPerFrame)
+	{
+		// A level that is partly up is finished first, after that the texture furthest away from the detail it needs
+		int best = -1;
+		int bestDeficit = 0;
+		for (unsigned int i = 0; i < entries.size(); i++)
+		{
+			int deficit = entries[i].resident - wanted[i];
+			if (entries[i].pendingRows > 0 && deficit > 0)
+			{
+				best = i;
+				break;
+			}
+			if (deficit > bestDeficit)
+			{
+				best = i;
+				bestDeficit = deficit;
+			}
+		}
+		if (best < 0)
+		{
+			break;
+		}
+		// The memory of a level is taken with its first band
+		size_t cost = entries[best].pendingRows > 0 ? 0 : levelBytes(entries[best], entries[best].resident - 1);
+
+		// Makes room by dropping levels that are finer than needed, the largest surplus first
+		while (residentBytes + cost > budgetBytes)
+		{
+			int victim = -1;
+			int victimSurplus = 0;
+			for (unsigned int i = 0; i < entries.size(); i++)
+			{
+				int surplus = wanted[i] - entries[i].resident;
+				if (surplus > victimSurplus)
+				{
+					victim = i;
+					victimSurplus = surplus;
+				}
+			}
+			if (victim < 0)
+			{
+				break;
+			}
+			evict(entries[victim]);
+		}
+		if (residentBytes + cost > budgetBytes)
+		{
+			break;
+		}
+		uploaded += streamIn(entries[best], uploadBytesPerFrame - uploaded);
+	}
+
+	// Requests only count for the frame they were made in
+	for (unsigned int i = 0; i < entries.size(); i++)
+	{
+		entries[i].requested = 0.0f;
+	}
+}
+
+
+// Finest level of a texture on the GPU, -1 for textures this doesn't manage
+int TextureResidency::ResidentLevel(GLuint ID) const
+{
+	std::unordered_map<GLuint, unsigned int>::const_iterator found = entryOfTexture.find(ID);
+	return found == entryOfTexture.end() ? -1 : entries[found->second].resident;
+}
+
+
+// Deletes every texture and the system memory copies
+void TextureResidency::Delete()
+{
+	for (unsigned int i = 0; i < entries.size(); i++)
+	{
+		glDeleteTextures(1, &entries[i].ID);
+	}
+	entries.clear();
+	entryOfTexture.clear();
+	residentBytes = 0;
+}
+
+
+// Level the requests of this frame ask for
+int TextureResidency::wantedLevel(const Entry& entry) const
+{
+	if (entry.requested <= 0.0f)
+	{
+		return entry.minimumResident;
+	}
+	// Texels of level 0 under one pixel, every level halves it
+	float texelsPerPixel = entry.requested * std::sqrt((float)entry.widths[0] * entry.heights[0]);
+	int level = texelsPerPixel <= 1.0f ? 0 : (int)std::floor(std::log2(texelsPerPixel));
+	return std::min(level, entry.minimumResident);
+}
+
+
+size_t TextureResidency::levelBytes(const Entry& entry, int level)
+{
+	// Stored as RGBA8 whatever the image had
+	return (size_t)entry.widths[level] * entry.heights[level] * 4;
+}
+
+
+// Uploads at most maxBytes of the level just finer than the resident one and returns the bytes it uploaded
+size_t TextureResidency::streamIn(Entry& entry, size_t maxBytes)
+{
+	int level = entry.resident - 1;
+	int width = entry.widths[level];
+	int height = entry.heights[level];
+	// The budget counts the RGBA8 bytes the GPU stores, the system memory copy keeps the channels of the image
+	size_t rowBytes = (size_t)width * 4;
+	size_t sourceRowBytes = (size_t)width * entry.channels;
+	// At least one row, so a single huge row can't stop streaming
+	int rows = (int)std::max<size_t>(1, std::min<size_t>(height - entry.pendingRows, maxBytes / rowBytes));
+
+	bind(entry);
+	// Rows of RGB images with odd widths aren't 4 byte aligned
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if (entry.pendingRows == 0)
+	{
+		// Allocates the level, BASE_LEVEL keeps sampling away from it until every band is in
+		glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, width, height, 0, entry.format, GL_UNSIGNED_BYTE, NULL);
+		residentBytes += levelBytes(entry, level);
+	}
+	glTexSubImage2D(GL_TEXTURE_2D, level, 0, entry.pendingRows, width, rows, entry.format, GL_UNSIGNED_BYTE, entry.levels[level].data() + entry.pendingRows * sourceRowBytes);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	entry.pendingRows += rows;
+	if (entry.pendingRows == height)
+	{
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+		entry.resident = level;
+		entry.pendingRows = 0;
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return rows * rowBytes;
+}
+
+
+// Drops the finest resident level, or the partly uploaded level below it if there is one
+void TextureResidency::evict(Entry& entry)
+{
+	if (entry.pendingRows > 0)
+	{
+		dropPending(entry);
+		return;
+	}
+	int level = entry.resident;
+	bind(entry);
+	// Sampling moves off the level before its memory goes away
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+	glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, 0, 0, 0, entry.format, GL_UNSIGNED_BYTE, NULL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	entry.resident = level + 1;
+	residentBytes -= levelBytes(entry, level);
+}
+
+
+// Frees the partly uploaded level of a texture
+void TextureResidency::dropPending(Entry& entry)
+{
+	int level = entry.resident - 1;
+	bind(entry);
+	glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, 0, 0, 0, entry.format, GL_UNSIGNED_BYTE, NULL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	entry.pendingRows = 0;
+	residentBytes -= levelBytes(entry, level);
+}
+
+
+// Binds the texture to its unit, the levels of a mutable texture can't be changed without binding
+void TextureResidency::bind(const Entry& entry)
+{
+	glActiveTexture(GL_TEXTURE0 + entry.unit);
+	glBindTexture(GL_TEXTURE_2D, entry.ID);
+}
@@ -0,0 +1,79 @@
+#ifndef TEXTURE_RESIDENCY_CLASS_H
+#define TEXTURE_RESIDENCY_CLASS_H
+
+#include<unordered_map>
+#include<vector>
+
+#include"TextureUploader.h"
+
+
+// Keeps only the mip levels of each texture resident that the screen needs, under a fixed budget
+// of texture memory. The full mip chain of every texture is built once in system memory, the
+// small levels go to the GPU right away and finer ones are streamed in or evicted every frame.
+// The resident range is exposed to sampling through GL_TEXTURE_BASE_LEVEL and GL_TEXTURE_MAX_LEVEL.
+// Levels larger than the upload budget of a frame go up a band of rows per frame
+class TextureResidency : public TextureUploader
+{
+public:
+	// Bytes of texture memory all resident levels together may use
+	size_t budgetBytes;
+	// Bytes of finer levels uploaded per frame, keeps streaming from causing hitches. At least one row goes up per frame
+	size_t uploadBytesPerFrame;
+	// Levels whose larger side is at most this many texels are always resident
+	int residentSize;
+
+	TextureResidency(size_t budgetBytes = 256 * 1024 * 1024, size_t uploadBytesPerFrame = 8 * 1024 * 1024, int residentSize = 64);
+
+	// Builds the mip chain of the pixels, creates the texture with only the small levels and hands its ID to ready right away
+	void UploadTexture(TextureImage image, const char* texType, GLuint slot, std::function<void(GLuint)> ready) override;
+	// Asks for enough detail that one screen pixel covers uvPerPixel texture coordinate units. The finest request of a frame wins
+	void Request(GLuint ID, float uvPerPixel);
+	// Evicts and streams levels towards the requests of this frame, call once a frame on the thread that owns the context
+	void Update();
+
+	size_t ResidentBytes() const { return residentBytes; }
+	// Finest level of a texture on the GPU, -1 for textures this doesn't manage
+	int ResidentLevel(GLuint ID) const;
+	// Deletes every texture and the system memory copies
+	void Delete();
+
+private:
+	// One texture and its mip chain in system memory
+	struct Entry
+	{
+		GLuint ID;
+		GLuint unit;
+		GLenum format;
+		int channels;
+		std::vector<int> widths;
+		std::vector<int> heights;
+		std::vector<std::vector<unsigned char>> levels;
+		// Finest level on the GPU, everything from here to the last level is resident
+		int resident;
+		// Rows of level resident - 1 uploaded so far, its memory is taken once the first band goes up
+		int pendingRows;
+		// Coarsest level that is never evicted
+		int minimumResident;
+		// Smallest uvPerPixel requested this frame, 0 when nothing asked
+		float requested;
+	};
+
+	std::vector<Entry> entries;
+	std::unordered_map<GLuint, unsigned int> entryOfTexture;
+	size_t residentBytes;
+
+	// Level the requests of this frame ask for
+	int wantedLevel(const Entry& entry) const;
+	static size_t levelBytes(const Entry& entry, int level);
+	// Uploads at most maxBytes of the level just finer than the resident one and returns the bytes
+	// it uploaded, the level is only sampled once its last row is in
+	size_t streamIn(Entry& entry, size_t maxBytes);
+	// Drops the finest resident level, or the partly uploaded level below it if there is one
+	void evict(Entry& entry);
+	// Frees the partly uploaded level of a texture
+	void dropPending(Entry& entry);
+	// Binds the texture to its unit, the levels of a mutable texture can't be changed without binding
+	void bind(const Entry& entry);
+};
+
+#endif
@@ -0,0 +1,94 @@
+#include"TextureStreamer.h"
+
+#include<algorithm>
+#include<cstring>
+
+// Constructor that creates a ring of ringSize bytes, it should hold a few frames worth of bytesPerFrame
+TextureStreamer::TextureStreamer(GLsizeiptr ringSize, GLsizeiptr bytesPerFrame)
+	: staging(ringSize)
+{
+	TextureStreamer::bytesPerFrame = bytesPerFrame;
+}
+
+
+// Creates the texture storage now and queues the pixels, ready runs inside Update once the last band went up
+void TextureStreamer::UploadTexture(TextureImage image, const char* texType, GLuint slot, std::function<void(GLuint)> ready)
+{
+	GLenum format;
+	try
+	{
+		format = Texture::PixelFormat(image.channels);
+	}
+	catch (...)
+	{
+		stbi_image_free(image.bytes);
+		throw;
+	}
+	Texture texture(image.width, image.height, texType, slot);
+	jobs.push_back(Job{ image, texture, format, 0, std::move(ready) });
+}
+
+
+// Starts the transfers of the next bands, call once a frame on the thread that owns the context
+void TextureStreamer::Update()
+{
+	if (jobs.empty())
+	{
+		return;
+	}
+	// Frees the bands of frames the GPU has copied already
+	staging.BeginFrame();
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.ID);
+	// Rows are packed tightly in the ring, RGB images with odd widths don't have 4 byte rows
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	GLsizeiptr budget = bytesPerFrame;
+	while (!jobs.empty() && budget > 0)
+	{
+		Job& job = jobs.front();
+		GLsizeiptr rowBytes = (GLsizeiptr)job.image.width * job.image.channels;
+		// At least one row, so a single huge row can't stop the queue
+		int rows = (int)std::max<GLsizeiptr>(1, std::min<GLsizeiptr>(job.image.height - job.nextRow, budget / rowBytes));
+		GLsizeiptr bytes = rows * rowBytes;
+
+		StreamAllocation band = staging.Allocate(bytes, 4);
+		std::memcpy(band.data, job.image.bytes + job.nextRow * rowBytes, bytes);
+		// Without persistent mapping the band only reaches the buffer here
+		staging.Flush();
+		job.texture.Upload(job.nextRow, job.image.width, rows, job.format, (const void*)band.offset);
+		job.nextRow += rows;
+		budget -= bytes;
+
+		if (job.nextRow == job.image.height)
+		{
+			// Commands run in order, so the mipmaps are made from the finished level 0
+			job.texture.GenerateMipmaps();
+			stbi_image_free(job.image.bytes);
+			std::function<void(GLuint)> ready = std::move(job.ready);
+			GLuint ID = job.texture.ID;
+			jobs.pop_front();
+			if (ready)
+			{
+				ready(ID);
+			}
+		}
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	// Fences the bands of this frame so the ring doesn't overwrite them too early
+	staging.EndFrame();
+}
+
+
+// Frees the pixels that are still queued and deletes the ring
+void TextureStreamer::Delete()
+{
+	for (unsigned int i = 0; i < jobs.size(); i++)
+	{
+		stbi_image_free(jobs[i].image.bytes);
+		jobs[i].texture.Delete();
+	}
+	jobs.clear();
+	staging.Delete();
+}
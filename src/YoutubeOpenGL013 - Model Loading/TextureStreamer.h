@@ -0,0 +1,49 @@
+#ifndef TEXTURE_STREAMER_CLASS_H
+#define TEXTURE_STREAMER_CLASS_H
+
+#include<deque>
+
+#include"StreamBuffer.h"
+#include"TextureUploader.h"
+
+
+// Uploads textures on the render thread without stalling it. Decoded pixels are copied into a
+// persistently mapped ring that is bound as the pixel unpack buffer, so glTexSubImage2D reads
+// them with DMA instead of from client memory. Big images go up a band of rows per frame,
+// at most bytesPerFrame bytes each frame, and their mipmaps are made once the last band is in
+class TextureStreamer : public TextureUploader
+{
+public:
+	// Bytes copied into the ring each frame, later frames continue where this stopped
+	GLsizeiptr bytesPerFrame;
+
+	// Constructor that creates a ring of ringSize bytes, it should hold a few frames worth of bytesPerFrame
+	TextureStreamer(GLsizeiptr ringSize = 16 * 1024 * 1024, GLsizeiptr bytesPerFrame = 4 * 1024 * 1024);
+
+	// Creates the texture storage now and queues the pixels, ready runs inside Update once the last band went up
+	void UploadTexture(TextureImage image, const char* texType, GLuint slot, std::function<void(GLuint)> ready) override;
+	// Starts the transfers of the next bands, call once a frame on the thread that owns the context
+	void Update();
+
+	// Textures whose pixels haven't all been handed to the GPU yet
+	unsigned int Pending() const { return jobs.size(); }
+	// Frees the pixels that are still queued and deletes the ring
+	void Delete();
+
+private:
+	// A texture that is still being uploaded
+	struct Job
+	{
+		TextureImage image;
+		Texture texture;
+		GLenum format;
+		// First row of level 0 that hasn't been uploaded
+		int nextRow;
+		std::function<void(GLuint)> ready;
+	};
+
+	StreamBuffer staging;
+	std::deque<Job> jobs;
+};
+
+#endif
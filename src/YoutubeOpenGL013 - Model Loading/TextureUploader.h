@@ -0,0 +1,20 @@
+#ifndef TEXTURE_UPLOADER_CLASS_H
+#define TEXTURE_UPLOADER_CLASS_H
+
+#include<functional>
+
+#include"Texture.h"
+
+
+// Something that turns decoded images into textures later than right away, such as the
+// upload thread or the pixel buffer streamer. Model hands its textures to one of these
+class TextureUploader
+{
+public:
+	virtual ~TextureUploader() {}
+
+	// Creates the texture from pixels decoded earlier and hands its ID to ready on the render thread, the pixels are freed
+	virtual void UploadTexture(TextureImage image, const char* texType, GLuint slot, std::function<void(GLuint)> ready) = 0;
+};
+
+#endif
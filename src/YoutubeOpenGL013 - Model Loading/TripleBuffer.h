@@ -0,0 +1,54 @@
+#ifndef TRIPLE_BUFFER_CLASS_H
+#define TRIPLE_BUFFER_CLASS_H
+
+#include<atomic>
+
+
+// Hands the newest value from one producer thread to one consumer thread without locks or waiting.
+// The producer fills Back() and publishes it, the consumer picks up the latest published value with
+// Acquire and reads it through Front(). Neither side ever blocks the other, values the consumer was
+// too slow for are simply overwritten
+template<typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer(const T& initial)
+		: slots{ initial, initial, initial }, back(0), ready(1), front(2)
+	{
+	}
+
+	// Slot only the producer touches
+	T& Back() { return slots[back]; }
+	// Makes Back() the newest value and gives the producer a free slot
+	void Publish()
+	{
+		int previous = ready.exchange(back | freshBit, std::memory_order_acq_rel);
+		back = previous & indexMask;
+	}
+
+	// Takes the newest published value if there is one the consumer hasn't seen, returns false otherwise
+	bool Acquire()
+	{
+		if ((ready.load(std::memory_order_acquire) & freshBit) == 0)
+		{
+			return false;
+		}
+		int previous = ready.exchange(front, std::memory_order_acq_rel);
+		front = previous & indexMask;
+		return true;
+	}
+	// Slot only the consumer touches
+	const T& Front() const { return slots[front]; }
+
+private:
+	static const int indexMask = 3;
+	// Set in ready while it holds a value the consumer hasn't taken yet
+	static const int freshBit = 4;
+
+	T slots[3];
+	int back;
+	std::atomic<int> ready;
+	int front;
+};
+
+#endif
@@ -0,0 +1,183 @@
+#include"UploadThread.h"
+
+#include<cstring>
+#include<memory>
+#include<vector>
+
+// Creates the hidden window that carries the upload context
+GLFWwindow* UploadThread::CreateContext(GLFWwindow* shareWith)
+{
+	// Same version and profile as the window it shares with, but never shown
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* context = glfwCreateWindow(1, 1, "Upload", NULL, shareWith);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+	return context;
+}
+
+
+// Starts the thread, call it on the render thread once OpenGL is loaded there
+UploadThread::UploadThread(GLFWwindow* context)
+	: running(true), pending(0)
+{
+	UploadThread::context = context;
+	thread = std::thread(&UploadThread::threadLoop, this);
+}
+
+
+UploadThread::~UploadThread()
+{
+	if (thread.joinable())
+	{
+		running = false;
+		queueCondition.notify_one();
+		thread.join();
+	}
+}
+
+
+// Runs upload on the upload thread, then ready on the render thread inside Poll once the GPU finished it
+void UploadThread::Upload(std::function<void()> upload, std::function<void()> ready)
+{
+	pending++;
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		queue.push_back(Queued{ std::move(upload), std::move(ready) });
+	}
+	queueCondition.notify_one();
+}
+
+
+// Creates the texture from pixels decoded earlier and hands its ID to ready, the pixels are freed
+void UploadThread::UploadTexture(TextureImage image, const char* texType, GLuint slot, std::function<void(GLuint)> ready)
+{
+	std::shared_ptr<GLuint> ID = std::make_shared<GLuint>(0);
+	Upload([image, texType, slot, ID]() mutable
+	{
+		Texture texture(image, texType, slot);
+		*ID = texture.ID;
+	},
+	[ready, ID]()
+	{
+		ready(*ID);
+	});
+}
+
+
+// Creates a buffer holding a copy of size bytes of data and hands its ID to ready
+void UploadThread::UploadBuffer(const void* data, GLsizeiptr size, std::function<void(GLuint)> ready)
+{
+	// The caller may free data right away, so the upload works on its own copy
+	std::shared_ptr<std::vector<unsigned char>> bytes = std::make_shared<std::vector<unsigned char>>(size);
+	std::memcpy(bytes->data(), data, size);
+	std::shared_ptr<GLuint> ID = std::make_shared<GLuint>(0);
+	Upload([bytes, ID]()
+	{
+		glGenBuffers(1, ID.get());
+		// The copy target is bound by nothing else, so no other binding gets disturbed
+		glBindBuffer(GL_COPY_WRITE_BUFFER, *ID);
+		if (GLCaps.bufferStorage)
+		{
+			glBufferStorage(GL_COPY_WRITE_BUFFER, bytes->size(), bytes->data(), 0);
+		}
+		else
+		{
+			glBufferData(GL_COPY_WRITE_BUFFER, bytes->size(), bytes->data(), GL_STATIC_DRAW);
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		bytes->clear();
+		bytes->shrink_to_fit();
+	},
+	[ready, ID]()
+	{
+		ready(*ID);
+	});
+}
+
+
+// Runs the ready callbacks of finished uploads in the order they were queued. Never waits
+void UploadThread::Poll()
+{
+	runReady(false);
+}
+
+
+// Waits for every queued upload, runs their callbacks and ends the thread. Render thread only
+void UploadThread::Finish()
+{
+	if (thread.joinable())
+	{
+		// The thread empties the queue before it looks at running
+		running = false;
+		queueCondition.notify_one();
+		thread.join();
+	}
+	runReady(true);
+}
+
+
+void UploadThread::threadLoop()
+{
+	// OpenGL was loaded by the render thread already, the function pointers work for this context too
+	glfwMakeContextCurrent(context);
+	while (true)
+	{
+		Queued job;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			queueCondition.wait(lock, [this]()
+			{
+				return !queue.empty() || !running;
+			});
+			if (queue.empty())
+			{
+				break;
+			}
+			job = std::move(queue.front());
+			queue.pop_front();
+		}
+
+		job.upload();
+		GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		// Without a flush the fence could sit in this context forever and the render thread would never see it signal
+		glFlush();
+
+		std::lock_guard<std::mutex> lock(finishedMutex);
+		finished.push_back(Finished{ fence, std::move(job.ready) });
+	}
+	glfwMakeContextCurrent(NULL);
+}
+
+
+// Runs the callbacks of finished uploads, waits for the fences only when wait is set
+void UploadThread::runReady(bool wait)
+{
+	while (true)
+	{
+		Finished done;
+		{
+			std::lock_guard<std::mutex> lock(finishedMutex);
+			if (finished.empty())
+			{
+				return;
+			}
+			GLenum status = GL_TIMEOUT_EXPIRED;
+			do
+			{
+				status = glClientWaitSync(finished.front().fence, 0, wait ? 1000000 : 0);
+			} while (wait && status == GL_TIMEOUT_EXPIRED);
+			// Later uploads may be done already, but the callbacks keep their order
+			if (status == GL_TIMEOUT_EXPIRED)
+			{
+				return;
+			}
+			done = std::move(finished.front());
+			finished.pop_front();
+		}
+		glDeleteSync(done.fence);
+		if (done.ready)
+		{
+			done.ready();
+		}
+		pending--;
+	}
+}
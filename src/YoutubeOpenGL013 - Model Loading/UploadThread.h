@@ -0,0 +1,76 @@
+#ifndef UPLOAD_THREAD_CLASS_H
+#define UPLOAD_THREAD_CLASS_H
+
+#include<atomic>
+#include<condition_variable>
+#include<deque>
+#include<functional>
+#include<mutex>
+#include<thread>
+
+#include"GLExtensions.h"
+#include"TextureUploader.h"
+
+
+// Creates buffers and textures and fills them on a thread with its own OpenGL context that
+// shares objects with the render context, so big uploads never stall a frame. Every upload
+// is followed by a fence, the render thread picks up the finished ones with Poll and only
+// then gets to see the new object through the ready callback
+class UploadThread : public TextureUploader
+{
+public:
+	// Creates the hidden window that carries the upload context. GLFW only creates windows
+	// on the main thread, so this can't happen inside the constructor
+	static GLFWwindow* CreateContext(GLFWwindow* shareWith);
+
+	// Starts the thread, call it on the render thread once OpenGL is loaded there
+	UploadThread(GLFWwindow* context);
+	~UploadThread();
+
+	// Runs upload on the upload thread, then ready on the render thread inside Poll once the GPU finished it
+	void Upload(std::function<void()> upload, std::function<void()> ready);
+	// Creates the texture from pixels decoded earlier and hands its ID to ready, the pixels are freed
+	void UploadTexture(TextureImage image, const char* texType, GLuint slot, std::function<void(GLuint)> ready) override;
+	// Creates a buffer holding a copy of size bytes of data and hands its ID to ready
+	void UploadBuffer(const void* data, GLsizeiptr size, std::function<void(GLuint)> ready);
+
+	// Runs the ready callbacks of finished uploads in the order they were queued. Never waits,
+	// call it on the render thread once a frame
+	void Poll();
+	// Waits for every queued upload, runs their callbacks and ends the thread. Render thread only
+	void Finish();
+
+	// Uploads that were queued and whose callback hasn't run yet
+	unsigned int Pending() const { return pending.load(); }
+
+private:
+	// An upload that was issued, its fence tells when the GPU is done with it
+	struct Finished
+	{
+		GLsync fence;
+		std::function<void()> ready;
+	};
+	struct Queued
+	{
+		std::function<void()> upload;
+		std::function<void()> ready;
+	};
+
+	GLFWwindow* context;
+	std::thread thread;
+	std::atomic<bool> running;
+	std::atomic<unsigned int> pending;
+
+	std::mutex queueMutex;
+	std::condition_variable queueCondition;
+	std::deque<Queued> queue;
+
+	std::mutex finishedMutex;
+	std::deque<Finished> finished;
+
+	void threadLoop();
+	// Runs the callbacks of finished uploads, waits for the fences only when wait is set
+	void runReady(bool wait);
+};
+
+#endif
@@ -3,6 +3,11 @@
 // Constructor that generates a VAO ID
 VAO::VAO()
 {
+	if (GLCaps.directStateAccess)
+	{
+		glCreateVertexArrays(1, &ID);
+		return;
+	}
 	glGenVertexArrays(1, &ID);
 }
 
@@ -18,12 +23,36 @@ void VAO::LinkVBO(VBO& VBO, GLuint layout)
 // Links a VBO Attribute such as a position or color to the VAO
 void VAO::LinkAttrib(VBO& VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void* offset)
 {
+	// With DSA every attribute gets its own binding point, which behaves the same as glVertexAttribPointer
+	if (GLCaps.directStateAccess)
+	{
+		glVertexArrayVertexBuffer(ID, layout, VBO.ID, (GLintptr)offset, stride);
+		glVertexArrayAttribFormat(ID, layout, numComponents, type, GL_FALSE, 0);
+		glVertexArrayAttribBinding(ID, layout, layout);
+		glEnableVertexArrayAttrib(ID, layout);
+		return;
+	}
 	VBO.Bind();
 	glVertexAttribPointer(layout, numComponents, type, GL_FALSE, stride, offset);
 	glEnableVertexAttribArray(layout);
 	VBO.Unbind();
 }
 
+// Makes the VAO draw its indices from an EBO
+void VAO::LinkEBO(EBO& EBO)
+{
+	if (GLCaps.directStateAccess)
+	{
+		glVertexArrayElementBuffer(ID, EBO.ID);
+		return;
+	}
+	// The element buffer binding is part of the VAO state
+	Bind();
+	EBO.Bind();
+	Unbind();
+	EBO.Unbind();
+}
+
 // Binds the VAO
 void VAO::Bind()
 {
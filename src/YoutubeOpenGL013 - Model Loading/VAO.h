@@ -1,8 +1,8 @@
 #ifndef VAO_CLASS_H
 #define VAO_CLASS_H
 
-#include<glad/glad.h>
 #include"VBO.h"
+#include"EBO.h"
 
 class VAO
 {
@@ -16,6 +16,8 @@ public:
 	void LinkVBO(VBO& VBO, GLuint layout);
 	// Links a VBO Attribute such as a position or color to the VAO
 	void LinkAttrib(VBO& VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void* offset);
+	// Makes the VAO draw its indices from an EBO
+	void LinkEBO(EBO& EBO);
 	// Binds the VAO
 	void Bind();
 	// Unbinds the VAO
@@ -3,11 +3,32 @@
 // Constructor that generates a Vertex Buffer Object and links it to vertices
 VBO::VBO(std::vector<Vertex>& vertices)
 {
+	// With DSA the buffer gets immutable storage without being bound
+	if (GLCaps.directStateAccess)
+	{
+		glCreateBuffers(1, &ID);
+		glNamedBufferStorage(ID, vertices.size() * sizeof(Vertex), vertices.data(), 0);
+		return;
+	}
 	glGenBuffers(1, &ID);
 	glBindBuffer(GL_ARRAY_BUFFER, ID);
 	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
 }
 
+// Constructor that generates an empty Vertex Buffer Object of a size in bytes
+VBO::VBO(GLsizeiptr size)
+{
+	if (GLCaps.directStateAccess)
+	{
+		glCreateBuffers(1, &ID);
+		glNamedBufferStorage(ID, size, NULL, GL_DYNAMIC_STORAGE_BIT);
+		return;
+	}
+	glGenBuffers(1, &ID);
+	glBindBuffer(GL_ARRAY_BUFFER, ID);
+	glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STATIC_DRAW);
+}
+
 // Binds the VBO
 void VBO::Bind()
 {
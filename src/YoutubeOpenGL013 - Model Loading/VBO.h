@@ -2,9 +2,10 @@
 #define VBO_CLASS_H
 
 #include<glm/glm.hpp>
-#include<glad/glad.h>
 #include<vector>
 
+#include"GLExtensions.h"
+
 
 // Structure to standardize the vertices used in the meshes
 struct Vertex
@@ -15,6 +16,19 @@ struct Vertex
 	glm::vec2 texUV;
 };
 
+// Describes where the attributes of a vertex are, counted in floats, -1 marks a missing attribute.
+// The position always comes first. Only vertex pulling reads it, the VAO path always uses Vertex
+struct VertexFormat
+{
+	GLint stride;
+	GLint normalOffset;
+	GLint colorOffset;
+	GLint texUVOffset;
+};
+
+// Format of the Vertex structure
+const VertexFormat standardVertexFormat = { 11, 3, 6, 9 };
+
 
 class VBO
 {
@@ -23,6 +37,8 @@ public:
 	GLuint ID;
 	// Constructor that generates a Vertex Buffer Object and links it to vertices
 	VBO(std::vector<Vertex>& vertices);
+	// Constructor that generates an empty Vertex Buffer Object of a size in bytes
+	VBO(GLsizeiptr size);
 
 	// Binds the VBO
 	void Bind();
@@ -0,0 +1,326 @@
+#include"VirtualTexture.h"
+
+#include<algorithm>
+#include<cmath>
+#include<stdexcept>
+
+// Marks the start of a page file, "VTPF"
+static const uint32_t pageFileMagic = 0x46505456;
+
+
+// Draws from a page file of WritePageFile
+VirtualTexture::VirtualTexture(const char* path, int windowWidth, int windowHeight, int slotsX, int slotsY, int feedbackDivisor)
+	: VirtualTexture(readHeader(path), path, windowWidth, windowHeight, slotsX, slotsY, feedbackDivisor)
+{
+}
+
+
+VirtualTexture::VirtualTexture(const PageFileHeader& header, const char* path, int windowWidth, int windowHeight, int slotsX, int slotsY, int feedbackDivisor)
+	: pages(header.width, header.height, header.pageSize, slotsX, slotsY), feedbackShader("shader/part13.vert", "shader/feedback.frag")
+{
+	VirtualTexture::windowWidth = windowWidth;
+	VirtualTexture::windowHeight = windowHeight;
+	VirtualTexture::feedbackDivisor = feedbackDivisor;
+	feedbackWidth = std::max(1, windowWidth / feedbackDivisor);
+	feedbackHeight = std::max(1, windowHeight / feedbackDivisor);
+	virtualWidth = header.width;
+	virtualHeight = header.height;
+
+	unsigned int pageCount = 0;
+	for (int l = 0; l < pages.LevelCount(); l++)
+	{
+		levelOffsets.push_back(pageCount);
+		pageCount += pages.PagesX(l) * pages.PagesY(l);
+	}
+	int pageSize = pages.PageSize();
+	tile.resize((size_t)pageSize * pageSize * 4);
+	pageFile.open(path, std::ios::binary);
+	pageFile.seekg(0, std::ios::end);
+	if (!pageFile || (std::streamoff)pageFile.tellg() < (std::streamoff)sizeof(PageFileHeader) + (std::streamoff)pageCount * (std::streamoff)tile.size())
+	{
+		feedbackShader.Delete();
+		throw std::invalid_argument("Virtual texture page file is missing pages");
+	}
+
+	// Physical pages, the level choice happens through the page table so the atlas needs no mipmaps
+	glGenTextures(1, &atlas);
+	glBindTexture(GL_TEXTURE_2D, atlas);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, slotsX * pageSize, slotsY * pageSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	// One texel per page, level n of the texture is page level n
+	glGenTextures(1, &pageTable);
+	glBindTexture(GL_TEXTURE_2D, pageTable);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, pages.LevelCount() - 1);
+	for (int l = 0; l < pages.LevelCount(); l++)
+	{
+		glTexImage2D(GL_TEXTURE_2D, l, GL_RGBA8, pages.PagesX(l), pages.PagesY(l), 0, GL_RGBA, GL_UNSIGNED_BYTE, pages.PageTable(l).data());
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// The pinned coarsest page was mapped by the page manager already
+	PageId coarsest = MakePageId(pages.LevelCount() - 1, 0, 0);
+	uploadPage(coarsest, pages.SlotOf(coarsest));
+
+	// Integer color target for the page ids and a depth buffer so only the nearest surface reports its page
+	glGenTextures(1, &feedbackColor);
+	glBindTexture(GL_TEXTURE_2D, feedbackColor);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, feedbackWidth, feedbackHeight, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glGenRenderbuffers(1, &feedbackDepth);
+	glBindRenderbuffer(GL_RENDERBUFFER, feedbackDepth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, feedbackWidth, feedbackHeight);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glGenFramebuffers(1, &feedbackFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, feedbackFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, feedbackColor, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, feedbackDepth);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glGenBuffers(2, readbackBuffers);
+	for (int i = 0; i < 2; i++)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffers[i]);
+		glBufferData(GL_PIXEL_PACK_BUFFER, feedbackWidth * feedbackHeight * sizeof(PageId), NULL, GL_STREAM_READ);
+		readbackFences[i] = 0;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	readbackIndex = 0;
+	feedback.resize(feedbackWidth * feedbackHeight);
+}
+
+
+// Redirects drawing into the feedback framebuffer and activates feedbackShader
+void VirtualTexture::BeginFeedback()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, feedbackFramebuffer);
+	glViewport(0, 0, feedbackWidth, feedbackHeight);
+	GLuint nothing[4] = { 0, 0, 0, 0 };
+	glClearBufferuiv(GL_COLOR, 0, nothing);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	feedbackShader.Activate();
+	glUniform2f(feedbackShader.Uniform("virtualSize"), (float)virtualWidth, (float)virtualHeight);
+	glUniform1f(feedbackShader.Uniform("pageSize"), (float)pages.PageSize());
+	glUniform1f(feedbackShader.Uniform("pageLevels"), (float)pages.LevelCount());
+	// Derivatives are feedbackDivisor times larger than at full resolution, this takes that back out
+	glUniform1f(feedbackShader.Uniform("feedbackBias"), -std::log2((float)feedbackDivisor));
+}
+
+
+// Starts reading the feedback back and restores the window framebuffer
+void VirtualTexture::EndFeedback()
+{
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffers[readbackIndex]);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	// Lands in the buffer, so this returns right away
+	glReadPixels(0, 0, feedbackWidth, feedbackHeight, GL_RED_INTEGER, GL_UNSIGNED_INT, (void*)0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	if (readbackFences[readbackIndex] != 0)
+	{
+		glDeleteSync(readbackFences[readbackIndex]);
+	}
+	readbackFences[readbackIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readbackIndex ^= 1;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, windowWidth, windowHeight);
+}
+
+
+// Processes the newest feedback that arrived, uploads the requested pages and updates the page table
+void VirtualTexture::Update()
+{
+	// The buffer EndFeedback writes next holds the older of the two reads
+	GLsync& fence = readbackFences[readbackIndex];
+	if (fence != 0)
+	{
+		GLenum status = glClientWaitSync(fence, 0, 0);
+		if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+		{
+			glDeleteSync(fence);
+			fence = 0;
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffers[readbackIndex]);
+			const PageId* ids = (const PageId*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, feedback.size() * sizeof(PageId), GL_MAP_READ_BIT);
+			if (ids != NULL)
+			{
+				std::copy(ids, ids + feedback.size(), feedback.begin());
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+				pages.ProcessFeedback(feedback.data(), feedback.size());
+			}
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		}
+	}
+
+	// Requests stay until they are resident, so frames without new feedback keep loading them
+	unsigned int uploads = 0;
+	const std::vector<PageId>& requests = pages.Requests();
+	for (size_t r = 0; r < requests.size() && uploads < maxUploadsPerFrame; r++)
+	{
+		if (pages.IsResident(requests[r]))
+		{
+			continue;
+		}
+		int slot;
+		PageId evicted;
+		if (!pages.MapPage(requests[r], slot, evicted))
+		{
+			// Every slot holds a page that is on screen, the rest falls back to coarser pages
+			break;
+		}
+		uploadPage(requests[r], slot);
+		uploads++;
+	}
+
+	dirty.clear();
+	if (pages.UpdatePageTable(dirty))
+	{
+		uploadPageTable();
+	}
+}
+
+
+// Binds the atlas and the page table and sets the uniforms virtual.frag needs
+void VirtualTexture::Bind(Shader& shader, GLuint atlasUnit, GLuint pageTableUnit)
+{
+	glActiveTexture(GL_TEXTURE0 + atlasUnit);
+	glBindTexture(GL_TEXTURE_2D, atlas);
+	glActiveTexture(GL_TEXTURE0 + pageTableUnit);
+	glBindTexture(GL_TEXTURE_2D, pageTable);
+
+	shader.Activate();
+	glUniform1i(shader.Uniform("pageAtlas"), atlasUnit);
+	glUniform1i(shader.Uniform("pageTable"), pageTableUnit);
+	glUniform2f(shader.Uniform("virtualSize"), (float)virtualWidth, (float)virtualHeight);
+	glUniform1f(shader.Uniform("pageSize"), (float)pages.PageSize());
+	glUniform1f(shader.Uniform("pageLevels"), (float)pages.LevelCount());
+	glUniform2f(shader.Uniform("atlasSlots"), (float)pages.SlotsX(), (float)pages.SlotsY());
+}
+
+
+// Deletes all the textures, framebuffers and buffers
+void VirtualTexture::Delete()
+{
+	for (int i = 0; i < 2; i++)
+	{
+		if (readbackFences[i] != 0)
+		{
+			glDeleteSync(readbackFences[i]);
+			readbackFences[i] = 0;
+		}
+	}
+	glDeleteBuffers(2, readbackBuffers);
+	glDeleteFramebuffers(1, &feedbackFramebuffer);
+	glDeleteRenderbuffers(1, &feedbackDepth);
+	glDeleteTextures(1, &feedbackColor);
+	glDeleteTextures(1, &pageTable);
+	glDeleteTextures(1, &atlas);
+	feedbackShader.Delete();
+	pageFile.close();
+}
+
+
+// Cuts every mip level of the image into pageSize x pageSize RGBA8 pages, writes them to a page file and frees the pixels
+bool VirtualTexture::WritePageFile(TextureImage& image, int pageSize, const char* path)
+{
+	// Only to count the levels and check the size, a page cache of two slots is the smallest there is
+	VirtualTexturePages layout(image.width, image.height, pageSize, 2, 1);
+	std::vector<int> widths;
+	std::vector<int> heights;
+	std::vector<std::vector<unsigned char>> levels = Texture::BuildMipChain(image, widths, heights);
+	stbi_image_free(image.bytes);
+	image.bytes = NULL;
+
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	PageFileHeader header = { pageFileMagic, image.width, image.height, pageSize };
+	out.write((const char*)&header, sizeof(header));
+
+	int channels = image.channels;
+	std::vector<unsigned char> tile((size_t)pageSize * pageSize * 4);
+	for (int l = 0; l < layout.LevelCount(); l++)
+	{
+		const std::vector<unsigned char>& level = levels[l];
+		for (int py = 0; py < layout.PagesY(l); py++)
+		{
+			for (int px = 0; px < layout.PagesX(l); px++)
+			{
+				// Pages stick out of levels that are smaller than one page, the edge texels are repeated there
+				for (int ty = 0; ty < pageSize; ty++)
+				{
+					int sy = std::min(py * pageSize + ty, heights[l] - 1);
+					for (int tx = 0; tx < pageSize; tx++)
+					{
+						int sx = std::min(px * pageSize + tx, widths[l] - 1);
+						const unsigned char* src = &level[((size_t)sy * widths[l] + sx) * channels];
+						unsigned char* dst = &tile[((size_t)ty * pageSize + tx) * 4];
+						// Same channels as sampling a GL_RED or GL_RGB texture would give
+						dst[0] = src[0];
+						dst[1] = channels >= 3 ? src[1] : 0;
+						dst[2] = channels >= 3 ? src[2] : 0;
+						dst[3] = channels == 4 ? src[3] : 255;
+					}
+				}
+				out.write((const char*)tile.data(), tile.size());
+			}
+		}
+	}
+	out.close();
+	return !out.fail();
+}
+
+
+// Throws if the file can't be read or isn't a page file
+VirtualTexture::PageFileHeader VirtualTexture::readHeader(const char* path)
+{
+	PageFileHeader header = { 0, 0, 0, 0 };
+	std::ifstream in(path, std::ios::binary);
+	in.read((char*)&header, sizeof(header));
+	if (!in || header.magic != pageFileMagic)
+	{
+		throw std::invalid_argument("Virtual texture page file can't be read");
+	}
+	return header;
+}
+
+
+void VirtualTexture::uploadPage(PageId page, int slot)
+{
+	int level = PageLevel(page);
+	// One page a time straight from the file, never more than maxUploadsPerFrame a frame
+	std::streamoff index = levelOffsets[level] + PageY(page) * pages.PagesX(level) + PageX(page);
+	pageFile.seekg((std::streamoff)sizeof(PageFileHeader) + index * (std::streamoff)tile.size());
+	pageFile.read((char*)tile.data(), tile.size());
+	int pageSize = pages.PageSize();
+	glBindTexture(GL_TEXTURE_2D, atlas);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % pages.SlotsX()) * pageSize, (slot / pages.SlotsX()) * pageSize, pageSize, pageSize, GL_RGBA, GL_UNSIGNED_BYTE, tile.data());
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+
+void VirtualTexture::uploadPageTable()
+{
+	glBindTexture(GL_TEXTURE_2D, pageTable);
+	for (size_t d = 0; d < dirty.size(); d++)
+	{
+		const PageRect& rect = dirty[d];
+		// Reads the rectangle straight out of the rows of the whole level
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, pages.PagesX(rect.level));
+		glPixelStorei(GL_UNPACK_SKIP_PIXELS, rect.x);
+		glPixelStorei(GL_UNPACK_SKIP_ROWS, rect.y);
+		glTexSubImage2D(GL_TEXTURE_2D, rect.level, rect.x, rect.y, rect.width, rect.height, GL_RGBA, GL_UNSIGNED_BYTE, pages.PageTable(rect.level).data());
+	}
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -0,0 +1,94 @@
+#ifndef VIRTUAL_TEXTURE_CLASS_H
+#define VIRTUAL_TEXTURE_CLASS_H
+
+#include<cstdint>
+#include<fstream>
+
+#include"Texture.h"
+#include"shader.h"
+#include"VirtualTexturePages.h"
+
+
+// Virtual texturing for images far bigger than texture memory. WritePageFile cuts the image into
+// pages of every mip level once, ahead of time, and drawing reads single pages back out of that file
+// as they are needed, so neither the image nor its pages have to fit in memory. Only the pages the
+// screen samples are kept in a physical page atlas and a page table texture (one texel per page,
+// with a mip level per page level) points every page to its slot in the atlas or to the finest
+// coarser page that is there. Which pages are needed comes from a feedback pass that renders page
+// ids into a small integer framebuffer, which is read back through pixel pack buffers a frame later
+// so nothing waits for the GPU. Shaders sample it with virtualTexture() from shader/virtual.frag
+class VirtualTexture
+{
+public:
+	// Decides which pages to load and where they go
+	VirtualTexturePages pages;
+	// Pages read from the page file and uploaded into the atlas per frame at most
+	unsigned int maxUploadsPerFrame = 16;
+
+	// Shader of the feedback pass, draws the meshes that use the texture with their usual model uniforms
+	Shader feedbackShader;
+
+	// Cuts every mip level of the image into pageSize x pageSize RGBA8 pages, writes them to a page file and
+	// frees the pixels. The only step that holds the whole image, false if the file couldn't be written
+	static bool WritePageFile(TextureImage& image, int pageSize, const char* path);
+
+	// Draws from a page file of WritePageFile. The atlas holds slotsX x slotsY pages, the feedback
+	// framebuffer is the window size divided by feedbackDivisor
+	VirtualTexture(const char* path, int windowWidth, int windowHeight, int slotsX = 16, int slotsY = 16, int feedbackDivisor = 8);
+
+	// Redirects drawing into the feedback framebuffer and activates feedbackShader, draw the meshes with it after this
+	void BeginFeedback();
+	// Starts reading the feedback back and restores the window framebuffer
+	void EndFeedback();
+	// Processes the newest feedback that arrived, uploads the requested pages and updates the page table
+	void Update();
+	// Binds the atlas and the page table and sets the uniforms virtual.frag needs
+	void Bind(Shader& shader, GLuint atlasUnit, GLuint pageTableUnit);
+	// Deletes all the textures, framebuffers and buffers
+	void Delete();
+
+private:
+	// Start of a page file, the pages follow it level by level and row by row
+	struct PageFileHeader
+	{
+		uint32_t magic;
+		int32_t width;
+		int32_t height;
+		int32_t pageSize;
+	};
+
+	VirtualTexture(const PageFileHeader& header, const char* path, int windowWidth, int windowHeight, int slotsX, int slotsY, int feedbackDivisor);
+
+	int windowWidth;
+	int windowHeight;
+	int feedbackWidth;
+	int feedbackHeight;
+	int feedbackDivisor;
+	int virtualWidth;
+	int virtualHeight;
+
+	// Pages are read from here by their index, levelOffsets[level] + y * PagesX(level) + x
+	std::ifstream pageFile;
+	std::vector<unsigned int> levelOffsets;
+	// Pixels of the page being uploaded
+	std::vector<unsigned char> tile;
+
+	GLuint atlas;
+	GLuint pageTable;
+	GLuint feedbackFramebuffer;
+	GLuint feedbackColor;
+	GLuint feedbackDepth;
+	// Feedback is read into these in turns, a fence tells when a read has landed
+	GLuint readbackBuffers[2];
+	GLsync readbackFences[2];
+	unsigned int readbackIndex;
+	std::vector<PageId> feedback;
+	std::vector<PageRect> dirty;
+
+	// Throws if the file can't be read or isn't a page file
+	static PageFileHeader readHeader(const char* path);
+	void uploadPage(PageId page, int slot);
+	void uploadPageTable();
+};
+
+#endif
@@ -0,0 +1,278 @@
+#include"VirtualTexturePages.h"
+
+#include<algorithm>
+#include<stdexcept>
+#include<unordered_map>
+
+// Checks that a number of pages halves evenly down to one
+static bool powerOfTwo(int value)
+{
+	return value > 0 && (value & (value - 1)) == 0;
+}
+
+
+VirtualTexturePages::VirtualTexturePages(int width, int height, int pageSize, int slotsX, int slotsY)
+{
+	if (pageSize <= 0 || width % pageSize != 0 || height % pageSize != 0 || !powerOfTwo(width / pageSize) || !powerOfTwo(height / pageSize))
+	{
+		throw std::invalid_argument("Virtual texture size has to be the page size times a power of two");
+	}
+	if (width / pageSize > 4096 || height / pageSize > 4096)
+	{
+		throw std::invalid_argument("Virtual texture has more than 4096 pages on a side");
+	}
+	// Slot coordinates are stored in 8 bits of the page table, and the pinned page needs a slot of its own
+	if (slotsX <= 0 || slotsY <= 0 || slotsX > 256 || slotsY > 256 || slotsX * slotsY < 2)
+	{
+		throw std::invalid_argument("Physical page cache has to be between 2 and 256 x 256 slots");
+	}
+	VirtualTexturePages::pageSize = pageSize;
+	VirtualTexturePages::slotsX = slotsX;
+	VirtualTexturePages::slotsY = slotsY;
+	pagesX.push_back(width / pageSize);
+	pagesY.push_back(height / pageSize);
+	while (pagesX.back() > 1 || pagesY.back() > 1)
+	{
+		pagesX.push_back(std::max(1, pagesX.back() / 2));
+		pagesY.push_back(std::max(1, pagesY.back() / 2));
+	}
+	for (int l = 0; l < LevelCount(); l++)
+	{
+		slots.push_back(std::vector<int>(pagesX[l] * pagesY[l], -1));
+		table.push_back(std::vector<uint32_t>(pagesX[l] * pagesY[l], 0));
+	}
+
+	int slotCount = slotsX * slotsY;
+	slotPages.assign(slotCount, 0);
+	slotFrames.assign(slotCount, 0);
+	for (int s = 0; s < slotCount; s++)
+	{
+		lruPlaces.push_back(lru.insert(lru.end(), s));
+	}
+	residentCount = 0;
+	frame = 0;
+	pinnedSlot = -1;
+
+	// The coarsest page covers everything, so every entry always has a page to fall back to
+	int slot;
+	PageId evicted;
+	MapPage(MakePageId(LevelCount() - 1, 0, 0), slot, evicted);
+	pinnedSlot = slot;
+	lru.erase(lruPlaces[slot]);
+	std::vector<PageRect> dirty;
+	UpdatePageTable(dirty);
+}
+
+
+// Starts a new frame: resident pages in the feedback count as used, missing ones and their missing parents become the requests
+void VirtualTexturePages::ProcessFeedback(const PageId* feedback, size_t count)
+{
+	frame++;
+	requests.clear();
+
+	std::vector<PageId> seen(feedback, feedback + count);
+	std::sort(seen.begin(), seen.end());
+	std::unordered_map<PageId, unsigned int> hits;
+	for (size_t i = 0; i < seen.size();)
+	{
+		// Runs of the same page are counted once
+		size_t end = i + 1;
+		while (end < seen.size() && seen[end] == seen[i])
+		{
+			end++;
+		}
+		PageId page = seen[i];
+		unsigned int pixels = end - i;
+		i = end;
+		if (!validPage(page))
+		{
+			continue;
+		}
+
+		// Walks up until a resident page is found, that one is what the pixels sampled this frame
+		while (true)
+		{
+			int slot = slotOf(page);
+			if (slot >= 0)
+			{
+				slotFrames[slot] = frame;
+				touch(slot);
+				break;
+			}
+			hits[page] += pixels;
+			page = MakePageId(PageLevel(page) + 1, PageX(page) >> 1, PageY(page) >> 1);
+		}
+	}
+
+	for (std::unordered_map<PageId, unsigned int>::iterator it = hits.begin(); it != hits.end(); it++)
+	{
+		requests.push_back(it->first);
+	}
+	// Coarse pages first, they are the fallback of the fine ones. Sorting by the id as well keeps the order deterministic
+	std::sort(requests.begin(), requests.end(), [&hits](PageId a, PageId b)
+	{
+		if (PageLevel(a) != PageLevel(b))
+		{
+			return PageLevel(a) > PageLevel(b);
+		}
+		unsigned int hitsA = hits[a];
+		unsigned int hitsB = hits[b];
+		if (hitsA != hitsB)
+		{
+			return hitsA > hitsB;
+		}
+		return a < b;
+	});
+}
+
+
+// Gives the page a slot, evicting the least recently used page that wasn't seen this frame
+bool VirtualTexturePages::MapPage(PageId page, int& slot, PageId& evicted)
+{
+	evicted = 0;
+	if (!validPage(page))
+	{
+		return false;
+	}
+	slot = slotOf(page);
+	if (slot >= 0)
+	{
+		return true;
+	}
+	if (lru.empty())
+	{
+		return false;
+	}
+
+	int victim = lru.front();
+	// The list is ordered by use, so if the oldest slot was used this frame all of them were
+	if (slotPages[victim] != 0 && slotFrames[victim] == frame)
+	{
+		return false;
+	}
+	if (slotPages[victim] != 0)
+	{
+		evicted = slotPages[victim];
+		slots[PageLevel(evicted)][PageY(evicted) * pagesX[PageLevel(evicted)] + PageX(evicted)] = -1;
+		changedPages.push_back(evicted);
+		residentCount--;
+	}
+
+	slotPages[victim] = page;
+	slotFrames[victim] = frame;
+	slots[PageLevel(page)][PageY(page) * pagesX[PageLevel(page)] + PageX(page)] = victim;
+	touch(victim);
+	changedPages.push_back(page);
+	residentCount++;
+	slot = victim;
+	return true;
+}
+
+
+// Recomputes the entries below every page that was mapped or evicted since the last call
+bool VirtualTexturePages::UpdatePageTable(std::vector<PageRect>& dirty)
+{
+	if (changedPages.empty())
+	{
+		return false;
+	}
+	// Parents first, the entries of a level are computed from the level above. Within a level by id,
+	// so a page that was mapped and evicted again ends up next to itself and is only walked once
+	std::sort(changedPages.begin(), changedPages.end(), [](PageId a, PageId b)
+	{
+		if (PageLevel(a) != PageLevel(b))
+		{
+			return PageLevel(a) > PageLevel(b);
+		}
+		return a < b;
+	});
+	changedPages.erase(std::unique(changedPages.begin(), changedPages.end()), changedPages.end());
+
+	int levels = LevelCount();
+	std::vector<PageRect> bounds(levels, PageRect{ 0, 0, 0, 0, 0 });
+	for (size_t c = 0; c < changedPages.size(); c++)
+	{
+		int pageLevel = PageLevel(changedPages[c]);
+		for (int l = pageLevel; l >= 0; l--)
+		{
+			int shift = pageLevel - l;
+			int x0 = PageX(changedPages[c]) << shift;
+			int y0 = PageY(changedPages[c]) << shift;
+			int x1 = std::min(x0 + (1 << shift), pagesX[l]);
+			int y1 = std::min(y0 + (1 << shift), pagesY[l]);
+			for (int y = y0; y < y1; y++)
+			{
+				for (int x = x0; x < x1; x++)
+				{
+					int index = y * pagesX[l] + x;
+					int slot = slots[l][index];
+					if (slot >= 0)
+					{
+						table[l][index] = Entry(slot % slotsX, slot / slotsX, l);
+					}
+					else
+					{
+						table[l][index] = table[l + 1][(y >> 1) * pagesX[l + 1] + (x >> 1)];
+					}
+				}
+			}
+
+			PageRect& rect = bounds[l];
+			if (rect.width == 0)
+			{
+				rect = PageRect{ l, x0, y0, x1 - x0, y1 - y0 };
+			}
+			else
+			{
+				int right = std::max(rect.x + rect.width, x1);
+				int bottom = std::max(rect.y + rect.height, y1);
+				rect.x = std::min(rect.x, x0);
+				rect.y = std::min(rect.y, y0);
+				rect.width = right - rect.x;
+				rect.height = bottom - rect.y;
+			}
+		}
+	}
+	changedPages.clear();
+
+	for (int l = 0; l < levels; l++)
+	{
+		if (bounds[l].width > 0)
+		{
+			dirty.push_back(bounds[l]);
+		}
+	}
+	return true;
+}
+
+
+int VirtualTexturePages::slotOf(PageId page) const
+{
+	if (!validPage(page))
+	{
+		return -1;
+	}
+	return slots[PageLevel(page)][PageY(page) * pagesX[PageLevel(page)] + PageX(page)];
+}
+
+
+bool VirtualTexturePages::validPage(PageId page) const
+{
+	if ((page & 0x80000000u) == 0)
+	{
+		return false;
+	}
+	int level = PageLevel(page);
+	return level < LevelCount() && PageX(page) < pagesX[level] && PageY(page) < pagesY[level];
+}
+
+
+// Moves a slot to the most recently used end of the list
+void VirtualTexturePages::touch(int slot)
+{
+	if (slot == pinnedSlot)
+	{
+		return;
+	}
+	lru.splice(lru.end(), lru, lruPlaces[slot]);
+}
@@ -0,0 +1,100 @@
+#ifndef VIRTUAL_TEXTURE_PAGES_CLASS_H
+#define VIRTUAL_TEXTURE_PAGES_CLASS_H
+
+#include<cstddef>
+#include<cstdint>
+#include<list>
+#include<vector>
+
+
+// A page of a virtual texture: valid bit, 7 bits level, 12 bits y and 12 bits x. The feedback
+// shader writes the same encoding, 0 means no virtual texture was sampled at that pixel
+typedef uint32_t PageId;
+
+inline PageId MakePageId(int level, int x, int y) { return 0x80000000u | ((uint32_t)level << 24) | ((uint32_t)y << 12) | (uint32_t)x; }
+inline int PageLevel(PageId page) { return (page >> 24) & 0x7F; }
+inline int PageX(PageId page) { return page & 0xFFF; }
+inline int PageY(PageId page) { return (page >> 12) & 0xFFF; }
+
+// Rectangle of page table entries of one level, in pages
+struct PageRect
+{
+	int level;
+	int x;
+	int y;
+	int width;
+	int height;
+};
+
+
+// CPU side of virtual texturing, needs no OpenGL. Reads feedback buffers of sampled pages,
+// decides which pages to load, gives each one a slot in the physical page cache, evicting the
+// least recently used page when the cache is full, and keeps the page table up to date. Every
+// page table entry points to the finest resident page covering it, so missing pages fall back
+// to coarser ones. The single page of the coarsest level is always resident
+class VirtualTexturePages
+{
+public:
+	// Value of a page table entry: x and y of the slot, the level of the page in it and 255
+	static uint32_t Entry(int slotX, int slotY, int level) { return (uint32_t)slotX | ((uint32_t)slotY << 8) | ((uint32_t)level << 16) | 0xFF000000u; }
+
+	// Pages are pageSize x pageSize texels. The size of the virtual texture has to be pageSize times a power of
+	// two on both sides, so the page table halves with every level like the mip chain of a texture does
+	VirtualTexturePages(int width, int height, int pageSize, int slotsX, int slotsY);
+
+	int LevelCount() const { return (int)pagesX.size(); }
+	int PagesX(int level) const { return pagesX[level]; }
+	int PagesY(int level) const { return pagesY[level]; }
+	int PageSize() const { return pageSize; }
+	int SlotsX() const { return slotsX; }
+	int SlotsY() const { return slotsY; }
+
+	// Starts a new frame: resident pages in the feedback count as used, missing ones and their missing
+	// parents become the requests, coarse levels first and pages seen more often first within a level
+	void ProcessFeedback(const PageId* feedback, size_t count);
+	const std::vector<PageId>& Requests() const { return requests; }
+
+	// Gives the page a slot, evicting the least recently used page that wasn't seen this frame.
+	// evicted is the page that lost its slot or 0. Returns false when every slot is in use this frame
+	bool MapPage(PageId page, int& slot, PageId& evicted);
+	bool IsResident(PageId page) const { return slotOf(page) >= 0; }
+	// Slot of a resident page, -1 if it isn't
+	int SlotOf(PageId page) const { return slotOf(page); }
+	int ResidentCount() const { return residentCount; }
+
+	// Recomputes the entries below every page that was mapped or evicted since the last call and
+	// appends the changed rectangle of every level to dirty. Returns false when nothing changed
+	bool UpdatePageTable(std::vector<PageRect>& dirty);
+	// Entries of one level, row by row
+	const std::vector<uint32_t>& PageTable(int level) const { return table[level]; }
+
+private:
+	int pageSize;
+	int slotsX;
+	int slotsY;
+	std::vector<int> pagesX;
+	std::vector<int> pagesY;
+
+	// Slot of every page of every level, -1 when it isn't resident
+	std::vector<std::vector<int>> slots;
+	std::vector<std::vector<uint32_t>> table;
+	// Page held by every slot, 0 when free
+	std::vector<PageId> slotPages;
+	std::vector<unsigned int> slotFrames;
+	// Slots from least to most recently used, with the place of every slot in the list
+	std::list<int> lru;
+	std::vector<std::list<int>::iterator> lruPlaces;
+	int pinnedSlot;
+	int residentCount;
+	unsigned int frame;
+
+	std::vector<PageId> requests;
+	// Pages whose subtree of the page table needs recomputing
+	std::vector<PageId> changedPages;
+
+	int slotOf(PageId page) const;
+	bool validPage(PageId page) const;
+	void touch(int slot);
+};
+
+#endif
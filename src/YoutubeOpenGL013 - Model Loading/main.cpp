@@ -1,10 +1,35 @@
 #include "Mesh.h"
 #include "Model.h"
+#include "DrawList.h"
+#include "JobSystem.h"
+#include "TripleBuffer.h"
+#include "UploadThread.h"
+#include "TextureStreamer.h"
+#include "TextureArrayPacker.h"
+#include "SamplerCache.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
 
 
 
 const unsigned int width = 800;
 const unsigned int height = 800;
+// How the textures of the model reach the GPU, picked by an argument (residency, streamer or thread)
+enum TextureLoading
+{
+	// Keep only the mip levels the screen needs in texture memory, streamed in and out every frame
+	TEXTURES_RESIDENCY,
+	// Whole textures through a persistently mapped pixel buffer, a band of rows per frame. Without GLCaps.bufferStorage
+	// the upload thread takes over
+	TEXTURES_STREAMER,
+	// Whole textures created on the upload thread's context. Like the streamer it allows bindless textures
+	TEXTURES_UPLOAD_THREAD
+};
+// Input and camera movement run at a fixed rate, the camera speed is per step
+const double simulationStep = 1.0 / 60.0;
 
 // Vertices coordinates
 Vertex vertices[] =
@@ -23,34 +48,45 @@ GLuint indices[] =
 };
 
 
-int main() 
+// Everything the render thread needs from the input and simulation thread for one frame
+struct FrameSnapshot
+{
+	Camera camera;
+	// Number of the simulation step that produced the snapshot
+	unsigned long long step;
+	// Ray of the last right click, pick counts the clicks so the render thread casts every ray once
+	unsigned int pick;
+	glm::vec3 pickOrigin;
+	glm::vec3 pickDirection;
+};
+
+// Culling results the render thread reports back for the window title
+struct RenderStats
+{
+	std::atomic<unsigned int> visible;
+	std::atomic<unsigned int> culled;
+	std::atomic<unsigned int> occluded;
+	// Mesh under the cursor at the last right click, -1 if the ray hit nothing
+	std::atomic<int> pickedMesh;
+	std::atomic<float> pickedDistance;
+};
+
+
+// Owns the OpenGL context: loads everything, then draws the newest snapshot until running turns false
+static void renderThread(GLFWwindow* window, GLFWwindow* uploadContext, TextureLoading textureLoading, bool vertexPulling, TripleBuffer<FrameSnapshot>* snapshots, RenderStats* stats, std::atomic<bool>* running)
 {
-  // Initialize GLFW
-  glfwInit();
-  
-  // Tell GLFW what version of OpenGL we are using
-  // In this case, we are using OpenGL 3.3
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-  // Tell GLFW we are using the CORE profile
-  // So that means we only have the modern functions
-  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-  
-  // Create a GLFWwindow object of 800 by 800 pixels, naming it YoutubeOpenGL
-  GLFWwindow *window = glfwCreateWindow(width, height, "YoutubeOpenGL", NULL, NULL);
-  if (window == NULL)
-  {
-    std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
-  }
-  
   // Introduce the windows into the current context
   glfwMakeContextCurrent(window);
   
   glfwSwapInterval(1); // Enable vsync to cap at screen refresh rate (usually 60Hz)
   
+  // Starts the worker threads, this thread becomes the main thread of the job system so GL jobs end up here
+  JobSystem::Shared();
+  
   // Load GLAD so it configures OpenGL
   gladLoadGL();
+  // Load the OpenGL 4.x functions that glad doesn't know about
+  loadGLExtensions();
   
   // Specify the viewport of OpenGL in the Window
   // In this case the viewport goes from x=0, y=0, to x=800, y=800
@@ -59,19 +95,44 @@ int main()
   
   // Generates Shader object using shaders defualt.vert and default.frag
 	Shader shaderProgram("shader/part13.vert", "shader/part13.frag");
+	// Static models are drawn with one indirect call when the context supports it. "pull" only
+	// changes how that call reads its vertices, without multi-draw indirect it does nothing
+	const char* indirectVert = vertexPulling ? "shader/pulling.vert" : "shader/indirect.vert";
+	// With resident texture handles that call covers meshes with different textures as well. Textures whose
+	// mip levels the residency manager keeps changing can't get handles, so streaming keeps binding them
+	bool bindless = GLCaps.bindlessTexture && textureLoading != TEXTURES_RESIDENCY;
+	const char* indirectFrag = bindless ? "shader/bindless.frag" : "shader/part13.frag";
+	Shader indirectProgram = GLCaps.multiDrawIndirect ? Shader(indirectVert, indirectFrag) : shaderProgram;
+	
+	// Small textures share array textures grouped by size, the mesh shader picks its image by layer
+	Shader arrayProgram("shader/part13.vert", "shader/array.frag");
+	TextureArrayPacker smallTextures;
+	TextureImage planks = TextureImage::Load("textures/planks.png");
+	TextureImage planksSpec = TextureImage::Load("textures/planksSpec.png");
+	unsigned int planksIndex, planksSpecIndex;
+	bool planksPacked = smallTextures.Add(planks, planksIndex);
+	bool planksSpecPacked = smallTextures.Add(planksSpec, planksSpecIndex);
+	smallTextures.Build();
 	
-	// Texture data
-	Texture textures[]
+	// Texture data, left out when the images are missing or too large to pack
+	std::vector<Texture> texVec;
+	if (planksPacked && planksSpecPacked)
 	{
-		// Texture("textures/planks.png", "diffuse", 0),
-		// Texture("textures/planksSpec.png", "specular", 1)
-	};
+		texVec.push_back(smallTextures.Get(planksIndex, "diffuse", 0));
+		texVec.push_back(smallTextures.Get(planksSpecIndex, "specular", 1));
+	}
+	stbi_image_free(planks.bytes);
+	stbi_image_free(planksSpec.bytes);
 	
 	std::vector<Vertex> vertVec(vertices, vertices + sizeof(vertices) / sizeof(Vertex));
 	std::vector<GLuint> indVec(indices, indices + sizeof(indices) / sizeof(GLuint));
-	std::vector<Texture> texVec(textures, textures + sizeof(textures) / sizeof(Texture));
 	
 	Mesh myMesh(vertVec, indVec, texVec);
+	// The floor keeps the default factors, its buffer also carries the layers of the packed textures
+	myMesh.material.Upload();
+	Shader& meshProgram = texVec.empty() ? shaderProgram : arrayProgram;
+	// Commands of the floor, recorded and run again every frame
+	CommandBuffer meshCommands;
   
   // Assign the color, position and model of light  
   glm::vec4 lightColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
@@ -81,8 +142,20 @@ int main()
   
   // Assign variables to object shader
   shaderProgram.Activate();
-	glUniform4f(glGetUniformLocation(shaderProgram.ID, "lightColor"), lightColor.x, lightColor.y, lightColor.z, lightColor.w);
-	glUniform3f(glGetUniformLocation(shaderProgram.ID, "lightPos"), lightPos.x, lightPos.y, lightPos.z);
+	glUniform4f(shaderProgram.Uniform("lightColor"), lightColor.x, lightColor.y, lightColor.z, lightColor.w);
+	glUniform3f(shaderProgram.Uniform("lightPos"), lightPos.x, lightPos.y, lightPos.z);
+	indirectProgram.Activate();
+	glUniform4f(indirectProgram.Uniform("lightColor"), lightColor.x, lightColor.y, lightColor.z, lightColor.w);
+	glUniform3f(indirectProgram.Uniform("lightPos"), lightPos.x, lightPos.y, lightPos.z);
+	arrayProgram.Activate();
+	glUniform4f(arrayProgram.Uniform("lightColor"), lightColor.x, lightColor.y, lightColor.z, lightColor.w);
+	glUniform3f(arrayProgram.Uniform("lightPos"), lightPos.x, lightPos.y, lightPos.z);
+	// Materials bind their textures to fixed units, so the samplers are set once
+	Material::SetupShader(shaderProgram);
+	Material::SetupShader(indirectProgram);
+	Material::SetupShader(arrayProgram);
+	// Roles without a texture sample these instead of whatever the last material left on the unit
+	Material::CreateFallbackTextures();
   
   
   // Specify the color of the background
@@ -92,47 +165,294 @@ int main()
   // Swap the back buffer with the front buffer
   glfwSwapBuffers(window);
   
-  // Variables that help the rotation of the pyramid
-	float rotation = 0.0f;
-	double prevTime = glfwGetTime();
-  
   // Enables the Depth Buffer
 	glEnable(GL_DEPTH_TEST);
   
-  // 
-  Camera camera(width, height, glm::vec3(0.0f, 0.5f, 2.0f));
+  // The camera of the last snapshot, kept when the main thread hasn't published a new one
+  Camera camera = snapshots->Front().camera;
+  // Last click that was picked
+  unsigned int pick = snapshots->Front().pick;
 	
-	Model model(("models/sword/scene.gltf"));
+	// Renderable objects of the scene, declared first so it outlives the models that fill it
+	Registry registry;
+	// Creates and fills textures on a second context so loading never holds up a frame
+	UploadThread uploader(uploadContext);
+	// With persistent mapping the textures go up from a pixel buffer ring a few MB per frame instead
+	TextureStreamer streamer;
+	// Fine mip levels come and go under a fixed budget of texture memory
+	TextureResidency residency;
+	TextureUploader* textureUploader = &uploader;
+	if (textureLoading == TEXTURES_RESIDENCY)
+	{
+		textureUploader = &residency;
+	}
+	else if (textureLoading == TEXTURES_STREAMER && GLCaps.bufferStorage)
+	{
+		textureUploader = &streamer;
+	}
+	Model model("models/sword/scene.gltf", textureUploader);
+	// Texture handles and material table of the bindless indirect path
+	BindlessMaterials materials;
+	model.AddToRegistry(registry);
+	// Culls and sorts the registry on all cores when there is no indirect drawing
+	DrawList drawList;
+	// Hide meshes that are behind the big ones
+	model.ChooseOccluders();
+	model.occlusionCulling = true;
+	// Heavy meshes are also tested against the real depth buffer, a frame late
+	model.EnableOcclusionQueries();
+	OcclusionQueryPass queryPass;
+	
+	// Everything that changes every frame is written into this buffer
+	StreamBuffer stream(8 * 1024 * 1024);
   
-  // Main while loop
-  while (!glfwWindowShouldClose(window))
+  // Render loop
+  while (running->load())
   {
+    // Take the newest camera the main thread published
+    if (snapshots->Acquire())
+    {
+      camera = snapshots->Front().camera;
+    }
+    
+    // Casts the ray of a new click against the triangles of the model, the BVH skips everything it can't hit
+    const FrameSnapshot& snapshot = snapshots->Front();
+    if (snapshot.pick != pick)
+    {
+      pick = snapshot.pick;
+      unsigned int hitMesh;
+      float hitDistance;
+      bool hit = model.Raycast(snapshot.pickOrigin, snapshot.pickDirection, camera.farPlane, hitMesh, hitDistance);
+      stats->pickedDistance = hit ? hitDistance : 0.0f;
+      stats->pickedMesh = hit ? (int)hitMesh : -1;
+    }
+    
+    // Reuse the stream memory of frames the GPU has finished
+    stream.BeginFrame();
+    // Hands over the textures the upload thread finished
+    uploader.Poll();
+    // Starts the next bands of the textures that stream through the pixel buffer
+    streamer.Update();
+    // Streams the mip levels the last camera asked for
+    model.RequestTextureLevels(residency, camera);
+    residency.Update();
+    // OpenGL work that other threads handed to the main thread
+    JobSystem::Shared().RunMainThreadJobs();
     
     // Specify the color of the background
 		glClearColor(0.07f, 0.13f, 0.17f, 1.0f);
 		// Clean the back buffer and depth buffer
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-
-		// Handles camera inputs
-		camera.Inputs(window);
-		// Updates and exports the camera matrix to the Vertex Shader
-		camera.updateMatrix(45.0f, 0.1f, 100.0f);
+		
+		// Picks up nodes moved through model.scene since the last frame
+		model.Update();
 		
 		// Draw models
-		model.Draw(shaderProgram, camera);
-		myMesh.Draw(shaderProgram, camera);
+		if (GLCaps.multiDrawIndirect)
+		{
+			camera.Upload(stream, 1);
+			model.DrawIndirect(indirectProgram, camera, stream, vertexPulling, bindless ? &materials : NULL);
+			stats->visible = model.visibleCount;
+			stats->culled = model.culledCount;
+			stats->occluded = model.occludedCount;
+		}
+		else
+		{
+			drawList.Build(registry, camera);
+			drawList.Submit(shaderProgram, camera);
+			stats->visible = drawList.visibleCount;
+			stats->culled = drawList.culledCount;
+			stats->occluded = 0;
+		}
+		myMesh.Draw(meshCommands, meshProgram, camera);
+		// Box queries go last so that everything else is already in the depth buffer
+		model.QueryOcclusion(queryPass, camera);
 
 
-		// Swap the back buffer with the front buffer
+		stream.EndFrame();
+
+		// Swap the back buffer with the front buffer, only this thread waits for vsync
 		glfwSwapBuffers(window);
-		// Take care of all GLFW events
-		glfwPollEvents();
   }
   
   // Delete all the objects we've created
+	uploader.Finish();
+	streamer.Delete();
+	residency.Delete();
+	materials.Delete();
+	Material::DeleteFallbackTextures();
+	model.Delete();
+	myMesh.Delete();
+	myMesh.material.Delete();
+	smallTextures.Delete();
+	stream.Delete();
+	queryPass.Delete();
+	GeometryArena::Shared().Delete();
+	SamplerCache::Shared().Delete();
 	shaderProgram.Delete();
+	arrayProgram.Delete();
+	if (indirectProgram.ID != shaderProgram.ID)
+	{
+		indirectProgram.Delete();
+	}
+	glfwMakeContextCurrent(NULL);
+}
+
+
+int main(int argc, char** argv) 
+{
+  // Every texture path can be run, residency streaming unless an argument asks for another
+  TextureLoading textureLoading = TEXTURES_RESIDENCY;
+  // "pull" fetches the vertices of the indirect path from a storage buffer instead of through vertex attributes
+  bool vertexPulling = false;
+  for (int a = 1; a < argc; a++)
+  {
+    if (std::strcmp(argv[a], "streamer") == 0)
+    {
+      textureLoading = TEXTURES_STREAMER;
+    }
+    else if (std::strcmp(argv[a], "thread") == 0)
+    {
+      textureLoading = TEXTURES_UPLOAD_THREAD;
+    }
+    else if (std::strcmp(argv[a], "residency") == 0)
+    {
+      textureLoading = TEXTURES_RESIDENCY;
+    }
+    else if (std::strcmp(argv[a], "pull") == 0)
+    {
+      vertexPulling = true;
+    }
+    else
+    {
+      std::cout << "Usage: " << argv[0] << " [residency|streamer|thread] [pull]" << std::endl;
+      return -1;
+    }
+  }
+  
+  // Initialize GLFW
+  glfwInit();
+  
+  // Tell GLFW what version of OpenGL we are using
+  // We ask for OpenGL 4.6 first so the indirect drawing path can be used
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+  // Tell GLFW we are using the CORE profile
+  // So that means we only have the modern functions
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  
+  // Create a GLFWwindow object of 800 by 800 pixels, naming it YoutubeOpenGL
+  GLFWwindow *window = glfwCreateWindow(width, height, "YoutubeOpenGL", NULL, NULL);
+  if (window == NULL)
+  {
+    // Fall back to OpenGL 3.3 which every path supports
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    window = glfwCreateWindow(width, height, "YoutubeOpenGL", NULL, NULL);
+  }
+  if (window == NULL)
+  {
+    std::cout << "Failed to create GLFW window" << std::endl;
+    glfwTerminate();
+    return -1;
+  }
+  // Second context for the upload thread, it shares buffers and textures with the window
+  GLFWwindow* uploadContext = UploadThread::CreateContext(window);
+  if (uploadContext == NULL)
+  {
+    std::cout << "Failed to create the upload context" << std::endl;
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return -1;
+  }
+  
+  // Input and simulation stay on this thread, window events have to be handled here
+  Camera camera(width, height, glm::vec3(0.0f, 0.5f, 2.0f));
+  camera.updateMatrix(45.0f, 0.1f, 100.0f);
+  
+  // Three snapshots, so the simulation never waits for the renderer and the renderer never waits for the simulation
+  TripleBuffer<FrameSnapshot> snapshots(FrameSnapshot{ camera, 0, 0, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f) });
+  RenderStats stats;
+  stats.visible = 0;
+  stats.culled = 0;
+  stats.occluded = 0;
+  stats.pickedMesh = -1;
+  stats.pickedDistance = 0.0f;
+  // Right clicks pick the mesh under the cursor, the left button is taken by the camera
+  unsigned int pick = 0;
+  glm::vec3 pickOrigin = glm::vec3(0.0f);
+  glm::vec3 pickDirection = glm::vec3(0.0f, 0.0f, -1.0f);
+  bool rightPressed = false;
+  std::atomic<bool> running(true);
+  // The context is never current on this thread, the render thread takes it
+  std::thread renderer(renderThread, window, uploadContext, textureLoading, vertexPulling, &snapshots, &stats, &running);
+  
+  double prevTime = glfwGetTime();
+  double nextStep = glfwGetTime();
+  unsigned long long step = 0;
+  
+  // Main while loop
+  while (!glfwWindowShouldClose(window))
+  {
+    // Take care of all GLFW events
+    glfwPollEvents();
+    
+		// Handles camera inputs
+		camera.Inputs(window);
+		// Updates the camera matrix the render thread will use
+		camera.updateMatrix(45.0f, 0.1f, 100.0f);
+		// A new right click sends a ray through the cursor
+		bool rightDown = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS;
+		if (rightDown && !rightPressed)
+		{
+			double cursorX, cursorY;
+			glfwGetCursorPos(window, &cursorX, &cursorY);
+			camera.CursorRay(cursorX, cursorY, pickOrigin, pickDirection);
+			pick++;
+		}
+		rightPressed = rightDown;
+		
+		// Hands the state of this step to the render thread
+		FrameSnapshot& snapshot = snapshots.Back();
+		snapshot.camera = camera;
+		snapshot.step = ++step;
+		snapshot.pick = pick;
+		snapshot.pickOrigin = pickOrigin;
+		snapshot.pickDirection = pickDirection;
+		snapshots.Publish();
+
+		// Reports the culling results once every second
+		double crntTime = glfwGetTime();
+		if (crntTime - prevTime >= 1.0)
+		{
+			std::string title = "YoutubeOpenGL - visible: " + std::to_string(stats.visible.load()) + " culled: " + std::to_string(stats.culled.load())
+				+ " occluded: " + std::to_string(stats.occluded.load());
+			int picked = stats.pickedMesh.load();
+			if (picked >= 0)
+			{
+				title += " picked: mesh " + std::to_string(picked) + " at " + std::to_string(stats.pickedDistance.load());
+			}
+			glfwSetWindowTitle(window, title.c_str());
+			prevTime = crntTime;
+		}
+		
+		// Waits for the next step instead of the swap, so input is never stuck behind vsync
+		nextStep += simulationStep;
+		double wait = nextStep - glfwGetTime();
+		if (wait > 0.0)
+		{
+			std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+		}
+		else
+		{
+			nextStep = glfwGetTime();
+		}
+  }
+  
+  running = false;
+  renderer.join();
 	// Delete window before ending the program
+	glfwDestroyWindow(uploadContext);
 	glfwDestroyWindow(window);
 	// Terminate GLFW before ending the program
 	glfwTerminate();
@@ -1,5 +1,7 @@
 #include "shader.h"
 
+#include <algorithm>
+
 // Reads a text file and outputs a string with everything in the text file
 std::string get_file_contents(const char* filename)
 {
@@ -58,6 +60,46 @@ Shader::Shader(const char* vertexFile, const char* fragmentFile)
 	glDeleteShader(vertexShader);
 	glDeleteShader(fragmentShader);
 
+	// Look every uniform up once instead of on each use
+	cacheUniforms();
+}
+
+// Location of a uniform, -1 if the program doesn't use it
+GLint Shader::Uniform(const char* name) const
+{
+	std::unordered_map<std::string, GLint>::const_iterator found = uniforms.find(name);
+	return found == uniforms.end() ? -1 : found->second;
+}
+
+// Fills uniforms after linking
+void Shader::cacheUniforms()
+{
+	uniforms.clear();
+	GLint count = 0;
+	GLint maxLength = 0;
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::string name(std::max(maxLength, 1), '\0');
+	for (GLint i = 0; i < count; i++)
+	{
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(ID, i, (GLsizei)name.size(), &length, &size, &type, &name[0]);
+		std::string uniform = name.substr(0, length);
+		GLint location = glGetUniformLocation(ID, uniform.c_str());
+		// Members of uniform blocks have no location
+		if (location < 0)
+		{
+			continue;
+		}
+		uniforms[uniform] = location;
+		// Arrays are reported as "name[0]" but usually looked up without the index
+		if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0)
+		{
+			uniforms[uniform.substr(0, uniform.size() - 3)] = location;
+		}
+	}
 }
 
 // Activates the Shader Program
@@ -7,6 +7,7 @@
 #include<sstream>
 #include<iostream>
 #include<cerrno>
+#include<unordered_map>
 
 std::string get_file_contents(const char* filename);
 
@@ -18,12 +19,21 @@ public:
 	// Constructor that build the Shader Program from 2 different shaders
 	Shader(const char* vertexFile, const char* fragmentFile);
 
+	// Location of a uniform, -1 if the program doesn't use it. Looked up in a table filled
+	// at link time, so it never calls OpenGL and works from any thread
+	GLint Uniform(const char* name) const;
+
 	// Activates the Shader Program
 	void Activate();
 	// Deletes the Shader Program
 	void Delete();
 
 private:
+	// Location of every active uniform, arrays are stored under "name" and "name[0]"
+	std::unordered_map<std::string, GLint> uniforms;
+
+	// Fills uniforms after linking
+	void cacheUniforms();
 	// Checks if the different Shaders have compiled properly
 	void compileErrors(unsigned int shader, const char* type);	
 };
@@ -0,0 +1,184 @@
+#include<chrono>
+#include<cmath>
+#include<cstdio>
+#include<cstdlib>
+#include<vector>
+
+#include<glm/gtc/matrix_transform.hpp>
+
+#include"BVH.h"
+#include"JobSystem.h"
+
+
+static float random(float low, float high)
+{
+	return low + (high - low) * (float)std::rand() / (float)RAND_MAX;
+}
+
+// Milliseconds of function, the best of a few runs
+template<typename Function>
+static double measure(int runs, Function function)
+{
+	double best = 1e30;
+	for (int run = 0; run < runs; run++)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		function();
+		std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - start;
+		best = std::min(best, time.count());
+	}
+	return best;
+}
+
+// A synthetic city: most objects sit in clusters on a ground plane, a few are spread through the air
+static std::vector<AABB> makeScene(size_t count)
+{
+	std::vector<glm::vec3> clusters;
+	for (int c = 0; c < 256; c++)
+	{
+		clusters.push_back(glm::vec3(random(-2000.0f, 2000.0f), 0.0f, random(-2000.0f, 2000.0f)));
+	}
+	std::vector<AABB> boxes(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		glm::vec3 center = i % 10 == 0
+			? glm::vec3(random(-2000.0f, 2000.0f), random(0.0f, 300.0f), random(-2000.0f, 2000.0f))
+			: clusters[std::rand() % clusters.size()] + glm::vec3(random(-100.0f, 100.0f), random(0.0f, 40.0f), random(-100.0f, 100.0f));
+		glm::vec3 extents(random(0.1f, 2.0f), random(0.1f, 4.0f), random(0.1f, 2.0f));
+		boxes[i] = AABB{ center - extents, center + extents };
+	}
+	return boxes;
+}
+
+
+// Builds the SAH BVH over a large synthetic scene and measures building, refitting, culling and
+// ray casts against testing every box. Usage: BVHBenchmark [primitives]
+int main(int argc, char** argv)
+{
+	size_t count = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 1000000;
+	std::srand(33);
+	std::vector<AABB> boxes = makeScene(count);
+	std::printf("%zu primitives, %u threads\n", count, JobSystem::Shared().ThreadCount());
+
+	BVH bvh;
+	double build = measure(3, [&]()
+	{
+		bvh.Build(boxes);
+	});
+	size_t leaves = 0;
+	for (const BVHNode& node : bvh.nodes)
+	{
+		leaves += node.count > 0;
+	}
+	std::printf("build      %9.1f ms  %zu nodes, %zu leaves\n", build, bvh.nodes.size(), leaves);
+
+	// Everything moves a little, the structure stays
+	for (AABB& box : boxes)
+	{
+		box.min += glm::vec3(0.5f, 0.0f, 0.0f);
+		box.max += glm::vec3(0.5f, 0.0f, 0.0f);
+	}
+	double refit = measure(3, [&]()
+	{
+		bvh.Refit(boxes);
+	});
+	std::printf("refit      %9.1f ms\n", refit);
+
+	// A few objects move, like an animated part of the scene. The partial refit has to end up with the
+	// same bounds as refitting everything
+	std::vector<unsigned int> moved;
+	for (size_t i = 0; i < count; i += 100)
+	{
+		moved.push_back(i);
+		boxes[i].min += glm::vec3(0.0f, 10.0f, 0.0f);
+		boxes[i].max += glm::vec3(0.0f, 10.0f, 0.0f);
+	}
+	double partialRefit = measure(3, [&]()
+	{
+		bvh.Refit(boxes, moved);
+	});
+	std::vector<BVHNode> partialNodes = bvh.nodes;
+	bvh.Refit(boxes);
+	size_t wrongNodes = 0;
+	for (size_t n = 0; n < partialNodes.size(); n++)
+	{
+		wrongNodes += partialNodes[n].bounds.min != bvh.nodes[n].bounds.min || partialNodes[n].bounds.max != bvh.nodes[n].bounds.max;
+	}
+	std::printf("refit 1%%   %9.2f ms  %zu moved, %zu nodes differ from a full refit\n", partialRefit, moved.size(), wrongNodes);
+
+	// Camera looking over part of the city
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1500.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 200.0f, 0.0f), glm::vec3(500.0f, 0.0f, 500.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum(projection * view);
+	std::vector<unsigned int> visible;
+	double cull = measure(5, [&]()
+	{
+		visible.clear();
+		bvh.Cull(frustum, boxes, visible);
+	});
+	size_t bvhVisible = visible.size();
+	double cullAll = measure(5, [&]()
+	{
+		visible.clear();
+		for (size_t i = 0; i < boxes.size(); i++)
+		{
+			if (frustum.Intersects(boxes[i]))
+			{
+				visible.push_back(i);
+			}
+		}
+	});
+	std::printf("cull       %9.2f ms  every box %.2f ms, %zu visible (%s)\n", cull, cullAll, bvhVisible,
+		bvhVisible == visible.size() ? "same" : "DIFFERENT");
+
+	// Rays from above into the clusters, the boxes themselves are the primitives
+	const int rayCount = 1000;
+	std::vector<glm::vec3> origins;
+	std::vector<glm::vec3> directions;
+	for (int r = 0; r < rayCount; r++)
+	{
+		origins.push_back(glm::vec3(random(-2000.0f, 2000.0f), 400.0f, random(-2000.0f, 2000.0f)));
+		directions.push_back(glm::normalize(glm::vec3(random(-1.0f, 1.0f), -1.0f, random(-1.0f, 1.0f))));
+	}
+	std::vector<float> bvhHits(rayCount);
+	glm::vec3 invDirection;
+	glm::vec3 origin;
+	BVH::RayTest test = [&](unsigned int primitive)
+	{
+		return rayBoxEntry(boxes[primitive], origin, invDirection, 1e30f);
+	};
+	double rays = measure(3, [&]()
+	{
+		for (int r = 0; r < rayCount; r++)
+		{
+			origin = origins[r];
+			invDirection = 1.0f / directions[r];
+			unsigned int hit;
+			float distance;
+			bvhHits[r] = bvh.Raycast(origins[r], directions[r], 1e30f, test, hit, distance) ? distance : -1.0f;
+		}
+	});
+	// Testing every box is slow, so only a few rays
+	int bruteRays = std::max(1, (int)std::min<size_t>(rayCount, 20000000 / std::max<size_t>(count, 1)));
+	int mismatches = 0;
+	double bruteForce = measure(1, [&]()
+	{
+		for (int r = 0; r < bruteRays; r++)
+		{
+			glm::vec3 inv = 1.0f / directions[r];
+			float closest = -1.0f;
+			for (size_t i = 0; i < boxes.size(); i++)
+			{
+				float distance = rayBoxEntry(boxes[i], origins[r], inv, 1e30f);
+				if (distance >= 0.0f && (closest < 0.0f || distance < closest))
+				{
+					closest = distance;
+				}
+			}
+			mismatches += std::fabs(closest - bvhHits[r]) > 1e-3f;
+		}
+	});
+	std::printf("raycast    %9.4f ms per ray  every box %.4f ms per ray, %d of %d checked rays differ\n",
+		rays / rayCount, bruteForce / bruteRays, mismatches, bruteRays);
+	return mismatches == 0 && bvhVisible == visible.size() && wrongNodes == 0 ? 0 : 1;
+}
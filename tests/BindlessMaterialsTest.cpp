@@ -0,0 +1,118 @@
+#include<cstdlib>
+#include<cstring>
+#include<vector>
+
+#include"Check.h"
+#include"HeadlessGL.h"
+#include"BindlessMaterials.h"
+#include"SamplerCache.h"
+
+CHECK_MAIN;
+
+// Bytes of an entry in the storage buffer: two handles, two vec4 factors and the padded alpha cutoff
+static const size_t entryBytes = 64;
+// GL_SHADER_STORAGE_BUFFER_BINDING, glad only goes up to 3.3
+static const GLenum shaderStorageBufferBinding = 0x90D3;
+
+
+static TextureImage makeImage(unsigned char value)
+{
+	TextureImage image = { (unsigned char*)std::malloc(4 * 4 * 4), 4, 4, 4 };
+	std::memset(image.bytes, value, 4 * 4 * 4);
+	return image;
+}
+
+static Material makeMaterial(const Texture* texture, glm::vec4 baseColorFactor)
+{
+	Material material;
+	if (texture != NULL)
+	{
+		material.SetTextures({ *texture });
+	}
+	material.block.baseColorFactor = baseColorFactor;
+	return material;
+}
+
+// The storage buffer bound to binding, as written by Bind
+static std::vector<unsigned char> readTable(GLuint binding, unsigned int count)
+{
+	GLint buffer = 0;
+	glGetIntegeri_v(shaderStorageBufferBinding, binding, &buffer);
+	std::vector<unsigned char> bytes(count * entryBytes);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, (GLuint)buffer);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bytes.size(), bytes.data());
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	return bytes;
+}
+
+static GLuint64 handleAt(const std::vector<unsigned char>& table, GLuint index, int which)
+{
+	GLuint64 handle;
+	std::memcpy(&handle, &table[index * entryBytes + which * sizeof(GLuint64)], sizeof(handle));
+	return handle;
+}
+
+
+// Materials with the same handles and factors share an entry, missing textures sample the fallbacks
+int main()
+{
+	if (!CreateHeadlessContext())
+	{
+		return CHECK_SKIP;
+	}
+	if (!GLCaps.bindlessTexture)
+	{
+		std::printf("No bindless textures, skipping\n");
+		DestroyHeadlessContext();
+		return CHECK_SKIP;
+	}
+
+	TextureImage image = makeImage(200);
+	Texture texture(image, "diffuse", 0);
+	glm::vec4 white = glm::vec4(1.0f);
+	glm::vec4 red = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+
+	BindlessMaterials materials;
+	GLuint textured = materials.Index(makeMaterial(&texture, white));
+	CHECK_EQUAL(materials.Index(makeMaterial(&texture, white)), textured);
+	GLuint tinted = materials.Index(makeMaterial(&texture, red));
+	CHECK(tinted != textured);
+	GLuint plain = materials.Index(makeMaterial(NULL, white));
+	CHECK(plain != textured && plain != tinted);
+	CHECK_EQUAL(materials.Index(makeMaterial(NULL, white)), plain);
+
+	// Another sampler is another handle, so another entry
+	Material clamped = makeMaterial(&texture, white);
+	SamplerState state;
+	state.wrapS = GL_CLAMP_TO_EDGE;
+	clamped.samplerObjects[Material::BASE_COLOR] = SamplerCache::Shared().Get(state);
+	GLuint clampedIndex = materials.Index(clamped);
+	CHECK(clampedIndex != textured);
+	CHECK_EQUAL(materials.Count(), 4u);
+
+	materials.Bind(3);
+	std::vector<unsigned char> table = readTable(3, materials.Count());
+	CHECK_EQUAL(handleAt(table, textured, 0), handleAt(table, tinted, 0));
+	CHECK(handleAt(table, textured, 0) != handleAt(table, clampedIndex, 0));
+	CHECK(handleAt(table, textured, 0) != 0);
+	// Handles of a texture without a sampler are the same every time they are asked for
+	CHECK_EQUAL(handleAt(table, plain, 0), glGetTextureHandleARB(Material::FallbackTexture(Material::BASE_COLOR)));
+	CHECK_EQUAL(handleAt(table, plain, 1), glGetTextureHandleARB(Material::FallbackTexture(Material::METALLIC_ROUGHNESS)));
+	float factor[4];
+	std::memcpy(factor, &table[tinted * entryBytes + 2 * sizeof(GLuint64)], sizeof(factor));
+	CHECK(factor[0] == 1.0f && factor[1] == 0.0f && factor[2] == 0.0f && factor[3] == 1.0f);
+
+	// Entries added after a Bind are written by the next one
+	GLuint added = materials.Index(makeMaterial(NULL, red));
+	materials.Bind(3);
+	table = readTable(3, materials.Count());
+	CHECK_EQUAL(handleAt(table, added, 0), handleAt(table, plain, 0));
+	CHECK_EQUAL(glGetError(), (GLenum)GL_NO_ERROR);
+
+	materials.Delete();
+	texture.Delete();
+	Material::DeleteFallbackTextures();
+	SamplerCache::Shared().Delete();
+	DestroyHeadlessContext();
+	return CHECK_RESULT();
+}
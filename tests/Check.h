@@ -0,0 +1,31 @@
+#ifndef CHECK_CLASS_H
+#define CHECK_CLASS_H
+
+#include<cstdio>
+
+// Minimal assertion helpers for the tests. A failed CHECK prints where it failed and is
+// counted, the test keeps going so one run shows every broken expectation
+extern int checkFailures;
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			checkFailures++; \
+		} \
+	} while (0)
+
+#define CHECK_EQUAL(a, b) CHECK((a) == (b))
+
+// Exit code of a test: 0 if every CHECK passed
+#define CHECK_RESULT() (checkFailures == 0 ? 0 : 1)
+
+// Defines the failure counter, once per test executable
+#define CHECK_MAIN int checkFailures = 0
+
+// Exit code that makes ctest report a test as skipped instead of failed
+#define CHECK_SKIP 77
+
+#endif
@@ -0,0 +1,214 @@
+#include<sstream>
+#include<string>
+#include<vector>
+
+#include"Check.h"
+#include"HeadlessGL.h"
+#include"Mesh.h"
+#include"DrawList.h"
+#include"SamplerCache.h"
+
+CHECK_MAIN;
+
+
+// Lines of a printed stream
+static std::vector<std::string> printLines(const CommandBuffer& commands)
+{
+	std::stringstream printed;
+	commands.Print(printed);
+	std::vector<std::string> lines;
+	std::string line;
+	while (std::getline(printed, line))
+	{
+		lines.push_back(line);
+	}
+	return lines;
+}
+
+// Everything a DrawList recorded, setup first and then the chunks in order
+static std::string printDrawList(const DrawList& list)
+{
+	std::stringstream printed;
+	list.SetupCommands().Print(printed);
+	for (size_t c = 0; c < list.CommandChunkCount(); c++)
+	{
+		list.ChunkCommands(c).Print(printed);
+	}
+	return printed.str();
+}
+
+// Leaves out the material binds, which depend on where the chunks start
+static std::string withoutBinds(const std::string& stream)
+{
+	std::stringstream in(stream);
+	std::string kept;
+	std::string line;
+	while (std::getline(in, line))
+	{
+		if (line.compare(0, 4, "Bind") != 0 || line.compare(0, 15, "BindVertexArray") == 0)
+		{
+			kept += line + "\n";
+		}
+	}
+	return kept;
+}
+
+// A quad facing the camera
+static Mesh makeQuad(GLuint diffuse)
+{
+	std::vector<Vertex> vertices =
+	{
+		Vertex{ glm::vec3(-1.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f), glm::vec2(0.0f, 0.0f) },
+		Vertex{ glm::vec3(1.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f), glm::vec2(1.0f, 0.0f) },
+		Vertex{ glm::vec3(1.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f), glm::vec2(1.0f, 1.0f) },
+		Vertex{ glm::vec3(-1.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f), glm::vec2(0.0f, 1.0f) }
+	};
+	std::vector<GLuint> indices = { 0, 1, 2, 0, 2, 3 };
+	// Texture IDs are only recorded, they don't have to exist
+	std::vector<Texture> textures = { Texture(diffuse, "diffuse", 0) };
+	return Mesh(vertices, indices, textures);
+}
+
+
+// Mesh::Record binds the material, sets the camera and the matrices and draws the range of the arena
+static void testMeshRecord(Shader& shader, Camera& camera)
+{
+	Mesh first = makeQuad(7);
+	Mesh second = makeQuad(7);
+
+	CommandBuffer commands;
+	first.Record(commands, shader, camera);
+	second.Record(commands, shader, camera);
+	std::vector<std::string> lines = printLines(commands);
+
+	CHECK_EQUAL(lines.size(), commands.CommandCount());
+	CHECK(lines.size() >= 4);
+	CHECK_EQUAL(lines[0], "UseProgram " + std::to_string(shader.ID));
+	CHECK_EQUAL(lines[1], "BindVertexArray " + std::to_string(GeometryArena::Shared().vertexArray.ID));
+	CHECK_EQUAL(lines[2], "BindTexture 0 7 " + std::to_string(GL_TEXTURE_2D));
+	// The texture came without a glTF sampler, so it gets the default one
+	CHECK_EQUAL(lines[3], "BindSampler 0 " + std::to_string(SamplerCache::Shared().Default()));
+
+	// Both meshes draw 6 indices, the second one behind the first inside the arena
+	const GeometryRange& a = GeometryArena::Shared().Get(first.geometry);
+	const GeometryRange& b = GeometryArena::Shared().Get(second.geometry);
+	std::vector<std::string> draws;
+	for (const std::string& line : lines)
+	{
+		if (line.compare(0, 11, "DrawIndexed") == 0)
+		{
+			draws.push_back(line);
+		}
+	}
+	CHECK_EQUAL(draws.size(), 2u);
+	CHECK_EQUAL(draws[0], "DrawIndexed 6 " + std::to_string(a.firstIndex) + " " + std::to_string(a.baseVertex));
+	CHECK_EQUAL(draws[1], "DrawIndexed 6 " + std::to_string(b.firstIndex) + " " + std::to_string(b.baseVertex));
+	CHECK(a.firstIndex != b.firstIndex);
+
+	// The same calls give the same stream
+	CommandBuffer again;
+	first.Record(again, shader, camera);
+	second.Record(again, shader, camera);
+	std::stringstream printedOnce;
+	std::stringstream printedAgain;
+	commands.Print(printedOnce);
+	again.Print(printedAgain);
+	CHECK_EQUAL(printedOnce.str(), printedAgain.str());
+
+	first.Delete();
+	second.Delete();
+}
+
+
+// DrawList::Record has to give the same draws no matter how the packets are split into chunks
+static void testDrawListRecord(Shader& shader, Camera& camera)
+{
+	Mesh planks = makeQuad(11);
+	Mesh stone = makeQuad(12);
+
+	Registry registry;
+	for (int i = 0; i < 40; i++)
+	{
+		Mesh* mesh = i % 3 == 0 ? &stone : &planks;
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3((float)(i % 8) - 4.0f, (float)(i / 8) - 2.0f, -5.0f - (float)i * 0.1f));
+		Entity entity = registry.Create();
+		registry.Add(entity, TransformComponent{ model });
+		registry.Add(entity, MeshComponent{ mesh });
+		registry.Add(entity, MaterialComponent{ mesh->material.BindingKey() });
+		AABB box = mesh->bounds.Transform(model);
+		registry.Add(entity, BoundsComponent{ box, BoundingSphere::FromAABB(mesh->bounds, model) });
+		registry.Add(entity, VisibilityComponent{ false, 0 });
+	}
+
+	DrawList whole;
+	whole.Build(registry, camera);
+	whole.Record(shader, camera);
+	CHECK_EQUAL(whole.visibleCount, 40u);
+	CHECK_EQUAL(whole.CommandChunkCount(), 1u);
+	std::string wholeStream = printDrawList(whole);
+
+	DrawList split;
+	split.chunkSize = 1;
+	split.Build(registry, camera);
+	split.Record(shader, camera);
+	CHECK_EQUAL(split.CommandChunkCount(), 40u);
+	std::string splitStream = printDrawList(split);
+
+	// Sorted by material, so one list binds each material once and the other once per chunk
+	std::vector<std::string> wholeLines;
+	std::stringstream wholeIn(wholeStream);
+	for (std::string line; std::getline(wholeIn, line);)
+	{
+		wholeLines.push_back(line);
+	}
+	size_t textureBinds = 0;
+	for (const std::string& line : wholeLines)
+	{
+		textureBinds += line.compare(0, 12, "BindTexture ") == 0;
+	}
+	CHECK_EQUAL(textureBinds, 2u);
+	CHECK(splitStream != wholeStream);
+	CHECK_EQUAL(withoutBinds(splitStream), withoutBinds(wholeStream));
+
+	// Recording a second time reuses the buffers and changes nothing
+	whole.Record(shader, camera);
+	CHECK_EQUAL(printDrawList(whole), wholeStream);
+
+	// Every packet draws what Mesh::Record would draw for its mesh
+	size_t draw = 0;
+	for (const std::string& line : wholeLines)
+	{
+		if (line.compare(0, 11, "DrawIndexed") == 0)
+		{
+			const GeometryRange& range = GeometryArena::Shared().Get(whole.packets[draw].mesh->geometry);
+			CHECK_EQUAL(line, "DrawIndexed " + std::to_string(range.indexCount) + " " + std::to_string(range.firstIndex) + " " + std::to_string(range.baseVertex));
+			draw++;
+		}
+	}
+	CHECK_EQUAL(draw, 40u);
+
+	planks.Delete();
+	stone.Delete();
+}
+
+
+int main()
+{
+	if (!CreateHeadlessContext())
+	{
+		return CHECK_SKIP;
+	}
+
+	Shader shader("shader/part13.vert", "shader/part13.frag");
+	Camera camera(800, 600, glm::vec3(0.0f, 0.0f, 2.0f));
+	camera.updateMatrix(45.0f, 0.1f, 100.0f);
+
+	testMeshRecord(shader, camera);
+	testDrawListRecord(shader, camera);
+
+	shader.Delete();
+	GeometryArena::Shared().Delete();
+	SamplerCache::Shared().Delete();
+	DestroyHeadlessContext();
+	return CHECK_RESULT();
+}
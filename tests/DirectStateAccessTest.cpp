@@ -0,0 +1,239 @@
+#include<cstdlib>
+#include<cstring>
+#include<vector>
+
+#include"Check.h"
+#include"HeadlessGL.h"
+#include"GeometryArena.h"
+#include"Texture.h"
+#include"Material.h"
+#include"SamplerCache.h"
+#include"CommandExecutor.h"
+
+CHECK_MAIN;
+
+static const int size = 32;
+
+
+// A quad in the middle of clip space
+static std::vector<Vertex> quadVertices()
+{
+	return
+	{
+		Vertex{ glm::vec3(-0.5f, -0.5f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f), glm::vec2(0.0f, 0.0f) },
+		Vertex{ glm::vec3(0.5f, -0.5f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f), glm::vec2(1.0f, 0.0f) },
+		Vertex{ glm::vec3(0.5f, 0.5f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f), glm::vec2(1.0f, 1.0f) },
+		Vertex{ glm::vec3(-0.5f, 0.5f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f), glm::vec2(0.0f, 1.0f) }
+	};
+}
+
+// 4x4 checker, malloc'd like stb_image does so the texture can free it
+static TextureImage checkerImage()
+{
+	TextureImage image = { (unsigned char*)std::malloc(4 * 4 * 4), 4, 4, 4 };
+	for (int i = 0; i < 16; i++)
+	{
+		unsigned char value = ((i % 4) + (i / 4)) % 2 == 0 ? 255 : 40;
+		image.bytes[i * 4 + 0] = value;
+		image.bytes[i * 4 + 1] = 255 - value;
+		image.bytes[i * 4 + 2] = 128;
+		image.bytes[i * 4 + 3] = 255;
+	}
+	return image;
+}
+
+
+// Everything one path created and rendered
+struct PathResult
+{
+	std::vector<unsigned char> vertexBytes;
+	std::vector<GLuint> indices;
+	std::vector<unsigned char> level0;
+	std::vector<unsigned char> level1;
+	std::vector<unsigned char> arenaPixels;
+	std::vector<unsigned char> vaoPixels;
+};
+
+
+// Draws the quad into the bound framebuffer and reads it back
+static std::vector<unsigned char> render(Shader& shader, Material& material, GLuint vertexArray, GLuint firstIndex, GLint baseVertex)
+{
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	shader.Activate();
+	glm::mat4 identity = glm::mat4(1.0f);
+	glUniformMatrix4fv(shader.Uniform("camMatrix"), 1, GL_FALSE, &identity[0][0]);
+	glUniformMatrix4fv(shader.Uniform("model"), 1, GL_FALSE, &identity[0][0]);
+	glUniformMatrix4fv(shader.Uniform("translation"), 1, GL_FALSE, &identity[0][0]);
+	glUniformMatrix4fv(shader.Uniform("rotation"), 1, GL_FALSE, &identity[0][0]);
+	glUniformMatrix4fv(shader.Uniform("scale"), 1, GL_FALSE, &identity[0][0]);
+	glUniform4f(shader.Uniform("lightColor"), 1.0f, 1.0f, 1.0f, 1.0f);
+	glUniform3f(shader.Uniform("camPos"), 0.0f, 0.0f, 2.0f);
+
+	CommandBuffer commands;
+	material.Bind(commands);
+	ExecuteCommands(commands);
+	glBindVertexArray(vertexArray);
+	glDrawElementsBaseVertex(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)(firstIndex * sizeof(GLuint)), baseVertex);
+	glBindVertexArray(0);
+
+	std::vector<unsigned char> pixels(size * size * 4);
+	glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	return pixels;
+}
+
+
+// Creates the arena, a texture, plain VBO/EBO/VAO objects and draws with them through whatever path GLCaps picks
+static PathResult runPath(Shader& shader)
+{
+	PathResult result;
+	std::vector<Vertex> vertices = quadVertices();
+	std::vector<GLuint> indices = { 0, 1, 2, 0, 2, 3 };
+
+	// Something in front, so the quad lands at a non-zero base vertex
+	GeometryArena arena(64 * sizeof(Vertex), 64 * sizeof(GLuint));
+	std::vector<Vertex> padding(5, vertices[0]);
+	std::vector<GLuint> paddingIndices = { 0, 1, 2 };
+	arena.Allocate(padding, paddingIndices);
+	GeometryArena::Handle quad = arena.Allocate(vertices, indices);
+	const GeometryRange& range = arena.Get(quad);
+
+	result.vertexBytes.resize(range.vertexBytes);
+	glBindBuffer(GL_COPY_READ_BUFFER, arena.VertexBufferID());
+	glGetBufferSubData(GL_COPY_READ_BUFFER, range.vertexOffset, range.vertexBytes, result.vertexBytes.data());
+	result.indices.resize(range.indexCount);
+	glBindBuffer(GL_COPY_READ_BUFFER, arena.IndexBufferID());
+	glGetBufferSubData(GL_COPY_READ_BUFFER, range.firstIndex * sizeof(GLuint), range.indexCount * sizeof(GLuint), result.indices.data());
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	TextureImage image = checkerImage();
+	Texture texture(image, "diffuse", 0);
+	CHECK(image.bytes == NULL);
+	glBindTexture(GL_TEXTURE_2D, texture.ID);
+	result.level0.resize(4 * 4 * 4);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, result.level0.data());
+	result.level1.resize(2 * 2 * 4);
+	glGetTexImage(GL_TEXTURE_2D, 1, GL_RGBA, GL_UNSIGNED_BYTE, result.level1.data());
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	std::vector<Texture> textures = { texture };
+	Material material;
+	material.SetTextures(textures);
+	material.Upload();
+
+	result.arenaPixels = render(shader, material, arena.vertexArray.ID, range.firstIndex, range.baseVertex);
+
+	// The standalone objects, linked the way the older chapters do it
+	VAO vao;
+	vao.Bind();
+	VBO vbo(vertices);
+	EBO ebo(indices);
+	vao.LinkAttrib(vbo, 0, 3, GL_FLOAT, sizeof(Vertex), (void*)0);
+	vao.LinkAttrib(vbo, 1, 3, GL_FLOAT, sizeof(Vertex), (void*)(3 * sizeof(float)));
+	vao.LinkAttrib(vbo, 2, 3, GL_FLOAT, sizeof(Vertex), (void*)(6 * sizeof(float)));
+	vao.LinkAttrib(vbo, 3, 2, GL_FLOAT, sizeof(Vertex), (void*)(9 * sizeof(float)));
+	vao.LinkEBO(ebo);
+	vao.Unbind();
+	result.vaoPixels = render(shader, material, vao.ID, 0, 0);
+	CHECK_EQUAL(glGetError(), (GLenum)GL_NO_ERROR);
+
+	vao.Delete();
+	vbo.Delete();
+	ebo.Delete();
+	material.Delete();
+	texture.Delete();
+	arena.Delete();
+	return result;
+}
+
+
+// The DSA path and the bind-to-edit path have to create the same objects and render the same image
+int main()
+{
+	if (!CreateHeadlessContext())
+	{
+		return CHECK_SKIP;
+	}
+	if (!GLCaps.directStateAccess)
+	{
+		std::printf("No direct state access, skipping\n");
+		return CHECK_SKIP;
+	}
+
+	GLuint framebuffer;
+	GLuint renderbuffers[2];
+	glGenFramebuffers(1, &framebuffer);
+	glGenRenderbuffers(2, renderbuffers);
+	glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size, size);
+	glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+	CHECK_EQUAL(glCheckFramebufferStatus(GL_FRAMEBUFFER), (GLenum)GL_FRAMEBUFFER_COMPLETE);
+	glViewport(0, 0, size, size);
+
+	Shader shader("shader/part13.vert", "shader/part13.frag");
+	Material::SetupShader(shader);
+
+	PathResult direct = runPath(shader);
+	GLCaps.directStateAccess = false;
+	PathResult bound = runPath(shader);
+	GLCaps.directStateAccess = true;
+
+	std::vector<Vertex> vertices = quadVertices();
+	CHECK(direct.vertexBytes.size() == vertices.size() * sizeof(Vertex));
+	CHECK(std::memcmp(direct.vertexBytes.data(), vertices.data(), direct.vertexBytes.size()) == 0);
+	CHECK(direct.vertexBytes == bound.vertexBytes);
+	CHECK(direct.indices == bound.indices);
+	CHECK(direct.level0 == bound.level0);
+	CHECK(direct.level1 == bound.level1);
+	CHECK(direct.arenaPixels == bound.arenaPixels);
+	CHECK(direct.vaoPixels == bound.vaoPixels);
+	CHECK(direct.arenaPixels == direct.vaoPixels);
+
+	// The quad was actually drawn and textured: it differs from the corner and isn't one flat color
+	const std::vector<unsigned char>& pixels = direct.arenaPixels;
+	// The quad covers pixels 8 to 23, every texel of the checker 4 of them
+	int texel = (10 * size + 10) * 4;
+	int nextTexel = (10 * size + 14) * 4;
+	CHECK(pixels[texel] != 0 || pixels[texel + 1] != 0);
+	CHECK(pixels[0] == 0 && pixels[1] == 0);
+	CHECK(std::memcmp(&pixels[texel], &pixels[nextTexel], 3) != 0);
+
+	// A material without textures drawn after a textured one samples the white fallback, not the checker
+	// the textured one left on unit 0
+	Material::CreateFallbackTextures();
+	GeometryArena arena(64 * sizeof(Vertex), 64 * sizeof(GLuint));
+	std::vector<GLuint> indices = { 0, 1, 2, 0, 2, 3 };
+	const GeometryRange& range = arena.Get(arena.Allocate(vertices, indices));
+	TextureImage image = checkerImage();
+	Texture texture(image, "diffuse", 0);
+	std::vector<Texture> textures = { texture };
+	Material textured;
+	textured.SetTextures(textures);
+	textured.Upload();
+	Material plain;
+	plain.Upload();
+	CHECK(!textured.SameBindings(plain));
+	CHECK(plain.SameBindings(plain));
+	std::vector<unsigned char> texturedPixels = render(shader, textured, arena.vertexArray.ID, range.firstIndex, range.baseVertex);
+	std::vector<unsigned char> plainPixels = render(shader, plain, arena.vertexArray.ID, range.firstIndex, range.baseVertex);
+	CHECK(std::memcmp(&texturedPixels[texel], &texturedPixels[nextTexel], 3) != 0);
+	CHECK(plainPixels[texel] != 0 || plainPixels[texel + 1] != 0);
+	CHECK(std::memcmp(&plainPixels[texel], &plainPixels[nextTexel], 3) == 0);
+	CHECK_EQUAL(glGetError(), (GLenum)GL_NO_ERROR);
+	plain.Delete();
+	textured.Delete();
+	texture.Delete();
+	arena.Delete();
+	Material::DeleteFallbackTextures();
+
+	shader.Delete();
+	SamplerCache::Shared().Delete();
+	glDeleteRenderbuffers(2, renderbuffers);
+	glDeleteFramebuffers(1, &framebuffer);
+	DestroyHeadlessContext();
+	return CHECK_RESULT();
+}
@@ -0,0 +1,125 @@
+#include<vector>
+
+#include<glm/gtc/matrix_transform.hpp>
+
+#include"Check.h"
+#include"DrawList.h"
+
+CHECK_MAIN;
+
+// Bindings of three materials, in no particular order
+static const uint64_t materials[3] = { 900, 17, 4000 };
+
+
+// A unit cube at a position, Build never looks at the mesh so the entity has none
+static Entity addObject(Registry& registry, glm::vec3 position, uint64_t material, float size)
+{
+	glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+	AABB local = { glm::vec3(-0.5f * size), glm::vec3(0.5f * size) };
+	Entity entity = registry.Create();
+	registry.Add(entity, TransformComponent{ model });
+	registry.Add(entity, MeshComponent{ NULL });
+	registry.Add(entity, MaterialComponent{ material });
+	registry.Add(entity, BoundsComponent{ local.Transform(model), BoundingSphere::FromAABB(local, model) });
+	registry.Add(entity, VisibilityComponent{ false, 0 });
+	return entity;
+}
+
+static float distanceOf(const DrawPacket& packet)
+{
+	return -packet.model[3].z;
+}
+
+
+// Packets come out grouped by material with one run per material, front to back inside a run,
+// and the same for every chunk size
+static void testOrder(Camera& camera)
+{
+	Registry registry;
+	std::vector<Entity> visible;
+	for (int i = 0; i < 60; i++)
+	{
+		glm::vec3 position((float)(i % 5) - 2.0f, (float)(i % 3) - 1.0f, -3.0f - (float)((i * 37) % 60));
+		visible.push_back(addObject(registry, position, materials[i % 3], 1.0f));
+	}
+	// Behind the camera, off to the side and too small to cover a pixel
+	Entity behind = addObject(registry, glm::vec3(0.0f, 0.0f, 10.0f), materials[0], 1.0f);
+	Entity aside = addObject(registry, glm::vec3(80.0f, 0.0f, -5.0f), materials[1], 1.0f);
+	Entity tiny = addObject(registry, glm::vec3(0.0f, 0.0f, -90.0f), materials[2], 0.001f);
+
+	DrawList whole;
+	whole.Build(registry, camera);
+	CHECK_EQUAL(whole.visibleCount, 60u);
+	CHECK_EQUAL(whole.culledCount, 3u);
+	CHECK_EQUAL(whole.packets.size(), 60u);
+	CHECK(!registry.Get<VisibilityComponent>(behind).visible);
+	CHECK(!registry.Get<VisibilityComponent>(aside).visible);
+	CHECK(!registry.Get<VisibilityComponent>(tiny).visible);
+	for (Entity entity : visible)
+	{
+		CHECK(registry.Get<VisibilityComponent>(entity).visible);
+	}
+
+	size_t runs = 1;
+	for (size_t p = 1; p < whole.packets.size(); p++)
+	{
+		const DrawPacket& before = whole.packets[p - 1];
+		const DrawPacket& packet = whole.packets[p];
+		CHECK(before.material <= packet.material);
+		if (before.material != packet.material)
+		{
+			runs++;
+		}
+		else
+		{
+			CHECK(distanceOf(before) <= distanceOf(packet));
+			CHECK(before.sortKey < packet.sortKey);
+		}
+	}
+	CHECK_EQUAL(runs, 3u);
+	CHECK_EQUAL(whole.packets.front().material, (uint64_t)17);
+	CHECK_EQUAL(whole.packets.back().material, (uint64_t)4000);
+
+	// Chunks are merged in order, so splitting the entities differently changes nothing
+	DrawList split;
+	split.chunkSize = 7;
+	split.Build(registry, camera);
+	CHECK_EQUAL(split.packets.size(), whole.packets.size());
+	for (size_t p = 0; p < split.packets.size(); p++)
+	{
+		CHECK_EQUAL(split.packets[p].material, whole.packets[p].material);
+		CHECK_EQUAL(split.packets[p].sortKey, whole.packets[p].sortKey);
+		CHECK(split.packets[p].model == whole.packets[p].model);
+	}
+}
+
+
+// Every level halves the pixel radius the one before it started at, up to maxLod
+static void testLod(Camera& camera)
+{
+	Registry registry;
+	Entity nearObject = addObject(registry, glm::vec3(0.0f, 0.0f, -2.0f), materials[0], 1.0f);
+	Entity farObject = addObject(registry, glm::vec3(0.0f, 0.0f, -60.0f), materials[0], 1.0f);
+
+	DrawList list;
+	list.lodPixelRadius = 100.0f;
+	list.maxLod = 2;
+	list.Build(registry, camera);
+	CHECK_EQUAL(list.packets.size(), 2u);
+	CHECK_EQUAL(list.packets[0].lod, 0u);
+	CHECK_EQUAL(registry.Get<VisibilityComponent>(nearObject).lod, 0u);
+	// About 10 pixels at 60 units, which would be level 4 without the limit
+	CHECK_EQUAL(list.packets[1].lod, 2u);
+	CHECK_EQUAL(registry.Get<VisibilityComponent>(farObject).lod, 2u);
+}
+
+
+int main()
+{
+	Camera camera(800, 600, glm::vec3(0.0f));
+	camera.updateMatrix(45.0f, 0.1f, 100.0f);
+
+	testOrder(camera);
+	testLod(camera);
+	return CHECK_RESULT();
+}
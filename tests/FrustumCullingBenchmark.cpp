@@ -0,0 +1,103 @@
+#include<chrono>
+#include<cstdio>
+#include<cstdlib>
+#include<vector>
+
+#include<glm/gtc/matrix_transform.hpp>
+
+#include"FrustumCulling.h"
+
+
+static float random(float low, float high)
+{
+	return low + (high - low) * (float)std::rand() / (float)RAND_MAX;
+}
+
+// Time of function in nanoseconds, the best of a few runs
+template<typename Function>
+static double measure(Function function)
+{
+	double best = 1e30;
+	for (int run = 0; run < 7; run++)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		function();
+		std::chrono::duration<double, std::nano> time = std::chrono::high_resolution_clock::now() - start;
+		best = std::min(best, time.count());
+	}
+	return best;
+}
+
+
+// Culls the same objects with Frustum::Intersects on an array of AABB and BoundingSphere
+// (one glm::vec3 at a time) and with CullBoxes and CullSpheres on every path the CPU has.
+// Usage: FrustumCullingBenchmark [objects]
+int main(int argc, char** argv)
+{
+	size_t count = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 1000000;
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(3.0f, 2.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum(projection * view);
+
+	std::srand(32);
+	BoundsSoA bounds;
+	std::vector<AABB> boxes;
+	std::vector<BoundingSphere> spheres;
+	for (size_t i = 0; i < count; i++)
+	{
+		glm::vec3 center(random(-80.0f, 80.0f), random(-40.0f, 40.0f), random(-100.0f, 30.0f));
+		glm::vec3 extents(random(0.0f, 3.0f), random(0.0f, 3.0f), random(0.0f, 3.0f));
+		AABB box = { center - extents, center + extents };
+		BoundingSphere sphere = { center, glm::length(extents) };
+		boxes.push_back(box);
+		spheres.push_back(sphere);
+		bounds.Push(box, sphere);
+	}
+
+	std::vector<unsigned int> visible;
+	visible.reserve(count);
+	double naiveBoxes = measure([&]()
+	{
+		visible.clear();
+		for (size_t i = 0; i < count; i++)
+		{
+			if (frustum.Intersects(boxes[i]))
+			{
+				visible.push_back(i);
+			}
+		}
+	});
+	size_t naiveVisible = visible.size();
+	double naiveSpheres = measure([&]()
+	{
+		visible.clear();
+		for (size_t i = 0; i < count; i++)
+		{
+			if (frustum.Intersects(spheres[i]))
+			{
+				visible.push_back(i);
+			}
+		}
+	});
+
+	std::printf("%zu objects, %zu boxes visible\n", count, naiveVisible);
+	std::printf("%-22s %8.2f ns per box  %8.2f ns per sphere\n", "glm::vec3, AABB", naiveBoxes / count, naiveSpheres / count);
+	const char* names[] = { "SoA scalar", "SoA SSE2", "SoA AVX2" };
+	for (int path = CULLING_SCALAR; path <= (int)SupportedCullingPath(); path++)
+	{
+		SetCullingPath((CullingPath)path);
+		double culledBoxes = measure([&]()
+		{
+			visible.clear();
+			CullBoxes(frustum, bounds, 0, count, visible);
+		});
+		double culledSpheres = measure([&]()
+		{
+			visible.clear();
+			CullSpheres(frustum, bounds, 0, count, visible);
+		});
+		std::printf("%-22s %8.2f ns per box  %8.2f ns per sphere  %5.1fx faster on boxes\n",
+			names[path], culledBoxes / count, culledSpheres / count, naiveBoxes / culledBoxes);
+	}
+	return 0;
+}
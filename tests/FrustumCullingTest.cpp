@@ -0,0 +1,112 @@
+#include<cmath>
+#include<cstdlib>
+#include<vector>
+
+#include<glm/gtc/matrix_transform.hpp>
+
+#include"Check.h"
+#include"FrustumCulling.h"
+
+CHECK_MAIN;
+
+
+static float random(float low, float high)
+{
+	return low + (high - low) * (float)std::rand() / (float)RAND_MAX;
+}
+
+// Objects this close to a plane may land on either side depending on rounding
+static bool nearPlane(const Frustum& frustum, glm::vec3 center, glm::vec3 extents, float radius)
+{
+	for (int p = 0; p < 6; p++)
+	{
+		glm::dvec4 plane = frustum.planes[p];
+		double distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+		double reach = std::fabs(plane.x) * extents.x + std::fabs(plane.y) * extents.y + std::fabs(plane.z) * extents.z;
+		if (std::fabs(distance + reach) < 1e-3 || std::fabs(distance + radius) < 1e-3)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+// Every path the CPU can run gives the same indices as Frustum::Intersects, over ranges that don't start or end on a batch
+int main()
+{
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(3.0f, 2.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum(projection * view);
+
+	std::srand(32);
+	const size_t count = 10003;
+	BoundsSoA bounds;
+	std::vector<AABB> boxes;
+	std::vector<BoundingSphere> spheres;
+	std::vector<bool> ambiguous;
+	for (size_t i = 0; i < count; i++)
+	{
+		glm::vec3 center(random(-80.0f, 80.0f), random(-40.0f, 40.0f), random(-100.0f, 30.0f));
+		glm::vec3 extents(random(0.0f, 3.0f), random(0.0f, 3.0f), random(0.0f, 3.0f));
+		AABB box = { center - extents, center + extents };
+		BoundingSphere sphere = { center, glm::length(extents) };
+		boxes.push_back(box);
+		spheres.push_back(sphere);
+		bounds.Push(box, sphere);
+		ambiguous.push_back(nearPlane(frustum, center, extents, sphere.radius));
+	}
+
+	std::printf("Supported path: %d\n", (int)SupportedCullingPath());
+	CHECK_EQUAL(CurrentCullingPath(), SupportedCullingPath());
+	const size_t begin = 5;
+	const size_t end = count - 2;
+	for (int path = CULLING_SCALAR; path <= (int)SupportedCullingPath(); path++)
+	{
+		SetCullingPath((CullingPath)path);
+		CHECK_EQUAL((int)CurrentCullingPath(), path);
+
+		std::vector<unsigned int> visibleBoxes;
+		std::vector<unsigned int> visibleSpheres;
+		CullBoxes(frustum, bounds, begin, end, visibleBoxes);
+		CullSpheres(frustum, bounds, begin, end, visibleSpheres);
+
+		std::vector<bool> boxVisible(count, false);
+		std::vector<bool> sphereVisible(count, false);
+		int unordered = 0;
+		for (size_t v = 0; v < visibleBoxes.size(); v++)
+		{
+			unordered += v > 0 && visibleBoxes[v] <= visibleBoxes[v - 1];
+			boxVisible[visibleBoxes[v]] = true;
+		}
+		for (size_t v = 0; v < visibleSpheres.size(); v++)
+		{
+			unordered += v > 0 && visibleSpheres[v] <= visibleSpheres[v - 1];
+			sphereVisible[visibleSpheres[v]] = true;
+		}
+		CHECK_EQUAL(unordered, 0);
+
+		int wrong = 0;
+		size_t expectedVisible = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			bool inRange = i >= begin && i < end;
+			bool expectedBox = inRange && frustum.Intersects(boxes[i]);
+			bool expectedSphere = inRange && frustum.Intersects(spheres[i]);
+			expectedVisible += expectedBox;
+			if (!ambiguous[i])
+			{
+				wrong += boxVisible[i] != expectedBox;
+				wrong += sphereVisible[i] != expectedSphere;
+			}
+		}
+		CHECK_EQUAL(wrong, 0);
+		// The scene is set up so a good part is visible and a good part isn't
+		CHECK(expectedVisible > count / 20 && expectedVisible < count / 2);
+	}
+
+	// Asking for more than the CPU has gives the best it has
+	SetCullingPath(CULLING_AVX2);
+	CHECK_EQUAL(CurrentCullingPath(), SupportedCullingPath());
+	return CHECK_RESULT();
+}
@@ -0,0 +1,71 @@
+#include<vector>
+
+#include"Check.h"
+#include"HeadlessGL.h"
+#include"GeometryArena.h"
+
+CHECK_MAIN;
+
+
+// Reads indices back from the index buffer of the arena
+static std::vector<GLuint> readIndices(GeometryArena& arena, const GeometryRange& range)
+{
+	std::vector<GLuint> indices(range.indexCount);
+	glBindBuffer(GL_COPY_READ_BUFFER, arena.IndexBufferID());
+	glGetBufferSubData(GL_COPY_READ_BUFFER, range.firstIndex * sizeof(GLuint), indices.size() * sizeof(GLuint), indices.data());
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	return indices;
+}
+
+
+// Meshes without vertices or without indices get empty ranges at offset 0 and take no space
+static void testEmptyRanges()
+{
+	GeometryArena arena(64 * sizeof(Vertex), 64 * sizeof(GLuint));
+	std::vector<Vertex> vertices(3, Vertex{ glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), glm::vec2(0.0f) });
+	std::vector<GLuint> indices = { 0, 1, 2 };
+	std::vector<Vertex> noVertices;
+	std::vector<GLuint> noIndices;
+
+	GeometryArena::Handle triangle = arena.Allocate(vertices, indices);
+	GeometryArena::Handle empty = arena.Allocate(noVertices, noIndices);
+	GeometryArena::Handle pointsOnly = arena.Allocate(vertices, noIndices);
+	CHECK_EQUAL(glGetError(), (GLenum)GL_NO_ERROR);
+
+	const GeometryRange& emptyRange = arena.Get(empty);
+	CHECK(emptyRange.live);
+	CHECK_EQUAL(emptyRange.vertexOffset, 0);
+	CHECK_EQUAL(emptyRange.vertexBytes, 0);
+	CHECK_EQUAL(emptyRange.baseVertex, 0);
+	CHECK_EQUAL(emptyRange.firstIndex, 0u);
+	CHECK_EQUAL(emptyRange.indexCount, 0u);
+	CHECK_EQUAL(arena.Get(pointsOnly).indexCount, 0u);
+	CHECK_EQUAL(arena.Get(pointsOnly).firstIndex, 0u);
+	CHECK(arena.Get(pointsOnly).vertexBytes > 0);
+
+	// Freeing the empty ranges gives nothing back and moving the rest leaves them at 0
+	arena.Free(empty);
+	arena.Free(pointsOnly);
+	GeometryArena::Handle emptyAgain = arena.Allocate(noVertices, noIndices);
+	arena.Defragment();
+	CHECK_EQUAL(arena.Get(emptyAgain).firstIndex, 0u);
+	CHECK_EQUAL(arena.Get(emptyAgain).vertexOffset, 0);
+	CHECK(readIndices(arena, arena.Get(triangle)) == indices);
+	CHECK_EQUAL(glGetError(), (GLenum)GL_NO_ERROR);
+
+	arena.Free(emptyAgain);
+	arena.Free(triangle);
+	arena.Delete();
+}
+
+
+int main()
+{
+	if (!CreateHeadlessContext())
+	{
+		return CHECK_SKIP;
+	}
+	testEmptyRanges();
+	DestroyHeadlessContext();
+	return CHECK_RESULT();
+}
@@ -0,0 +1,138 @@
+#include"HeadlessGL.h"
+
+#define EGL_NO_X11
+#include<EGL/egl.h>
+#include<EGL/eglext.h>
+
+#include<cstdio>
+
+// Stands in for the GLFW window, only its context matters to the engine
+struct GLFWwindow
+{
+	EGLContext context;
+};
+
+static EGLDisplay display = EGL_NO_DISPLAY;
+static GLFWwindow mainWindow = { EGL_NO_CONTEXT };
+
+// Newest first, Mesa refuses versions it can't fully do even though it gives a newer one for an older request
+static const EGLint contextVersions[][2] = { { 4, 6 }, { 4, 5 }, { 4, 3 }, { 3, 3 } };
+
+// Creates a core context sharing objects with share
+static EGLContext createContext(EGLContext share)
+{
+	for (const EGLint* version : contextVersions)
+	{
+		const EGLint attributes[] =
+		{
+			EGL_CONTEXT_MAJOR_VERSION, version[0],
+			EGL_CONTEXT_MINOR_VERSION, version[1],
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, share, attributes);
+		if (context != EGL_NO_CONTEXT)
+		{
+			return context;
+		}
+	}
+	return EGL_NO_CONTEXT;
+}
+
+// Surfaceless display if Mesa offers one, else the default one
+static EGLDisplay openDisplay()
+{
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay != NULL)
+	{
+		EGLDisplay surfaceless = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		if (surfaceless != EGL_NO_DISPLAY)
+		{
+			return surfaceless;
+		}
+	}
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+bool CreateHeadlessContext()
+{
+	display = openDisplay();
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL) || !eglBindAPI(EGL_OPENGL_API))
+	{
+		std::printf("No EGL display, skipping\n");
+		return false;
+	}
+	mainWindow.context = createContext(EGL_NO_CONTEXT);
+	if (mainWindow.context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, mainWindow.context))
+	{
+		std::printf("No OpenGL context (EGL error 0x%x), skipping\n", eglGetError());
+		return false;
+	}
+	if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+	{
+		std::printf("Couldn't load OpenGL, skipping\n");
+		return false;
+	}
+	loadGLExtensions();
+	std::printf("%s | %s\n", glGetString(GL_VERSION), glGetString(GL_RENDERER));
+	return true;
+}
+
+void DestroyHeadlessContext()
+{
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(display, mainWindow.context);
+	eglTerminate(display);
+	mainWindow.context = EGL_NO_CONTEXT;
+	display = EGL_NO_DISPLAY;
+}
+
+
+// The GLFW functions the engine calls outside of main.cpp
+extern "C"
+{
+	GLFWglproc glfwGetProcAddress(const char* name)
+	{
+		return (GLFWglproc)eglGetProcAddress(name);
+	}
+
+	int glfwGetKey(GLFWwindow*, int)
+	{
+		return GLFW_RELEASE;
+	}
+
+	int glfwGetMouseButton(GLFWwindow*, int)
+	{
+		return GLFW_RELEASE;
+	}
+
+	void glfwSetInputMode(GLFWwindow*, int, int)
+	{
+	}
+
+	void glfwGetCursorPos(GLFWwindow*, double* x, double* y)
+	{
+		*x = 0.0;
+		*y = 0.0;
+	}
+
+	void glfwSetCursorPos(GLFWwindow*, double, double)
+	{
+	}
+
+	void glfwWindowHint(int, int)
+	{
+	}
+
+	// Only UploadThread creates windows, and only for a context that shares with the render one
+	GLFWwindow* glfwCreateWindow(int, int, const char*, GLFWmonitor*, GLFWwindow* share)
+	{
+		EGLContext context = createContext(share != NULL ? share->context : mainWindow.context);
+		return context == EGL_NO_CONTEXT ? NULL : new GLFWwindow{ context };
+	}
+
+	void glfwMakeContextCurrent(GLFWwindow* window)
+	{
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, window != NULL ? window->context : EGL_NO_CONTEXT);
+	}
+}
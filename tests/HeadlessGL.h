@@ -0,0 +1,17 @@
+#ifndef HEADLESS_GL_CLASS_H
+#define HEADLESS_GL_CLASS_H
+
+#include"GLExtensions.h"
+
+// Creates an OpenGL context without any window through EGL, loads glad and the extensions
+// into it and makes it current on the calling thread. Returns false if the machine has no
+// driver that can give one, GL tests then exit with CHECK_SKIP
+bool CreateHeadlessContext();
+// Destroys the context again
+void DestroyHeadlessContext();
+
+// The engine reads input and creates its upload context through GLFW, which the tests don't
+// link. HeadlessGL.cpp implements those few functions: input is always released and
+// glfwCreateWindow gives a windowless context sharing with the headless one, so UploadThread works
+
+#endif
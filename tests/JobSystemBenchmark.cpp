@@ -0,0 +1,77 @@
+#include<atomic>
+#include<chrono>
+#include<cstdio>
+#include<cstdlib>
+#include<functional>
+
+#include"JobSystem.h"
+
+
+// Time of function in nanoseconds, the best of a few runs
+template<typename Function>
+static double measure(Function function)
+{
+	double best = 1e30;
+	for (int run = 0; run < 5; run++)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		function();
+		std::chrono::duration<double, std::nano> time = std::chrono::high_resolution_clock::now() - start;
+		best = std::min(best, time.count());
+	}
+	return best;
+}
+
+
+// Overhead of one job: scheduling, finding, running and counting down an empty job.
+// Usage: JobSystemBenchmark [jobs]
+int main(int argc, char** argv)
+{
+	size_t jobs = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 1000000;
+	JobSystem& pool = JobSystem::Shared();
+	std::atomic<size_t> sink(0);
+
+	// Baseline, calling the same std::function without any pool
+	std::function<void()> empty = [&sink]() { sink.fetch_add(1, std::memory_order_relaxed); };
+	double direct = measure([&]()
+	{
+		for (size_t i = 0; i < jobs; i++)
+		{
+			empty();
+		}
+	});
+
+	double run = measure([&]()
+	{
+		JobCounter counter;
+		for (size_t i = 0; i < jobs; i++)
+		{
+			pool.Run(empty, &counter);
+		}
+		pool.Wait(counter);
+	});
+
+	double parallelFor = measure([&]()
+	{
+		pool.ParallelFor(jobs, 1, [&sink](size_t, size_t, size_t)
+		{
+			sink.fetch_add(1, std::memory_order_relaxed);
+		});
+	});
+
+	// One job per chunk of 1024, what the engine actually does
+	double chunked = measure([&]()
+	{
+		pool.ParallelFor(jobs, 1024, [&sink](size_t, size_t begin, size_t end)
+		{
+			sink.fetch_add(end - begin, std::memory_order_relaxed);
+		});
+	});
+
+	std::printf("%u threads, %zu jobs\n", pool.ThreadCount(), jobs);
+	std::printf("direct call         %8.1f ns per call\n", direct / jobs);
+	std::printf("Run + Wait          %8.1f ns per job\n", run / jobs);
+	std::printf("ParallelFor, 1      %8.1f ns per job\n", parallelFor / jobs);
+	std::printf("ParallelFor, 1024   %8.1f ns per element\n", chunked / jobs);
+	return 0;
+}
@@ -0,0 +1,228 @@
+#include<atomic>
+#include<thread>
+#include<vector>
+
+#include"Check.h"
+#include"JobSystem.h"
+
+CHECK_MAIN;
+
+
+// Owner pushes and pops while thieves steal, every job has to come out exactly once
+static void testDequeRaces()
+{
+	const int jobCount = 200000;
+	const int thiefCount = 3;
+	std::vector<Job> jobs(jobCount);
+	std::vector<std::atomic<int>> taken(jobCount);
+	for (int i = 0; i < jobCount; i++)
+	{
+		taken[i] = 0;
+	}
+
+	WorkStealingDeque deque(1024);
+	std::atomic<bool> done(false);
+	std::atomic<int> stolen(0);
+	std::vector<std::thread> thieves;
+	for (int t = 0; t < thiefCount; t++)
+	{
+		thieves.emplace_back([&]()
+		{
+			while (!done.load())
+			{
+				Job* job = deque.Steal();
+				if (job != NULL)
+				{
+					taken[job - jobs.data()]++;
+					stolen++;
+				}
+			}
+		});
+	}
+
+	// Pops now and then, so the owner and the thieves fight over the last job
+	int next = 0;
+	while (next < jobCount)
+	{
+		if (deque.Push(&jobs[next]))
+		{
+			next++;
+		}
+		if (next % 3 == 0)
+		{
+			Job* job = deque.Pop();
+			if (job != NULL)
+			{
+				taken[job - jobs.data()]++;
+			}
+		}
+	}
+	for (Job* job = deque.Pop(); job != NULL; job = deque.Pop())
+	{
+		taken[job - jobs.data()]++;
+	}
+	done = true;
+	for (std::thread& thief : thieves)
+	{
+		thief.join();
+	}
+
+	int wrong = 0;
+	for (int i = 0; i < jobCount; i++)
+	{
+		wrong += taken[i] != 1;
+	}
+	CHECK_EQUAL(wrong, 0);
+	CHECK(stolen.load() > 0);
+
+	// A full deque refuses more jobs
+	WorkStealingDeque small(4);
+	for (int i = 0; i < 4; i++)
+	{
+		CHECK(small.Push(&jobs[i]));
+	}
+	CHECK(!small.Push(&jobs[4]));
+}
+
+
+// ParallelFor inside ParallelFor, the counters live on the stacks of jobs that end right after Wait
+static void testNestedParallelFor(JobSystem& pool)
+{
+	for (int round = 0; round < 200; round++)
+	{
+		std::atomic<int> sum(0);
+		pool.ParallelFor(32, 1, [&](size_t, size_t, size_t)
+		{
+			pool.ParallelFor(64, 4, [&](size_t, size_t begin, size_t end)
+			{
+				sum += (int)(end - begin);
+			});
+		});
+		CHECK_EQUAL(sum.load(), 32 * 64);
+	}
+}
+
+
+// Jobs behind a counter only start once every job counted by it finished
+static void testRunAfter(JobSystem& pool)
+{
+	for (int round = 0; round < 500; round++)
+	{
+		std::atomic<int> finished(0);
+		std::atomic<int> early(0);
+		JobCounter first;
+		JobCounter second;
+		for (int i = 0; i < 16; i++)
+		{
+			pool.Run([&]()
+			{
+				finished++;
+			}, &first);
+		}
+		for (int i = 0; i < 4; i++)
+		{
+			pool.RunAfter(first, [&]()
+			{
+				early += finished.load() != 16;
+			}, &second);
+		}
+		pool.Wait(second);
+		CHECK_EQUAL(early.load(), 0);
+		CHECK(first.IsDone());
+
+		// A counter that is done already starts the job right away
+		JobCounter third;
+		pool.RunAfter(first, [&]()
+		{
+			finished++;
+		}, &third);
+		pool.Wait(third);
+		CHECK_EQUAL(finished.load(), 17);
+	}
+}
+
+
+// Jobs for the main thread queued from workers run inside Wait on the main thread
+static void testRunOnMainThread(JobSystem& pool)
+{
+	std::thread::id mainThread = std::this_thread::get_id();
+	for (int round = 0; round < 200; round++)
+	{
+		std::atomic<int> onMain(0);
+		std::atomic<int> elsewhere(0);
+		JobCounter counter;
+		pool.ParallelFor(16, 1, [&](size_t, size_t, size_t)
+		{
+			pool.RunOnMainThread([&]()
+			{
+				if (std::this_thread::get_id() == mainThread)
+				{
+					onMain++;
+				}
+				else
+				{
+					elsewhere++;
+				}
+			}, &counter);
+		});
+		pool.Wait(counter);
+		CHECK_EQUAL(onMain.load(), 16);
+		CHECK_EQUAL(elsewhere.load(), 0);
+	}
+}
+
+
+// Lots of tiny jobs from the main thread and from a thread outside the pool, all run exactly once
+static void testManySmallJobs(JobSystem& pool)
+{
+	const int jobCount = 20000;
+	std::vector<std::atomic<int>> runs(jobCount * 2);
+	for (size_t i = 0; i < runs.size(); i++)
+	{
+		runs[i] = 0;
+	}
+
+	JobCounter counter;
+	std::thread outside([&]()
+	{
+		JobCounter outsideCounter;
+		for (int i = 0; i < jobCount; i++)
+		{
+			pool.Run([&runs, i, jobCount]()
+			{
+				runs[jobCount + i]++;
+			}, &outsideCounter);
+		}
+		pool.Wait(outsideCounter);
+	});
+	for (int i = 0; i < jobCount; i++)
+	{
+		pool.Run([&runs, i]()
+		{
+			runs[i]++;
+		}, &counter);
+	}
+	pool.Wait(counter);
+	outside.join();
+
+	int wrong = 0;
+	for (size_t i = 0; i < runs.size(); i++)
+	{
+		wrong += runs[i] != 1;
+	}
+	CHECK_EQUAL(wrong, 0);
+}
+
+
+int main()
+{
+	testDequeRaces();
+
+	// More threads than cores on small machines too, so the steal paths get exercised
+	JobSystem pool(std::max(3u, std::thread::hardware_concurrency()));
+	testNestedParallelFor(pool);
+	testRunAfter(pool);
+	testRunOnMainThread(pool);
+	testManySmallJobs(pool);
+	return CHECK_RESULT();
+}
@@ -0,0 +1,174 @@
+#include<cstddef>
+#include<cstring>
+#include<vector>
+
+#include"Check.h"
+#include"HeadlessGL.h"
+#include"Material.h"
+
+CHECK_MAIN;
+
+
+// Two materials and the textures and samplers they name, the second one without anything optional
+static nlohmann::json makeGLTF()
+{
+	return nlohmann::json::parse(R"({
+		"materials": [
+			{
+				"pbrMetallicRoughness": {
+					"baseColorFactor": [ 0.5, 0.25, 1.0, 0.75 ],
+					"metallicFactor": 0.2,
+					"roughnessFactor": 0.6,
+					"baseColorTexture": { "index": 1 },
+					"metallicRoughnessTexture": { "index": 0 }
+				},
+				"emissiveFactor": [ 1.0, 0.5, 0.0 ],
+				"alphaMode": "MASK",
+				"alphaCutoff": 0.3
+			},
+			{
+				"alphaMode": "BLEND"
+			},
+			{
+				"alphaMode": "MASK"
+			}
+		],
+		"textures": [
+			{ "source": 4 },
+			{ "source": 2, "sampler": 1 }
+		]
+	})");
+}
+
+
+// Factors, alpha mode and the image and sampler of every role come from the glTF material
+static void testFromJSON()
+{
+	nlohmann::json JSON = makeGLTF();
+
+	Material full(JSON, 0);
+	CHECK(full.block.baseColorFactor == glm::vec4(0.5f, 0.25f, 1.0f, 0.75f));
+	CHECK(full.block.emissiveFactor == glm::vec4(1.0f, 0.5f, 0.0f, 0.0f));
+	CHECK(full.block.metallicFactor == 0.2f);
+	CHECK(full.block.roughnessFactor == 0.6f);
+	CHECK(full.block.alphaCutoff == 0.3f);
+	CHECK_EQUAL(full.images[Material::BASE_COLOR], 2);
+	CHECK_EQUAL(full.samplers[Material::BASE_COLOR], 1);
+	CHECK_EQUAL(full.images[Material::METALLIC_ROUGHNESS], 4);
+	CHECK_EQUAL(full.samplers[Material::METALLIC_ROUGHNESS], -1);
+	// Textures only arrive later
+	CHECK_EQUAL(full.textures[Material::BASE_COLOR], 0u);
+	CHECK_EQUAL(full.uniformBuffer, 0u);
+
+	// Everything missing keeps the glTF defaults, blending isn't a cutoff
+	Material blend(JSON, 1);
+	CHECK(blend.block.baseColorFactor == glm::vec4(1.0f));
+	CHECK(blend.block.emissiveFactor == glm::vec4(0.0f));
+	CHECK(blend.block.metallicFactor == 1.0f);
+	CHECK(blend.block.roughnessFactor == 1.0f);
+	CHECK(blend.block.alphaCutoff == 0.0f);
+	CHECK_EQUAL(blend.images[Material::BASE_COLOR], -1);
+	CHECK_EQUAL(blend.samplers[Material::METALLIC_ROUGHNESS], -1);
+
+	// MASK without a cutoff uses the glTF default of 0.5
+	Material mask(JSON, 2);
+	CHECK(mask.block.alphaCutoff == 0.5f);
+}
+
+
+// SetTextures takes the first texture of every role and the layer of array textures
+static void testSetTextures()
+{
+	Texture diffuse(11, "diffuse", 0);
+	Texture secondDiffuse(12, "diffuse", 0);
+	Texture specular(13, "specular", 1);
+	specular.target = GL_TEXTURE_2D_ARRAY;
+	specular.layer = 3;
+
+	Material material;
+	// Stands in for a glTF sampler, so SetTextures keeps it and doesn't reach for the cache
+	material.samplerObjects[Material::BASE_COLOR] = 5;
+	material.samplerObjects[Material::METALLIC_ROUGHNESS] = 6;
+	material.SetTextures({ diffuse, secondDiffuse, specular });
+	CHECK_EQUAL(material.textures[Material::BASE_COLOR], 11u);
+	CHECK_EQUAL(material.targets[Material::BASE_COLOR], (GLenum)GL_TEXTURE_2D);
+	CHECK_EQUAL(material.textures[Material::METALLIC_ROUGHNESS], 13u);
+	CHECK_EQUAL(material.targets[Material::METALLIC_ROUGHNESS], (GLenum)GL_TEXTURE_2D_ARRAY);
+	CHECK(material.block.layers == glm::ivec4(0, 3, 0, 0));
+	CHECK_EQUAL(material.samplerObjects[Material::BASE_COLOR], 5u);
+}
+
+
+// Offset of a member of the Material block as the shader lays it out
+static GLint memberOffset(GLuint program, const char* name)
+{
+	GLuint index = GL_INVALID_INDEX;
+	glGetUniformIndices(program, 1, &name, &index);
+	CHECK(index != GL_INVALID_INDEX);
+	GLint offset = -1;
+	glGetActiveUniformsiv(program, 1, &index, GL_UNIFORM_OFFSET, &offset);
+	return offset;
+}
+
+
+// MaterialBlock has to match the std140 Material block of every shader that binds materials
+static void testBlockLayout(const char* vertexFile, const char* fragmentFile)
+{
+	Shader shader(vertexFile, fragmentFile);
+	GLuint block = glGetUniformBlockIndex(shader.ID, "Material");
+	CHECK(block != GL_INVALID_INDEX);
+	GLint size = 0;
+	glGetActiveUniformBlockiv(shader.ID, block, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+	CHECK(size > 0 && (size_t)size <= sizeof(MaterialBlock));
+
+	CHECK_EQUAL(memberOffset(shader.ID, "baseColorFactor"), (GLint)offsetof(MaterialBlock, baseColorFactor));
+	CHECK_EQUAL(memberOffset(shader.ID, "emissiveFactor"), (GLint)offsetof(MaterialBlock, emissiveFactor));
+	CHECK_EQUAL(memberOffset(shader.ID, "layers"), (GLint)offsetof(MaterialBlock, layers));
+	CHECK_EQUAL(memberOffset(shader.ID, "metallicFactor"), (GLint)offsetof(MaterialBlock, metallicFactor));
+	CHECK_EQUAL(memberOffset(shader.ID, "roughnessFactor"), (GLint)offsetof(MaterialBlock, roughnessFactor));
+	CHECK_EQUAL(memberOffset(shader.ID, "alphaCutoff"), (GLint)offsetof(MaterialBlock, alphaCutoff));
+
+	// SetupShader points the block to the binding Bind uses
+	Material::SetupShader(shader);
+	GLint binding = -1;
+	glGetActiveUniformBlockiv(shader.ID, block, GL_UNIFORM_BLOCK_BINDING, &binding);
+	CHECK_EQUAL(binding, (GLint)Material::blockBinding);
+	shader.Delete();
+}
+
+
+// Upload copies the block into the uniform buffer as it is
+static void testUpload()
+{
+	Material material(makeGLTF(), 0);
+	material.block.layers = glm::ivec4(1, 2, 0, 0);
+	material.Upload();
+	CHECK(material.uniformBuffer != 0);
+	MaterialBlock stored;
+	glBindBuffer(GL_UNIFORM_BUFFER, material.uniformBuffer);
+	glGetBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(stored), &stored);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	CHECK(std::memcmp(&stored, &material.block, sizeof(stored)) == 0);
+	material.Delete();
+	CHECK_EQUAL(material.uniformBuffer, 0u);
+}
+
+
+int main()
+{
+	testFromJSON();
+	testSetTextures();
+
+	if (!CreateHeadlessContext())
+	{
+		std::printf("No context, skipping the block layout\n");
+		return CHECK_RESULT();
+	}
+	testBlockLayout("shader/part13.vert", "shader/part13.frag");
+	testBlockLayout("shader/part13.vert", "shader/array.frag");
+	testUpload();
+	CHECK_EQUAL(glGetError(), (GLenum)GL_NO_ERROR);
+
+	DestroyHeadlessContext();
+	return CHECK_RESULT();
+}
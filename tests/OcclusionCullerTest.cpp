@@ -0,0 +1,118 @@
+#include<cmath>
+#include<limits>
+#include<vector>
+
+#include<glm/gtc/matrix_transform.hpp>
+
+#include"Check.h"
+#include"OcclusionCuller.h"
+
+CHECK_MAIN;
+
+
+static AABB boxAround(glm::vec3 center, float halfSize)
+{
+	return AABB{ center - glm::vec3(halfSize), center + glm::vec3(halfSize) };
+}
+
+static glm::mat4 cameraMatrix()
+{
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 100.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	return projection * view;
+}
+
+
+// A wall at z = 0 hides boxes behind it but not boxes in front of it or next to it
+static void testWall()
+{
+	std::vector<glm::vec3> positions = { glm::vec3(-2.0f, -2.0f, 0.0f), glm::vec3(2.0f, -2.0f, 0.0f), glm::vec3(2.0f, 2.0f, 0.0f), glm::vec3(-2.0f, 2.0f, 0.0f) };
+	std::vector<GLuint> indices = { 0, 1, 2, 0, 2, 3 };
+	std::vector<OcclusionCuller::Occluder> occluders = { OcclusionCuller::Occluder{ &positions, &indices, glm::mat4(1.0f) } };
+
+	OcclusionCuller culler(256, 128);
+	culler.Render(cameraMatrix(), occluders);
+
+	std::vector<AABB> boxes =
+	{
+		boxAround(glm::vec3(0.0f, 0.0f, -3.0f), 0.5f),
+		boxAround(glm::vec3(0.0f, 0.0f, 2.0f), 0.5f),
+		boxAround(glm::vec3(6.0f, 0.0f, -3.0f), 0.5f),
+		boxAround(glm::vec3(1.0f, 1.0f, -10.0f), 0.5f),
+		// Reaches in front of the wall
+		AABB{ glm::vec3(-0.5f, -0.5f, -3.0f), glm::vec3(0.5f, 0.5f, 1.0f) },
+		// Behind the camera
+		boxAround(glm::vec3(0.0f, 0.0f, 10.0f), 0.5f)
+	};
+	CHECK(!culler.IsVisible(boxes[0]));
+	CHECK(culler.IsVisible(boxes[1]));
+	CHECK(culler.IsVisible(boxes[2]));
+	CHECK(!culler.IsVisible(boxes[3]));
+	CHECK(culler.IsVisible(boxes[4]));
+	CHECK(culler.IsVisible(boxes[5]));
+
+	std::vector<unsigned int> indicesToFilter = { 5, 4, 3, 2, 1, 0 };
+	culler.Filter(boxes, indicesToFilter);
+	CHECK(indicesToFilter == std::vector<unsigned int>({ 5, 4, 2, 1 }));
+
+	// Every texel of a level holds the furthest depth of the texels below it
+	int wrong = 0;
+	for (int l = 1; l < culler.LevelCount(); l++)
+	{
+		const std::vector<float>& below = culler.Level(l - 1);
+		const std::vector<float>& level = culler.Level(l);
+		int belowWidth = std::max(1, culler.Width() >> (l - 1));
+		int levelWidth = std::max(1, culler.Width() >> l);
+		for (size_t i = 0; i < below.size(); i++)
+		{
+			int x = (int)(i % belowWidth) / 2;
+			int y = (int)(i / belowWidth) / 2;
+			wrong += below[i] > level[y * levelWidth + x];
+		}
+	}
+	CHECK_EQUAL(wrong, 0);
+	CHECK(culler.Level(culler.LevelCount() - 1)[0] == 1.0f);
+	CHECK_EQUAL(culler.Level(culler.LevelCount() - 1).size(), 1u);
+}
+
+
+// Vertices right next to the camera plane project to enormous or non-finite pixel coordinates,
+// they have to be clamped before they turn into ints
+static void testExtremeCoordinates()
+{
+	const float nan = std::numeric_limits<float>::quiet_NaN();
+	const float huge = 1e30f;
+	std::vector<glm::vec3> positions =
+	{
+		// Barely in front of the camera at z = 5, far off to the side
+		glm::vec3(-1e6f, -1e6f, 4.8999f), glm::vec3(1e6f, -1e6f, 4.8999f), glm::vec3(0.0f, 1e6f, 4.8999f),
+		glm::vec3(huge, huge, -1.0f), glm::vec3(-huge, huge, -1.0f), glm::vec3(0.0f, -huge, -1.0f),
+		glm::vec3(nan, 0.0f, 0.0f), glm::vec3(1.0f, nan, 0.0f), glm::vec3(0.0f, 1.0f, nan)
+	};
+	std::vector<GLuint> indices = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+	std::vector<OcclusionCuller::Occluder> occluders = { OcclusionCuller::Occluder{ &positions, &indices, glm::mat4(1.0f) } };
+
+	OcclusionCuller culler(64, 32);
+	culler.Render(cameraMatrix(), occluders);
+	int invalid = 0;
+	for (float depth : culler.Level(0))
+	{
+		invalid += !(depth >= 0.0f && depth <= 1.0f);
+	}
+	CHECK_EQUAL(invalid, 0);
+
+	// Boxes with such corners get an answer without reading outside the pyramid
+	culler.IsVisible(AABB{ glm::vec3(-huge), glm::vec3(huge) });
+	culler.IsVisible(AABB{ glm::vec3(-1e7f, -1e7f, -50.0f), glm::vec3(1e7f, 1e7f, -40.0f) });
+	culler.IsVisible(AABB{ glm::vec3(nan), glm::vec3(nan) });
+	CHECK(culler.IsVisible(AABB{ glm::vec3(1e7f, 0.0f, -50.0f), glm::vec3(2e7f, 1.0f, -40.0f) }));
+	CHECK(culler.IsVisible(AABB{ glm::vec3(-2e7f, 0.0f, -50.0f), glm::vec3(-1e7f, 1.0f, -40.0f) }));
+}
+
+
+int main()
+{
+	testWall();
+	testExtremeCoordinates();
+	return CHECK_RESULT();
+}
@@ -0,0 +1,111 @@
+#include<cstdlib>
+#include<deque>
+#include<utility>
+#include<vector>
+
+#include"Check.h"
+#include"RingAllocator.h"
+
+CHECK_MAIN;
+
+
+// Ranges at the end of the ring that don't fit are skipped, not split
+static void testWrapAround()
+{
+	RingAllocator ring(100);
+	CHECK_EQUAL(ring.Allocate(40), 0u);
+	CHECK_EQUAL(ring.Allocate(40), 40u);
+	// Would have to wrap onto bytes the open frame still uses
+	CHECK_EQUAL(ring.Allocate(40), RingAllocator::InvalidOffset);
+	ring.EndFrame();
+	CHECK_EQUAL(ring.FramesInFlight(), 1u);
+	CHECK_EQUAL(ring.UsedBytes(), 80u);
+
+	ring.RetireFrame();
+	CHECK_EQUAL(ring.FramesInFlight(), 0u);
+	CHECK_EQUAL(ring.UsedBytes(), 0u);
+	// Starts over at 0, the 20 skipped bytes count as used by this frame
+	CHECK_EQUAL(ring.Allocate(40), 0u);
+	CHECK_EQUAL(ring.UsedBytes(), 60u);
+	ring.EndFrame();
+	ring.RetireFrame();
+	CHECK_EQUAL(ring.UsedBytes(), 0u);
+}
+
+
+static void testAlignmentAndLimits()
+{
+	RingAllocator ring(100);
+	CHECK_EQUAL(ring.Allocate(3), 0u);
+	CHECK_EQUAL(ring.Allocate(4, 16), 16u);
+	CHECK_EQUAL(ring.UsedBytes(), 20u);
+	CHECK_EQUAL(ring.Allocate(0), RingAllocator::InvalidOffset);
+	CHECK_EQUAL(ring.Allocate(4, 0), RingAllocator::InvalidOffset);
+	CHECK_EQUAL(ring.Allocate(101), RingAllocator::InvalidOffset);
+	CHECK_EQUAL(ring.UsedBytes(), 20u);
+
+	// Retiring without closed frames does nothing
+	ring.RetireFrame();
+	CHECK_EQUAL(ring.UsedBytes(), 20u);
+}
+
+
+// Random frames with at most three in flight, the ranges of frames in flight never overlap
+static void testFramesNeverOverlap()
+{
+	const size_t capacity = 4096;
+	RingAllocator ring(capacity);
+	std::srand(28);
+	// Ranges of every frame that isn't retired, the last one is the open frame
+	std::deque<std::vector<std::pair<size_t, size_t>>> frames(1);
+	int overlaps = 0;
+	int failed = 0;
+	for (int frame = 0; frame < 2000; frame++)
+	{
+		int allocations = std::rand() % 8;
+		for (int a = 0; a < allocations; a++)
+		{
+			size_t size = 1 + std::rand() % 300;
+			size_t alignment = (size_t)1 << (std::rand() % 7);
+			size_t offset = ring.Allocate(size, alignment);
+			if (offset == RingAllocator::InvalidOffset)
+			{
+				failed++;
+				continue;
+			}
+			overlaps += offset % alignment != 0 || offset + size > capacity;
+			for (const std::vector<std::pair<size_t, size_t>>& ranges : frames)
+			{
+				for (const std::pair<size_t, size_t>& range : ranges)
+				{
+					overlaps += offset < range.first + range.second && range.first < offset + size;
+				}
+			}
+			frames.back().push_back(std::make_pair(offset, size));
+		}
+		ring.EndFrame();
+		frames.push_back(std::vector<std::pair<size_t, size_t>>());
+		if (ring.FramesInFlight() > 3)
+		{
+			ring.RetireFrame();
+			frames.pop_front();
+		}
+	}
+	CHECK_EQUAL(overlaps, 0);
+	// 8 allocations of up to 300 bytes over 4 frames fit most of the time
+	CHECK(failed < 200);
+	while (ring.FramesInFlight() > 0)
+	{
+		ring.RetireFrame();
+	}
+	CHECK_EQUAL(ring.UsedBytes(), 0u);
+}
+
+
+int main()
+{
+	testWrapAround();
+	testAlignmentAndLimits();
+	testFramesNeverOverlap();
+	return CHECK_RESULT();
+}
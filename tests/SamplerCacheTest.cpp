@@ -0,0 +1,114 @@
+#include"Check.h"
+#include"HeadlessGL.h"
+#include"SamplerCache.h"
+
+CHECK_MAIN;
+
+
+// Missing glTF values keep the defaults, which are trilinear filtering and repeating
+static void testFromGLTF()
+{
+	SamplerState defaults;
+	CHECK_EQUAL(defaults.minFilter, (GLenum)GL_LINEAR_MIPMAP_LINEAR);
+	CHECK_EQUAL(defaults.magFilter, (GLenum)GL_LINEAR);
+	CHECK_EQUAL(defaults.wrapS, (GLenum)GL_REPEAT);
+	CHECK_EQUAL(defaults.wrapT, (GLenum)GL_REPEAT);
+	CHECK(defaults.anisotropy == 1.0f);
+	CHECK(defaults.UsesMipmaps());
+
+	CHECK(SamplerState::FromGLTF(nlohmann::json::object()) == defaults);
+
+	SamplerState nearest = SamplerState::FromGLTF(nlohmann::json::parse(R"({ "magFilter": 9728, "minFilter": 9728, "wrapT": 33071 })"));
+	CHECK_EQUAL(nearest.minFilter, (GLenum)GL_NEAREST);
+	CHECK_EQUAL(nearest.magFilter, (GLenum)GL_NEAREST);
+	CHECK_EQUAL(nearest.wrapS, (GLenum)GL_REPEAT);
+	CHECK_EQUAL(nearest.wrapT, (GLenum)GL_CLAMP_TO_EDGE);
+	CHECK(!nearest.UsesMipmaps());
+	CHECK(!(nearest == defaults));
+}
+
+
+static GLint samplerParameter(GLuint sampler, GLenum name)
+{
+	GLint value = 0;
+	glGetSamplerParameteriv(sampler, name, &value);
+	return value;
+}
+
+
+// Equal states share one sampler object that carries the state
+static void testGet()
+{
+	SamplerCache cache;
+	SamplerState state;
+	GLuint sampler = cache.Get(state);
+	CHECK(sampler != 0);
+	CHECK_EQUAL(cache.Get(state), sampler);
+	CHECK_EQUAL(cache.Default(), sampler);
+	CHECK_EQUAL(cache.Count(), 1u);
+	CHECK_EQUAL(samplerParameter(sampler, GL_TEXTURE_MIN_FILTER), GL_LINEAR_MIPMAP_LINEAR);
+	CHECK_EQUAL(samplerParameter(sampler, GL_TEXTURE_WRAP_S), GL_REPEAT);
+
+	SamplerState mirrored = state;
+	mirrored.wrapS = GL_MIRRORED_REPEAT;
+	GLuint other = cache.Get(mirrored);
+	CHECK(other != sampler);
+	CHECK_EQUAL(cache.Count(), 2u);
+	CHECK_EQUAL(samplerParameter(other, GL_TEXTURE_WRAP_S), GL_MIRRORED_REPEAT);
+	CHECK_EQUAL(samplerParameter(other, GL_TEXTURE_WRAP_T), GL_REPEAT);
+
+	cache.Delete();
+	CHECK_EQUAL(cache.Count(), 0u);
+	CHECK_EQUAL(glIsSampler(sampler), (GLboolean)GL_FALSE);
+}
+
+
+// Anisotropy is clamped to the context before matching, so asking for too much reuses the largest sampler
+static void testAnisotropy()
+{
+	float supported = GLCaps.maxAnisotropy;
+	// The clamp only looks at GLCaps, so a smaller limit works on every context
+	GLCaps.maxAnisotropy = 1.0f;
+	SamplerCache cache;
+	SamplerState state;
+	state.anisotropy = 16.0f;
+	CHECK_EQUAL(cache.Get(state), cache.Default());
+	CHECK_EQUAL(cache.Count(), 1u);
+	state.anisotropy = 0.0f;
+	CHECK_EQUAL(cache.Get(state), cache.Default());
+	cache.Delete();
+	GLCaps.maxAnisotropy = supported;
+
+	if (supported < 2.0f)
+	{
+		std::printf("No anisotropic filtering, skipping the sampler parameter\n");
+		return;
+	}
+	state.anisotropy = supported * 2.0f;
+	GLuint largest = cache.Get(state);
+	state.anisotropy = supported;
+	CHECK_EQUAL(cache.Get(state), largest);
+	CHECK(largest != cache.Default());
+	GLfloat anisotropy = 0.0f;
+	glGetSamplerParameterfv(largest, GL_TEXTURE_MAX_ANISOTROPY, &anisotropy);
+	CHECK(anisotropy == supported);
+	cache.Delete();
+}
+
+
+int main()
+{
+	testFromGLTF();
+
+	if (!CreateHeadlessContext())
+	{
+		std::printf("No context, skipping the sampler objects\n");
+		return CHECK_RESULT();
+	}
+	testGet();
+	testAnisotropy();
+	CHECK_EQUAL(glGetError(), (GLenum)GL_NO_ERROR);
+
+	DestroyHeadlessContext();
+	return CHECK_RESULT();
+}
@@ -0,0 +1,102 @@
+#include<chrono>
+#include<cmath>
+#include<cstdio>
+#include<cstdlib>
+#include<vector>
+
+#include"JobSystem.h"
+#include"SceneGraph.h"
+
+
+static float random(float low, float high)
+{
+	return low + (high - low) * (float)std::rand() / (float)RAND_MAX;
+}
+
+// Milliseconds of function, the best of a few runs
+template<typename Function>
+static double measure(int runs, Function function)
+{
+	double best = 1e30;
+	for (int run = 0; run < runs; run++)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		function();
+		std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - start;
+		best = std::min(best, time.count());
+	}
+	return best;
+}
+
+// Adds a node with a random transform and then children below it until depth runs out or count nodes exist
+static void addSubtree(SceneGraph& scene, int parent, int depth, size_t count)
+{
+	glm::vec3 translation(random(-10.0f, 10.0f), random(-10.0f, 10.0f), random(-10.0f, 10.0f));
+	glm::quat rotation = glm::angleAxis(random(0.0f, 6.28f), glm::normalize(glm::vec3(random(0.1f, 1.0f), random(0.1f, 1.0f), random(0.1f, 1.0f))));
+	unsigned int node = scene.AddNode(parent, -1, glm::mat4(1.0f), translation, rotation, glm::vec3(random(0.5f, 1.5f)));
+	for (int child = 0; child < 4 && depth > 0 && scene.Size() < count; child++)
+	{
+		addSubtree(scene, node, depth - 1, count);
+	}
+}
+
+// Moves every root, so both versions recompute the whole graph
+static void moveRoots(SceneGraph& scene, float offset)
+{
+	for (unsigned int root = 0; root < scene.Size(); root += scene.subtreeSizes[root])
+	{
+		scene.SetTranslation(root, scene.translations[root] + glm::vec3(offset, 0.0f, 0.0f));
+	}
+}
+
+
+// Measures the flat, SIMD, job system SceneGraph::Update against the recursive glm version when every
+// node moves, and checks both give the same world matrices. Usage: SceneGraphBenchmark [nodes]
+int main(int argc, char** argv)
+{
+	size_t count = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 1000000;
+	std::srand(37);
+	SceneGraph scene;
+	// Roots with four children per node, five levels deep, like many small animated hierarchies
+	while (scene.Size() < count)
+	{
+		addSubtree(scene, -1, 5, count);
+	}
+	std::printf("%zu nodes, %u threads\n", scene.Size(), JobSystem::Shared().ThreadCount());
+
+	std::vector<unsigned int> changed;
+	changed.reserve(scene.Size());
+	float offset = 0.0f;
+	double recursive = measure(5, [&]()
+	{
+		moveRoots(scene, offset += 1.0f);
+		changed.clear();
+		scene.UpdateRecursive(changed);
+	});
+	std::vector<glm::mat4> reference = scene.worlds;
+	size_t recursiveChanged = changed.size();
+
+	// Same translations as the last recursive run
+	moveRoots(scene, 0.0f);
+	changed.clear();
+	scene.UpdateRecursive(changed);
+	double flat = measure(5, [&]()
+	{
+		moveRoots(scene, 0.0f);
+		changed.clear();
+		scene.Update(changed);
+	});
+
+	size_t different = 0;
+	for (size_t n = 0; n < scene.Size(); n++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			glm::vec4 difference = glm::abs(scene.worlds[n][c] - reference[n][c]);
+			different += std::fmax(std::fmax(difference.x, difference.y), std::fmax(difference.z, difference.w)) > 1e-3f;
+		}
+	}
+	std::printf("recursive  %9.2f ms  %zu changed\n", recursive, recursiveChanged);
+	std::printf("update     %9.2f ms  %zu changed, %.1fx, %zu matrix columns differ\n", flat, changed.size(), recursive / flat, different);
+	return different == 0 && changed.size() == recursiveChanged ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+#include<cstring>
+#include<stdexcept>
+#include<vector>
+
+#include"Check.h"
+#include"HeadlessGL.h"
+#include"StreamBuffer.h"
+
+CHECK_MAIN;
+
+
+// Reads a range of a buffer back
+static std::vector<int> readBack(GLuint buffer, GLintptr offset, size_t count)
+{
+	std::vector<int> values(count);
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, offset, count * sizeof(int), values.data());
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	return values;
+}
+
+
+// Writes frames through the stream buffer and checks what the GPU side sees, with whatever path GLCaps picks
+static void testStreaming(const char* path)
+{
+	std::printf("%s\n", path);
+	// Room for a bit more than two frames of 4 KB, so the ring wraps and has to wait for fences
+	StreamBuffer stream(9 * 1024, 3);
+	for (int frame = 0; frame < 20; frame++)
+	{
+		stream.BeginFrame();
+		std::vector<int> values(1024);
+		for (int i = 0; i < 1024; i++)
+		{
+			values[i] = frame * 10000 + i;
+		}
+		GLintptr offset = stream.Upload(values.data(), values.size() * sizeof(int), 256);
+		CHECK_EQUAL(offset % 256, 0);
+
+		StreamAllocation allocation = stream.Allocate(sizeof(int), 4);
+		*(int*)allocation.data = -frame;
+		stream.Flush();
+
+		CHECK(readBack(stream.ID, offset, values.size()) == values);
+		CHECK_EQUAL(readBack(stream.ID, allocation.offset, 1)[0], -frame);
+		stream.EndFrame();
+	}
+	CHECK_EQUAL(glGetError(), (GLenum)GL_NO_ERROR);
+
+	// More than the whole buffer can never fit
+	bool threw = false;
+	try
+	{
+		stream.Allocate(10 * 1024, 4);
+	}
+	catch (const std::invalid_argument&)
+	{
+		threw = true;
+	}
+	CHECK(threw);
+	stream.Delete();
+}
+
+
+int main()
+{
+	if (!CreateHeadlessContext())
+	{
+		return CHECK_SKIP;
+	}
+
+	// Every path the buffer can take, the flags are only ever turned off
+	GLCapabilities caps = GLCaps;
+	if (caps.directStateAccess)
+	{
+		testStreaming("Direct state access");
+	}
+	GLCaps.directStateAccess = false;
+	if (caps.bufferStorage)
+	{
+		testStreaming("Persistent mapping");
+	}
+	GLCaps.bufferStorage = false;
+	testStreaming("CPU copy");
+	GLCaps = caps;
+
+	DestroyHeadlessContext();
+	return CHECK_RESULT();
+}
@@ -0,0 +1,151 @@
+#include<cstdlib>
+#include<cstring>
+#include<vector>
+
+#include"Check.h"
+#include"HeadlessGL.h"
+#include"TextureArrayPacker.h"
+
+CHECK_MAIN;
+
+
+// Image filled from a seed, malloced like stb_image does since the packer frees it
+static TextureImage makeImage(int width, int height, int channels, int seed)
+{
+	TextureImage image = { (unsigned char*)std::malloc((size_t)width * height * channels), width, height, channels };
+	for (int i = 0; i < width * height * channels; i++)
+	{
+		image.bytes[i] = (unsigned char)(i * 13 + seed * 41);
+	}
+	return image;
+}
+
+// Level 0 of one layer of an array texture, in the format of the image it came from
+static std::vector<unsigned char> readLayer(GLuint ID, int width, int height, int layers, int layer, GLenum format, int channels)
+{
+	std::vector<unsigned char> all((size_t)width * height * channels * layers);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, format, GL_UNSIGNED_BYTE, all.data());
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	size_t layerBytes = (size_t)width * height * channels;
+	return std::vector<unsigned char>(all.begin() + layer * layerBytes, all.begin() + (layer + 1) * layerBytes);
+}
+
+static GLint layerCount(GLuint ID)
+{
+	GLint depth = 0;
+	glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_DEPTH, &depth);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	return depth;
+}
+
+
+// Images of the same size and channels share an array and are numbered in the order they were added
+static void testGroups()
+{
+	TextureArrayPacker packer;
+	TextureImage images[4] =
+	{
+		makeImage(4, 4, 3, 1),
+		makeImage(8, 8, 3, 2),
+		makeImage(4, 4, 3, 3),
+		makeImage(4, 4, 4, 4)
+	};
+	std::vector<std::vector<unsigned char>> expected;
+	for (int i = 0; i < 4; i++)
+	{
+		expected.push_back(std::vector<unsigned char>(images[i].bytes,
+			images[i].bytes + images[i].width * images[i].height * images[i].channels));
+	}
+
+	unsigned int indices[4];
+	for (int i = 0; i < 4; i++)
+	{
+		CHECK(packer.Add(images[i], indices[i]));
+		CHECK_EQUAL(indices[i], (unsigned int)i);
+		// The packer owns the pixels now
+		CHECK(images[i].bytes == NULL);
+	}
+	CHECK_EQUAL(packer.ArrayCount(), 3u);
+	packer.Build();
+
+	Texture first = packer.Get(indices[0], "diffuse", 0);
+	Texture large = packer.Get(indices[1], "diffuse", 0);
+	Texture second = packer.Get(indices[2], "specular", 1);
+	Texture alpha = packer.Get(indices[3], "diffuse", 0);
+	CHECK(first.ID != 0);
+	CHECK_EQUAL(first.target, (GLenum)GL_TEXTURE_2D_ARRAY);
+	CHECK_EQUAL(first.ID, second.ID);
+	CHECK(first.ID != large.ID);
+	CHECK(first.ID != alpha.ID);
+	CHECK(large.ID != alpha.ID);
+	CHECK_EQUAL(first.layer, 0);
+	CHECK_EQUAL(second.layer, 1);
+	CHECK_EQUAL(large.layer, 0);
+	CHECK_EQUAL(alpha.layer, 0);
+	CHECK_EQUAL(layerCount(first.ID), 2);
+	CHECK_EQUAL(layerCount(large.ID), 1);
+
+	// Every layer holds its own image, RGB ones come back unchanged from the RGBA8 storage
+	CHECK(readLayer(first.ID, 4, 4, 2, 0, GL_RGB, 3) == expected[0]);
+	CHECK(readLayer(first.ID, 4, 4, 2, 1, GL_RGB, 3) == expected[2]);
+	CHECK(readLayer(large.ID, 8, 8, 1, 0, GL_RGB, 3) == expected[1]);
+	CHECK(readLayer(alpha.ID, 4, 4, 1, 0, GL_RGBA, 4) == expected[3]);
+
+	// Build only creates arrays it didn't create yet
+	packer.Build();
+	CHECK_EQUAL(packer.Get(indices[0], "diffuse", 0).ID, first.ID);
+	CHECK_EQUAL(glGetError(), (GLenum)GL_NO_ERROR);
+	packer.Delete();
+}
+
+
+// Images larger than maxSize and images that didn't decode stay with the caller
+static void testRejects()
+{
+	TextureArrayPacker packer;
+	packer.maxSize = 16;
+	unsigned int index = 99;
+
+	TextureImage wide = makeImage(32, 8, 3, 5);
+	unsigned char* wideBytes = wide.bytes;
+	CHECK(!packer.Add(wide, index));
+	CHECK(wide.bytes == wideBytes);
+	TextureImage tall = makeImage(8, 17, 3, 6);
+	CHECK(!packer.Add(tall, index));
+	CHECK(tall.bytes != NULL);
+	TextureImage missing = { NULL, 0, 0, 0 };
+	CHECK(!packer.Add(missing, index));
+	CHECK_EQUAL(index, 99u);
+	CHECK_EQUAL(packer.ArrayCount(), 0u);
+
+	// Right at the limit is still packed
+	TextureImage edge = makeImage(16, 16, 1, 7);
+	CHECK(packer.Add(edge, index));
+	CHECK_EQUAL(index, 0u);
+	packer.Build();
+	CHECK_EQUAL(packer.ArrayCount(), 1u);
+	CHECK(packer.Get(index, "diffuse", 0).ID != 0);
+
+	std::free(wide.bytes);
+	std::free(tall.bytes);
+	packer.Delete();
+}
+
+
+int main()
+{
+	if (!CreateHeadlessContext())
+	{
+		return CHECK_SKIP;
+	}
+
+	testGroups();
+	testRejects();
+
+	DestroyHeadlessContext();
+	return CHECK_RESULT();
+}
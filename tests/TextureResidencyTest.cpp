@@ -0,0 +1,137 @@
+#include<algorithm>
+#include<cstdlib>
+#include<vector>
+
+#include"Check.h"
+#include"HeadlessGL.h"
+#include"TextureResidency.h"
+
+CHECK_MAIN;
+
+
+// RGB image with rows that aren't 4 byte aligned, the bytes are malloced since the uploader frees them
+static TextureImage makeImage(int width, int height)
+{
+	TextureImage image = { (unsigned char*)std::malloc((size_t)width * height * 3), width, height, 3 };
+	for (int i = 0; i < width * height * 3; i++)
+	{
+		image.bytes[i] = (unsigned char)(i * 7 + i / 3);
+	}
+	return image;
+}
+
+static TextureImage copyImage(const TextureImage& image)
+{
+	TextureImage copy = image;
+	size_t bytes = (size_t)image.width * image.height * image.channels;
+	copy.bytes = (unsigned char*)std::malloc(bytes);
+	std::copy(image.bytes, image.bytes + bytes, copy.bytes);
+	return copy;
+}
+
+static GLint baseLevel(GLuint ID)
+{
+	GLint level = -1;
+	glBindTexture(GL_TEXTURE_2D, ID);
+	glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, &level);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return level;
+}
+
+static std::vector<unsigned char> readLevel(GLuint ID, int level, int width, int height)
+{
+	std::vector<unsigned char> pixels((size_t)width * height * 3);
+	glBindTexture(GL_TEXTURE_2D, ID);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTexImage(GL_TEXTURE_2D, level, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return pixels;
+}
+
+
+// Levels larger than the upload budget go up a band of rows per frame and are only sampled once complete
+static void testBands()
+{
+	// Levels of 250, 125, 62, ... texels, everything from 62 down is resident from the start
+	TextureImage image = makeImage(250, 250);
+	std::vector<int> widths, heights;
+	std::vector<std::vector<unsigned char>> expected = Texture::BuildMipChain(image, widths, heights);
+	// Ten rows of level 1 or five rows of level 0 per frame
+	TextureResidency residency(64 * 1024 * 1024, 125 * 4 * 10, 64);
+	GLuint ID = 0;
+	residency.UploadTexture(copyImage(image), "diffuse", 0, [&ID](GLuint texture) { ID = texture; });
+	std::free(image.bytes);
+	CHECK(ID != 0);
+	CHECK_EQUAL(residency.ResidentLevel(ID), 2);
+	CHECK_EQUAL(baseLevel(ID), 2);
+	size_t startBytes = residency.ResidentBytes();
+
+	// The first band takes the memory of the level, sampling stays on the complete levels
+	residency.Request(ID, 1e-4f);
+	residency.Update();
+	CHECK_EQUAL(residency.ResidentLevel(ID), 2);
+	CHECK_EQUAL(baseLevel(ID), 2);
+	CHECK_EQUAL(residency.ResidentBytes(), startBytes + 125 * 125 * 4);
+
+	int frames = 1;
+	int levelOneFrame = 0;
+	while (residency.ResidentLevel(ID) > 0 && frames < 1000)
+	{
+		residency.Request(ID, 1e-4f);
+		residency.Update();
+		frames++;
+		if (levelOneFrame == 0 && residency.ResidentLevel(ID) == 1)
+		{
+			levelOneFrame = frames;
+			CHECK_EQUAL(baseLevel(ID), 1);
+		}
+	}
+	// 125 rows of level 1 at 10 a frame, then 250 rows of level 0 at 5 a frame, sharing the frame in between
+	CHECK_EQUAL(levelOneFrame, 13);
+	CHECK_EQUAL(frames, 63);
+	CHECK_EQUAL(baseLevel(ID), 0);
+	CHECK_EQUAL(residency.ResidentBytes(), startBytes + 125 * 125 * 4 + 250 * 250 * 4);
+	CHECK(readLevel(ID, 0, 250, 250) == expected[0]);
+	CHECK(readLevel(ID, 1, 125, 125) == expected[1]);
+	residency.Delete();
+}
+
+
+// A level that is partly up gives its memory back once nothing asks for it anymore
+static void testDroppedBands()
+{
+	TextureResidency residency(64 * 1024 * 1024, 125 * 4 * 10, 64);
+	GLuint ID = 0;
+	residency.UploadTexture(makeImage(250, 250), "diffuse", 0, [&ID](GLuint texture) { ID = texture; });
+	size_t startBytes = residency.ResidentBytes();
+	residency.Request(ID, 1e-4f);
+	residency.Update();
+	CHECK(residency.ResidentBytes() > startBytes);
+	residency.Update();
+	CHECK_EQUAL(residency.ResidentBytes(), startBytes);
+	CHECK_EQUAL(residency.ResidentLevel(ID), 2);
+
+	// Starting over uploads the level from its first row again
+	for (int frame = 0; frame < 13; frame++)
+	{
+		residency.Request(ID, 0.01f);
+		residency.Update();
+	}
+	CHECK_EQUAL(residency.ResidentLevel(ID), 1);
+	CHECK_EQUAL(glGetError(), (GLenum)GL_NO_ERROR);
+	residency.Delete();
+}
+
+
+int main()
+{
+	if (!CreateHeadlessContext())
+	{
+		return CHECK_SKIP;
+	}
+	testBands();
+	testDroppedBands();
+	DestroyHeadlessContext();
+	return CHECK_RESULT();
+}
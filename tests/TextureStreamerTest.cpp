@@ -0,0 +1,155 @@
+#include<cstdlib>
+#include<vector>
+
+#include"Check.h"
+#include"HeadlessGL.h"
+#include"TextureStreamer.h"
+
+CHECK_MAIN;
+
+
+// Image with rows that aren't 4 byte aligned for 3 channels, the bytes are malloced since the streamer frees them
+static TextureImage makeImage(int width, int height, int channels, int seed)
+{
+	TextureImage image = { (unsigned char*)std::malloc((size_t)width * height * channels), width, height, channels };
+	for (int i = 0; i < width * height * channels; i++)
+	{
+		image.bytes[i] = (unsigned char)(i * 7 + i / 3 + seed);
+	}
+	return image;
+}
+
+static std::vector<unsigned char> readLevel(GLuint ID, int level, int width, int height, GLenum format, int channels)
+{
+	std::vector<unsigned char> pixels((size_t)width * height * channels);
+	glBindTexture(GL_TEXTURE_2D, ID);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTexImage(GL_TEXTURE_2D, level, format, GL_UNSIGNED_BYTE, pixels.data());
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return pixels;
+}
+
+
+// A texture goes up a band of rows per frame through a ring that holds only a few bands, so the
+// ring wraps and waits on its fences. ready only runs with the last band
+static void testBands()
+{
+	const int width = 250;
+	const int height = 100;
+	const int rowBytes = width * 3;
+	// Ten rows per frame, three frames of them fit in the ring
+	TextureStreamer streamer(rowBytes * 10 * 3, rowBytes * 10);
+
+	TextureImage image = makeImage(width, height, 3, 0);
+	std::vector<unsigned char> expected(image.bytes, image.bytes + rowBytes * height);
+	GLuint ready = 0;
+	int readyCalls = 0;
+	streamer.UploadTexture(image, "diffuse", 0, [&](GLuint ID) { ready = ID; readyCalls++; });
+	CHECK_EQUAL(streamer.Pending(), 1u);
+
+	int frames = 0;
+	while (streamer.Pending() > 0 && frames < 100)
+	{
+		streamer.Update();
+		frames++;
+		if (streamer.Pending() > 0)
+		{
+			CHECK_EQUAL(readyCalls, 0);
+		}
+	}
+	CHECK_EQUAL(frames, 10);
+	CHECK_EQUAL(readyCalls, 1);
+	CHECK(ready != 0);
+
+	// Every band landed on its own rows
+	CHECK(readLevel(ready, 0, width, height, GL_RGB, 3) == expected);
+	// The mipmaps were made from the complete level 0
+	std::vector<unsigned char> level1 = readLevel(ready, 1, width / 2, height / 2, GL_RGB, 3);
+	bool filled = false;
+	for (unsigned char value : level1)
+	{
+		filled |= value != 0;
+	}
+	CHECK(filled);
+
+	// Nothing left, Update does nothing
+	streamer.Update();
+	CHECK_EQUAL(readyCalls, 1);
+	CHECK_EQUAL(glGetError(), (GLenum)GL_NO_ERROR);
+	glDeleteTextures(1, &ready);
+	streamer.Delete();
+}
+
+
+// Queued textures finish in order, a frame can end one and start the next, and a row larger
+// than the budget still goes up one per frame
+static void testQueue()
+{
+	TextureStreamer streamer(64 * 1024, 1000);
+	TextureImage first = makeImage(100, 4, 4, 1);
+	TextureImage second = makeImage(30, 10, 3, 2);
+	std::vector<unsigned char> firstBytes(first.bytes, first.bytes + 100 * 4 * 4);
+	std::vector<unsigned char> secondBytes(second.bytes, second.bytes + 30 * 10 * 3);
+	std::vector<GLuint> ready;
+	streamer.UploadTexture(first, "diffuse", 0, [&](GLuint ID) { ready.push_back(ID); });
+	streamer.UploadTexture(second, "specular", 1, [&](GLuint ID) { ready.push_back(ID); });
+	CHECK_EQUAL(streamer.Pending(), 2u);
+
+	// 400 byte rows: two fit, a third starts with budget left and goes over it
+	streamer.Update();
+	CHECK(ready.empty());
+	// The last row, then 600 bytes are six rows of the second texture and a seventh goes over
+	streamer.Update();
+	CHECK_EQUAL(ready.size(), 1u);
+	CHECK_EQUAL(streamer.Pending(), 1u);
+	int frames = 2;
+	while (streamer.Pending() > 0 && frames < 100)
+	{
+		streamer.Update();
+		frames++;
+	}
+	CHECK_EQUAL(ready.size(), 2u);
+	// The 3 rows left fit in one frame
+	CHECK_EQUAL(frames, 3);
+	CHECK(ready[0] != ready[1]);
+	CHECK(readLevel(ready[0], 0, 100, 4, GL_RGBA, 4) == firstBytes);
+	CHECK(readLevel(ready[1], 0, 30, 10, GL_RGB, 3) == secondBytes);
+
+	// One row over the budget
+	streamer.bytesPerFrame = 100;
+	TextureImage wide = makeImage(64, 3, 4, 3);
+	GLuint wideID = 0;
+	streamer.UploadTexture(wide, "diffuse", 0, [&](GLuint ID) { wideID = ID; });
+	streamer.Update();
+	streamer.Update();
+	CHECK_EQUAL(wideID, 0u);
+	streamer.Update();
+	CHECK(wideID != 0);
+
+	// Delete frees what is still queued
+	streamer.UploadTexture(makeImage(64, 64, 4, 4), "diffuse", 0, [](GLuint) {});
+	streamer.Update();
+	CHECK_EQUAL(streamer.Pending(), 1u);
+	CHECK_EQUAL(glGetError(), (GLenum)GL_NO_ERROR);
+	streamer.Delete();
+	CHECK_EQUAL(streamer.Pending(), 0u);
+
+	glDeleteTextures(2, ready.data());
+	glDeleteTextures(1, &wideID);
+}
+
+
+int main()
+{
+	if (!CreateHeadlessContext())
+	{
+		return CHECK_SKIP;
+	}
+
+	testBands();
+	testQueue();
+
+	DestroyHeadlessContext();
+	return CHECK_RESULT();
+}
@@ -0,0 +1,130 @@
+#include<atomic>
+#include<thread>
+
+#include"Check.h"
+#include"TripleBuffer.h"
+
+CHECK_MAIN;
+
+
+// Large enough that a torn copy can't go unnoticed, every field holds the same number
+struct Snapshot
+{
+	unsigned long long values[64];
+
+	void Fill(unsigned long long value)
+	{
+		for (unsigned long long& v : values)
+		{
+			v = value;
+		}
+	}
+	bool Whole() const
+	{
+		for (unsigned long long v : values)
+		{
+			if (v != values[0])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+static Snapshot makeSnapshot(unsigned long long value)
+{
+	Snapshot snapshot;
+	snapshot.Fill(value);
+	return snapshot;
+}
+
+
+// Acquire only succeeds for a value published after the last one it took, and takes the newest
+static void testAcquire()
+{
+	TripleBuffer<Snapshot> buffer(makeSnapshot(0));
+	CHECK(!buffer.Acquire());
+	CHECK_EQUAL(buffer.Front().values[0], 0ull);
+
+	buffer.Back().Fill(1);
+	buffer.Publish();
+	CHECK(buffer.Acquire());
+	CHECK_EQUAL(buffer.Front().values[0], 1ull);
+	CHECK(!buffer.Acquire());
+	CHECK_EQUAL(buffer.Front().values[0], 1ull);
+
+	// The consumer was too slow for 2, it only ever sees 3
+	buffer.Back().Fill(2);
+	buffer.Publish();
+	buffer.Back().Fill(3);
+	buffer.Publish();
+	CHECK(buffer.Acquire());
+	CHECK_EQUAL(buffer.Front().values[0], 3ull);
+	CHECK(buffer.Front().Whole());
+	CHECK(!buffer.Acquire());
+}
+
+
+// A producer and a consumer running flat out: the consumer never sees a half written value and
+// never goes back to an older one
+static void testThreads()
+{
+	const unsigned long long count = 2000000;
+	TripleBuffer<Snapshot> buffer(makeSnapshot(0));
+	std::atomic<bool> started(false);
+	std::atomic<bool> done(false);
+
+	std::thread producer([&]()
+	{
+		// Starts with the consumer, otherwise it may be done before the consumer looked once
+		while (!started.load())
+		{
+			std::this_thread::yield();
+		}
+		for (unsigned long long value = 1; value <= count; value++)
+		{
+			buffer.Back().Fill(value);
+			buffer.Publish();
+		}
+		done = true;
+	});
+
+	unsigned long long torn = 0;
+	unsigned long long backwards = 0;
+	unsigned long long acquired = 0;
+	unsigned long long last = 0;
+	bool finished = false;
+	started = true;
+	while (!finished)
+	{
+		// Reads done first, so the last Acquire comes after the last Publish
+		finished = done.load();
+		if (!buffer.Acquire())
+		{
+			continue;
+		}
+		acquired++;
+		const Snapshot& front = buffer.Front();
+		torn += !front.Whole();
+		backwards += front.values[0] <= last;
+		last = front.values[0];
+	}
+	producer.join();
+
+	std::printf("Acquired %llu of %llu values\n", acquired, count);
+	CHECK_EQUAL(torn, 0ull);
+	CHECK_EQUAL(backwards, 0ull);
+	CHECK(acquired > 0);
+	// The newest value always gets through
+	CHECK_EQUAL(last, count);
+	CHECK(!buffer.Acquire());
+}
+
+
+int main()
+{
+	testAcquire();
+	testThreads();
+	return CHECK_RESULT();
+}
@@ -0,0 +1,172 @@
+#include<atomic>
+#include<chrono>
+#include<cstdlib>
+#include<thread>
+#include<vector>
+
+#include"Check.h"
+#include"HeadlessGL.h"
+#include"UploadThread.h"
+
+CHECK_MAIN;
+
+
+// Polls like the render thread does once a frame until nothing is pending, false if that takes too long
+static bool pollUntilDone(UploadThread& uploader)
+{
+	for (int frame = 0; frame < 2000 && uploader.Pending() > 0; frame++)
+	{
+		uploader.Poll();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return uploader.Pending() == 0;
+}
+
+
+// Callbacks run on the thread that polls, in the order of the uploads, and only after their upload.
+// An upload that isn't done holds back the callbacks of everything queued after it
+static void testOrder(UploadThread& uploader)
+{
+	std::thread::id renderThread = std::this_thread::get_id();
+	std::atomic<bool> gate(false);
+	std::atomic<int> uploaded(0);
+	std::vector<int> order;
+	bool wrongThread = false;
+	bool tooEarly = false;
+
+	for (int i = 0; i < 4; i++)
+	{
+		uploader.Upload([&, i]()
+		{
+			// The first upload waits until the test lets it go
+			while (i == 0 && !gate.load())
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			uploaded++;
+		},
+		[&, i]()
+		{
+			wrongThread |= std::this_thread::get_id() != renderThread;
+			tooEarly |= uploaded.load() <= i;
+			order.push_back(i);
+		});
+	}
+	CHECK_EQUAL(uploader.Pending(), 4u);
+
+	// Nothing can finish while the first upload is stuck
+	for (int frame = 0; frame < 20; frame++)
+	{
+		uploader.Poll();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	CHECK(order.empty());
+	CHECK_EQUAL(uploader.Pending(), 4u);
+
+	gate = true;
+	CHECK(pollUntilDone(uploader));
+	CHECK((order == std::vector<int>{ 0, 1, 2, 3 }));
+	CHECK(!wrongThread);
+	CHECK(!tooEarly);
+}
+
+
+// By the time the callback runs the render context sees the whole buffer and texture
+static void testObjects(UploadThread& uploader)
+{
+	std::vector<unsigned char> data(1000);
+	for (size_t i = 0; i < data.size(); i++)
+	{
+		data[i] = (unsigned char)(i * 3);
+	}
+	GLuint buffer = 0;
+	uploader.UploadBuffer(data.data(), (GLsizeiptr)data.size(), [&buffer](GLuint ID) { buffer = ID; });
+	// The upload works on its own copy
+	data.assign(data.size(), 0);
+
+	TextureImage image = { (unsigned char*)std::malloc(8 * 8 * 4), 8, 8, 4 };
+	for (int i = 0; i < 8 * 8 * 4; i++)
+	{
+		image.bytes[i] = (unsigned char)(i * 5);
+	}
+	std::vector<unsigned char> pixels(image.bytes, image.bytes + 8 * 8 * 4);
+	GLuint texture = 0;
+	uploader.UploadTexture(image, "diffuse", 0, [&texture](GLuint ID) { texture = ID; });
+
+	CHECK(pollUntilDone(uploader));
+	CHECK(buffer != 0);
+	CHECK(texture != 0);
+
+	std::vector<unsigned char> stored(data.size());
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, 0, (GLsizeiptr)stored.size(), stored.data());
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	for (size_t i = 0; i < stored.size(); i++)
+	{
+		CHECK_EQUAL(stored[i], (unsigned char)(i * 3));
+	}
+
+	std::vector<unsigned char> level0(pixels.size());
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, level0.data());
+	glBindTexture(GL_TEXTURE_2D, 0);
+	CHECK(level0 == pixels);
+
+	glDeleteBuffers(1, &buffer);
+	glDeleteTextures(1, &texture);
+}
+
+
+// Finish waits for everything still queued and runs the callbacks before it returns
+static void testFinish(UploadThread& uploader)
+{
+	std::vector<int> order;
+	for (int i = 0; i < 16; i++)
+	{
+		uploader.Upload([]()
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		},
+		[&order, i]()
+		{
+			order.push_back(i);
+		});
+	}
+	uploader.Finish();
+	CHECK_EQUAL(uploader.Pending(), 0u);
+	CHECK_EQUAL(order.size(), 16u);
+	for (int i = 0; i < (int)order.size(); i++)
+	{
+		CHECK_EQUAL(order[i], i);
+	}
+	// Nothing is left for Poll
+	uploader.Poll();
+	CHECK_EQUAL(order.size(), 16u);
+}
+
+
+int main()
+{
+	if (!CreateHeadlessContext())
+	{
+		return CHECK_SKIP;
+	}
+	GLFWwindow* context = UploadThread::CreateContext(NULL);
+	if (context == NULL)
+	{
+		std::printf("No shared context, skipping\n");
+		DestroyHeadlessContext();
+		return CHECK_SKIP;
+	}
+
+	{
+		UploadThread uploader(context);
+		testOrder(uploader);
+		testObjects(uploader);
+		testFinish(uploader);
+	}
+	CHECK_EQUAL(glGetError(), (GLenum)GL_NO_ERROR);
+
+	DestroyHeadlessContext();
+	return CHECK_RESULT();
+}
@@ -0,0 +1,200 @@
+#include<string>
+#include<vector>
+
+#include"Check.h"
+#include"HeadlessGL.h"
+#include"Model.h"
+
+CHECK_MAIN;
+
+static const int size = 32;
+// GL_SHADER_STORAGE_BUFFER binding of the vertices, the one Model::DrawIndirect uses
+static const GLuint verticesBinding = 2;
+
+// Writes what the vertex shaders hand over, so any attribute read from the wrong place changes the image
+static const char* fragmentSource = R"(#version 450 core
+in vec3 crntPos;
+in vec3 Normal;
+in vec3 color;
+in vec2 texCoord;
+flat in int material;
+out vec4 FragColor;
+
+void main()
+{
+	FragColor = vec4(texCoord.x, -texCoord.y, color.b * 0.5 + Normal.y * 0.5, float(material) / 8.0);
+}
+)";
+
+
+static GLuint compile(GLenum type, const std::string& source)
+{
+	GLuint shader = glCreateShader(type);
+	const char* text = source.c_str();
+	glShaderSource(shader, 1, &text, NULL);
+	glCompileShader(shader);
+	GLint compiled = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+	if (compiled != GL_TRUE)
+	{
+		char log[1024];
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		std::printf("%s\n", log);
+	}
+	CHECK(compiled == GL_TRUE);
+	return shader;
+}
+
+// Links a vertex shader of the indirect path with the fragment shader above. Before 4.60 gl_DrawID
+// comes from GL_ARB_shader_draw_parameters, where a draw that isn't a multi-draw has draw ID 0
+static GLuint makeProgram(const char* vertexFile)
+{
+	std::string source = get_file_contents(vertexFile);
+	if (GLCaps.major * 10 + GLCaps.minor < 46)
+	{
+		std::string version = "#version 460 core";
+		CHECK(source.compare(0, version.size(), version) == 0);
+		source.replace(0, version.size(), "#version 450 core\n#extension GL_ARB_shader_draw_parameters : require");
+		for (size_t at = source.find("gl_DrawID"); at != std::string::npos; at = source.find("gl_DrawID", at + 1))
+		{
+			source.replace(at, 9, "gl_DrawIDARB");
+		}
+	}
+	GLuint vertex = compile(GL_VERTEX_SHADER, source);
+	GLuint fragment = compile(GL_FRAGMENT_SHADER, fragmentSource);
+	GLuint program = glCreateProgram();
+	glAttachShader(program, vertex);
+	glAttachShader(program, fragment);
+	glLinkProgram(program);
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	CHECK(linked == GL_TRUE);
+	glDeleteShader(vertex);
+	glDeleteShader(fragment);
+	return program;
+}
+
+// Draws a range of the arena with DrawData entry 0 and reads the image back
+static std::vector<unsigned char> render(GLuint program, GLuint firstIndex, GLint baseVertex)
+{
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "drawOffset"), 0);
+	glDrawElementsBaseVertex(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)(firstIndex * sizeof(GLuint)), baseVertex);
+	std::vector<unsigned char> pixels(size * size * 4);
+	glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	return pixels;
+}
+
+// Fills storage buffer binding 0 with one DrawData entry for a range of the arena
+static GLuint drawBuffer(const GeometryRange& range, glm::mat4 model)
+{
+	DrawData draw = { model, (GLint)(range.vertexOffset / sizeof(float)), range.format, 3, { 0, 0 } };
+	GLuint buffer;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(draw), &draw, GL_STATIC_DRAW);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+	return buffer;
+}
+
+
+// pulling.vert has to give the same image as indirect.vert reading the same vertices through
+// attributes, and fill in missing attributes of other vertex formats like the attribute path
+int main()
+{
+	if (!CreateHeadlessContext())
+	{
+		return CHECK_SKIP;
+	}
+	if (GLCaps.major * 10 + GLCaps.minor < 46 && !hasGLExtension("GL_ARB_shader_draw_parameters"))
+	{
+		std::printf("No gl_DrawID, skipping\n");
+		DestroyHeadlessContext();
+		return CHECK_SKIP;
+	}
+
+	GLuint framebuffer;
+	GLuint renderbuffer;
+	glGenFramebuffers(1, &framebuffer);
+	glGenRenderbuffers(1, &renderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size, size);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer);
+	CHECK_EQUAL(glCheckFramebufferStatus(GL_FRAMEBUFFER), (GLenum)GL_FRAMEBUFFER_COMPLETE);
+	glViewport(0, 0, size, size);
+
+	// Something in front, so the quad starts at a vertex offset and base vertex that aren't 0
+	GeometryArena arena(64 * sizeof(Vertex), 64 * sizeof(GLuint));
+	std::vector<Vertex> padding(5, Vertex{ glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), glm::vec2(0.0f) });
+	std::vector<GLuint> paddingIndices = { 0, 1, 2 };
+	arena.Allocate(padding, paddingIndices);
+	std::vector<Vertex> vertices =
+	{
+		Vertex{ glm::vec3(-0.5f, -0.5f, 0.0f), glm::vec3(0.0f, 0.2f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(0.0f, 0.0f) },
+		Vertex{ glm::vec3(0.5f, -0.5f, 0.0f), glm::vec3(0.0f, 0.4f, 1.0f), glm::vec3(0.0f, 1.0f, 0.5f), glm::vec2(1.0f, 0.0f) },
+		Vertex{ glm::vec3(0.5f, 0.5f, 0.0f), glm::vec3(0.0f, 0.6f, 1.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(1.0f, 1.0f) },
+		Vertex{ glm::vec3(-0.5f, 0.5f, 0.0f), glm::vec3(0.0f, 0.8f, 1.0f), glm::vec3(1.0f, 1.0f, 0.0f), glm::vec2(0.0f, 1.0f) }
+	};
+	std::vector<GLuint> indices = { 0, 1, 2, 0, 2, 3 };
+	GeometryArena::Handle quad = arena.Allocate(vertices, indices);
+	const GeometryRange& range = arena.Get(quad);
+	CHECK(range.baseVertex != 0);
+
+	FrameUniforms frame = { glm::mat4(1.0f), glm::vec4(0.0f) };
+	GLuint frameBuffer;
+	glGenBuffers(1, &frameBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, frameBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(frame), &frame, GL_STATIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, 1, frameBuffer);
+	GLuint draws = drawBuffer(range, glm::translate(glm::mat4(1.0f), glm::vec3(0.2f, 0.1f, 0.0f)));
+
+	GLuint attributes = makeProgram("shader/indirect.vert");
+	GLuint pulling = makeProgram("shader/pulling.vert");
+
+	arena.Bind();
+	std::vector<unsigned char> expected = render(attributes, range.firstIndex, range.baseVertex);
+	// Pulled vertices are addressed through the DrawData entry, the indices stay raw
+	arena.BindPulling(verticesBinding);
+	std::vector<unsigned char> pulled = render(pulling, range.firstIndex, 0);
+	CHECK(pulled == expected);
+	int covered = 0;
+	for (int p = 0; p < size * size; p++)
+	{
+		covered += expected[p * 4 + 3] != 0;
+	}
+	// The quad covers a quarter of the framebuffer
+	CHECK(covered > size * size / 8 && covered < size * size / 2);
+	// Moved by the model matrix: with the negated position it sits left of and below the middle
+	CHECK(expected[((size / 2 - 8) * size + size / 2 - 8) * 4 + 3] != 0);
+	CHECK(expected[((size / 2 + 7) * size + size / 2 + 7) * 4 + 3] == 0);
+
+	// Positions and texture coordinates only: no normal and color to read, the defaults fill in
+	const float packed[] = { -0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.5f, 0.5f, 0.0f, 1.0f, 1.0f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f };
+	VertexFormat format = { 5, -1, -1, 3 };
+	GeometryArena::Handle bare = arena.Allocate(packed, 4, format, indices.data(), 6);
+	const GeometryRange& bareRange = arena.Get(bare);
+	glDeleteBuffers(1, &draws);
+	draws = drawBuffer(bareRange, glm::mat4(1.0f));
+	arena.BindPulling(verticesBinding);
+	std::vector<unsigned char> barePixels = render(pulling, bareRange.firstIndex, 0);
+	int middle = ((size / 2) * size + size / 2) * 4;
+	// White color and an up normal, material 3
+	CHECK_EQUAL(barePixels[middle + 2], 255);
+	CHECK(barePixels[middle + 3] >= 95 && barePixels[middle + 3] <= 97);
+	// The texture coordinates change across the quad
+	CHECK(barePixels[middle] > 64 && barePixels[middle] < 192);
+	CHECK_EQUAL(glGetError(), (GLenum)GL_NO_ERROR);
+
+	glDeleteProgram(attributes);
+	glDeleteProgram(pulling);
+	glDeleteBuffers(1, &draws);
+	glDeleteBuffers(1, &frameBuffer);
+	arena.Delete();
+	glDeleteRenderbuffers(1, &renderbuffer);
+	glDeleteFramebuffers(1, &framebuffer);
+	DestroyHeadlessContext();
+	return CHECK_RESULT();
+}
@@ -0,0 +1,217 @@
+#include<stdexcept>
+#include<vector>
+
+#include"Check.h"
+#include"VirtualTexturePages.h"
+
+CHECK_MAIN;
+
+
+// Entry of the page table of a level at page x, y
+static uint32_t entryAt(const VirtualTexturePages& pages, int level, int x, int y)
+{
+	return pages.PageTable(level)[y * pages.PagesX(level) + x];
+}
+
+// Counts the entries of a level that point at the slot of page
+static int entriesOf(const VirtualTexturePages& pages, int level, PageId page)
+{
+	int slot = pages.SlotOf(page);
+	uint32_t entry = VirtualTexturePages::Entry(slot % pages.SlotsX(), slot / pages.SlotsX(), PageLevel(page));
+	int count = 0;
+	for (uint32_t value : pages.PageTable(level))
+	{
+		count += value == entry;
+	}
+	return count;
+}
+
+static void frame(VirtualTexturePages& pages, const std::vector<PageId>& feedback)
+{
+	pages.ProcessFeedback(feedback.data(), feedback.size());
+}
+
+
+static void testConstruction()
+{
+	// 8 x 8 pages: levels of 8, 4, 2 and 1 pages a side
+	VirtualTexturePages pages(128, 128, 16, 2, 2);
+	CHECK_EQUAL(pages.LevelCount(), 4);
+	CHECK_EQUAL(pages.PagesX(0), 8);
+	CHECK_EQUAL(pages.PagesY(2), 2);
+	CHECK_EQUAL(pages.ResidentCount(), 1);
+
+	// The coarsest page is resident from the start and every entry of every level falls back to it
+	PageId pinned = MakePageId(3, 0, 0);
+	CHECK(pages.IsResident(pinned));
+	for (int l = 0; l < pages.LevelCount(); l++)
+	{
+		CHECK_EQUAL(entriesOf(pages, l, pinned), pages.PagesX(l) * pages.PagesY(l));
+	}
+
+	int failures = 0;
+	try { VirtualTexturePages(100, 128, 16, 2, 2); } catch (const std::invalid_argument&) { failures++; }
+	try { VirtualTexturePages(96, 128, 16, 2, 2); } catch (const std::invalid_argument&) { failures++; }
+	try { VirtualTexturePages(128, 128, 16, 1, 1); } catch (const std::invalid_argument&) { failures++; }
+	try { VirtualTexturePages(128, 128, 16, 257, 2); } catch (const std::invalid_argument&) { failures++; }
+	CHECK_EQUAL(failures, 4);
+}
+
+
+// A missing page is requested with its missing parents, coarse levels first, then by pixel count
+static void testRequests()
+{
+	VirtualTexturePages pages(128, 128, 16, 2, 2);
+	PageId fine = MakePageId(0, 3, 5);
+	PageId other = MakePageId(0, 6, 6);
+	std::vector<PageId> feedback = { other, fine, fine, 0, MakePageId(0, 100, 0), MakePageId(5, 0, 0), fine };
+	frame(pages, feedback);
+
+	std::vector<PageId> expected =
+	{
+		MakePageId(2, 0, 1), MakePageId(2, 1, 1),
+		MakePageId(1, 1, 2), MakePageId(1, 3, 3),
+		fine, other
+	};
+	CHECK(pages.Requests() == expected);
+
+	// Pages that are resident are used, not requested
+	int slot;
+	PageId evicted;
+	CHECK(pages.MapPage(MakePageId(2, 0, 1), slot, evicted));
+	frame(pages, feedback);
+	CHECK_EQUAL(pages.Requests().size(), 5u);
+	CHECK_EQUAL(pages.Requests()[0], MakePageId(2, 1, 1));
+}
+
+
+// Entries of missing pages point at the finest resident page above them
+static void testParentFallback()
+{
+	VirtualTexturePages pages(128, 128, 16, 2, 2);
+	std::vector<PageRect> dirty;
+	CHECK(!pages.UpdatePageTable(dirty));
+
+	int slot;
+	PageId evicted;
+	PageId parent = MakePageId(1, 0, 1);
+	frame(pages, { MakePageId(0, 1, 3) });
+	CHECK(pages.MapPage(parent, slot, evicted));
+	CHECK_EQUAL(evicted, 0u);
+	CHECK(pages.UpdatePageTable(dirty));
+
+	// The level 1 page covers pages 0-1, 2-3 of level 0
+	uint32_t parentEntry = VirtualTexturePages::Entry(slot % 2, slot / 2, 1);
+	CHECK_EQUAL(entryAt(pages, 1, 0, 1), parentEntry);
+	CHECK_EQUAL(entryAt(pages, 0, 1, 3), parentEntry);
+	CHECK_EQUAL(entryAt(pages, 0, 0, 2), parentEntry);
+	CHECK_EQUAL(entriesOf(pages, 0, parent), 4);
+	CHECK_EQUAL(entriesOf(pages, 1, parent), 1);
+	CHECK(entryAt(pages, 0, 2, 3) != parentEntry);
+
+	// Only the covered rectangles of the level of the page and the levels below it changed
+	CHECK_EQUAL(dirty.size(), 2u);
+	CHECK(dirty[0].level == 0 && dirty[0].x == 0 && dirty[0].y == 2 && dirty[0].width == 2 && dirty[0].height == 2);
+	CHECK(dirty[1].level == 1 && dirty[1].x == 0 && dirty[1].y == 1 && dirty[1].width == 1 && dirty[1].height == 1);
+
+	// A finer page wins over its parent, the rest of the parent area keeps pointing at the parent
+	PageId child = MakePageId(0, 1, 3);
+	int childSlot;
+	CHECK(pages.MapPage(child, childSlot, evicted));
+	dirty.clear();
+	CHECK(pages.UpdatePageTable(dirty));
+	CHECK_EQUAL(entryAt(pages, 0, 1, 3), VirtualTexturePages::Entry(childSlot % 2, childSlot / 2, 0));
+	CHECK_EQUAL(entriesOf(pages, 0, parent), 3);
+	CHECK_EQUAL(dirty.size(), 1u);
+	CHECK(dirty[0].level == 0 && dirty[0].x == 1 && dirty[0].y == 3 && dirty[0].width == 1 && dirty[0].height == 1);
+}
+
+
+// The least recently used page goes first, pages seen in the current frame and the pinned page never do
+static void testEviction()
+{
+	// Three slots besides the pinned one
+	VirtualTexturePages pages(128, 128, 16, 2, 2);
+	PageId pinned = MakePageId(3, 0, 0);
+	PageId a = MakePageId(0, 0, 0);
+	PageId b = MakePageId(0, 1, 0);
+	PageId c = MakePageId(0, 2, 0);
+	PageId d = MakePageId(0, 3, 0);
+	PageId e = MakePageId(0, 4, 0);
+	int slot;
+	PageId evicted;
+
+	frame(pages, { a, b, c });
+	CHECK(pages.MapPage(a, slot, evicted));
+	CHECK(pages.MapPage(b, slot, evicted));
+	CHECK(pages.MapPage(c, slot, evicted));
+	CHECK_EQUAL(pages.ResidentCount(), 4);
+	// Everything is in use this frame
+	CHECK(!pages.MapPage(d, slot, evicted));
+	CHECK_EQUAL(evicted, 0u);
+	CHECK(!pages.IsResident(d));
+
+	// a wasn't seen, so it is the oldest
+	frame(pages, { b, c });
+	CHECK(pages.MapPage(d, slot, evicted));
+	CHECK_EQUAL(evicted, a);
+	CHECK(!pages.IsResident(a));
+	CHECK_EQUAL(pages.SlotOf(d), slot);
+
+	// b and c were used in the same frame, b first, and neither since
+	frame(pages, { d });
+	CHECK(pages.MapPage(e, slot, evicted));
+	CHECK_EQUAL(evicted, b);
+	CHECK(pages.MapPage(a, slot, evicted));
+	CHECK_EQUAL(evicted, c);
+	// Mapping a resident page just returns its slot
+	int again;
+	CHECK(pages.MapPage(a, again, evicted));
+	CHECK_EQUAL(again, slot);
+	CHECK_EQUAL(evicted, 0u);
+
+	// Many frames of churn never take the slot of the coarsest page
+	int pinnedSlot = pages.SlotOf(pinned);
+	for (int f = 0; f < 20; f++)
+	{
+		frame(pages, {});
+		for (int x = 0; x < 8; x++)
+		{
+			pages.MapPage(MakePageId(0, x, f % 8), slot, evicted);
+			CHECK(evicted != pinned);
+		}
+	}
+	CHECK_EQUAL(pages.SlotOf(pinned), pinnedSlot);
+	CHECK_EQUAL(pages.ResidentCount(), 4);
+
+	// Evicted pages fall back to the coarsest page again, mapped and evicted pages are handled once each
+	std::vector<PageRect> dirty;
+	CHECK(pages.UpdatePageTable(dirty));
+	int resident = 0;
+	for (int x = 0; x < 8; x++)
+	{
+		for (int y = 0; y < 8; y++)
+		{
+			PageId page = MakePageId(0, x, y);
+			uint32_t expected = VirtualTexturePages::Entry(pinnedSlot % 2, pinnedSlot / 2, 3);
+			if (pages.IsResident(page))
+			{
+				expected = VirtualTexturePages::Entry(pages.SlotOf(page) % 2, pages.SlotOf(page) / 2, 0);
+				resident++;
+			}
+			CHECK_EQUAL(entryAt(pages, 0, x, y), expected);
+		}
+	}
+	CHECK_EQUAL(resident, 3);
+	CHECK(!pages.UpdatePageTable(dirty));
+}
+
+
+int main()
+{
+	testConstruction();
+	testRequests();
+	testParentFallback();
+	testEviction();
+	return CHECK_RESULT();
+}
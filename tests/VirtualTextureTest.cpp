@@ -0,0 +1,257 @@
+#include<cstdio>
+#include<cstdlib>
+#include<filesystem>
+#include<stdexcept>
+#include<string>
+#include<vector>
+
+#include"Check.h"
+#include"HeadlessGL.h"
+#include"GeometryArena.h"
+#include"VirtualTexture.h"
+
+CHECK_MAIN;
+
+// 8 x 8 pages of 32 texels, levels of 8, 4, 2 and 1 pages a side
+static const int imageSize = 256;
+static const int pageSize = 32;
+// 256 texels over 44 pixels is level 2, far enough from level 1 and 3 that rounding can't tip it
+static const int size = 44;
+
+
+// Red and green grow with x and y, so a page in the wrong place is far off. Blue is a checker of
+// 4 x 4 texel squares, one texel of level 2 each, which averages to gray from level 3 on
+static TextureImage makeImage()
+{
+	TextureImage image = { (unsigned char*)std::malloc(imageSize * imageSize * 3), imageSize, imageSize, 3 };
+	for (int y = 0; y < imageSize; y++)
+	{
+		for (int x = 0; x < imageSize; x++)
+		{
+			unsigned char* texel = &image.bytes[(y * imageSize + x) * 3];
+			texel[0] = (unsigned char)x;
+			texel[1] = (unsigned char)y;
+			texel[2] = ((x / 4 + y / 4) % 2) ? 255 : 0;
+		}
+	}
+	return image;
+}
+
+// virtual.frag with the lighting left out, or a plain texture in its place
+static Shader makeShader(const char* sampling)
+{
+	std::string source = get_file_contents("shader/virtual.frag");
+	std::string lit = "FragColor = direcLight();";
+	size_t at = source.find(lit);
+	CHECK(at != std::string::npos);
+	source.replace(at, lit.size(), sampling);
+	source.insert(source.find('\n') + 1, "uniform sampler2D reference;\n");
+
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "VirtualTextureTest.frag";
+	std::FILE* file = std::fopen(path.string().c_str(), "wb");
+	std::fwrite(source.data(), 1, source.size(), file);
+	std::fclose(file);
+	Shader shader("shader/part13.vert", path.string().c_str());
+	std::filesystem::remove(path);
+	return shader;
+}
+
+// The model uniforms part13.vert needs, a quad in clip space stays where it is
+static void setTransforms(Shader& shader)
+{
+	shader.Activate();
+	glm::mat4 identity(1.0f);
+	const char* names[] = { "camMatrix", "model", "translation", "rotation", "scale" };
+	for (const char* name : names)
+	{
+		glUniformMatrix4fv(shader.Uniform(name), 1, GL_FALSE, &identity[0][0]);
+	}
+}
+
+static std::vector<unsigned char> readImage()
+{
+	std::vector<unsigned char> pixels(size * size * 4);
+	glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	return pixels;
+}
+
+static std::vector<unsigned char> render(Shader& shader, GLuint firstIndex, GLint baseVertex)
+{
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	setTransforms(shader);
+	glDrawElementsBaseVertex(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)(firstIndex * sizeof(GLuint)), baseVertex);
+	return readImage();
+}
+
+// Pixels that differ by more than neighbouring texels of the smooth channels do. Nearest sampling
+// may pick the other texel where a pixel center falls right on a texel edge, those are few
+static int differences(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b)
+{
+	int count = 0;
+	for (int p = 0; p < size * size; p++)
+	{
+		bool same = true;
+		for (int c = 0; c < 4; c++)
+		{
+			same &= std::abs(a[p * 4 + c] - b[p * 4 + c]) <= 12;
+		}
+		count += !same;
+	}
+	return count;
+}
+
+// A level of the mip chain as a plain texture
+static GLuint levelTexture(const std::vector<unsigned char>& pixels, int width)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, width, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return texture;
+}
+
+
+// The page file holds every page of every level after its header
+static void testPageFile(const std::string& path)
+{
+	TextureImage image = makeImage();
+	CHECK(VirtualTexture::WritePageFile(image, pageSize, path.c_str()));
+	CHECK(image.bytes == NULL);
+	std::uintmax_t pageBytes = pageSize * pageSize * 4;
+	CHECK_EQUAL(std::filesystem::file_size(path), 16 + (64 + 16 + 4 + 1) * pageBytes);
+
+	bool threw = false;
+	try
+	{
+		VirtualTexture missing("shader/virtual.frag", size, size);
+	}
+	catch (const std::invalid_argument&)
+	{
+		threw = true;
+	}
+	CHECK(threw);
+}
+
+
+// Feedback of the drawn quad comes back a frame later, Update loads the pages it asks for, and
+// drawing through the page table then matches the level the screen needs. Before that the pinned
+// coarsest page stands in for everything
+static void testRoundTrip(const std::string& path)
+{
+	// A divisor of 1 keeps the feedback at the size of the framebuffer
+	VirtualTexture texture(path.c_str(), size, size, 4, 4, 1);
+	CHECK_EQUAL(texture.pages.LevelCount(), 4);
+	CHECK_EQUAL(texture.pages.ResidentCount(), 1);
+
+	// Stands in for the window, EndFeedback goes back to framebuffer 0 which a headless context doesn't have
+	GLuint framebuffer;
+	GLuint renderbuffer;
+	glGenFramebuffers(1, &framebuffer);
+	glGenRenderbuffers(1, &renderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size, size);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer);
+	CHECK_EQUAL(glCheckFramebufferStatus(GL_FRAMEBUFFER), (GLenum)GL_FRAMEBUFFER_COMPLETE);
+	glViewport(0, 0, size, size);
+
+	// The whole image once across the whole framebuffer
+	GeometryArena arena(16 * sizeof(Vertex), 16 * sizeof(GLuint));
+	std::vector<Vertex> vertices =
+	{
+		Vertex{ glm::vec3(-1.0f, -1.0f, 0.0f), glm::vec3(0.0f), glm::vec3(1.0f), glm::vec2(0.0f, 0.0f) },
+		Vertex{ glm::vec3(1.0f, -1.0f, 0.0f), glm::vec3(0.0f), glm::vec3(1.0f), glm::vec2(1.0f, 0.0f) },
+		Vertex{ glm::vec3(1.0f, 1.0f, 0.0f), glm::vec3(0.0f), glm::vec3(1.0f), glm::vec2(1.0f, 1.0f) },
+		Vertex{ glm::vec3(-1.0f, 1.0f, 0.0f), glm::vec3(0.0f), glm::vec3(1.0f), glm::vec2(0.0f, 1.0f) }
+	};
+	std::vector<GLuint> indices = { 0, 1, 2, 0, 2, 3 };
+	const GeometryRange& quad = arena.Get(arena.Allocate(vertices, indices));
+	arena.Bind();
+
+	Shader virtualShader = makeShader("FragColor = virtualTexture(texCoord);");
+	Shader referenceShader = makeShader("FragColor = textureLod(reference, fract(texCoord), 0.0);");
+
+	TextureImage image = makeImage();
+	std::vector<int> widths;
+	std::vector<int> heights;
+	std::vector<std::vector<unsigned char>> levels = Texture::BuildMipChain(image, widths, heights);
+	std::free(image.bytes);
+	GLuint level2 = levelTexture(levels[2], widths[2]);
+	GLuint level3 = levelTexture(levels[3], widths[3]);
+	referenceShader.Activate();
+	glUniform1i(referenceShader.Uniform("reference"), 2);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, level2);
+	std::vector<unsigned char> fine = render(referenceShader, quad.firstIndex, quad.baseVertex);
+	glBindTexture(GL_TEXTURE_2D, level3);
+	std::vector<unsigned char> coarse = render(referenceShader, quad.firstIndex, quad.baseVertex);
+	// The checker tells the levels apart everywhere
+	CHECK(differences(fine, coarse) > size * size * 9 / 10);
+
+	texture.Bind(virtualShader, 0, 1);
+	CHECK(differences(render(virtualShader, quad.firstIndex, quad.baseVertex), coarse) < size * size / 20);
+
+	// The first read back is still on its way when Update looks, nothing is requested yet
+	texture.BeginFeedback();
+	setTransforms(texture.feedbackShader);
+	glDrawElementsBaseVertex(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)(quad.firstIndex * sizeof(GLuint)), quad.baseVertex);
+	texture.EndFeedback();
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	texture.Update();
+	CHECK(texture.pages.Requests().empty());
+	CHECK_EQUAL(texture.pages.ResidentCount(), 1);
+
+	// A frame later the first one has landed: the four pages of level 2, level 3 is resident already
+	texture.BeginFeedback();
+	setTransforms(texture.feedbackShader);
+	glDrawElementsBaseVertex(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)(quad.firstIndex * sizeof(GLuint)), quad.baseVertex);
+	texture.EndFeedback();
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFinish();
+	texture.Update();
+	const std::vector<PageId>& requests = texture.pages.Requests();
+	CHECK_EQUAL(requests.size(), 4u);
+	for (PageId page : requests)
+	{
+		CHECK_EQUAL(PageLevel(page), 2);
+		CHECK(texture.pages.IsResident(page));
+	}
+	CHECK_EQUAL(texture.pages.ResidentCount(), 5);
+
+	texture.Bind(virtualShader, 0, 1);
+	std::vector<unsigned char> paged = render(virtualShader, quad.firstIndex, quad.baseVertex);
+	CHECK(differences(paged, fine) < size * size / 20);
+	CHECK_EQUAL(glGetError(), (GLenum)GL_NO_ERROR);
+
+	glDeleteTextures(1, &level2);
+	glDeleteTextures(1, &level3);
+	virtualShader.Delete();
+	referenceShader.Delete();
+	texture.Delete();
+	arena.Delete();
+	glDeleteRenderbuffers(1, &renderbuffer);
+	glDeleteFramebuffers(1, &framebuffer);
+}
+
+
+int main()
+{
+	if (!CreateHeadlessContext())
+	{
+		return CHECK_SKIP;
+	}
+
+	std::string path = (std::filesystem::temp_directory_path() / "VirtualTextureTest.pages").string();
+	testPageFile(path);
+	testRoundTrip(path);
+	std::filesystem::remove(path);
+
+	DestroyHeadlessContext();
+	return CHECK_RESULT();
+}